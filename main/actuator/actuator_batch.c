@@ -0,0 +1,436 @@
+/**
+ * @file actuator_batch.c
+ * @brief Run many actuator operations in as few bus transactions as possible
+ */
+
+#include "actuator_batch.h"
+#include <string.h>
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+
+#include "actuator_registry.h"
+#include "actuator_poller.h"
+#include "bus_manager.h"
+#include "mightyzap.h"
+#include "memprof.h"
+
+static const char *TAG = "ACT_BATCH";
+
+#define REG_SPACE           256     // Registers addressable by a batch (0x00-0xFF)
+#define READ_MAX_REGS       125     // FC 0x03 limit
+
+/**
+ * @brief Registers of one actuator touched by a batch
+ */
+typedef struct {
+    uint32_t wr_mask[REG_SPACE / 32];
+    uint32_t rd_mask[REG_SPACE / 32];
+    uint16_t wr_val[REG_SPACE];
+    uint16_t rd_val[REG_SPACE];
+    uint8_t wr_status[REG_SPACE];   // actuator_batch_status_t
+    uint8_t rd_status[REG_SPACE];
+    esp_err_t err;                  // First error on the actuator
+} reg_plan_t;
+
+typedef struct {
+    actuator_batch_op_t *ops;
+    size_t count;
+    bool stop_on_error;
+    volatile bool abort;            // stop_on_error: a transaction failed
+    actuator_batch_stats_t stats[BUS_MAX];
+} batch_ctx_t;
+
+static inline bool mask_test(const uint32_t *mask, int reg)
+{
+    return (mask[reg / 32] >> (reg % 32)) & 1;
+}
+
+static inline void mask_set(uint32_t *mask, int reg)
+{
+    mask[reg / 32] |= 1u << (reg % 32);
+}
+
+// ============================================================================
+// Planning
+// ============================================================================
+
+static void plan_write(reg_plan_t *plan, int reg, uint16_t value)
+{
+    mask_set(plan->wr_mask, reg);
+    plan->wr_val[reg] = value;
+}
+
+static void plan_read(reg_plan_t *plan, int reg, int count)
+{
+    for (int r = reg; r < reg + count; r++) {
+        mask_set(plan->rd_mask, r);
+    }
+}
+
+/**
+ * @brief Get the registers an operation reads or writes
+ */
+static void op_span(const actuator_batch_op_t *op, int *reg, int *count)
+{
+    if (op->type == ACTUATOR_BATCH_STATUS) {
+        *reg = MZAP_REG_PRESENT_POSITION;
+        *count = ACTUATOR_BATCH_STATUS_REGS;
+    } else {
+        *reg = op->reg;
+        *count = op->count;
+    }
+}
+
+static bool same_actuator(const actuator_batch_op_t *a, const actuator_batch_op_t *b)
+{
+    return a->bus == b->bus && a->id == b->id;
+}
+
+/**
+ * @brief Merge the operations of the actuator of ops[first] into a plan
+ */
+static void plan_actuator(const batch_ctx_t *ctx, size_t first, reg_plan_t *plan)
+{
+    memset(plan, 0, sizeof(*plan));
+
+    for (size_t i = first; i < ctx->count; i++) {
+        const actuator_batch_op_t *op = &ctx->ops[i];
+        if (!same_actuator(op, &ctx->ops[first])) {
+            continue;
+        }
+
+        int reg, count;
+        switch (op->type) {
+        case ACTUATOR_BATCH_CONTROL:
+            if (op->set & ACTUATOR_BATCH_SET_FORCE) plan_write(plan, MZAP_REG_FORCE_ON_OFF, op->force ? 1 : 0);
+            if (op->set & ACTUATOR_BATCH_SET_POSITION) plan_write(plan, MZAP_REG_GOAL_POSITION, op->position);
+            if (op->set & ACTUATOR_BATCH_SET_SPEED) plan_write(plan, MZAP_REG_GOAL_SPEED, op->speed);
+            if (op->set & ACTUATOR_BATCH_SET_CURRENT) plan_write(plan, MZAP_REG_GOAL_CURRENT, op->current);
+            break;
+        case ACTUATOR_BATCH_WRITE:
+            for (int k = 0; k < op->count; k++) {
+                plan_write(plan, op->reg + k, op->values[k]);
+            }
+            break;
+        case ACTUATOR_BATCH_STATUS:
+        case ACTUATOR_BATCH_READ:
+            op_span(op, &reg, &count);
+            plan_read(plan, reg, count);
+            break;
+        }
+    }
+}
+
+// ============================================================================
+// Execution
+// ============================================================================
+
+static void set_status(uint8_t *status, int reg, int count, actuator_batch_status_t value)
+{
+    memset(&status[reg], value, count);
+}
+
+/**
+ * @brief Account for one transaction and record its result
+ */
+static actuator_batch_status_t finish_transaction(batch_ctx_t *ctx, uint8_t bus, reg_plan_t *plan, esp_err_t ret)
+{
+    ctx->stats[bus].transactions++;
+    if (ret == ESP_OK) {
+        return ACTUATOR_BATCH_DONE;
+    }
+    ctx->stats[bus].failed++;
+    if (plan->err == ESP_OK) {
+        plan->err = ret;
+    }
+    if (ctx->stop_on_error) {
+        ctx->abort = true;
+    }
+    return ACTUATOR_BATCH_FAILED;
+}
+
+/**
+ * @brief Send the transactions of a plan
+ *
+ * Called with the bus locked.
+ */
+static void execute_plan(batch_ctx_t *ctx, uint8_t bus, mightyzap_handle_t handle, reg_plan_t *plan)
+{
+    // Writes: one transaction per run of consecutive registers, ascending
+    for (int reg = 0; reg < REG_SPACE; ) {
+        if (!mask_test(plan->wr_mask, reg)) {
+            reg++;
+            continue;
+        }
+        int start = reg;
+        while (reg < REG_SPACE && mask_test(plan->wr_mask, reg) && reg - start < MZAP_WRITE_MAX_REGS) {
+            reg++;
+        }
+
+        actuator_batch_status_t status = ACTUATOR_BATCH_SKIPPED;
+        if (!ctx->abort) {
+            esp_err_t ret = mightyzap_write_registers(handle, start, reg - start, &plan->wr_val[start]);
+            status = finish_transaction(ctx, bus, plan, ret);
+        }
+        set_status(plan->wr_status, start, reg - start, status);
+    }
+
+    // Reads: one transaction per run, reading through short gaps
+    for (int reg = 0; reg < REG_SPACE; ) {
+        if (!mask_test(plan->rd_mask, reg)) {
+            reg++;
+            continue;
+        }
+        int start = reg;
+        int end = reg + 1;              // Past the last requested register
+        for (reg++; reg < REG_SPACE && reg - start < READ_MAX_REGS; reg++) {
+            if (mask_test(plan->rd_mask, reg)) {
+                end = reg + 1;
+            } else if (reg + 1 - end > ACTUATOR_BATCH_READ_GAP) {
+                break;
+            }
+        }
+        reg = end;
+
+        actuator_batch_status_t status = ACTUATOR_BATCH_SKIPPED;
+        if (!ctx->abort) {
+            esp_err_t ret = mightyzap_read_registers(handle, start, end - start, &plan->rd_val[start]);
+            status = finish_transaction(ctx, bus, plan, ret);
+        }
+        set_status(plan->rd_status, start, end - start, status);
+    }
+}
+
+/**
+ * @brief Combine the results of the registers of an operation
+ */
+static actuator_batch_status_t span_status(const uint8_t *status, int reg, int count)
+{
+    actuator_batch_status_t result = ACTUATOR_BATCH_DONE;
+    for (int r = reg; r < reg + count; r++) {
+        if (status[r] == ACTUATOR_BATCH_FAILED) {
+            return ACTUATOR_BATCH_FAILED;
+        }
+        if (status[r] != ACTUATOR_BATCH_DONE) {
+            result = ACTUATOR_BATCH_SKIPPED;
+        }
+    }
+    return result;
+}
+
+static actuator_batch_status_t control_status(const reg_plan_t *plan, const actuator_batch_op_t *op)
+{
+    static const struct { uint8_t flag; uint16_t reg; } fields[] = {
+        { ACTUATOR_BATCH_SET_FORCE,     MZAP_REG_FORCE_ON_OFF },
+        { ACTUATOR_BATCH_SET_POSITION,  MZAP_REG_GOAL_POSITION },
+        { ACTUATOR_BATCH_SET_SPEED,     MZAP_REG_GOAL_SPEED },
+        { ACTUATOR_BATCH_SET_CURRENT,   MZAP_REG_GOAL_CURRENT },
+    };
+
+    actuator_batch_status_t result = ACTUATOR_BATCH_DONE;
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        if (op->set & fields[i].flag) {
+            actuator_batch_status_t status = span_status(plan->wr_status, fields[i].reg, 1);
+            if (status == ACTUATOR_BATCH_FAILED) {
+                return status;
+            }
+            if (status != ACTUATOR_BATCH_DONE) {
+                result = status;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Store the results of the operations of the actuator of ops[first]
+ */
+static void resolve_ops(batch_ctx_t *ctx, size_t first, const reg_plan_t *plan)
+{
+    for (size_t i = first; i < ctx->count; i++) {
+        actuator_batch_op_t *op = &ctx->ops[i];
+        if (!same_actuator(op, &ctx->ops[first])) {
+            continue;
+        }
+
+        int reg, count;
+        op_span(op, &reg, &count);
+        switch (op->type) {
+        case ACTUATOR_BATCH_CONTROL:
+            op->status = control_status(plan, op);
+            break;
+        case ACTUATOR_BATCH_WRITE:
+            op->status = span_status(plan->wr_status, reg, count);
+            break;
+        case ACTUATOR_BATCH_STATUS:
+        case ACTUATOR_BATCH_READ:
+            op->status = span_status(plan->rd_status, reg, count);
+            if (op->status == ACTUATOR_BATCH_DONE) {
+                memcpy(op->values, &plan->rd_val[reg], count * sizeof(uint16_t));
+            }
+            break;
+        }
+        op->err = op->status == ACTUATOR_BATCH_FAILED ? plan->err : ESP_OK;
+    }
+}
+
+static bool is_first_of_actuator(const batch_ctx_t *ctx, size_t index)
+{
+    for (size_t i = 0; i < index; i++) {
+        if (same_actuator(&ctx->ops[i], &ctx->ops[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run the operations of one bus, actuator by actuator
+ */
+static void batch_bus_job(uint8_t bus, void *arg)
+{
+    batch_ctx_t *ctx = arg;
+    reg_plan_t *plan = NULL;
+
+    for (size_t i = 0; i < ctx->count; i++) {
+        actuator_batch_op_t *op = &ctx->ops[i];
+        if (op->bus != bus || !is_first_of_actuator(ctx, i)) {
+            continue;
+        }
+
+        if (plan == NULL) {
+            plan = memprof_malloc(MEMPROF_TAG_HTTP, sizeof(reg_plan_t));
+            if (plan == NULL) {
+                break;      // Left pending, reported as out of memory
+            }
+        }
+        plan_actuator(ctx, i, plan);
+
+        // The bus lock keeps the handle valid for the whole sequence
+        bus_manager_lock(bus);
+        mightyzap_handle_t handle = actuator_registry_get(bus, op->id);
+        if (handle != NULL) {
+            execute_plan(ctx, bus, handle, plan);
+        } else {
+            plan->err = ESP_ERR_NOT_FOUND;
+            memset(plan->wr_status, ACTUATOR_BATCH_FAILED, sizeof(plan->wr_status));
+            memset(plan->rd_status, ACTUATOR_BATCH_FAILED, sizeof(plan->rd_status));
+        }
+        bus_manager_unlock(bus);
+
+        // Follow the motion at the fast poll rate
+        if (plan->wr_status[MZAP_REG_GOAL_POSITION] == ACTUATOR_BATCH_DONE) {
+            actuator_poller_kick(bus, op->id);
+        }
+
+        resolve_ops(ctx, i, plan);
+    }
+
+    memprof_free(MEMPROF_TAG_HTTP, plan);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t actuator_batch_validate(const actuator_batch_op_t *ops, size_t count, size_t *bad_index)
+{
+    if (ops == NULL || count == 0 || count > ACTUATOR_BATCH_MAX_OPS) {
+        if (bad_index) *bad_index = 0;
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const actuator_batch_op_t *op = &ops[i];
+        bool valid = op->bus < bus_manager_count() &&
+                     op->id >= ACTUATOR_ID_MIN && op->id <= ACTUATOR_ID_MAX;
+
+        switch (op->type) {
+        case ACTUATOR_BATCH_CONTROL:
+            valid = valid && op->set != 0 && op->position <= 4095 &&
+                    op->speed <= 1023 && op->current <= 1600;
+            break;
+        case ACTUATOR_BATCH_READ:
+        case ACTUATOR_BATCH_WRITE:
+            valid = valid && op->count >= 1 && op->count <= ACTUATOR_BATCH_MAX_REGS &&
+                    op->reg + op->count <= REG_SPACE;
+            break;
+        case ACTUATOR_BATCH_STATUS:
+            break;
+        default:
+            valid = false;
+            break;
+        }
+
+        if (!valid) {
+            if (bad_index) *bad_index = i;
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t actuator_batch_run(actuator_batch_op_t *ops, size_t count, bool stop_on_error,
+                             actuator_batch_stats_t *stats)
+{
+    esp_err_t ret = actuator_batch_validate(ops, count, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    batch_ctx_t *ctx = memprof_calloc(MEMPROF_TAG_HTTP, 1, sizeof(batch_ctx_t));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->ops = ops;
+    ctx->count = count;
+    ctx->stop_on_error = stop_on_error;
+
+    uint32_t buses = 0;
+    for (size_t i = 0; i < count; i++) {
+        ops[i].status = ACTUATOR_BATCH_PENDING;
+        ops[i].err = ESP_OK;
+        buses |= 1u << ops[i].bus;
+    }
+
+    int64_t start = esp_timer_get_time();
+    if ((buses & (buses - 1)) == 0) {
+        // One bus: no need for a job task
+        uint8_t bus = __builtin_ctz(buses);
+        if (bus_manager_is_up(bus)) {
+            batch_bus_job(bus, ctx);
+        }
+    } else {
+        bus_manager_run_parallel(batch_bus_job, ctx);
+    }
+
+    actuator_batch_stats_t total = {
+        .elapsed_us = (uint32_t)(esp_timer_get_time() - start),
+    };
+    for (int b = 0; b < BUS_MAX; b++) {
+        total.transactions += ctx->stats[b].transactions;
+        total.failed += ctx->stats[b].failed;
+    }
+
+    ret = ESP_OK;
+    for (size_t i = 0; i < count; i++) {
+        if (ops[i].status == ACTUATOR_BATCH_PENDING) {
+            // Bus down, or no memory for its plan
+            ops[i].status = ACTUATOR_BATCH_FAILED;
+            ops[i].err = bus_manager_is_up(ops[i].bus) ? ESP_ERR_NO_MEM : ESP_ERR_INVALID_STATE;
+        }
+        if (ops[i].status != ACTUATOR_BATCH_DONE) {
+            ret = ESP_FAIL;
+        }
+    }
+
+    DLOGD(TAG, "%d ops in %u transactions (%u failed), %lu us",
+          (int)count, total.transactions, total.failed, (unsigned long)total.elapsed_us);
+
+    if (stats) {
+        *stats = total;
+    }
+    memprof_free(MEMPROF_TAG_HTTP, ctx);
+    return ret;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file actuator_batch.h
+ * @brief Run many actuator operations in as few bus transactions as possible
+ *
+ * The operations of a batch are grouped per actuator. For each actuator,
+ * every register to write is merged into one image (a later operation
+ * overrides an earlier one on the same register) and written in ascending
+ * order, one transaction per run of consecutive registers; then the
+ * registers to read are fetched, one transaction per run, reading through
+ * gaps of up to ACTUATOR_BATCH_READ_GAP registers. A control setting force,
+ * position, speed and current is two transactions; any number of status
+ * and read operations on one actuator is usually one.
+ *
+ * Actuators on the same bus are handled in the order of their first
+ * operation; buses run in parallel. Within one actuator, writes always come
+ * before reads: use two batches when a read must see the state before a
+ * write.
+ */
+
+#ifndef ACTUATOR_BATCH_H
+#define ACTUATOR_BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACTUATOR_BATCH_MAX_OPS      32
+#define ACTUATOR_BATCH_MAX_REGS     16      // Registers per read or write operation
+#define ACTUATOR_BATCH_READ_GAP     4       // Unrequested registers read to save a transaction
+#define ACTUATOR_BATCH_STATUS_REGS  6       // Present position .. hardware error
+
+/**
+ * @brief Operation types
+ */
+typedef enum {
+    ACTUATOR_BATCH_CONTROL = 0,     // Force, goal position, speed and current
+    ACTUATOR_BATCH_STATUS,          // Present position, current, motor rate, voltage, moving, hw error
+    ACTUATOR_BATCH_READ,            // Holding registers
+    ACTUATOR_BATCH_WRITE,           // Holding registers
+} actuator_batch_type_t;
+
+/**
+ * @brief Fields set by a control operation
+ */
+#define ACTUATOR_BATCH_SET_FORCE        0x01
+#define ACTUATOR_BATCH_SET_POSITION     0x02
+#define ACTUATOR_BATCH_SET_SPEED        0x04
+#define ACTUATOR_BATCH_SET_CURRENT      0x08
+
+/**
+ * @brief Operation result
+ */
+typedef enum {
+    ACTUATOR_BATCH_PENDING = 0,
+    ACTUATOR_BATCH_DONE,
+    ACTUATOR_BATCH_FAILED,          // A transaction of the operation failed
+    ACTUATOR_BATCH_SKIPPED,         // Not sent: an earlier transaction failed (stop_on_error)
+} actuator_batch_status_t;
+
+/**
+ * @brief Operation
+ */
+typedef struct {
+    actuator_batch_type_t type;
+    uint8_t bus;
+    uint8_t id;
+
+    // CONTROL
+    uint8_t set;                    // ACTUATOR_BATCH_SET_*
+    bool force;
+    uint16_t position;
+    uint16_t speed;
+    uint16_t current;
+
+    // READ, WRITE
+    uint16_t reg;                   // First register
+    uint8_t count;                  // Registers (1-ACTUATOR_BATCH_MAX_REGS)
+
+    // WRITE: values to write; READ, STATUS: values read (STATUS: registers 0x37-0x3C)
+    uint16_t values[ACTUATOR_BATCH_MAX_REGS];
+
+    // Result
+    actuator_batch_status_t status;
+    esp_err_t err;                  // FAILED: first error on the actuator
+} actuator_batch_op_t;
+
+/**
+ * @brief Batch statistics
+ */
+typedef struct {
+    uint16_t transactions;          // Bus transactions sent
+    uint16_t failed;                // Transactions that failed
+    uint32_t elapsed_us;
+} actuator_batch_stats_t;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Check a batch without running it
+ *
+ * @param ops Operations
+ * @param count Number of operations
+ * @param bad_index Pointer to store the index of the first invalid operation (can be NULL)
+ * @return esp_err_t ESP_OK if every operation is valid, ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t actuator_batch_validate(const actuator_batch_op_t *ops, size_t count, size_t *bad_index);
+
+/**
+ * @brief Run a batch
+ *
+ * Nothing is sent unless the whole batch is valid. The result of each
+ * operation is stored in its status, err and values.
+ *
+ * @param ops Operations
+ * @param count Number of operations (1-ACTUATOR_BATCH_MAX_OPS)
+ * @param stop_on_error Once a transaction fails, skip all that were not sent yet
+ * @param stats Pointer to store statistics (can be NULL)
+ * @return esp_err_t ESP_OK if every operation is done, ESP_FAIL if any failed
+ *         or was skipped, ESP_ERR_INVALID_ARG if the batch is invalid,
+ *         ESP_ERR_NO_MEM
+ */
+esp_err_t actuator_batch_run(actuator_batch_op_t *ops, size_t count, bool stop_on_error,
+                             actuator_batch_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACTUATOR_BATCH_H
@@ -0,0 +1,377 @@
+/**
+ * @file actuator_poller.c
+ * @brief Bus polling scheduler for registered actuators
+ */
+
+#include "actuator_poller.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "POLLER";
+
+#define MINOR_CYCLE_MS          CONFIG_ACTUATOR_POLL_FAST_MS
+#define BUS_UTIL_PCT            CONFIG_ACTUATOR_POLL_BUS_UTIL
+#define REBUILD_INTERVAL_MS     1000    // Schedule re-fit to measured costs
+#define BOOST_MS                500     // Fast polling after a motion command
+#define INITIAL_COST_US         5000    // Transaction time until measured
+
+#define POLLER_TASK_STACK       4096
+#define POLLER_TASK_PRIORITY    (tskIDLE_PRIORITY + 6)  // Above the web server
+
+static const uint32_t s_nominal_ms[ACTUATOR_RATE_COUNT] = {
+    CONFIG_ACTUATOR_POLL_FAST_MS,
+    CONFIG_ACTUATOR_POLL_NORMAL_MS,
+    CONFIG_ACTUATOR_POLL_SLOW_MS,
+    CONFIG_ACTUATOR_POLL_VERY_SLOW_MS,
+};
+
+/**
+ * @brief One scheduled read, collected under the registry lock
+ */
+typedef struct {
+    uint8_t id;
+    uint8_t group;
+    int64_t due_us;
+} poll_item_t;
+
+/**
+ * @brief Scheduler of one bus
+ *
+ * Each bus has its own task, schedule and cost model; buses never wait for
+ * each other.
+ */
+typedef struct {
+    uint8_t bus;
+    TaskHandle_t task;
+    int64_t period_us[ACTUATOR_RATE_COUNT];
+    uint32_t cost_us[ACTUATOR_GROUP_COUNT];
+    actuator_poller_stats_t stats;
+    poll_item_t items[ACTUATOR_REGISTRY_MAX * ACTUATOR_GROUP_COUNT];
+} poller_t;
+
+static poller_t s_pollers[BUS_MAX];
+
+const char *actuator_rate_name(actuator_rate_class_t rate)
+{
+    switch (rate) {
+        case ACTUATOR_RATE_FAST:        return "fast";
+        case ACTUATOR_RATE_NORMAL:      return "normal";
+        case ACTUATOR_RATE_SLOW:        return "slow";
+        case ACTUATOR_RATE_VERY_SLOW:   return "very_slow";
+        default:                        return "unknown";
+    }
+}
+
+/**
+ * @brief Rate class of a register group of a slot (registry locked)
+ */
+static actuator_rate_class_t rate_of(uint8_t slot, actuator_group_t group, int64_t now_us)
+{
+    switch (group) {
+        case ACTUATOR_GROUP_MOTION:
+            return actuator_registry_is_active(slot, now_us) ? ACTUATOR_RATE_FAST
+                                                             : ACTUATOR_RATE_NORMAL;
+        case ACTUATOR_GROUP_DIAG:
+            return ACTUATOR_RATE_SLOW;
+        default:
+            return ACTUATOR_RATE_VERY_SLOW;
+    }
+}
+
+static bool is_quarantined(uint8_t slot)
+{
+    actuator_state_t state;
+    return actuator_registry_get_state(slot, &state) == ESP_OK &&
+           state.health == ACTUATOR_QUARANTINED;
+}
+
+// ============================================================================
+// Schedule
+// ============================================================================
+
+/**
+ * @brief Fit the schedule to the measured bus capacity
+ *
+ * Demand is the share of bus time the schedule needs: the sum of
+ * transaction time / period over every polled (actuator, group) pair.
+ */
+static void rebuild_schedule(poller_t *p)
+{
+    int64_t now = esp_timer_get_time();
+    float demand = 0.0f;
+
+    actuator_registry_lock();
+    uint8_t count = actuator_registry_count();
+    for (uint8_t slot = 0; slot < count; slot++) {
+        if (actuator_registry_bus_at(slot) != p->bus || is_quarantined(slot)) {
+            continue;
+        }
+        for (int g = 0; g < ACTUATOR_GROUP_COUNT; g++) {
+            actuator_rate_class_t rate = rate_of(slot, g, now);
+            demand += (float)p->cost_us[g] / (s_nominal_ms[rate] * 1000.0f);
+        }
+    }
+    actuator_registry_unlock();
+
+    float target = BUS_UTIL_PCT / 100.0f;
+    float scale = demand > target ? demand / target : 1.0f;
+
+    for (int c = 0; c < ACTUATOR_RATE_COUNT; c++) {
+        p->period_us[c] = (int64_t)(s_nominal_ms[c] * 1000.0f * scale);
+        p->stats.period_ms[c] = (uint32_t)(p->period_us[c] / 1000);
+    }
+
+    if ((scale > 1.0f) != (p->stats.scale > 1.0f)) {
+        DLOGW(TAG, "Bus %d demand %d%%, periods scaled x%.2f", p->bus, (int)(demand * 100), scale);
+    }
+
+    p->stats.scale = scale;
+    p->stats.demand_pct = (uint32_t)(demand * 100);
+    p->stats.utilisation_pct = (uint32_t)(demand / scale * 100);
+    memcpy(p->stats.cost_us, p->cost_us, sizeof(p->cost_us));
+}
+
+// ============================================================================
+// Cyclic executive
+// ============================================================================
+
+static void poll_one(poller_t *p, const poll_item_t *item, uint32_t *spent_us)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = actuator_registry_read(p->bus, item->id, item->group);
+    int64_t end = esp_timer_get_time();
+    uint32_t elapsed = (uint32_t)(end - start);
+
+    if (ret == ESP_ERR_NOT_FOUND || ret == ESP_ERR_INVALID_STATE) {
+        return;     // Removed or quarantined since collected
+    }
+
+    *spent_us += elapsed;
+    p->stats.polls++;
+
+    if (ret == ESP_OK) {
+        p->cost_us[item->group] = (7 * p->cost_us[item->group] + elapsed) / 8;
+    }
+
+    actuator_registry_lock();
+    int slot = actuator_registry_find(p->bus, item->id);
+    if (slot >= 0) {
+        // Keep the phase; never queue up catch-up reads. The class is taken
+        // after the read so a newly moving actuator is promoted right away.
+        int64_t period = p->period_us[rate_of(slot, item->group, end)];
+        int64_t next = (item->due_us > 0 ? item->due_us : start) + period;
+        if (next <= end) {
+            next = end + period;
+        }
+        actuator_registry_set_due(slot, item->group, next);
+    }
+    actuator_registry_unlock();
+}
+
+/**
+ * @brief Collect the reads of one rate class that are due on the bus
+ *
+ * @return int Number of items
+ */
+static int collect_due(poller_t *p, actuator_rate_class_t rate)
+{
+    int n = 0;
+    int64_t now = esp_timer_get_time();
+
+    actuator_registry_lock();
+    uint8_t count = actuator_registry_count();
+    for (uint8_t slot = 0; slot < count; slot++) {
+        if (actuator_registry_bus_at(slot) != p->bus || is_quarantined(slot)) {
+            continue;
+        }
+        for (int g = 0; g < ACTUATOR_GROUP_COUNT; g++) {
+            if (rate_of(slot, g, now) != rate) continue;
+
+            int64_t due = actuator_registry_get_due(slot, g);
+            if (now < due) continue;
+
+            if (due > 0 && now - due > p->period_us[rate]) {
+                p->stats.late++;
+            }
+            p->items[n++] = (poll_item_t){
+                .id = actuator_registry_id_at(slot),
+                .group = g,
+                .due_us = due,
+            };
+        }
+    }
+    actuator_registry_unlock();
+
+    return n;
+}
+
+/**
+ * @brief Collect quarantined actuators on the bus whose probe is due
+ *
+ * @return int Number of items
+ */
+static int collect_probes(poller_t *p)
+{
+    int n = 0;
+    int64_t now = esp_timer_get_time();
+
+    actuator_registry_lock();
+    uint8_t count = actuator_registry_count();
+    for (uint8_t slot = 0; slot < count; slot++) {
+        if (actuator_registry_bus_at(slot) == p->bus && is_quarantined(slot) &&
+            actuator_registry_poll_due(slot, now)) {
+            p->items[n++] = (poll_item_t){
+                .id = actuator_registry_id_at(slot),
+                .group = ACTUATOR_GROUP_MOTION,
+            };
+        }
+    }
+    actuator_registry_unlock();
+
+    return n;
+}
+
+static void run_minor_cycle(poller_t *p)
+{
+    const uint32_t minor_us = MINOR_CYCLE_MS * 1000;
+    const uint32_t budget_us = minor_us * BUS_UTIL_PCT / 100;
+    uint32_t spent_us = 0;
+
+    // Highest rate class first, so the budget goes to the most useful data
+    for (int rate = 0; rate < ACTUATOR_RATE_COUNT; rate++) {
+        int n = collect_due(p, rate);
+        for (int i = 0; i < n; i++) {
+            if (spent_us > 0 && spent_us + p->cost_us[p->items[i].group] > budget_us) {
+                p->stats.deferred++;
+                continue;
+            }
+            poll_one(p, &p->items[i], &spent_us);
+        }
+    }
+
+    // Probe quarantined actuators in the time that is left
+    int n = collect_probes(p);
+    for (int i = 0; i < n; i++) {
+        if (spent_us > 0 && spent_us + p->cost_us[ACTUATOR_GROUP_MOTION] > budget_us) {
+            break;
+        }
+        int64_t start = esp_timer_get_time();
+        actuator_registry_read(p->bus, p->items[i].id, ACTUATOR_GROUP_MOTION);
+        spent_us += (uint32_t)(esp_timer_get_time() - start);
+        p->stats.probes++;
+    }
+
+    p->stats.cycles++;
+    if (spent_us > minor_us) {
+        p->stats.overruns++;
+    }
+    p->stats.busy_pct = (7 * p->stats.busy_pct + spent_us * 100 / minor_us) / 8;
+}
+
+static void poller_task(void *arg)
+{
+    poller_t *p = arg;
+
+    ESP_LOGI(TAG, "Bus %d poller started on core %d, minor cycle %d ms",
+             p->bus, xPortGetCoreID(), MINOR_CYCLE_MS);
+
+    TickType_t last_wake = xTaskGetTickCount();
+    TickType_t last_rebuild = last_wake;
+    uint8_t last_count = actuator_registry_count();
+
+    while (1) {
+        run_minor_cycle(p);
+
+        TickType_t now = xTaskGetTickCount();
+        uint8_t count = actuator_registry_count();
+        if (count != last_count || now - last_rebuild >= pdMS_TO_TICKS(REBUILD_INTERVAL_MS)) {
+            rebuild_schedule(p);
+            last_rebuild = now;
+            last_count = count;
+        }
+
+        // An overrun leaves last_wake in the past; restart the cycle grid
+        if (now - last_wake > pdMS_TO_TICKS(MINOR_CYCLE_MS)) {
+            last_wake = now;
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MINOR_CYCLE_MS));
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t actuator_poller_start(void)
+{
+    int started = 0;
+
+    for (uint8_t bus = 0; bus < bus_manager_count(); bus++) {
+        poller_t *p = &s_pollers[bus];
+        if (p->task != NULL) {
+            started++;
+            continue;
+        }
+        if (!bus_manager_is_up(bus)) {
+            continue;
+        }
+
+        memset(&p->stats, 0, sizeof(p->stats));
+        p->bus = bus;
+        p->stats.minor_cycle_ms = MINOR_CYCLE_MS;
+        p->stats.scale = 1.0f;
+        for (int g = 0; g < ACTUATOR_GROUP_COUNT; g++) {
+            p->cost_us[g] = INITIAL_COST_US;
+        }
+        rebuild_schedule(p);
+
+        char name[16];
+        snprintf(name, sizeof(name), "act_poller%d", bus);
+        BaseType_t ret = xTaskCreatePinnedToCore(poller_task, name, POLLER_TASK_STACK, p,
+                                                 POLLER_TASK_PRIORITY, &p->task,
+                                                 bus_manager_get_core(bus));
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create poller task for bus %d", bus);
+            p->task = NULL;
+            continue;
+        }
+
+        p->stats.running = true;
+        started++;
+    }
+
+    return started > 0 ? ESP_OK : ESP_FAIL;
+}
+
+bool actuator_poller_is_running(void)
+{
+    for (int bus = 0; bus < BUS_MAX; bus++) {
+        if (s_pollers[bus].task != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void actuator_poller_kick(uint8_t bus, uint8_t id)
+{
+    actuator_registry_boost(bus, id, esp_timer_get_time() + BOOST_MS * 1000);
+}
+
+void actuator_poller_get_stats(uint8_t bus, actuator_poller_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (bus < BUS_MAX) {
+        *stats = s_pollers[bus].stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
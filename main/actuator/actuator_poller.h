@@ -0,0 +1,100 @@
+/**
+ * @file actuator_poller.h
+ * @brief Bus polling scheduler for registered actuators
+ *
+ * Every (actuator, register group) pair is polled at the period of its rate
+ * class. Motion feedback of moving actuators runs at the fast rate, which is
+ * also the minor cycle of a cyclic executive. Each minor cycle spends at
+ * most a configured share of its length on the bus, based on measured
+ * transaction times. When the schedule needs more bus time than that, all
+ * periods are stretched by the same factor until it fits.
+ *
+ * Each bus has its own task, pinned to the bus's core, and its own schedule.
+ */
+
+#ifndef ACTUATOR_POLLER_H
+#define ACTUATOR_POLLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "actuator_registry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Poll rate classes
+ */
+typedef enum {
+    ACTUATOR_RATE_FAST = 0,     // Motion feedback of moving actuators
+    ACTUATOR_RATE_NORMAL,       // Motion feedback of idle actuators
+    ACTUATOR_RATE_SLOW,         // Diagnostics
+    ACTUATOR_RATE_VERY_SLOW,    // Non-volatile identity and limits
+    ACTUATOR_RATE_COUNT,
+} actuator_rate_class_t;
+
+/**
+ * @brief Scheduler statistics of one bus
+ */
+typedef struct {
+    bool running;
+    uint32_t minor_cycle_ms;                        // Minor cycle length
+    uint32_t period_ms[ACTUATOR_RATE_COUNT];        // Effective period per class
+    uint32_t cost_us[ACTUATOR_GROUP_COUNT];         // Measured transaction time per group
+    float scale;                                    // Period stretch factor (1 = nominal)
+    uint32_t demand_pct;                            // Bus demand of the nominal schedule
+    uint32_t utilisation_pct;                       // Bus demand of the effective schedule
+    uint32_t busy_pct;                              // Measured bus time per minor cycle (average)
+    uint32_t cycles;                                // Minor cycles run
+    uint32_t polls;                                 // Scheduled reads performed
+    uint32_t probes;                                // Reads of quarantined actuators
+    uint32_t deferred;                              // Reads pushed to a later cycle by the budget
+    uint32_t late;                                  // Reads served more than one period late
+    uint32_t overruns;                              // Minor cycles that ran past their end
+} actuator_poller_stats_t;
+
+/**
+ * @brief Start a polling task for every bus that is up
+ *
+ * @return esp_err_t ESP_OK if at least one task runs
+ */
+esp_err_t actuator_poller_start(void);
+
+/**
+ * @brief Check whether the polling tasks are running
+ *
+ * While it runs, the registry cache is kept fresh and readers should serve
+ * from it instead of reading the bus.
+ */
+bool actuator_poller_is_running(void);
+
+/**
+ * @brief Poll an actuator's motion feedback at the fast rate for a while
+ *
+ * Call after sending a motion command.
+ *
+ * @param bus Bus index
+ * @param id Slave ID
+ */
+void actuator_poller_kick(uint8_t bus, uint8_t id);
+
+/**
+ * @brief Get scheduler statistics of a bus
+ *
+ * @param bus Bus index
+ * @param stats Pointer to store statistics (zeroed for an unknown bus)
+ */
+void actuator_poller_get_stats(uint8_t bus, actuator_poller_stats_t *stats);
+
+/**
+ * @brief Get the name of a rate class
+ */
+const char *actuator_rate_name(actuator_rate_class_t rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACTUATOR_POLLER_H
@@ -0,0 +1,563 @@
+/**
+ * @file actuator_registry.c
+ * @brief Registry of active mightyZAP actuators
+ */
+
+#include "actuator_registry.h"
+#include <string.h>
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "config_manager.h"
+
+static const char *TAG = "ACT_REG";
+
+#define STATE_CONNECTED     0x01
+
+// Circuit breaker
+#define QUARANTINE_FAILURES     3       // Consecutive failures before quarantine
+#define PROBE_BACKOFF_MIN_MS    1000
+#define PROBE_BACKOFF_MAX_MS    60000
+
+/**
+ * @brief Registry storage
+ *
+ * Hot state is kept as parallel arrays (struct-of-arrays) indexed by slot so
+ * that loops touching one field only walk one contiguous array.
+ */
+static struct {
+    // (bus, ID) -> slot + 1 (0 = not registered)
+    uint8_t index[BUS_MAX][ACTUATOR_ID_MAX + 1];
+    uint8_t count;
+
+    // Cold: identity
+    uint8_t bus[ACTUATOR_REGISTRY_MAX];
+    uint8_t id[ACTUATOR_REGISTRY_MAX];
+    mightyzap_handle_t handle[ACTUATOR_REGISTRY_MAX];
+
+    // Hot: cached telemetry
+    uint16_t position[ACTUATOR_REGISTRY_MAX];
+    uint16_t current[ACTUATOR_REGISTRY_MAX];
+    uint16_t motor_op[ACTUATOR_REGISTRY_MAX];
+    uint16_t voltage[ACTUATOR_REGISTRY_MAX];
+    uint8_t moving[ACTUATOR_REGISTRY_MAX];
+    uint8_t flags[ACTUATOR_REGISTRY_MAX];
+    int64_t updated_us[ACTUATOR_REGISTRY_MAX];
+
+    // Circuit breaker
+    uint8_t health[ACTUATOR_REGISTRY_MAX];
+    uint8_t failures[ACTUATOR_REGISTRY_MAX];
+    uint32_t backoff_ms[ACTUATOR_REGISTRY_MAX];
+    int64_t next_probe_us[ACTUATOR_REGISTRY_MAX];
+
+    // Slow-changing registers
+    uint16_t hw_error[ACTUATOR_REGISTRY_MAX];
+    uint16_t model[ACTUATOR_REGISTRY_MAX];
+    uint16_t firmware[ACTUATOR_REGISTRY_MAX];
+
+    // Poll schedule
+    int64_t due_us[ACTUATOR_GROUP_COUNT][ACTUATOR_REGISTRY_MAX];
+    int64_t boost_until_us[ACTUATOR_REGISTRY_MAX];
+} s_reg;
+
+static SemaphoreHandle_t s_mutex = NULL;
+
+// ============================================================================
+// Locking
+// ============================================================================
+
+void actuator_registry_lock(void)
+{
+    if (s_mutex) xSemaphoreTakeRecursive(s_mutex, portMAX_DELAY);
+}
+
+void actuator_registry_unlock(void)
+{
+    if (s_mutex) xSemaphoreGiveRecursive(s_mutex);
+}
+
+// ============================================================================
+// Circuit breaker
+// ============================================================================
+
+static void enter_quarantine(uint8_t slot, int64_t now_us)
+{
+    if (s_reg.health[slot] != ACTUATOR_QUARANTINED) {
+        s_reg.health[slot] = ACTUATOR_QUARANTINED;
+        s_reg.backoff_ms[slot] = PROBE_BACKOFF_MIN_MS;
+        DLOGW(TAG, "Actuator %d:%d quarantined", s_reg.bus[slot], s_reg.id[slot]);
+    } else if (s_reg.backoff_ms[slot] < PROBE_BACKOFF_MAX_MS) {
+        s_reg.backoff_ms[slot] *= 2;
+        if (s_reg.backoff_ms[slot] > PROBE_BACKOFF_MAX_MS) {
+            s_reg.backoff_ms[slot] = PROBE_BACKOFF_MAX_MS;
+        }
+    }
+    s_reg.next_probe_us[slot] = now_us + (int64_t)s_reg.backoff_ms[slot] * 1000;
+}
+
+static void record_success(uint8_t slot)
+{
+    if (s_reg.health[slot] == ACTUATOR_QUARANTINED) {
+        DLOGI(TAG, "Actuator %d:%d back online", s_reg.bus[slot], s_reg.id[slot]);
+    }
+    s_reg.health[slot] = ACTUATOR_HEALTHY;
+    s_reg.failures[slot] = 0;
+    s_reg.backoff_ms[slot] = 0;
+    s_reg.next_probe_us[slot] = 0;
+}
+
+static void record_failure(uint8_t slot, int64_t now_us)
+{
+    if (s_reg.failures[slot] < UINT8_MAX) {
+        s_reg.failures[slot]++;
+    }
+
+    if (s_reg.health[slot] == ACTUATOR_QUARANTINED ||
+        s_reg.failures[slot] >= QUARANTINE_FAILURES) {
+        enter_quarantine(slot, now_us);
+    } else {
+        s_reg.health[slot] = ACTUATOR_SUSPECT;
+    }
+}
+
+const char *actuator_health_name(actuator_health_t health)
+{
+    switch (health) {
+        case ACTUATOR_HEALTHY:      return "healthy";
+        case ACTUATOR_SUSPECT:      return "suspect";
+        case ACTUATOR_QUARANTINED:  return "quarantined";
+        default:                    return "unknown";
+    }
+}
+
+// ============================================================================
+// Init
+// ============================================================================
+
+esp_err_t actuator_registry_init(void)
+{
+    if (s_mutex == NULL) {
+        s_mutex = xSemaphoreCreateRecursiveMutex();
+        if (s_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create registry mutex");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    ESP_LOGI(TAG, "Actuator registry initialized (%d slots)", ACTUATOR_REGISTRY_MAX);
+    return ESP_OK;
+}
+
+/**
+ * @brief Probe the saved actuators of one bus (bus_manager_run_parallel() job)
+ */
+static void probe_bus(uint8_t bus, void *arg)
+{
+    int *offline = arg;
+
+    for (uint8_t id = ACTUATOR_ID_MIN; id <= ACTUATOR_ID_MAX; id++) {
+        if (s_reg.index[bus][id] == 0) {
+            continue;
+        }
+
+        esp_err_t ret = actuator_registry_refresh(bus, id);
+        if (ret == ESP_OK) {
+            continue;
+        }
+
+        // Quarantine right away rather than after several failed polls
+        actuator_registry_lock();
+        int slot = actuator_registry_find(bus, id);
+        if (slot >= 0) {
+            enter_quarantine(slot, esp_timer_get_time());
+        }
+        actuator_registry_unlock();
+        offline[bus]++;
+    }
+}
+
+void actuator_registry_load_saved(void)
+{
+    uint8_t count = config_get_saved_actuator_count();
+    if (count == 0) {
+        ESP_LOGI(TAG, "No saved actuators to load");
+        return;
+    }
+
+    const uint8_t *ids = config_get_saved_actuator_ids();
+    const uint8_t *buses = config_get_saved_actuator_buses();
+    if (ids == NULL || buses == NULL) {
+        ESP_LOGW(TAG, "Failed to get saved actuator IDs");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Loading %d saved actuators from config", count);
+
+    int loaded = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        esp_err_t ret = actuator_registry_add(buses[i], ids[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to load actuator %d:%d: %s", buses[i], ids[i], esp_err_to_name(ret));
+            continue;
+        }
+        loaded++;
+    }
+
+    // Probe once so absent actuators start out quarantined
+    int offline[BUS_MAX] = {0};
+    bus_manager_run_parallel(probe_bus, offline);
+
+    int total_offline = 0;
+    for (int b = 0; b < BUS_MAX; b++) {
+        total_offline += offline[b];
+    }
+
+    ESP_LOGI(TAG, "Loaded %d of %d saved actuators (%d offline)", loaded, count, total_offline);
+}
+
+// ============================================================================
+// Add / Remove
+// ============================================================================
+
+esp_err_t actuator_registry_add(uint8_t bus, uint8_t id)
+{
+    if (bus >= BUS_MAX || id < ACTUATOR_ID_MIN || id > ACTUATOR_ID_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    actuator_registry_lock();
+
+    if (s_reg.index[bus][id] != 0) {
+        actuator_registry_unlock();
+        return ESP_OK;  // Already registered
+    }
+
+    modbus_handle_t modbus = bus_manager_get_modbus(bus);
+    if (modbus == NULL) {
+        actuator_registry_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (s_reg.count >= ACTUATOR_REGISTRY_MAX) {
+        actuator_registry_unlock();
+        ESP_LOGW(TAG, "Cannot add actuator %d:%d: registry full (%d)", bus, id, ACTUATOR_REGISTRY_MAX);
+        return ESP_ERR_NO_MEM;
+    }
+
+    mightyzap_handle_t handle = NULL;
+    esp_err_t ret = mightyzap_init(modbus, id, &handle);
+    if (ret != ESP_OK) {
+        actuator_registry_unlock();
+        return ret;
+    }
+
+    uint8_t slot = s_reg.count;
+    s_reg.bus[slot] = bus;
+    s_reg.id[slot] = id;
+    s_reg.handle[slot] = handle;
+    s_reg.position[slot] = 0;
+    s_reg.current[slot] = 0;
+    s_reg.motor_op[slot] = 0;
+    s_reg.voltage[slot] = 0;
+    s_reg.moving[slot] = 0;
+    s_reg.flags[slot] = 0;
+    s_reg.updated_us[slot] = 0;
+    s_reg.health[slot] = ACTUATOR_HEALTHY;
+    s_reg.failures[slot] = 0;
+    s_reg.backoff_ms[slot] = 0;
+    s_reg.next_probe_us[slot] = 0;
+    s_reg.hw_error[slot] = 0;
+    s_reg.model[slot] = 0;
+    s_reg.firmware[slot] = 0;
+    for (int g = 0; g < ACTUATOR_GROUP_COUNT; g++) {
+        s_reg.due_us[g][slot] = 0;
+    }
+    s_reg.boost_until_us[slot] = 0;
+    s_reg.index[bus][id] = slot + 1;
+    s_reg.count++;
+
+    actuator_registry_unlock();
+
+    ESP_LOGI(TAG, "Registered actuator %d:%d (slot %d)", bus, id, slot);
+    return ESP_OK;
+}
+
+void actuator_registry_remove(uint8_t bus, uint8_t id)
+{
+    if (bus >= BUS_MAX || id < ACTUATOR_ID_MIN || id > ACTUATOR_ID_MAX) {
+        return;
+    }
+
+    // Waits for any transaction in flight on the handle
+    bus_manager_lock(bus);
+    actuator_registry_lock();
+
+    if (s_reg.index[bus][id] == 0) {
+        actuator_registry_unlock();
+        bus_manager_unlock(bus);
+        return;
+    }
+
+    uint8_t slot = s_reg.index[bus][id] - 1;
+    uint8_t last = s_reg.count - 1;
+
+    mightyzap_deinit(s_reg.handle[slot]);
+
+    // Keep slots dense: move the last slot into the hole
+    if (slot != last) {
+        s_reg.bus[slot] = s_reg.bus[last];
+        s_reg.id[slot] = s_reg.id[last];
+        s_reg.handle[slot] = s_reg.handle[last];
+        s_reg.position[slot] = s_reg.position[last];
+        s_reg.current[slot] = s_reg.current[last];
+        s_reg.motor_op[slot] = s_reg.motor_op[last];
+        s_reg.voltage[slot] = s_reg.voltage[last];
+        s_reg.moving[slot] = s_reg.moving[last];
+        s_reg.flags[slot] = s_reg.flags[last];
+        s_reg.updated_us[slot] = s_reg.updated_us[last];
+        s_reg.health[slot] = s_reg.health[last];
+        s_reg.failures[slot] = s_reg.failures[last];
+        s_reg.backoff_ms[slot] = s_reg.backoff_ms[last];
+        s_reg.next_probe_us[slot] = s_reg.next_probe_us[last];
+        s_reg.hw_error[slot] = s_reg.hw_error[last];
+        s_reg.model[slot] = s_reg.model[last];
+        s_reg.firmware[slot] = s_reg.firmware[last];
+        for (int g = 0; g < ACTUATOR_GROUP_COUNT; g++) {
+            s_reg.due_us[g][slot] = s_reg.due_us[g][last];
+        }
+        s_reg.boost_until_us[slot] = s_reg.boost_until_us[last];
+        s_reg.index[s_reg.bus[slot]][s_reg.id[slot]] = slot + 1;
+    }
+
+    s_reg.handle[last] = NULL;
+    s_reg.index[bus][id] = 0;
+    s_reg.count--;
+
+    actuator_registry_unlock();
+    bus_manager_unlock(bus);
+
+    ESP_LOGI(TAG, "Unregistered actuator %d:%d", bus, id);
+}
+
+// ============================================================================
+// Lookup
+// ============================================================================
+
+uint8_t actuator_registry_count(void)
+{
+    return s_reg.count;
+}
+
+int actuator_registry_find(uint8_t bus, uint8_t id)
+{
+    if (bus >= BUS_MAX || id > ACTUATOR_ID_MAX || s_reg.index[bus][id] == 0) {
+        return -1;
+    }
+    return s_reg.index[bus][id] - 1;
+}
+
+mightyzap_handle_t actuator_registry_get(uint8_t bus, uint8_t id)
+{
+    actuator_registry_lock();
+    int slot = actuator_registry_find(bus, id);
+    mightyzap_handle_t handle = slot < 0 ? NULL : s_reg.handle[slot];
+    actuator_registry_unlock();
+    return handle;
+}
+
+uint8_t actuator_registry_bus_at(uint8_t slot)
+{
+    return slot < s_reg.count ? s_reg.bus[slot] : 0;
+}
+
+uint8_t actuator_registry_id_at(uint8_t slot)
+{
+    return slot < s_reg.count ? s_reg.id[slot] : 0;
+}
+
+// ============================================================================
+// Telemetry cache
+// ============================================================================
+
+bool actuator_registry_poll_due(uint8_t slot, int64_t now_us)
+{
+    if (slot >= s_reg.count) {
+        return false;
+    }
+    return s_reg.health[slot] != ACTUATOR_QUARANTINED || now_us >= s_reg.next_probe_us[slot];
+}
+
+/**
+ * @brief Result of one register group read
+ */
+typedef union {
+    mightyzap_status_t status;
+    uint16_t hw_error;
+    mightyzap_info_t info;
+} group_data_t;
+
+static esp_err_t read_group(mightyzap_handle_t handle, actuator_group_t group, group_data_t *data)
+{
+    switch (group) {
+        case ACTUATOR_GROUP_MOTION: return mightyzap_get_status(handle, &data->status);
+        case ACTUATOR_GROUP_DIAG:   return mightyzap_get_hw_error(handle, &data->hw_error);
+        default:                    return mightyzap_get_info(handle, &data->info);
+    }
+}
+
+/**
+ * @brief Store the result of a read in a slot (registry locked)
+ */
+static void apply_group(uint8_t slot, actuator_group_t group, esp_err_t ret,
+                        const group_data_t *data, int64_t now_us)
+{
+    switch (group) {
+        case ACTUATOR_GROUP_MOTION:
+            if (ret == ESP_OK) {
+                s_reg.position[slot] = data->status.position;
+                s_reg.current[slot] = data->status.current;
+                s_reg.motor_op[slot] = data->status.motor_op;
+                s_reg.voltage[slot] = data->status.voltage;
+                s_reg.moving[slot] = data->status.moving;
+                s_reg.flags[slot] |= STATE_CONNECTED;
+                s_reg.updated_us[slot] = now_us;
+            } else {
+                s_reg.flags[slot] &= ~STATE_CONNECTED;
+            }
+            break;
+
+        case ACTUATOR_GROUP_DIAG:
+            if (ret == ESP_OK) {
+                if (data->hw_error != 0 && data->hw_error != s_reg.hw_error[slot]) {
+                    DLOGW(TAG, "Actuator %d:%d hardware error 0x%04X",
+                             s_reg.bus[slot], s_reg.id[slot], data->hw_error);
+                }
+                s_reg.hw_error[slot] = data->hw_error;
+            }
+            break;
+
+        default:
+            if (ret == ESP_OK) {
+                s_reg.model[slot] = data->info.model;
+                s_reg.firmware[slot] = data->info.firmware;
+            }
+            break;
+    }
+
+    if (ret == ESP_OK) {
+        record_success(slot);
+    } else {
+        record_failure(slot, now_us);
+    }
+}
+
+esp_err_t actuator_registry_read(uint8_t bus, uint8_t id, actuator_group_t group)
+{
+    if (group >= ACTUATOR_GROUP_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The bus lock keeps the handle alive; the registry lock is only held
+    // around cache access so other buses are not blocked by this transaction
+    bus_manager_lock(bus);
+
+    actuator_registry_lock();
+    int slot = actuator_registry_find(bus, id);
+    if (slot < 0) {
+        actuator_registry_unlock();
+        bus_manager_unlock(bus);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!actuator_registry_poll_due(slot, esp_timer_get_time())) {
+        actuator_registry_unlock();
+        bus_manager_unlock(bus);
+        return ESP_ERR_INVALID_STATE;
+    }
+    mightyzap_handle_t handle = s_reg.handle[slot];
+    actuator_registry_unlock();
+
+    group_data_t data;
+    esp_err_t ret = read_group(handle, group, &data);
+    int64_t now = esp_timer_get_time();
+
+    // Slots may have moved while unlocked
+    actuator_registry_lock();
+    slot = actuator_registry_find(bus, id);
+    if (slot >= 0) {
+        apply_group(slot, group, ret, &data, now);
+    }
+    actuator_registry_unlock();
+
+    bus_manager_unlock(bus);
+    return ret;
+}
+
+esp_err_t actuator_registry_refresh(uint8_t bus, uint8_t id)
+{
+    return actuator_registry_read(bus, id, ACTUATOR_GROUP_MOTION);
+}
+
+// ============================================================================
+// Poll schedule
+// ============================================================================
+
+int64_t actuator_registry_get_due(uint8_t slot, actuator_group_t group)
+{
+    if (slot >= s_reg.count || group >= ACTUATOR_GROUP_COUNT) {
+        return INT64_MAX;
+    }
+    return s_reg.due_us[group][slot];
+}
+
+void actuator_registry_set_due(uint8_t slot, actuator_group_t group, int64_t due_us)
+{
+    if (slot < s_reg.count && group < ACTUATOR_GROUP_COUNT) {
+        s_reg.due_us[group][slot] = due_us;
+    }
+}
+
+void actuator_registry_boost(uint8_t bus, uint8_t id, int64_t until_us)
+{
+    actuator_registry_lock();
+    int slot = actuator_registry_find(bus, id);
+    if (slot >= 0) {
+        s_reg.boost_until_us[slot] = until_us;
+        s_reg.due_us[ACTUATOR_GROUP_MOTION][slot] = 0;
+    }
+    actuator_registry_unlock();
+}
+
+bool actuator_registry_is_active(uint8_t slot, int64_t now_us)
+{
+    if (slot >= s_reg.count) {
+        return false;
+    }
+    return s_reg.moving[slot] != 0 || now_us < s_reg.boost_until_us[slot];
+}
+
+esp_err_t actuator_registry_get_state(uint8_t slot, actuator_state_t *state)
+{
+    if (state == NULL || slot >= s_reg.count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    state->bus = s_reg.bus[slot];
+    state->id = s_reg.id[slot];
+    state->connected = (s_reg.flags[slot] & STATE_CONNECTED) != 0;
+    state->position = s_reg.position[slot];
+    state->current = s_reg.current[slot];
+    state->motor_op = s_reg.motor_op[slot];
+    state->voltage = s_reg.voltage[slot];
+    state->moving = s_reg.moving[slot];
+    state->updated_us = s_reg.updated_us[slot];
+    state->health = s_reg.health[slot];
+    state->failures = s_reg.failures[slot];
+    state->next_probe_us = s_reg.next_probe_us[slot];
+    state->hw_error = s_reg.hw_error[slot];
+    state->model = s_reg.model[slot];
+    state->firmware = s_reg.firmware[slot];
+    return ESP_OK;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file actuator_registry.h
+ * @brief Registry of active mightyZAP actuators
+ *
+ * Actuators are stored in dense slots (0..count-1) so that status, polling
+ * and group operations iterate without gaps. Actuators are addressed as
+ * (bus, slave ID); a direct lookup table per bus covering the whole Modbus
+ * address space maps an address to its slot in O(1).
+ */
+
+#ifndef ACTUATOR_REGISTRY_H
+#define ACTUATOR_REGISTRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "modbus_rtu.h"
+#include "mightyzap.h"
+#include "bus_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ACTUATOR_ID_MIN         1
+#define ACTUATOR_ID_MAX         247
+#define ACTUATOR_REGISTRY_MAX   CONFIG_ACTUATOR_REGISTRY_MAX
+
+/**
+ * @brief Actuator health (circuit breaker state)
+ *
+ * A failed status read makes an actuator suspect; consecutive failures
+ * quarantine it. Quarantined actuators are skipped by status reads and
+ * only probed again on an exponential schedule. Any successful read makes
+ * the actuator healthy again.
+ */
+typedef enum {
+    ACTUATOR_HEALTHY = 0,
+    ACTUATOR_SUSPECT,
+    ACTUATOR_QUARANTINED,
+} actuator_health_t;
+
+/**
+ * @brief Register groups read from an actuator
+ *
+ * Each group is a single Modbus transaction and is polled at its own rate.
+ */
+typedef enum {
+    ACTUATOR_GROUP_MOTION = 0,  // Position, current, voltage, moving
+    ACTUATOR_GROUP_DIAG,        // Hardware error state
+    ACTUATOR_GROUP_INFO,        // Model, firmware, limits (EEPROM)
+    ACTUATOR_GROUP_COUNT,
+} actuator_group_t;
+
+/**
+ * @brief Cached actuator state (copy of the registry hot state for one slot)
+ */
+typedef struct {
+    uint8_t bus;                // Bus index
+    uint8_t id;                 // Slave ID
+    bool connected;             // Last status read succeeded
+    uint16_t position;          // Present position
+    uint16_t current;           // Present current (mA)
+    uint16_t motor_op;          // Motor operating rate
+    uint16_t voltage;           // Present voltage (0.1V units)
+    uint8_t moving;             // Moving status
+    int64_t updated_us;         // esp_timer timestamp of last successful read (0 = never)
+    actuator_health_t health;   // Circuit breaker state
+    uint8_t failures;           // Consecutive failed reads
+    int64_t next_probe_us;      // esp_timer timestamp of next probe (quarantined only)
+    uint16_t hw_error;          // Hardware error state (DIAG group)
+    uint16_t model;             // Model number (INFO group, 0 = not read yet)
+    uint16_t firmware;          // Firmware version (INFO group)
+} actuator_state_t;
+
+/**
+ * @brief Initialize the registry
+ *
+ * Actuator handles are created on the Modbus master of their bus, see
+ * bus_manager.h. Adds on a bus that is down fail.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t actuator_registry_init(void);
+
+/**
+ * @brief Register actuators persisted in the configuration
+ *
+ * Each one is probed once (all buses in parallel) so that absent actuators
+ * start out quarantined.
+ */
+void actuator_registry_load_saved(void);
+
+/**
+ * @brief Register an actuator (idempotent)
+ *
+ * @param bus Bus index
+ * @param id Slave ID (1-247)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the registry is full,
+ *         ESP_ERR_INVALID_STATE if the bus is down
+ */
+esp_err_t actuator_registry_add(uint8_t bus, uint8_t id);
+
+/**
+ * @brief Unregister an actuator (idempotent)
+ *
+ * @param bus Bus index
+ * @param id Slave ID (1-247)
+ */
+void actuator_registry_remove(uint8_t bus, uint8_t id);
+
+/**
+ * @brief Get the number of registered actuators
+ */
+uint8_t actuator_registry_count(void);
+
+/**
+ * @brief Get the slot of an actuator
+ *
+ * @param bus Bus index
+ * @param id Slave ID
+ * @return int Slot index, or -1 if not registered
+ */
+int actuator_registry_find(uint8_t bus, uint8_t id);
+
+/**
+ * @brief Get the actuator handle for an address
+ *
+ * The handle stays valid while the bus is locked (bus_manager_lock()).
+ *
+ * @param bus Bus index
+ * @param id Slave ID
+ * @return mightyzap_handle_t Handle, or NULL if not registered
+ */
+mightyzap_handle_t actuator_registry_get(uint8_t bus, uint8_t id);
+
+/**
+ * @brief Get the bus of the actuator stored in a slot
+ */
+uint8_t actuator_registry_bus_at(uint8_t slot);
+
+/**
+ * @brief Get the slave ID stored in a slot
+ */
+uint8_t actuator_registry_id_at(uint8_t slot);
+
+/**
+ * @brief Lock the registry
+ *
+ * Slots are only stable while the lock is held: removing an actuator moves
+ * the last slot into the freed one. Take the lock around any loop over
+ * slots. The lock is recursive and is never held during bus transactions;
+ * when both are needed, take the bus lock first.
+ */
+void actuator_registry_lock(void);
+
+/**
+ * @brief Unlock the registry
+ */
+void actuator_registry_unlock(void);
+
+/**
+ * @brief Check whether a slot should be read from the bus now
+ *
+ * @param slot Slot index
+ * @param now_us Current esp_timer time
+ * @return true if the actuator is not quarantined or its probe is due
+ */
+bool actuator_registry_poll_due(uint8_t slot, int64_t now_us);
+
+/**
+ * @brief Read a register group from an actuator and cache it
+ *
+ * Quarantined actuators are only read when their probe is due. The result
+ * updates the actuator's health. Takes the bus lock for the duration of
+ * the transaction; must be called without the registry lock held.
+ *
+ * @param bus Bus index
+ * @param id Slave ID
+ * @param group Register group
+ * @return esp_err_t Result of the bus transaction, ESP_ERR_NOT_FOUND if not
+ *         registered, ESP_ERR_INVALID_STATE if the actuator is quarantined
+ *         and was not probed
+ */
+esp_err_t actuator_registry_read(uint8_t bus, uint8_t id, actuator_group_t group);
+
+/**
+ * @brief Get the time a register group of a slot is next due for polling
+ *
+ * @param slot Slot index
+ * @param group Register group
+ * @return int64_t esp_timer timestamp (0 = due now)
+ */
+int64_t actuator_registry_get_due(uint8_t slot, actuator_group_t group);
+
+/**
+ * @brief Set the time a register group of a slot is next due for polling
+ */
+void actuator_registry_set_due(uint8_t slot, actuator_group_t group, int64_t due_us);
+
+/**
+ * @brief Treat an actuator as moving until the given time
+ *
+ * Used after a motion command so feedback is polled at the fast rate before
+ * the actuator reports its moving flag.
+ *
+ * @param bus Bus index
+ * @param id Slave ID
+ * @param until_us esp_timer timestamp
+ */
+void actuator_registry_boost(uint8_t bus, uint8_t id, int64_t until_us);
+
+/**
+ * @brief Check whether the actuator in a slot is (about to be) moving
+ *
+ * @param slot Slot index
+ * @param now_us Current esp_timer time
+ * @return true if the cached moving flag is set or a boost is active
+ */
+bool actuator_registry_is_active(uint8_t slot, int64_t now_us);
+
+/**
+ * @brief Read motion status from an actuator and cache it
+ *
+ * Same as actuator_registry_read() with ACTUATOR_GROUP_MOTION.
+ *
+ * @param bus Bus index
+ * @param id Slave ID
+ * @return esp_err_t See actuator_registry_read()
+ */
+esp_err_t actuator_registry_refresh(uint8_t bus, uint8_t id);
+
+/**
+ * @brief Copy the cached state of a slot
+ *
+ * @param slot Slot index
+ * @param state Pointer to store state
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if slot is empty
+ */
+esp_err_t actuator_registry_get_state(uint8_t slot, actuator_state_t *state);
+
+/**
+ * @brief Get the name of a health state
+ */
+const char *actuator_health_name(actuator_health_t health);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACTUATOR_REGISTRY_H
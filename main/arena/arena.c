@@ -0,0 +1,195 @@
+/**
+ * @file arena.c
+ * @brief Bump allocator for request-scoped memory
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "cJSON.h"
+
+#include "memprof.h"
+
+static const char *TAG = "ARENA";
+
+#define ARENA_ALIGN             8
+#define ARENA_JSON_MAX          4       // Arenas that can serve cJSON
+#define ARENA_MAX_BLOCK_DIV     4       // Larger cJSON blocks go to the heap
+
+struct arena {
+    uint8_t *base;
+    size_t size;
+    size_t top;                 // Offset of the first free byte
+    size_t last;                // Offset of the latest block, for rewinding
+    TaskHandle_t owner;         // Task served by the cJSON hooks, NULL when idle
+    arena_stats_t stats;
+};
+
+static arena_handle_t s_json_arenas[ARENA_JSON_MAX];
+static volatile int s_json_count = 0;
+static bool s_hooks_installed = false;
+
+// ============================================================================
+// Allocation
+// ============================================================================
+
+esp_err_t arena_create(size_t size, arena_handle_t *out_handle)
+{
+    if (size == 0 || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct arena *arena = memprof_calloc(MEMPROF_TAG_HTTP, 1, sizeof(struct arena));
+    if (arena == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    size = size & ~(size_t)(ARENA_ALIGN - 1);
+    arena->base = memprof_malloc(MEMPROF_TAG_HTTP, size);
+    if (arena->base == NULL) {
+        memprof_free(MEMPROF_TAG_HTTP, arena);
+        return ESP_ERR_NO_MEM;
+    }
+    arena->size = size;
+    arena->stats.size = size;
+
+    *out_handle = arena;
+    return ESP_OK;
+}
+
+void *arena_alloc(arena_handle_t arena, size_t size)
+{
+    size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (arena == NULL || size == 0 || aligned > arena->size - arena->top) {
+        return NULL;
+    }
+
+    void *ptr = arena->base + arena->top;
+    arena->last = arena->top;
+    arena->top += aligned;
+    arena->stats.allocs++;
+    if (arena->top > arena->stats.high_water) {
+        arena->stats.high_water = arena->top;
+    }
+    return ptr;
+}
+
+void arena_free(arena_handle_t arena, void *ptr)
+{
+    if (arena != NULL && ptr == arena->base + arena->last && arena->last < arena->top) {
+        arena->top = arena->last;
+    }
+}
+
+bool arena_contains(arena_handle_t arena, const void *ptr)
+{
+    return arena != NULL && (const uint8_t *)ptr >= arena->base &&
+           (const uint8_t *)ptr < arena->base + arena->size;
+}
+
+void arena_reset(arena_handle_t arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    arena->top = 0;
+    arena->last = 0;
+    arena->stats.resets++;
+}
+
+void arena_get_stats(arena_handle_t arena, arena_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (arena == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = arena->stats;
+    stats->used = arena->top;
+}
+
+// ============================================================================
+// cJSON hooks
+// ============================================================================
+
+static void *json_malloc(size_t size)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < s_json_count; i++) {
+        arena_handle_t arena = s_json_arenas[i];
+        if (arena->owner != self) {
+            continue;
+        }
+        void *ptr = size <= arena->size / ARENA_MAX_BLOCK_DIV ? arena_alloc(arena, size) : NULL;
+        if (ptr != NULL) {
+            return ptr;
+        }
+        arena->stats.overflows++;
+        arena->stats.overflow_bytes += size;
+        break;
+    }
+    return memprof_malloc(MEMPROF_TAG_JSON, size);
+}
+
+static void json_free(void *ptr)
+{
+    // Blocks of any arena, whichever task frees them, are never heap blocks
+    for (int i = 0; i < s_json_count; i++) {
+        if (arena_contains(s_json_arenas[i], ptr)) {
+            arena_free(s_json_arenas[i], ptr);
+            return;
+        }
+    }
+    memprof_free(MEMPROF_TAG_JSON, ptr);
+}
+
+esp_err_t arena_json_begin(arena_handle_t arena)
+{
+    if (arena == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (arena->owner != NULL && arena->owner != self) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int i = 0;
+    while (i < s_json_count && s_json_arenas[i] != arena) {
+        i++;
+    }
+    if (i == s_json_count) {
+        if (s_json_count == ARENA_JSON_MAX) {
+            return ESP_ERR_NO_MEM;
+        }
+        s_json_arenas[i] = arena;
+        s_json_count = i + 1;       // Published after the slot is written
+    }
+
+    if (!s_hooks_installed) {
+        // Blocks allocated through the previous (memprof) hooks are freed
+        // through memprof by these ones, so switching is safe at any time
+        cJSON_Hooks hooks = {
+            .malloc_fn = json_malloc,
+            .free_fn = json_free,
+        };
+        cJSON_InitHooks(&hooks);
+        s_hooks_installed = true;
+        ESP_LOGI(TAG, "cJSON served from %u-byte arenas", (unsigned)arena->size);
+    }
+
+    arena->owner = self;
+    return ESP_OK;
+}
+
+void arena_json_end(arena_handle_t arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    arena->owner = NULL;
+    arena_reset(arena);
+}
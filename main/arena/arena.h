@@ -0,0 +1,117 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator for request-scoped memory
+ *
+ * An arena hands out memory by advancing a pointer in one preallocated
+ * block and releases everything at once with arena_reset(). Freeing a
+ * single block is a no-op, except for the latest one, which is rewound.
+ *
+ * Between arena_json_begin() and arena_json_end() the cJSON allocations of
+ * the calling task are served from the arena; other tasks keep using the
+ * heap. Allocations larger than a quarter of the arena, or that do not fit,
+ * fall back to the heap and are counted as overflows. Anything allocated
+ * from the arena must be released before arena_json_end(): the memory is
+ * reused by the next request.
+ *
+ * An arena is not thread-safe: only the task that bound it may allocate.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct arena *arena_handle_t;
+
+/**
+ * @brief Arena usage
+ */
+typedef struct {
+    uint32_t size;
+    uint32_t used;              // Bytes in use now
+    uint32_t high_water;        // Most bytes used between two resets
+    uint32_t resets;            // Requests served
+    uint32_t allocs;            // Blocks served from the arena
+    uint32_t overflows;         // Blocks that fell back to the heap
+    uint32_t overflow_bytes;
+} arena_stats_t;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Create an arena
+ *
+ * @param size Bytes available to the arena
+ * @param out_handle Pointer to store the arena handle
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the block cannot be allocated
+ */
+esp_err_t arena_create(size_t size, arena_handle_t *out_handle);
+
+/**
+ * @brief Allocate from an arena (8-byte aligned)
+ *
+ * @param arena Arena
+ * @param size Bytes
+ * @return void* Block, NULL if it does not fit
+ */
+void *arena_alloc(arena_handle_t arena, size_t size);
+
+/**
+ * @brief Release a block (only the latest block is actually reclaimed)
+ *
+ * @param arena Arena
+ * @param ptr Block allocated from the arena
+ */
+void arena_free(arena_handle_t arena, void *ptr);
+
+/**
+ * @brief Check whether a pointer lies in an arena
+ */
+bool arena_contains(arena_handle_t arena, const void *ptr);
+
+/**
+ * @brief Release every block of an arena
+ */
+void arena_reset(arena_handle_t arena);
+
+/**
+ * @brief Get the usage of an arena
+ *
+ * @param arena Arena
+ * @param stats Pointer to store the usage
+ */
+void arena_get_stats(arena_handle_t arena, arena_stats_t *stats);
+
+/**
+ * @brief Serve the cJSON allocations of the calling task from an arena
+ *
+ * Installs the cJSON hooks on the first call; blocks that do not come from
+ * an arena go through memprof (MEMPROF_TAG_JSON).
+ *
+ * @param arena Arena, not bound to another task
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if the arena is
+ *         in use by another task, ESP_ERR_NO_MEM if too many arenas are bound
+ */
+esp_err_t arena_json_begin(arena_handle_t arena);
+
+/**
+ * @brief Stop serving cJSON from an arena and reset it
+ *
+ * @param arena Arena bound by arena_json_begin()
+ */
+void arena_json_end(arena_handle_t arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARENA_H
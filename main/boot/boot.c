@@ -0,0 +1,206 @@
+/**
+ * @file boot.c
+ * @brief Boot orchestrator with dependency-ordered, parallel phases
+ */
+
+#include "boot.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "BOOT";
+
+#define BOOT_DEFAULT_STACK      4096
+
+static const boot_phase_t *s_phases = NULL;
+static size_t s_count = 0;
+static boot_phase_info_t s_info[BOOT_MAX_PHASES];
+
+static EventGroupHandle_t s_done = NULL;    // One bit per finished phase
+static uint32_t s_blocked = 0;              // Phases whose dependents must be skipped
+static uint32_t s_ok = 0;                   // Phases that succeeded
+static size_t s_finished = 0;
+static int64_t s_start_us = 0;
+static int64_t s_end_us = 0;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// Phase task
+// ============================================================================
+
+static void finish_phase(size_t index, boot_state_t state, esp_err_t result)
+{
+    const boot_phase_t *phase = &s_phases[index];
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_mux);
+    s_info[index].state = state;
+    s_info[index].result = result;
+    s_info[index].end_us = now;
+    if (state == BOOT_PHASE_DONE) {
+        s_ok |= BOOT_DEP(index);
+    } else if (state == BOOT_PHASE_SKIPPED || !phase->optional) {
+        // A skipped phase blocks its dependents too, optional or not
+        s_blocked |= BOOT_DEP(index);
+    }
+    if (++s_finished == s_count) {
+        s_end_us = now;
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    // Published after the state, so waiters see it
+    xEventGroupSetBits(s_done, BOOT_DEP(index));
+}
+
+static void phase_task(void *arg)
+{
+    size_t index = (size_t)(uintptr_t)arg;
+    const boot_phase_t *phase = &s_phases[index];
+
+    if (phase->deps != 0) {
+        xEventGroupWaitBits(s_done, phase->deps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    portENTER_CRITICAL(&s_mux);
+    uint32_t blocked = s_blocked & phase->deps;
+    portEXIT_CRITICAL(&s_mux);
+
+    if (blocked != 0) {
+        ESP_LOGW(TAG, "%s skipped: a required phase failed", phase->name);
+        finish_phase(index, BOOT_PHASE_SKIPPED, ESP_ERR_INVALID_STATE);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    portENTER_CRITICAL(&s_mux);
+    s_info[index].state = BOOT_PHASE_RUNNING;
+    s_info[index].start_us = start;
+    portEXIT_CRITICAL(&s_mux);
+
+    esp_err_t ret = phase->run();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s ready in %lld ms", phase->name,
+                 (esp_timer_get_time() - start) / 1000);
+    } else if (phase->optional) {
+        ESP_LOGW(TAG, "%s failed: %s", phase->name, esp_err_to_name(ret));
+    } else {
+        ESP_LOGE(TAG, "%s failed: %s", phase->name, esp_err_to_name(ret));
+    }
+    finish_phase(index, ret == ESP_OK ? BOOT_PHASE_DONE : BOOT_PHASE_FAILED, ret);
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t boot_start(const boot_phase_t *phases, size_t count)
+{
+    if (phases == NULL || count == 0 || count > BOOT_MAX_PHASES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_phases != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        // Only earlier phases: the graph cannot have cycles
+        if (phases[i].run == NULL || (phases[i].deps >> i) != 0) {
+            ESP_LOGE(TAG, "Phase %u (%s) has invalid dependencies", (unsigned)i,
+                     phases[i].name ? phases[i].name : "?");
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    s_done = xEventGroupCreate();
+    if (s_done == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_start_us = esp_timer_get_time();
+    s_phases = phases;
+    s_count = count;
+    for (size_t i = 0; i < count; i++) {
+        s_info[i] = (boot_phase_info_t) {
+            .name = phases[i].name,
+            .deps = phases[i].deps,
+            .state = BOOT_PHASE_WAITING,
+            .result = ESP_OK,
+        };
+    }
+
+    // Phases run at the caller's priority; the scheduler interleaves them
+    // whenever one blocks on I/O
+    UBaseType_t prio = uxTaskPriorityGet(NULL);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t stack = phases[i].stack ? phases[i].stack : BOOT_DEFAULT_STACK;
+        if (xTaskCreate(phase_task, phases[i].name, stack, (void *)(uintptr_t)i,
+                        prio, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create task of phase %s", phases[i].name);
+            finish_phase(i, BOOT_PHASE_FAILED, ESP_ERR_NO_MEM);
+        }
+    }
+
+    ESP_LOGI(TAG, "Started %u boot phases", (unsigned)count);
+    return ESP_OK;
+}
+
+esp_err_t boot_wait(uint32_t deps, TickType_t timeout)
+{
+    if (s_done == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t all = (uint32_t)(BOOT_DEP(s_count) - 1);
+    deps = deps ? deps & all : all;
+
+    EventBits_t bits = xEventGroupWaitBits(s_done, deps, pdFALSE, pdTRUE, timeout);
+    if ((bits & deps) != deps) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    portENTER_CRITICAL(&s_mux);
+    uint32_t ok = s_ok & deps;
+    portEXIT_CRITICAL(&s_mux);
+    return ok == deps ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t boot_get_phase(size_t index, boot_phase_info_t *info)
+{
+    if (index >= s_count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_mux);
+    *info = s_info[index];
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+void boot_get_times(int64_t *start_us, int64_t *end_us)
+{
+    portENTER_CRITICAL(&s_mux);
+    if (start_us != NULL) {
+        *start_us = s_start_us;
+    }
+    if (end_us != NULL) {
+        *end_us = s_end_us;
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+
+const char *boot_state_name(boot_state_t state)
+{
+    switch (state) {
+    case BOOT_PHASE_WAITING: return "waiting";
+    case BOOT_PHASE_RUNNING: return "running";
+    case BOOT_PHASE_DONE:    return "done";
+    case BOOT_PHASE_FAILED:  return "failed";
+    case BOOT_PHASE_SKIPPED: return "skipped";
+    default:                 return "unknown";
+    }
+}
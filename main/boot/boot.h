@@ -0,0 +1,117 @@
+/**
+ * @file boot.h
+ * @brief Boot orchestrator with dependency-ordered, parallel phases
+ *
+ * Each phase declares the phases it waits for. boot_start() gives every
+ * phase its own short-lived task, which blocks on an event group until its
+ * dependencies have finished, runs the phase and sets its own bit. Phases
+ * without a dependency between them run in parallel: the bus stack does
+ * not wait for WiFi association, nothing waits on fixed delays.
+ *
+ * A phase that fails skips the phases depending on it, unless it is
+ * marked optional. The time each phase started and ended is
+ * kept and exported by GET /api/boot.
+ */
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_MAX_PHASES         16
+#define BOOT_DEP(id)            (1u << (id))
+
+/**
+ * @brief Phase description
+ */
+typedef struct {
+    const char *name;
+    esp_err_t (*run)(void);
+    uint32_t deps;              // BOOT_DEP() of the phases to wait for (earlier entries only)
+    bool optional;              // Dependents still run when this phase fails
+    uint32_t stack;             // Task stack (0 = 4096)
+} boot_phase_t;
+
+/**
+ * @brief Phase state
+ */
+typedef enum {
+    BOOT_PHASE_WAITING = 0,     // Dependencies not finished
+    BOOT_PHASE_RUNNING,
+    BOOT_PHASE_DONE,
+    BOOT_PHASE_FAILED,
+    BOOT_PHASE_SKIPPED,         // A required dependency failed
+} boot_state_t;
+
+/**
+ * @brief Boot profile of one phase (times in µs since reset)
+ */
+typedef struct {
+    const char *name;
+    uint32_t deps;
+    boot_state_t state;
+    esp_err_t result;
+    int64_t start_us;           // Dependencies finished, phase started
+    int64_t end_us;
+} boot_phase_info_t;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Start all phases
+ *
+ * @param phases Phase table, kept by reference (must stay valid)
+ * @param count Number of phases (at most BOOT_MAX_PHASES)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if a phase
+ *         depends on itself or a later phase, ESP_ERR_NO_MEM if a task
+ *         cannot be created
+ */
+esp_err_t boot_start(const boot_phase_t *phases, size_t count);
+
+/**
+ * @brief Wait until phases have finished (done, failed or skipped)
+ *
+ * @param deps BOOT_DEP() of the phases to wait for, 0 for all
+ * @param timeout Maximum time to wait
+ * @return esp_err_t ESP_OK if they all succeeded, ESP_FAIL if one failed or
+ *         was skipped, ESP_ERR_TIMEOUT
+ */
+esp_err_t boot_wait(uint32_t deps, TickType_t timeout);
+
+/**
+ * @brief Get the profile of one phase
+ *
+ * @param index Phase index
+ * @param info Pointer to store the profile
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND past the last phase
+ */
+esp_err_t boot_get_phase(size_t index, boot_phase_info_t *info);
+
+/**
+ * @brief Time boot_start() was called and all phases had finished
+ *
+ * @param start_us Pointer to store the start (µs since reset)
+ * @param end_us Pointer to store the end, 0 while phases are still running
+ */
+void boot_get_times(int64_t *start_us, int64_t *end_us);
+
+/**
+ * @brief Name of a phase state
+ */
+const char *boot_state_name(boot_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_H
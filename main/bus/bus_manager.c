@@ -0,0 +1,227 @@
+/**
+ * @file bus_manager.c
+ * @brief RS485/Modbus bus instances
+ */
+
+#include "bus_manager.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "BUS";
+
+#define BUS_JOB_STACK       4096
+#define BUS_JOB_PRIORITY    (tskIDLE_PRIORITY + 5)
+
+/**
+ * @brief Bus instance
+ */
+typedef struct {
+    rs485_handle_t rs485;
+    modbus_handle_t modbus;
+    SemaphoreHandle_t lock;
+    uint8_t uart;
+    int core;
+} bus_t;
+
+static bus_t s_buses[BUS_MAX];
+static uint8_t s_bus_count = 0;
+
+// ============================================================================
+// Init
+// ============================================================================
+
+static esp_err_t bus_start(uint8_t index, const config_rs485_bus_t *cfg, uint32_t timeout_ms)
+{
+    bus_t *bus = &s_buses[index];
+
+    ESP_LOGI(TAG, "Bus %d: UART%d, TX=%d, RX=%d, DE=%d, Baud=%lu",
+             index, cfg->uart, cfg->tx_pin, cfg->rx_pin, cfg->de_pin, cfg->baud);
+
+    rs485_config_t rs485_cfg = {
+        .uart_num = cfg->uart,
+        .tx_pin = cfg->tx_pin,
+        .rx_pin = cfg->rx_pin,
+        .de_pin = cfg->de_pin,
+        .baud_rate = cfg->baud,
+        .rx_buffer_size = 256,
+        .tx_buffer_size = 256,
+    };
+
+    esp_err_t ret = rs485_init(&rs485_cfg, &bus->rs485);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Bus %d: failed to initialize RS485: %s", index, esp_err_to_name(ret));
+        bus->rs485 = NULL;
+        return ret;
+    }
+
+    modbus_config_t modbus_cfg = {
+        .rs485 = bus->rs485,
+        .response_timeout = timeout_ms,
+    };
+
+    ret = modbus_init(&modbus_cfg, &bus->modbus);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Bus %d: failed to initialize Modbus: %s", index, esp_err_to_name(ret));
+        rs485_deinit(bus->rs485);
+        bus->rs485 = NULL;
+        bus->modbus = NULL;
+        return ret;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t bus_manager_init(uint32_t response_timeout_ms)
+{
+    uint8_t count = config_get_rs485_bus_count();
+    uint8_t up = 0;
+    uint8_t uarts_used = 0;
+
+    memset(s_buses, 0, sizeof(s_buses));
+    s_bus_count = count > BUS_MAX ? BUS_MAX : count;
+
+    for (uint8_t i = 0; i < s_bus_count; i++) {
+        bus_t *bus = &s_buses[i];
+        config_rs485_bus_t cfg;
+
+        // Spread buses over the cores, starting with the application core
+        bus->core = (i + 1) % portNUM_PROCESSORS;
+        bus->lock = xSemaphoreCreateRecursiveMutex();
+        if (bus->lock == NULL) {
+            ESP_LOGE(TAG, "Bus %d: failed to create lock", i);
+            continue;
+        }
+
+        if (config_get_rs485_bus(i, &cfg) != ESP_OK) {
+            continue;
+        }
+        bus->uart = cfg.uart;
+
+        // UART0 is the console
+        if (cfg.uart < 1 || cfg.uart >= UART_NUM_MAX || (uarts_used & (1 << cfg.uart))) {
+            ESP_LOGE(TAG, "Bus %d: UART%d invalid or already in use", i, cfg.uart);
+            continue;
+        }
+
+        if (bus_start(i, &cfg, response_timeout_ms) == ESP_OK) {
+            uarts_used |= 1 << cfg.uart;
+            up++;
+        }
+    }
+
+    ESP_LOGI(TAG, "%d of %d buses up", up, s_bus_count);
+    return up > 0 ? ESP_OK : ESP_FAIL;
+}
+
+// ============================================================================
+// Accessors
+// ============================================================================
+
+uint8_t bus_manager_count(void)
+{
+    return s_bus_count;
+}
+
+bool bus_manager_is_up(uint8_t bus)
+{
+    return bus < s_bus_count && s_buses[bus].modbus != NULL;
+}
+
+int bus_manager_get_uart(uint8_t bus)
+{
+    return bus < s_bus_count ? s_buses[bus].uart : -1;
+}
+
+int bus_manager_get_core(uint8_t bus)
+{
+    return bus < s_bus_count ? s_buses[bus].core : 0;
+}
+
+rs485_handle_t bus_manager_get_rs485(uint8_t bus)
+{
+    return bus < s_bus_count ? s_buses[bus].rs485 : NULL;
+}
+
+modbus_handle_t bus_manager_get_modbus(uint8_t bus)
+{
+    return bus < s_bus_count ? s_buses[bus].modbus : NULL;
+}
+
+void bus_manager_lock(uint8_t bus)
+{
+    if (bus < s_bus_count && s_buses[bus].lock) {
+        xSemaphoreTakeRecursive(s_buses[bus].lock, portMAX_DELAY);
+    }
+}
+
+void bus_manager_unlock(uint8_t bus)
+{
+    if (bus < s_bus_count && s_buses[bus].lock) {
+        xSemaphoreGiveRecursive(s_buses[bus].lock);
+    }
+}
+
+// ============================================================================
+// Parallel jobs
+// ============================================================================
+
+typedef struct {
+    bus_job_fn_t fn;
+    void *arg;
+    uint8_t bus;
+    SemaphoreHandle_t done;
+} bus_job_t;
+
+static void bus_job_task(void *param)
+{
+    bus_job_t *job = param;
+    job->fn(job->bus, job->arg);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t bus_manager_run_parallel(bus_job_fn_t fn, void *arg)
+{
+    if (fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(BUS_MAX, 0);
+    if (done == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Jobs live on this stack; it is only left once they have all finished
+    bus_job_t jobs[BUS_MAX];
+    int started = 0;
+
+    for (uint8_t i = 0; i < s_bus_count; i++) {
+        if (!bus_manager_is_up(i)) {
+            continue;
+        }
+
+        jobs[i] = (bus_job_t){ .fn = fn, .arg = arg, .bus = i, .done = done };
+
+        char name[16];
+        snprintf(name, sizeof(name), "bus%d_job", i);
+        if (xTaskCreatePinnedToCore(bus_job_task, name, BUS_JOB_STACK, &jobs[i],
+                                    BUS_JOB_PRIORITY, NULL, s_buses[i].core) == pdPASS) {
+            started++;
+        } else {
+            // Run inline rather than skip the bus
+            ESP_LOGW(TAG, "Bus %d: failed to start job task, running inline", i);
+            fn(i, arg);
+        }
+    }
+
+    for (int i = 0; i < started; i++) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+
+    vSemaphoreDelete(done);
+    return ESP_OK;
+}
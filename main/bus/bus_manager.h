@@ -0,0 +1,106 @@
+/**
+ * @file bus_manager.h
+ * @brief RS485/Modbus bus instances
+ *
+ * Creates one RS485 driver and Modbus master per bus configured in
+ * config.json. Buses are independent: each has its own UART, transaction
+ * lock and worker tasks, pinned to the bus's core, so traffic on one bus
+ * never waits for another.
+ */
+
+#ifndef BUS_MANAGER_H
+#define BUS_MANAGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "rs485_driver.h"
+#include "modbus_rtu.h"
+#include "config_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUS_MAX     MAX_RS485_BUSES
+
+/**
+ * @brief Job run on every bus by bus_manager_run_parallel()
+ *
+ * @param bus Bus index
+ * @param arg User argument
+ */
+typedef void (*bus_job_fn_t)(uint8_t bus, void *arg);
+
+/**
+ * @brief Bring up all configured buses
+ *
+ * A bus that fails to start is logged and left down; the others still
+ * start.
+ *
+ * @param response_timeout_ms Maximum Modbus response timeout
+ * @return esp_err_t ESP_OK if at least one bus is up
+ */
+esp_err_t bus_manager_init(uint32_t response_timeout_ms);
+
+/**
+ * @brief Get the number of configured buses (up or down)
+ */
+uint8_t bus_manager_count(void);
+
+/**
+ * @brief Check whether a bus is up
+ */
+bool bus_manager_is_up(uint8_t bus);
+
+/**
+ * @brief Get the UART port of a bus
+ */
+int bus_manager_get_uart(uint8_t bus);
+
+/**
+ * @brief Get the core that runs a bus's tasks
+ */
+int bus_manager_get_core(uint8_t bus);
+
+/**
+ * @brief Get the RS485 handle of a bus (NULL if down)
+ */
+rs485_handle_t bus_manager_get_rs485(uint8_t bus);
+
+/**
+ * @brief Get the Modbus handle of a bus (NULL if down)
+ */
+modbus_handle_t bus_manager_get_modbus(uint8_t bus);
+
+/**
+ * @brief Take exclusive use of a bus's devices (recursive)
+ *
+ * Held across a read or command sequence on an actuator of the bus so that
+ * the actuator can not be removed meanwhile. Individual Modbus transactions
+ * are serialized by the RS485 driver on their own.
+ */
+void bus_manager_lock(uint8_t bus);
+
+/**
+ * @brief Release a bus taken with bus_manager_lock()
+ */
+void bus_manager_unlock(uint8_t bus);
+
+/**
+ * @brief Run a job on all buses that are up, in parallel
+ *
+ * One task per bus is started on the bus's core; the call returns once
+ * every job has finished.
+ *
+ * @param fn Job function
+ * @param arg User argument passed to every job
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t bus_manager_run_parallel(bus_job_fn_t fn, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BUS_MANAGER_H
@@ -4,6 +4,7 @@
 #include "esp_log.h"
 #include "esp_littlefs.h"
 #include "cJSON.h"
+#include "memprof.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
@@ -23,19 +24,20 @@ typedef struct {
     char ap_ssid[32];
     char ap_password[64];
 
-    // RS485
-    uint32_t rs485_baud;
-    uint8_t rs485_tx_pin;
-    uint8_t rs485_rx_pin;
-    uint8_t rs485_de_pin;
+    // RS485 (bus 0 is the "rs485" section)
+    config_rs485_bus_t rs485[MAX_RS485_BUSES];
+    uint8_t rs485_bus_count;
 
     // Modbus
     uint8_t modbus_slave_id;
     uint32_t modbus_timeout;
+    config_rtu_slave_t rtu_slave;
+    config_udp_control_t udp_control;
 
     // Actuator
     uint8_t scan_max_id;
     uint8_t saved_actuator_ids[MAX_SAVED_ACTUATORS];
+    uint8_t saved_actuator_buses[MAX_SAVED_ACTUATORS];
     char saved_actuator_names[MAX_SAVED_ACTUATORS][32];
     uint8_t saved_actuator_count;
 
@@ -48,6 +50,37 @@ typedef struct {
 static config_t s_config;
 static bool s_initialized = false;
 
+// Saved actuator lookup: (bus, ID) -> index + 1 in saved_actuator_ids (0 = not saved)
+static uint8_t s_saved_index[MAX_RS485_BUSES][256];
+
+static void rebuild_saved_index(void)
+{
+    memset(s_saved_index, 0, sizeof(s_saved_index));
+    for (int i = 0; i < s_config.saved_actuator_count; i++) {
+        s_saved_index[s_config.saved_actuator_buses[i]][s_config.saved_actuator_ids[i]] = i + 1;
+    }
+}
+
+static void parse_rs485_bus(const cJSON *obj, config_rs485_bus_t *bus)
+{
+    cJSON *item;
+    if ((item = cJSON_GetObjectItem(obj, "uart")) && cJSON_IsNumber(item)) {
+        bus->uart = item->valueint;
+    }
+    if ((item = cJSON_GetObjectItem(obj, "baud")) && cJSON_IsNumber(item)) {
+        bus->baud = item->valueint;
+    }
+    if ((item = cJSON_GetObjectItem(obj, "tx_pin")) && cJSON_IsNumber(item)) {
+        bus->tx_pin = item->valueint;
+    }
+    if ((item = cJSON_GetObjectItem(obj, "rx_pin")) && cJSON_IsNumber(item)) {
+        bus->rx_pin = item->valueint;
+    }
+    if ((item = cJSON_GetObjectItem(obj, "de_pin")) && cJSON_IsNumber(item)) {
+        bus->de_pin = item->valueint;
+    }
+}
+
 // ============================================================================
 // LittleFS Setup
 // ============================================================================
@@ -99,18 +132,30 @@ void config_reset_defaults(void)
     strcpy(s_config.ap_ssid, "Bocal-Dinamico");
     strcpy(s_config.ap_password, "12345678");
 
-    // RS485 defaults (safe pins, 57600 for mightyZAP)
-    s_config.rs485_baud = 57600;
-    s_config.rs485_tx_pin = 17;
-    s_config.rs485_rx_pin = 5;
-    s_config.rs485_de_pin = 18;
+    // RS485 defaults (safe pins, 57600 for mightyZAP), single bus on UART1
+    s_config.rs485[0].uart = 1;
+    s_config.rs485[0].baud = 57600;
+    s_config.rs485[0].tx_pin = 17;
+    s_config.rs485[0].rx_pin = 5;
+    s_config.rs485[0].de_pin = 18;
+    s_config.rs485_bus_count = 1;
 
     // Modbus defaults
     s_config.modbus_timeout = 100;  // Reduced from 500ms for faster response
+    s_config.rtu_slave.enabled = false;
+    s_config.rtu_slave.slave_id = 1;
+    s_config.rtu_slave.port.uart = 2;
+    s_config.rtu_slave.port.baud = 57600;
+    s_config.rtu_slave.port.tx_pin = 25;
+    s_config.rtu_slave.port.rx_pin = 26;
+    s_config.rtu_slave.port.de_pin = 27;
+    s_config.udp_control.enabled = false;
+    s_config.udp_control.port = 5005;
 
     // Actuator defaults
     s_config.scan_max_id = 3;  // Scan IDs 1-3 by default
     s_config.saved_actuator_count = 0;  // No saved actuators initially
+    rebuild_saved_index();
 
     // Web defaults
     strcpy(s_config.web_username, "admin");
@@ -140,18 +185,51 @@ static esp_err_t _config_save_internal(void)
 
     // RS485 section
     cJSON *rs485 = cJSON_CreateObject();
-    cJSON_AddNumberToObject(rs485, "baud", s_config.rs485_baud);
-    cJSON_AddNumberToObject(rs485, "tx_pin", s_config.rs485_tx_pin);
-    cJSON_AddNumberToObject(rs485, "rx_pin", s_config.rs485_rx_pin);
-    cJSON_AddNumberToObject(rs485, "de_pin", s_config.rs485_de_pin);
+    cJSON_AddNumberToObject(rs485, "baud", s_config.rs485[0].baud);
+    cJSON_AddNumberToObject(rs485, "tx_pin", s_config.rs485[0].tx_pin);
+    cJSON_AddNumberToObject(rs485, "rx_pin", s_config.rs485[0].rx_pin);
+    cJSON_AddNumberToObject(rs485, "de_pin", s_config.rs485[0].de_pin);
     cJSON_AddItemToObject(root, "rs485", rs485);
 
+    // Additional RS485 buses
+    if (s_config.rs485_bus_count > 1) {
+        cJSON *buses = cJSON_CreateArray();
+        for (int i = 1; i < s_config.rs485_bus_count; i++) {
+            cJSON *bus = cJSON_CreateObject();
+            cJSON_AddNumberToObject(bus, "uart", s_config.rs485[i].uart);
+            cJSON_AddNumberToObject(bus, "baud", s_config.rs485[i].baud);
+            cJSON_AddNumberToObject(bus, "tx_pin", s_config.rs485[i].tx_pin);
+            cJSON_AddNumberToObject(bus, "rx_pin", s_config.rs485[i].rx_pin);
+            cJSON_AddNumberToObject(bus, "de_pin", s_config.rs485[i].de_pin);
+            cJSON_AddItemToArray(buses, bus);
+        }
+        cJSON_AddItemToObject(root, "rs485_buses", buses);
+    }
+
     // Modbus section
     cJSON *modbus = cJSON_CreateObject();
     cJSON_AddNumberToObject(modbus, "slave_id", s_config.modbus_slave_id);
     cJSON_AddNumberToObject(modbus, "timeout", s_config.modbus_timeout);
     cJSON_AddItemToObject(root, "modbus", modbus);
 
+    // Modbus RTU slave section
+    cJSON *rtu_slave = cJSON_CreateObject();
+    cJSON_AddBoolToObject(rtu_slave, "enabled", s_config.rtu_slave.enabled);
+    cJSON_AddNumberToObject(rtu_slave, "slave_id", s_config.rtu_slave.slave_id);
+    cJSON_AddNumberToObject(rtu_slave, "uart", s_config.rtu_slave.port.uart);
+    cJSON_AddNumberToObject(rtu_slave, "baud", s_config.rtu_slave.port.baud);
+    cJSON_AddNumberToObject(rtu_slave, "tx_pin", s_config.rtu_slave.port.tx_pin);
+    cJSON_AddNumberToObject(rtu_slave, "rx_pin", s_config.rtu_slave.port.rx_pin);
+    cJSON_AddNumberToObject(rtu_slave, "de_pin", s_config.rtu_slave.port.de_pin);
+    cJSON_AddItemToObject(root, "rtu_slave", rtu_slave);
+
+    // UDP control section
+    cJSON *udp_control = cJSON_CreateObject();
+    cJSON_AddBoolToObject(udp_control, "enabled", s_config.udp_control.enabled);
+    cJSON_AddNumberToObject(udp_control, "port", s_config.udp_control.port);
+    cJSON_AddStringToObject(udp_control, "key", s_config.udp_control.key);
+    cJSON_AddItemToObject(root, "udp_control", udp_control);
+
     // Actuator section
     cJSON *actuator = cJSON_CreateObject();
     cJSON_AddNumberToObject(actuator, "scan_max_id", s_config.scan_max_id);
@@ -161,6 +239,12 @@ static esp_err_t _config_save_internal(void)
         cJSON_AddItemToArray(saved_ids, cJSON_CreateNumber(s_config.saved_actuator_ids[i]));
     }
     cJSON_AddItemToObject(actuator, "saved_ids", saved_ids);
+    // Serialize bus of each saved ID
+    cJSON *saved_buses = cJSON_CreateArray();
+    for (int i = 0; i < s_config.saved_actuator_count; i++) {
+        cJSON_AddItemToArray(saved_buses, cJSON_CreateNumber(s_config.saved_actuator_buses[i]));
+    }
+    cJSON_AddItemToObject(actuator, "saved_buses", saved_buses);
     // Serialize names array
     cJSON *saved_names = cJSON_CreateArray();
     for (int i = 0; i < s_config.saved_actuator_count; i++) {
@@ -185,14 +269,14 @@ static esp_err_t _config_save_internal(void)
 
     FILE *f = fopen(CONFIG_FILE, "w");
     if (f == NULL) {
-        free(json_str);
+        cJSON_free(json_str);
         ESP_LOGE(TAG, "Failed to open config file for writing");
         return ESP_FAIL;
     }
 
     fprintf(f, "%s", json_str);
     fclose(f);
-    free(json_str);
+    cJSON_free(json_str);
 
     ESP_LOGI(TAG, "Configuration saved");
     return ESP_OK;
@@ -219,7 +303,7 @@ esp_err_t config_load(void)
     long fsize = ftell(f);
     fseek(f, 0, SEEK_SET);
 
-    char *json_str = malloc(fsize + 1);
+    char *json_str = memprof_malloc(MEMPROF_TAG_CONFIG, fsize + 1);
     if (json_str == NULL) {
         fclose(f);
         return ESP_ERR_NO_MEM;
@@ -231,7 +315,7 @@ esp_err_t config_load(void)
 
     // Parse JSON
     cJSON *root = cJSON_Parse(json_str);
-    free(json_str);
+    memprof_free(MEMPROF_TAG_CONFIG, json_str);
 
     if (root == NULL) {
         ESP_LOGE(TAG, "Failed to parse config file");
@@ -263,18 +347,25 @@ esp_err_t config_load(void)
     // RS485 section
     cJSON *rs485 = cJSON_GetObjectItem(root, "rs485");
     if (rs485) {
-        cJSON *item;
-        if ((item = cJSON_GetObjectItem(rs485, "baud")) && cJSON_IsNumber(item)) {
-            s_config.rs485_baud = item->valueint;
-        }
-        if ((item = cJSON_GetObjectItem(rs485, "tx_pin")) && cJSON_IsNumber(item)) {
-            s_config.rs485_tx_pin = item->valueint;
-        }
-        if ((item = cJSON_GetObjectItem(rs485, "rx_pin")) && cJSON_IsNumber(item)) {
-            s_config.rs485_rx_pin = item->valueint;
-        }
-        if ((item = cJSON_GetObjectItem(rs485, "de_pin")) && cJSON_IsNumber(item)) {
-            s_config.rs485_de_pin = item->valueint;
+        parse_rs485_bus(rs485, &s_config.rs485[0]);
+        s_config.rs485[0].uart = 1;
+    }
+
+    // Additional RS485 buses (optional)
+    cJSON *rs485_buses = cJSON_GetObjectItem(root, "rs485_buses");
+    if (rs485_buses && cJSON_IsArray(rs485_buses)) {
+        s_config.rs485_bus_count = 1;
+        cJSON *bus;
+        cJSON_ArrayForEach(bus, rs485_buses) {
+            if (s_config.rs485_bus_count >= MAX_RS485_BUSES) {
+                ESP_LOGW(TAG, "Ignoring extra RS485 buses (max %d)", MAX_RS485_BUSES);
+                break;
+            }
+            config_rs485_bus_t *cfg = &s_config.rs485[s_config.rs485_bus_count];
+            *cfg = s_config.rs485[0];
+            cfg->uart = 2;
+            parse_rs485_bus(bus, cfg);
+            s_config.rs485_bus_count++;
         }
     }
 
@@ -290,6 +381,34 @@ esp_err_t config_load(void)
         }
     }
 
+    // Modbus RTU slave section (optional)
+    cJSON *rtu_slave = cJSON_GetObjectItem(root, "rtu_slave");
+    if (rtu_slave) {
+        cJSON *item;
+        if ((item = cJSON_GetObjectItem(rtu_slave, "enabled")) && cJSON_IsBool(item)) {
+            s_config.rtu_slave.enabled = cJSON_IsTrue(item);
+        }
+        if ((item = cJSON_GetObjectItem(rtu_slave, "slave_id")) && cJSON_IsNumber(item)) {
+            s_config.rtu_slave.slave_id = item->valueint;
+        }
+        parse_rs485_bus(rtu_slave, &s_config.rtu_slave.port);
+    }
+
+    // UDP control section (optional)
+    cJSON *udp_control = cJSON_GetObjectItem(root, "udp_control");
+    if (udp_control) {
+        cJSON *item;
+        if ((item = cJSON_GetObjectItem(udp_control, "enabled")) && cJSON_IsBool(item)) {
+            s_config.udp_control.enabled = cJSON_IsTrue(item);
+        }
+        if ((item = cJSON_GetObjectItem(udp_control, "port")) && cJSON_IsNumber(item)) {
+            s_config.udp_control.port = item->valueint;
+        }
+        if ((item = cJSON_GetObjectItem(udp_control, "key")) && cJSON_IsString(item)) {
+            strncpy(s_config.udp_control.key, item->valuestring, sizeof(s_config.udp_control.key) - 1);
+        }
+    }
+
     // Actuator section
     cJSON *actuator = cJSON_GetObjectItem(root, "actuator");
     if (actuator) {
@@ -300,15 +419,28 @@ esp_err_t config_load(void)
         // Parse saved_ids array
         cJSON *saved_ids = cJSON_GetObjectItem(actuator, "saved_ids");
         if (saved_ids && cJSON_IsArray(saved_ids)) {
+            // Bus of each ID (optional, defaults to bus 0)
+            cJSON *saved_buses = cJSON_GetObjectItem(actuator, "saved_buses");
+            if (saved_buses && !cJSON_IsArray(saved_buses)) {
+                saved_buses = NULL;
+            }
+
             s_config.saved_actuator_count = 0;
             int array_size = cJSON_GetArraySize(saved_ids);
             for (int i = 0; i < array_size && i < MAX_SAVED_ACTUATORS; i++) {
                 cJSON *id_item = cJSON_GetArrayItem(saved_ids, i);
                 if (id_item && cJSON_IsNumber(id_item)) {
+                    cJSON *bus_item = saved_buses ? cJSON_GetArrayItem(saved_buses, i) : NULL;
+                    uint8_t bus = cJSON_IsNumber(bus_item) ? (uint8_t)bus_item->valueint : 0;
+                    if (bus >= MAX_RS485_BUSES) {
+                        bus = 0;
+                    }
                     s_config.saved_actuator_ids[s_config.saved_actuator_count] = (uint8_t)id_item->valueint;
+                    s_config.saved_actuator_buses[s_config.saved_actuator_count] = bus;
                     s_config.saved_actuator_count++;
                 }
             }
+            rebuild_saved_index();
             ESP_LOGI(TAG, "Loaded %d saved actuator IDs", s_config.saved_actuator_count);
         }
         // Parse names array (optional, for backward compatibility)
@@ -434,19 +566,30 @@ void config_set_ap_password(const char *password) {
 // Getters - RS485
 // ============================================================================
 
-uint32_t config_get_rs485_baud(void) { return s_config.rs485_baud; }
-uint8_t config_get_rs485_tx_pin(void) { return s_config.rs485_tx_pin; }
-uint8_t config_get_rs485_rx_pin(void) { return s_config.rs485_rx_pin; }
-uint8_t config_get_rs485_de_pin(void) { return s_config.rs485_de_pin; }
+uint8_t config_get_rs485_bus_count(void) { return s_config.rs485_bus_count; }
+
+esp_err_t config_get_rs485_bus(uint8_t bus, config_rs485_bus_t *cfg)
+{
+    if (cfg == NULL || bus >= s_config.rs485_bus_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *cfg = s_config.rs485[bus];
+    return ESP_OK;
+}
+
+uint32_t config_get_rs485_baud(void) { return s_config.rs485[0].baud; }
+uint8_t config_get_rs485_tx_pin(void) { return s_config.rs485[0].tx_pin; }
+uint8_t config_get_rs485_rx_pin(void) { return s_config.rs485[0].rx_pin; }
+uint8_t config_get_rs485_de_pin(void) { return s_config.rs485[0].de_pin; }
 
 // ============================================================================
 // Setters - RS485
 // ============================================================================
 
-void config_set_rs485_baud(uint32_t baud) { s_config.rs485_baud = baud; }
-void config_set_rs485_tx_pin(uint8_t pin) { s_config.rs485_tx_pin = pin; }
-void config_set_rs485_rx_pin(uint8_t pin) { s_config.rs485_rx_pin = pin; }
-void config_set_rs485_de_pin(uint8_t pin) { s_config.rs485_de_pin = pin; }
+void config_set_rs485_baud(uint32_t baud) { s_config.rs485[0].baud = baud; }
+void config_set_rs485_tx_pin(uint8_t pin) { s_config.rs485[0].tx_pin = pin; }
+void config_set_rs485_rx_pin(uint8_t pin) { s_config.rs485[0].rx_pin = pin; }
+void config_set_rs485_de_pin(uint8_t pin) { s_config.rs485[0].de_pin = pin; }
 
 // ============================================================================
 // Getters - Modbus
@@ -455,6 +598,16 @@ void config_set_rs485_de_pin(uint8_t pin) { s_config.rs485_de_pin = pin; }
 uint8_t config_get_modbus_slave_id(void) { return s_config.modbus_slave_id; }
 uint32_t config_get_modbus_timeout(void) { return s_config.modbus_timeout; }
 
+void config_get_rtu_slave(config_rtu_slave_t *cfg)
+{
+    if (cfg) *cfg = s_config.rtu_slave;
+}
+
+void config_get_udp_control(config_udp_control_t *cfg)
+{
+    if (cfg) *cfg = s_config.udp_control;
+}
+
 // ============================================================================
 // Setters - Modbus
 // ============================================================================
@@ -478,6 +631,11 @@ const uint8_t* config_get_saved_actuator_ids(void)
     return s_config.saved_actuator_ids;
 }
 
+const uint8_t* config_get_saved_actuator_buses(void)
+{
+    return s_config.saved_actuator_buses;
+}
+
 const char* config_get_saved_actuator_name(uint8_t index)
 {
     if (index >= MAX_SAVED_ACTUATORS) {
@@ -492,14 +650,16 @@ const char* config_get_saved_actuator_name(uint8_t index)
 
 void config_set_scan_max_id(uint8_t max_id) { s_config.scan_max_id = max_id; }
 
-bool config_add_saved_actuator_id(uint8_t id)
+bool config_add_saved_actuator_id(uint8_t bus, uint8_t id)
 {
+    if (bus >= MAX_RS485_BUSES) {
+        return false;
+    }
+
     // Check if already exists
-    for (int i = 0; i < s_config.saved_actuator_count; i++) {
-        if (s_config.saved_actuator_ids[i] == id) {
-            ESP_LOGD(TAG, "Actuator ID %d already saved", id);
-            return true;  // Already exists - success (idempotent)
-        }
+    if (s_saved_index[bus][id] != 0) {
+        ESP_LOGD(TAG, "Actuator ID %d already saved", id);
+        return true;  // Already exists - success (idempotent)
     }
 
     // Check if array is full
@@ -511,25 +671,25 @@ bool config_add_saved_actuator_id(uint8_t id)
 
     // Add to array
     s_config.saved_actuator_ids[s_config.saved_actuator_count] = id;
+    s_config.saved_actuator_buses[s_config.saved_actuator_count] = bus;
     // Initialize name to empty string
     s_config.saved_actuator_names[s_config.saved_actuator_count][0] = '\0';
     s_config.saved_actuator_count++;
-    ESP_LOGI(TAG, "Added actuator ID %d to saved list (count=%d)",
-             id, s_config.saved_actuator_count);
+    s_saved_index[bus][id] = s_config.saved_actuator_count;
+    ESP_LOGI(TAG, "Added actuator %d:%d to saved list (count=%d)",
+             bus, id, s_config.saved_actuator_count);
     return true;
 }
 
-bool config_remove_saved_actuator_id(uint8_t id)
+bool config_remove_saved_actuator_id(uint8_t bus, uint8_t id)
 {
-    // Find the actuator ID in the array
-    int found_index = -1;
-    for (int i = 0; i < s_config.saved_actuator_count; i++) {
-        if (s_config.saved_actuator_ids[i] == id) {
-            found_index = i;
-            break;
-        }
+    if (bus >= MAX_RS485_BUSES) {
+        return true;
     }
 
+    // Find the actuator ID in the array
+    int found_index = s_saved_index[bus][id] - 1;
+
     if (found_index < 0) {
         ESP_LOGD(TAG, "Actuator ID %d not found in saved list", id);
         return true;  // Not found - success (idempotent)
@@ -538,23 +698,27 @@ bool config_remove_saved_actuator_id(uint8_t id)
     // Shift remaining elements down
     for (int i = found_index; i < s_config.saved_actuator_count - 1; i++) {
         s_config.saved_actuator_ids[i] = s_config.saved_actuator_ids[i + 1];
+        s_config.saved_actuator_buses[i] = s_config.saved_actuator_buses[i + 1];
         strncpy(s_config.saved_actuator_names[i], s_config.saved_actuator_names[i + 1],
                 sizeof(s_config.saved_actuator_names[i]));
     }
     // Clear the last entry
     s_config.saved_actuator_names[s_config.saved_actuator_count - 1][0] = '\0';
     s_config.saved_actuator_count--;
+    rebuild_saved_index();
 
-    ESP_LOGI(TAG, "Removed actuator ID %d from saved list (count=%d)",
-             id, s_config.saved_actuator_count);
+    ESP_LOGI(TAG, "Removed actuator %d:%d from saved list (count=%d)",
+             bus, id, s_config.saved_actuator_count);
     return true;
 }
 
 void config_clear_saved_actuators(void)
 {
     memset(s_config.saved_actuator_ids, 0, sizeof(s_config.saved_actuator_ids));
+    memset(s_config.saved_actuator_buses, 0, sizeof(s_config.saved_actuator_buses));
     memset(s_config.saved_actuator_names, 0, sizeof(s_config.saved_actuator_names));
     s_config.saved_actuator_count = 0;
+    rebuild_saved_index();
     ESP_LOGI(TAG, "Cleared all saved actuators");
 }
 
@@ -577,38 +741,38 @@ bool config_set_saved_actuator_name(uint8_t index, const char* name)
     return true;
 }
 
-const char* config_get_actuator_name(uint8_t id)
+const char* config_get_actuator_name(uint8_t bus, uint8_t id)
 {
-    // Find the actuator ID in the saved array
-    for (int i = 0; i < s_config.saved_actuator_count; i++) {
-        if (s_config.saved_actuator_ids[i] == id) {
-            return s_config.saved_actuator_names[i];
-        }
+    if (bus >= MAX_RS485_BUSES) {
+        return "";
+    }
+
+    int i = s_saved_index[bus][id] - 1;
+    if (i >= 0) {
+        return s_config.saved_actuator_names[i];
     }
 
     // ID not found, return empty string
     return "";
 }
 
-bool config_set_actuator_name(uint8_t id, const char *name)
+bool config_set_actuator_name(uint8_t bus, uint8_t id, const char *name)
 {
     if (name == NULL) {
         ESP_LOGW(TAG, "Cannot set actuator name: name is NULL");
         return false;
     }
 
-    // Find the actuator ID in the saved array
-    for (int i = 0; i < s_config.saved_actuator_count; i++) {
-        if (s_config.saved_actuator_ids[i] == id) {
-            strncpy(s_config.saved_actuator_names[i], name, sizeof(s_config.saved_actuator_names[i]) - 1);
-            s_config.saved_actuator_names[i][sizeof(s_config.saved_actuator_names[i]) - 1] = '\0';
-            ESP_LOGI(TAG, "Set actuator name for ID %d to '%s'", id, name);
-            return true;
-        }
+    int i = bus < MAX_RS485_BUSES ? s_saved_index[bus][id] - 1 : -1;
+    if (i >= 0) {
+        strncpy(s_config.saved_actuator_names[i], name, sizeof(s_config.saved_actuator_names[i]) - 1);
+        s_config.saved_actuator_names[i][sizeof(s_config.saved_actuator_names[i]) - 1] = '\0';
+        ESP_LOGI(TAG, "Set actuator name for %d:%d to '%s'", bus, id, name);
+        return true;
     }
 
     // ID not found in saved actuators
-    ESP_LOGW(TAG, "Cannot set actuator name: ID %d not found in saved actuators", id);
+    ESP_LOGW(TAG, "Cannot set actuator name: %d:%d not found in saved actuators", bus, id);
     return false;
 }
 
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,6 +58,24 @@ void config_set_ap_password(const char *password);
 // RS485 Configuration
 // ============================================================================
 
+#define MAX_RS485_BUSES CONFIG_RS485_MAX_BUSES
+
+/**
+ * @brief RS485 bus configuration
+ */
+typedef struct {
+    uint8_t uart;               // UART port (1 or 2)
+    uint32_t baud;              // Baud rate
+    uint8_t tx_pin;             // TX pin (to transceiver DI)
+    uint8_t rx_pin;             // RX pin (from transceiver RO)
+    uint8_t de_pin;             // Direction enable pin
+} config_rs485_bus_t;
+
+// All configured buses (bus 0 is the "rs485" section)
+uint8_t config_get_rs485_bus_count(void);
+esp_err_t config_get_rs485_bus(uint8_t bus, config_rs485_bus_t *cfg);
+
+// Bus 0
 uint32_t config_get_rs485_baud(void);
 uint8_t config_get_rs485_tx_pin(void);
 uint8_t config_get_rs485_rx_pin(void);
@@ -77,29 +96,52 @@ uint32_t config_get_modbus_timeout(void);
 void config_set_modbus_slave_id(uint8_t id);
 void config_set_modbus_timeout(uint32_t timeout_ms);
 
+/**
+ * @brief Modbus RTU slave port configuration (the "rtu_slave" section)
+ */
+typedef struct {
+    bool enabled;
+    uint8_t slave_id;           // Address answered on the port
+    config_rs485_bus_t port;    // Must not be a UART used by a bus
+} config_rtu_slave_t;
+
+void config_get_rtu_slave(config_rtu_slave_t *cfg);
+
+/**
+ * @brief UDP control channel configuration (the "udp_control" section)
+ */
+typedef struct {
+    bool enabled;
+    uint16_t port;              // UDP port of setpoints and telemetry
+    char key[65];               // Pre-shared HMAC key (at least 16 characters)
+} config_udp_control_t;
+
+void config_get_udp_control(config_udp_control_t *cfg);
+
 // ============================================================================
 // Actuator Configuration
 // ============================================================================
 
-#define MAX_SAVED_ACTUATORS 10
+#define MAX_SAVED_ACTUATORS CONFIG_ACTUATOR_REGISTRY_MAX
 
 uint8_t config_get_scan_max_id(void);
 void config_set_scan_max_id(uint8_t max_id);
 
-// Saved actuator ID persistence
+// Saved actuator persistence, addressed as (bus, ID)
 uint8_t config_get_saved_actuator_count(void);
 const uint8_t* config_get_saved_actuator_ids(void);
-bool config_add_saved_actuator_id(uint8_t id);
-bool config_remove_saved_actuator_id(uint8_t id);
+const uint8_t* config_get_saved_actuator_buses(void);
+bool config_add_saved_actuator_id(uint8_t bus, uint8_t id);
+bool config_remove_saved_actuator_id(uint8_t bus, uint8_t id);
 void config_clear_saved_actuators(void);
 
 // Saved actuator name persistence
 const char* config_get_saved_actuator_name(uint8_t index);
 bool config_set_saved_actuator_name(uint8_t index, const char* name);
 
-// Actuator name by ID (finds ID in saved_actuator_ids and returns/sets corresponding name)
-const char* config_get_actuator_name(uint8_t id);
-bool config_set_actuator_name(uint8_t id, const char *name);
+// Actuator name by (bus, ID) (finds it in the saved actuators and returns/sets corresponding name)
+const char* config_get_actuator_name(uint8_t bus, uint8_t id);
+bool config_set_actuator_name(uint8_t bus, uint8_t id, const char *name);
 
 // ============================================================================
 // Web Server Configuration
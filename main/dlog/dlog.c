@@ -0,0 +1,524 @@
+/**
+ * @file dlog.c
+ * @brief Deferred binary logging
+ */
+
+#include "dlog.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#if CONFIG_DLOG_ENABLE
+
+static const char *TAG = "DLOG";
+
+#define RING_SIZE           CONFIG_DLOG_BUFFER_SIZE     // Bytes per core (power of two)
+#define RING_COUNT          portNUM_PROCESSORS
+#define MAX_TAGS            16
+#define TAG_NAME_MAX        16
+#define LINE_MAX            256
+
+#define DRAIN_PERIOD_MS     20
+#define DRAIN_TASK_STACK    4096
+#define DRAIN_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+// Record header word: marker | flags | length (bytes, multiple of 4)
+#define HDR_MARKER          0xD1000000u
+#define HDR_MARKER_MASK     0xFF000000u
+#define HDR_PAD             0x00800000u     // Filler up to the end of the ring
+#define HDR_LEN_MASK        0x0000FFFFu
+
+#define ALIGN4(n)           (((n) + 3) & ~3u)
+
+_Static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "CONFIG_DLOG_BUFFER_SIZE must be a power of two");
+
+/**
+ * @brief Record layout after the header word
+ */
+typedef struct {
+    uint8_t level;
+    uint8_t core;
+    uint8_t args_len;
+    uint8_t truncated;
+    uint32_t fmt;                   // Format string address
+    uint32_t tag;                   // Tag string address
+    uint32_t pad;
+    int64_t time_us;
+} record_head_t;
+
+#define RECORD_FIXED        (4 + sizeof(record_head_t))
+
+/**
+ * @brief Per-core ring
+ *
+ * Writers reserve space by advancing head with a CAS, fill the record and
+ * publish it by writing its header word last. The drain task is the only
+ * reader: it consumes committed records from tail and zeroes them before
+ * releasing the space, so a reserved but uncommitted header always reads 0.
+ */
+typedef struct {
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_uint dropped;
+    uint32_t high_water;
+    uint8_t buf[RING_SIZE] __attribute__((aligned(8)));
+} ring_t;
+
+/**
+ * @brief Level of a tag
+ */
+typedef struct {
+    char name[TAG_NAME_MAX];
+    volatile esp_log_level_t level;
+} tag_level_t;
+
+static ring_t s_rings[RING_COUNT];
+static tag_level_t s_tags[MAX_TAGS];
+static atomic_int s_tag_count;
+static volatile esp_log_level_t s_default_level = CONFIG_LOG_DEFAULT_LEVEL;
+static atomic_uint s_recorded;
+static uint32_t s_drained = 0;
+static uint32_t s_dropped_reported = 0;
+static TaskHandle_t s_drain_task = NULL;
+
+volatile esp_log_level_t dlog_max_level = CONFIG_LOG_DEFAULT_LEVEL;
+
+// ============================================================================
+// Levels
+// ============================================================================
+
+static esp_log_level_t tag_level(const char *tag)
+{
+    int count = atomic_load_explicit(&s_tag_count, memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(s_tags[i].name, tag) == 0) {
+            return s_tags[i].level;
+        }
+    }
+    return s_default_level;
+}
+
+void dlog_level_set(const char *tag, esp_log_level_t level)
+{
+    if (tag == NULL) {
+        return;
+    }
+
+    esp_log_level_set(tag, level);
+
+    if (strcmp(tag, "*") == 0) {
+        // Like esp_log_level_set("*"), the default also resets every tag
+        s_default_level = level;
+        atomic_store(&s_tag_count, 0);
+    } else {
+        int count = atomic_load(&s_tag_count);
+        int i;
+        for (i = 0; i < count; i++) {
+            if (strcmp(s_tags[i].name, tag) == 0) {
+                s_tags[i].level = level;
+                break;
+            }
+        }
+        if (i == count) {
+            if (count >= MAX_TAGS) {
+                ESP_LOGW(TAG, "Too many tag levels, '%s' only applies to ESP_LOGx", tag);
+                return;
+            }
+            strncpy(s_tags[count].name, tag, TAG_NAME_MAX - 1);
+            s_tags[count].name[TAG_NAME_MAX - 1] = '\0';
+            s_tags[count].level = level;
+            atomic_store_explicit(&s_tag_count, count + 1, memory_order_release);
+        }
+    }
+
+    esp_log_level_t max = s_default_level;
+    int count = atomic_load(&s_tag_count);
+    for (int i = 0; i < count; i++) {
+        if (s_tags[i].level > max) max = s_tags[i].level;
+    }
+    dlog_max_level = max;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+static inline void put_word(ring_t *ring, uint32_t offset, uint32_t value)
+{
+    atomic_store_explicit((atomic_uint *)&ring->buf[offset & (RING_SIZE - 1)], value,
+                          memory_order_release);
+}
+
+static inline uint32_t get_word(ring_t *ring, uint32_t offset)
+{
+    return atomic_load_explicit((atomic_uint *)&ring->buf[offset & (RING_SIZE - 1)],
+                                memory_order_acquire);
+}
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt, const dlog_args_t *args)
+{
+    if (level > tag_level(tag)) {
+        return;
+    }
+
+    uint32_t core = xPortGetCoreID();
+    ring_t *ring = &s_rings[core];
+    uint32_t len = ALIGN4(RECORD_FIXED + args->len);
+    uint32_t head, start, total;
+
+    // Reserve; a record never wraps, the end of the ring is padded instead
+    do {
+        head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        uint32_t to_end = RING_SIZE - (head & (RING_SIZE - 1));
+        start = head + (to_end < len ? to_end : 0);
+        total = start + len - head;
+
+        if (head + total - tail > RING_SIZE) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&ring->head, &head, head + total,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    if (start != head) {
+        put_word(ring, head, HDR_MARKER | HDR_PAD | (start - head));
+    }
+
+    record_head_t rec = {
+        .level = level,
+        .core = core,
+        .args_len = args->len,
+        .truncated = args->truncated,
+        .fmt = (uint32_t)(uintptr_t)fmt,
+        .tag = (uint32_t)(uintptr_t)tag,
+        .time_us = esp_timer_get_time(),
+    };
+    uint8_t *p = &ring->buf[(start & (RING_SIZE - 1)) + 4];
+    memcpy(p, &rec, sizeof(rec));
+    memcpy(p + sizeof(rec), args->buf, args->len);
+
+    put_word(ring, start, HDR_MARKER | len);
+    atomic_fetch_add_explicit(&s_recorded, 1, memory_order_relaxed);
+}
+
+// ============================================================================
+// Formatting
+// ============================================================================
+
+/**
+ * @brief Format a message from its format string and encoded arguments
+ *
+ * Each conversion is printed with its own snprintf() call, with the length
+ * modifier replaced by the one matching the captured argument type.
+ */
+static size_t format_message(char *out, size_t size, const char *fmt,
+                             const uint8_t *args, size_t args_len)
+{
+    size_t pos = 0;
+    size_t arg = 0;
+
+#define EMIT(...) do {                                                          \
+        int _n = snprintf(out + pos, size - pos, __VA_ARGS__);                  \
+        if (_n > 0) pos = pos + _n < size - 1 ? pos + _n : size - 1;            \
+    } while (0)
+
+    for (const char *f = fmt; *f != '\0' && pos < size - 1; f++) {
+        if (*f != '%') {
+            out[pos++] = *f;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[pos++] = '%';
+            f++;
+            continue;
+        }
+
+        // Flags, width and precision are kept; length modifiers are dropped
+        char spec[16] = "%";
+        size_t sl = 1;
+        const char *s = f + 1;
+        while (*s != '\0' && strchr("-+ #0123456789.", *s) && sl < sizeof(spec) - 4) {
+            spec[sl++] = *s++;
+        }
+        while (*s != '\0' && strchr("hlLqjzt", *s)) {
+            s++;
+        }
+        char conv = *s;
+        if (conv == '\0') {
+            break;
+        }
+        f = s;
+
+        if (arg >= args_len) {
+            EMIT("<?>");
+            continue;
+        }
+
+        uint8_t type = args[arg++];
+        const uint8_t *v = &args[arg];
+
+        switch (type) {
+            case DLOG_ARG_U32:
+            case DLOG_ARG_PTR: {
+                uint32_t u;
+                memcpy(&u, v, sizeof(u));
+                arg += sizeof(u);
+                if (conv == 'p') {
+                    EMIT("0x%08lx", (unsigned long)u);
+                } else if (conv == 'c') {
+                    EMIT("%c", (int)u);
+                } else if (strchr("diouxX", conv)) {
+                    spec[sl++] = 'l';
+                    spec[sl++] = conv;
+                    spec[sl] = '\0';
+                    EMIT(spec, (unsigned long)u);
+                } else {
+                    EMIT("<%c?>", conv);
+                }
+                break;
+            }
+            case DLOG_ARG_I64: {
+                int64_t i;
+                memcpy(&i, v, sizeof(i));
+                arg += sizeof(i);
+                if (strchr("diouxX", conv)) {
+                    spec[sl++] = 'l';
+                    spec[sl++] = 'l';
+                    spec[sl++] = conv;
+                    spec[sl] = '\0';
+                    EMIT(spec, (long long)i);
+                } else {
+                    EMIT("<%c?>", conv);
+                }
+                break;
+            }
+            case DLOG_ARG_F64: {
+                double d;
+                memcpy(&d, v, sizeof(d));
+                arg += sizeof(d);
+                if (strchr("fFeEgGaA", conv)) {
+                    spec[sl++] = conv;
+                    spec[sl] = '\0';
+                    EMIT(spec, d);
+                } else {
+                    EMIT("<%c?>", conv);
+                }
+                break;
+            }
+            case DLOG_ARG_STR: {
+                char str[DLOG_STR_MAX + 1];
+                uint8_t n = v[0] < DLOG_STR_MAX ? v[0] : DLOG_STR_MAX;
+                memcpy(str, &v[1], n);
+                str[n] = '\0';
+                arg += 1 + v[0];
+                spec[sl++] = 's';
+                spec[sl] = '\0';
+                EMIT(spec, str);
+                break;
+            }
+            default:
+                arg = args_len;     // Corrupt record: stop decoding arguments
+                EMIT("<?>");
+                break;
+        }
+    }
+
+#undef EMIT
+
+    out[pos] = '\0';
+    return pos;
+}
+
+static char level_letter(uint8_t level)
+{
+    static const char letters[] = "NEWIDV";
+    return level < sizeof(letters) - 1 ? letters[level] : '?';
+}
+
+static void print_record(const record_head_t *rec, const uint8_t *args)
+{
+#if CONFIG_DLOG_HOST_DECODE
+    // ~D<level><core><fmt><tag><time><args>, decoded by tools/dlog_decode.py
+    char line[2 * (sizeof(record_head_t) + DLOG_ARGS_SIZE) + 8];
+    size_t pos = 0;
+    pos += sprintf(line, "~D%02x%02x%08lx%08lx%016llx", rec->level, rec->core,
+                   (unsigned long)rec->fmt, (unsigned long)rec->tag,
+                   (unsigned long long)rec->time_us);
+    for (size_t i = 0; i < rec->args_len; i++) {
+        pos += sprintf(line + pos, "%02x", args[i]);
+    }
+    puts(line);
+#else
+    char msg[LINE_MAX];
+    format_message(msg, sizeof(msg), (const char *)(uintptr_t)rec->fmt, args, rec->args_len);
+    printf("%c (%lu) %s: %s%s\n", level_letter(rec->level),
+           (unsigned long)(rec->time_us / 1000), (const char *)(uintptr_t)rec->tag, msg,
+           rec->truncated ? " [...]" : "");
+#endif
+}
+
+// ============================================================================
+// Drain
+// ============================================================================
+
+/**
+ * @brief Zero a consumed record and give its space back to the writers
+ */
+static void ring_release(ring_t *ring, uint32_t tail, uint32_t hdr)
+{
+    memset(&ring->buf[tail & (RING_SIZE - 1)], 0, hdr & HDR_LEN_MASK);
+    atomic_store_explicit(&ring->tail, tail + (hdr & HDR_LEN_MASK), memory_order_release);
+}
+
+/**
+ * @brief Skip padding and return the header of the next committed record
+ *
+ * @return uint32_t Header word, 0 if the ring has no committed record
+ */
+static uint32_t ring_peek(ring_t *ring)
+{
+    while (1) {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+            return 0;
+        }
+
+        uint32_t hdr = get_word(ring, tail);
+        if ((hdr & HDR_MARKER_MASK) != HDR_MARKER) {
+            return 0;       // Reserved but not committed yet
+        }
+        if ((hdr & HDR_PAD) == 0) {
+            return hdr;
+        }
+
+        ring_release(ring, tail, hdr);
+    }
+}
+
+static void ring_consume(ring_t *ring, uint32_t hdr)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t used = atomic_load_explicit(&ring->head, memory_order_relaxed) - tail;
+    if (used > ring->high_water) {
+        ring->high_water = used;
+    }
+    ring_release(ring, tail, hdr);
+}
+
+/**
+ * @brief Print every committed record, oldest first across the cores
+ */
+static void drain(void)
+{
+    while (1) {
+        ring_t *next = NULL;
+        uint32_t next_hdr = 0;
+        record_head_t next_rec;
+
+        for (int i = 0; i < RING_COUNT; i++) {
+            uint32_t hdr = ring_peek(&s_rings[i]);
+            if (hdr == 0) {
+                continue;
+            }
+            record_head_t rec;
+            uint32_t tail = atomic_load_explicit(&s_rings[i].tail, memory_order_relaxed);
+            memcpy(&rec, &s_rings[i].buf[(tail & (RING_SIZE - 1)) + 4], sizeof(rec));
+            if (next == NULL || rec.time_us < next_rec.time_us) {
+                next = &s_rings[i];
+                next_hdr = hdr;
+                next_rec = rec;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+
+        uint8_t args[DLOG_ARGS_SIZE];
+        uint32_t tail = atomic_load_explicit(&next->tail, memory_order_relaxed);
+        memcpy(args, &next->buf[(tail & (RING_SIZE - 1)) + RECORD_FIXED], next_rec.args_len);
+        ring_consume(next, next_hdr);
+
+        print_record(&next_rec, args);
+        s_drained++;
+    }
+
+    uint32_t dropped = 0;
+    for (int i = 0; i < RING_COUNT; i++) {
+        dropped += atomic_load_explicit(&s_rings[i].dropped, memory_order_relaxed);
+    }
+    if (dropped != s_dropped_reported) {
+        ESP_LOGW(TAG, "%lu messages dropped (ring full)", (unsigned long)(dropped - s_dropped_reported));
+        s_dropped_reported = dropped;
+    }
+}
+
+static void drain_task(void *arg)
+{
+    while (1) {
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t dlog_init(void)
+{
+    if (s_drain_task != NULL) {
+        return ESP_OK;
+    }
+
+    if (xTaskCreate(drain_task, "dlog", DRAIN_TASK_STACK, NULL,
+                    DRAIN_TASK_PRIORITY, &s_drain_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create drain task");
+        return ESP_FAIL;
+    }
+
+#if CONFIG_DLOG_HOST_DECODE
+    ESP_LOGI(TAG, "Deferred logging started (%d bytes x %d cores, host decode)", RING_SIZE, RING_COUNT);
+#else
+    ESP_LOGI(TAG, "Deferred logging started (%d bytes x %d cores)", RING_SIZE, RING_COUNT);
+#endif
+    return ESP_OK;
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->recorded = atomic_load(&s_recorded);
+    stats->drained = s_drained;
+    for (int i = 0; i < RING_COUNT; i++) {
+        stats->dropped += atomic_load(&s_rings[i].dropped);
+        if (s_rings[i].high_water > stats->high_water) {
+            stats->high_water = s_rings[i].high_water;
+        }
+    }
+}
+
+#else
+
+esp_err_t dlog_init(void)
+{
+    return ESP_OK;
+}
+
+void dlog_level_set(const char *tag, esp_log_level_t level)
+{
+    esp_log_level_set(tag, level);
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+#endif // CONFIG_DLOG_ENABLE
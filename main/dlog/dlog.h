@@ -0,0 +1,228 @@
+/**
+ * @file dlog.h
+ * @brief Deferred binary logging
+ *
+ * DLOGx() records the format string address, the tag address, a timestamp
+ * and the raw arguments into a lock-free ring of the calling core. Nothing
+ * is formatted at the call site: a low-priority task drains the rings and
+ * prints the messages in the ESP_LOGx format, or, with
+ * CONFIG_DLOG_HOST_DECODE, prints the records as hex for
+ * tools/dlog_decode.py to format on the host from the ELF's strings.
+ *
+ * Use DLOGx() on runtime paths (bus transactions, request handlers). Keep
+ * ESP_LOGx() for boot and fatal messages that must reach the console
+ * before the drain task runs. A full ring drops new messages and counts
+ * them; logging never blocks.
+ *
+ * Arguments are captured by type: integers up to 32 bits, 64-bit integers,
+ * floating point, void pointers, and strings (copied, truncated to
+ * DLOG_STR_MAX bytes). Up to DLOG_MAX_ARGS arguments per message.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLOG_MAX_ARGS       8
+#define DLOG_ARGS_SIZE      64      // Encoded argument bytes per message
+#define DLOG_STR_MAX        24      // Bytes kept of a string argument
+
+/**
+ * @brief Argument type tags of the encoded arguments
+ */
+typedef enum {
+    DLOG_ARG_U32 = 1,   // 4 bytes
+    DLOG_ARG_I64,       // 8 bytes
+    DLOG_ARG_F64,       // 8 bytes (double)
+    DLOG_ARG_PTR,       // 4 bytes
+    DLOG_ARG_STR,       // 1 length byte + bytes (no terminator)
+} dlog_arg_type_t;
+
+/**
+ * @brief Encoded arguments of one message
+ */
+typedef struct {
+    uint8_t len;
+    bool truncated;
+    uint8_t buf[DLOG_ARGS_SIZE];
+} dlog_args_t;
+
+/**
+ * @brief Logging statistics
+ */
+typedef struct {
+    uint32_t recorded;          // Messages recorded
+    uint32_t dropped;           // Messages dropped on a full ring
+    uint32_t drained;           // Messages printed
+    uint32_t high_water;        // Most bytes used in a ring
+} dlog_stats_t;
+
+#if CONFIG_DLOG_ENABLE
+
+// Highest level enabled for any tag (call-site filter)
+extern volatile esp_log_level_t dlog_max_level;
+
+#define DLOGE(tag, fmt, ...)    DLOG_AT(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...)    DLOG_AT(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...)    DLOG_AT(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...)    DLOG_AT(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define DLOGV(tag, fmt, ...)    DLOG_AT(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+#define DLOG_AT(level, tag, fmt, ...) do {                                      \
+        if ((level) <= LOG_LOCAL_LEVEL && (level) <= dlog_max_level) {          \
+            if (0) dlog_check_format(fmt, ##__VA_ARGS__);                       \
+            dlog_args_t _dlog_args;                                             \
+            _dlog_args.len = 0;                                                 \
+            _dlog_args.truncated = false;                                       \
+            DLOG_EACH(&_dlog_args, ##__VA_ARGS__)                               \
+            dlog_write((level), (tag), (fmt), &_dlog_args);                     \
+        }                                                                       \
+    } while (0)
+
+#else
+
+#define DLOGE(tag, fmt, ...)    ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...)    ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...)    ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...)    ESP_LOGD(tag, fmt, ##__VA_ARGS__)
+#define DLOGV(tag, fmt, ...)    ESP_LOGV(tag, fmt, ##__VA_ARGS__)
+
+#endif // CONFIG_DLOG_ENABLE
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Start the drain task
+ *
+ * Messages logged before this are kept in the rings.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t dlog_init(void);
+
+/**
+ * @brief Set the log level of a tag ("*" for the default)
+ *
+ * Applies to DLOGx() at the call site and is forwarded to
+ * esp_log_level_set() for ESP_LOGx().
+ *
+ * @param tag Tag
+ * @param level Level
+ */
+void dlog_level_set(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Get logging statistics
+ *
+ * @param stats Pointer to store statistics
+ */
+void dlog_get_stats(dlog_stats_t *stats);
+
+// ============================================================================
+// Internals used by the macros
+// ============================================================================
+
+/**
+ * @brief Record a message (use the DLOGx macros)
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt, const dlog_args_t *args);
+
+// Never called: lets the compiler check the format against the arguments
+static inline void __attribute__((format(printf, 1, 2))) dlog_check_format(const char *fmt, ...)
+{
+}
+
+static inline uint8_t *dlog_arg_reserve(dlog_args_t *a, dlog_arg_type_t type, size_t len)
+{
+    if (a->len + 1 + len > DLOG_ARGS_SIZE) {
+        a->truncated = true;
+        return NULL;
+    }
+    a->buf[a->len] = type;
+    uint8_t *p = &a->buf[a->len + 1];
+    a->len += 1 + len;
+    return p;
+}
+
+static inline void dlog_arg_u32(dlog_args_t *a, uint32_t v)
+{
+    uint8_t *p = dlog_arg_reserve(a, DLOG_ARG_U32, sizeof(v));
+    if (p) __builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline void dlog_arg_i64(dlog_args_t *a, int64_t v)
+{
+    uint8_t *p = dlog_arg_reserve(a, DLOG_ARG_I64, sizeof(v));
+    if (p) __builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline void dlog_arg_f64(dlog_args_t *a, double v)
+{
+    uint8_t *p = dlog_arg_reserve(a, DLOG_ARG_F64, sizeof(v));
+    if (p) __builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline void dlog_arg_ptr(dlog_args_t *a, const void *v)
+{
+    uint32_t u = (uint32_t)(uintptr_t)v;
+    uint8_t *p = dlog_arg_reserve(a, DLOG_ARG_PTR, sizeof(u));
+    if (p) __builtin_memcpy(p, &u, sizeof(u));
+}
+
+static inline void dlog_arg_str(dlog_args_t *a, const char *s)
+{
+    size_t n = 0;
+    if (s == NULL) s = "(null)";
+    while (n < DLOG_STR_MAX && s[n] != '\0') n++;
+
+    uint8_t *p = dlog_arg_reserve(a, DLOG_ARG_STR, 1 + n);
+    if (p) {
+        p[0] = n;
+        __builtin_memcpy(p + 1, s, n);
+    }
+}
+
+#define DLOG_ARG(a, x) _Generic((x),                                            \
+        char *: dlog_arg_str,                                                   \
+        const char *: dlog_arg_str,                                             \
+        void *: dlog_arg_ptr,                                                   \
+        const void *: dlog_arg_ptr,                                             \
+        float: dlog_arg_f64,                                                    \
+        double: dlog_arg_f64,                                                   \
+        long long: dlog_arg_i64,                                                \
+        unsigned long long: dlog_arg_i64,                                       \
+        default: dlog_arg_u32)((a), (x));
+
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define DLOG_NARGS(...)         DLOG_NARGS_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_CAT_(a, b)         a##b
+#define DLOG_CAT(a, b)          DLOG_CAT_(a, b)
+
+#define DLOG_EACH_0(a)
+#define DLOG_EACH_1(a, x)       DLOG_ARG(a, x)
+#define DLOG_EACH_2(a, x, ...)  DLOG_ARG(a, x) DLOG_EACH_1(a, __VA_ARGS__)
+#define DLOG_EACH_3(a, x, ...)  DLOG_ARG(a, x) DLOG_EACH_2(a, __VA_ARGS__)
+#define DLOG_EACH_4(a, x, ...)  DLOG_ARG(a, x) DLOG_EACH_3(a, __VA_ARGS__)
+#define DLOG_EACH_5(a, x, ...)  DLOG_ARG(a, x) DLOG_EACH_4(a, __VA_ARGS__)
+#define DLOG_EACH_6(a, x, ...)  DLOG_ARG(a, x) DLOG_EACH_5(a, __VA_ARGS__)
+#define DLOG_EACH_7(a, x, ...)  DLOG_ARG(a, x) DLOG_EACH_6(a, __VA_ARGS__)
+#define DLOG_EACH_8(a, x, ...)  DLOG_ARG(a, x) DLOG_EACH_7(a, __VA_ARGS__)
+#define DLOG_EACH(a, ...)       DLOG_CAT(DLOG_EACH_, DLOG_NARGS(__VA_ARGS__))(a, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DLOG_H
@@ -0,0 +1,76 @@
+/**
+ * @file export_writer.c
+ * @brief Buffered writer for streamed exports
+ */
+
+#include "export_writer.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+void export_writer_init(export_writer_t *w, void *buf, size_t size, export_write_fn write, void *ctx)
+{
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->write = write;
+    w->ctx = ctx;
+    w->err = ESP_OK;
+}
+
+void export_writer_flush(export_writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0) {
+        w->err = w->write(w->ctx, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+void export_writer_printf(export_writer_t *w, const char *fmt, ...)
+{
+    if (w->err != ESP_OK) {
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    size_t room = w->size - w->len;
+    int n = vsnprintf((char *)&w->buf[w->len], room, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        return;
+    }
+
+    if ((size_t)n >= room && w->len > 0) {
+        // Did not fit behind the buffered output: send that, then format again
+        export_writer_flush(w);
+        room = w->size;
+        va_start(ap, fmt);
+        n = vsnprintf((char *)w->buf, room, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            return;
+        }
+    }
+    w->len += (size_t)n < room ? (size_t)n : room - 1;
+}
+
+uint8_t *export_writer_reserve(export_writer_t *w, size_t len)
+{
+    if (len > w->size) {
+        return NULL;
+    }
+    if (w->len + len > w->size) {
+        export_writer_flush(w);
+    }
+    uint8_t *p = &w->buf[w->len];
+    memset(p, 0, len);
+    w->len += len;
+    return p;
+}
+
+esp_err_t export_writer_finish(export_writer_t *w)
+{
+    export_writer_flush(w);
+    return w->err;
+}
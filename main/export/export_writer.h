@@ -0,0 +1,93 @@
+/**
+ * @file export_writer.h
+ * @brief Buffered writer for streamed exports
+ *
+ * The metrics, trace point, profiler and RS485 trace exports format their
+ * output into a fixed buffer that is handed to a write callback (usually an
+ * HTTP chunk sender) each time it fills. The first error of the callback
+ * ends the export: later output is dropped and export_writer_finish()
+ * returns the error.
+ */
+
+#ifndef EXPORT_WRITER_H
+#define EXPORT_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Output callback
+ *
+ * @param ctx Caller context
+ * @param data Bytes to send
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK to continue, anything else aborts the export
+ */
+typedef esp_err_t (*export_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Writer state, owned by the caller
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    export_write_fn write;
+    void *ctx;
+    esp_err_t err;              // First error of the callback
+} export_writer_t;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Start an export
+ *
+ * @param w Writer
+ * @param buf Output buffer, kept until the export is finished
+ * @param size Size of the buffer
+ * @param write Output callback
+ * @param ctx Callback context
+ */
+void export_writer_init(export_writer_t *w, void *buf, size_t size, export_write_fn write, void *ctx);
+
+/**
+ * @brief Hand the buffered output to the callback
+ */
+void export_writer_flush(export_writer_t *w);
+
+/**
+ * @brief Append formatted text
+ *
+ * Flushes first when the text does not fit behind the buffered output. Text
+ * longer than the whole buffer is truncated.
+ */
+void export_writer_printf(export_writer_t *w, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Reserve zeroed space for a binary block
+ *
+ * @param w Writer
+ * @param len Block size, at most the buffer size
+ * @return uint8_t* Block to fill in, NULL if it is larger than the buffer
+ */
+uint8_t *export_writer_reserve(export_writer_t *w, size_t len);
+
+/**
+ * @brief Flush the rest of the output
+ *
+ * @return esp_err_t ESP_OK, or the first error of the callback
+ */
+esp_err_t export_writer_finish(export_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXPORT_WRITER_H
@@ -0,0 +1,269 @@
+/**
+ * @file cpu_sampler.c
+ * @brief Background CPU load sampling per task and per core
+ */
+
+#include "cpu_sampler.h"
+#include <string.h>
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include "metrics.h"
+
+static const char *TAG = "CPU";
+
+#define SAMPLER_TASK_STACK      3072
+#define SAMPLER_TASK_PRIORITY   (tskIDLE_PRIORITY + 8)  // Above the application: samples stay on time
+
+/**
+ * @brief Per-task sampling state, matched to the tasks by task number
+ */
+typedef struct {
+    bool used;
+    bool seen;                  // Present in the current sample
+    uint32_t number;
+    configRUN_TIME_COUNTER_TYPE prev_runtime;
+    uint8_t samples;            // Valid history entries
+    uint8_t history[CPU_SAMPLER_HISTORY];   // Load in 0.5 % units, ring at s_pos
+} task_slot_t;
+
+static TaskStatus_t s_status[CPU_SAMPLER_MAX_TASKS];
+static task_slot_t s_slots[CPU_SAMPLER_MAX_TASKS];
+static configRUN_TIME_COUNTER_TYPE s_prev_total;
+static unsigned s_pos;          // History index of the current sample
+
+static cpu_load_t s_load;       // Published snapshot, under s_lock
+static SemaphoreHandle_t s_lock = NULL;
+static bool s_warned_tasks = false;
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+static int64_t read_core0_load(void)
+{
+    return cpu_sampler_core_load(0) / 10;
+}
+
+static int64_t read_core1_load(void)
+{
+    return cpu_sampler_core_load(1) / 10;
+}
+
+METRIC_GAUGE_DEFINE(s_m_core0, "cpu_core0_load_percent", "Load of core 0 over the last sampling interval", read_core0_load);
+METRIC_GAUGE_DEFINE(s_m_core1, "cpu_core1_load_percent", "Load of core 1 over the last sampling interval", read_core1_load);
+
+// ============================================================================
+// Sampling
+// ============================================================================
+
+static task_slot_t *find_slot(uint32_t number)
+{
+    task_slot_t *free_slot = NULL;
+    for (int i = 0; i < CPU_SAMPLER_MAX_TASKS; i++) {
+        if (s_slots[i].used && s_slots[i].number == number) {
+            return &s_slots[i];
+        }
+        if (!s_slots[i].used && free_slot == NULL) {
+            free_slot = &s_slots[i];
+        }
+    }
+    if (free_slot != NULL) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->used = true;
+        free_slot->number = number;
+    }
+    return free_slot;
+}
+
+static char state_char(eTaskState state)
+{
+    switch (state) {
+        case eRunning:   return 'R';
+        case eReady:     return 'r';
+        case eBlocked:   return 'B';
+        case eSuspended: return 'S';
+        case eDeleted:   return 'D';
+        default:         return '?';
+    }
+}
+
+/**
+ * @brief Load in 0.1 % of a run time delta over the interval
+ */
+static uint16_t load_permille(uint64_t delta, uint64_t interval)
+{
+    if (interval == 0) {
+        return 0;
+    }
+    uint64_t permille = (delta * 1000 + interval / 2) / interval;
+    return permille > 1000 ? 1000 : permille;
+}
+
+static void take_sample(void)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(s_status, CPU_SAMPLER_MAX_TASKS, &total);
+    if (count == 0) {
+        // More tasks than CPU_SAMPLER_MAX_TASKS: nothing is returned
+        if (!s_warned_tasks) {
+            ESP_LOGW(TAG, "More than %d tasks, load not sampled", CPU_SAMPLER_MAX_TASKS);
+            s_warned_tasks = true;
+        }
+        return;
+    }
+
+    bool first = s_prev_total == 0;
+    uint64_t interval = total - s_prev_total;
+    s_prev_total = total;
+    s_pos = (s_pos + 1) % CPU_SAMPLER_HISTORY;
+
+    for (int i = 0; i < CPU_SAMPLER_MAX_TASKS; i++) {
+        s_slots[i].seen = false;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    TaskHandle_t idle[CPU_SAMPLER_CORES];
+    uint16_t idle_load[CPU_SAMPLER_CORES] = {0};
+    for (int core = 0; core < CPU_SAMPLER_CORES; core++) {
+        idle[core] = xTaskGetIdleTaskHandleForCore(core);
+    }
+    uint8_t n = 0;
+
+    for (UBaseType_t t = 0; t < count; t++) {
+        const TaskStatus_t *st = &s_status[t];
+        task_slot_t *slot = find_slot(st->xTaskNumber);
+        if (slot == NULL) {
+            continue;
+        }
+
+        // A task created during the interval is measured from its start
+        bool known = slot->prev_runtime != 0 || slot->samples > 0;
+        uint64_t delta = known ? st->ulRunTimeCounter - slot->prev_runtime : st->ulRunTimeCounter;
+        slot->prev_runtime = st->ulRunTimeCounter;
+        slot->seen = true;
+
+        uint16_t load = first ? 0 : load_permille(delta, interval);
+        slot->history[s_pos] = (load + 2) / 5;
+        if (slot->samples < CPU_SAMPLER_HISTORY) {
+            slot->samples++;
+        }
+
+        uint32_t sum = 0;
+        uint8_t peak = 0;
+        for (unsigned k = 0; k < slot->samples; k++) {
+            uint8_t v = slot->history[(s_pos + CPU_SAMPLER_HISTORY - k) % CPU_SAMPLER_HISTORY];
+            sum += v;
+            if (v > peak) peak = v;
+        }
+
+        for (int core = 0; core < CPU_SAMPLER_CORES; core++) {
+            if (st->xHandle == idle[core]) {
+                idle_load[core] = load;
+            }
+        }
+
+        cpu_task_load_t *out = &s_load.tasks[n++];
+        strncpy(out->name, st->pcTaskName, sizeof(out->name) - 1);
+        out->name[sizeof(out->name) - 1] = '\0';
+        out->number = st->xTaskNumber;
+        out->priority = st->uxCurrentPriority;
+        out->core = st->xCoreID < CPU_SAMPLER_CORES ? st->xCoreID : -1;
+        out->state = state_char(st->eCurrentState);
+        out->load = load;
+        out->load_avg = sum * 5 / slot->samples;
+        out->load_peak = peak * 5;
+        out->stack_free = st->usStackHighWaterMark;
+        out->runtime_us = st->ulRunTimeCounter;
+    }
+    s_load.task_count = n;
+
+    // Deleted tasks free their slot
+    for (int i = 0; i < CPU_SAMPLER_MAX_TASKS; i++) {
+        if (s_slots[i].used && !s_slots[i].seen) {
+            s_slots[i].used = false;
+        }
+    }
+
+    if (!first) {
+        // Shift the core history left by one sample (oldest first)
+        if (s_load.history_len == CPU_SAMPLER_HISTORY) {
+            memmove(s_load.core_history[0], s_load.core_history[1],
+                    sizeof(s_load.core_history) - sizeof(s_load.core_history[0]));
+        } else {
+            s_load.history_len++;
+        }
+        for (int core = 0; core < CPU_SAMPLER_CORES; core++) {
+            s_load.core_load[core] = 1000 - idle_load[core];
+            s_load.core_history[s_load.history_len - 1][core] = (s_load.core_load[core] + 5) / 10;
+        }
+        s_load.samples++;
+    }
+
+    xSemaphoreGive(s_lock);
+}
+
+static void sampler_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        take_sample();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_CPU_SAMPLER_PERIOD_MS));
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t cpu_sampler_start(void)
+{
+    if (s_lock != NULL) {
+        return ESP_OK;
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    if (s_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_load.period_ms = CONFIG_CPU_SAMPLER_PERIOD_MS;
+
+    if (xTaskCreate(sampler_task, "cpu_sampler", SAMPLER_TASK_STACK, NULL,
+                    SAMPLER_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sampler task");
+        return ESP_FAIL;
+    }
+
+    metrics_register(&s_m_core0);
+    metrics_register(&s_m_core1);
+
+    ESP_LOGI(TAG, "CPU load sampling every %d ms (%d samples kept)",
+             CONFIG_CPU_SAMPLER_PERIOD_MS, CPU_SAMPLER_HISTORY);
+    return ESP_OK;
+}
+
+esp_err_t cpu_sampler_get(cpu_load_t *load)
+{
+    if (load == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    esp_err_t ret = s_load.samples > 0 ? ESP_OK : ESP_ERR_INVALID_STATE;
+    memcpy(load, &s_load, sizeof(*load));
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+uint16_t cpu_sampler_core_load(int core)
+{
+    if (core < 0 || core >= CPU_SAMPLER_CORES) {
+        return 0;
+    }
+    return s_load.core_load[core];     // 16-bit read, no lock needed
+}
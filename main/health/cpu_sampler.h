@@ -0,0 +1,89 @@
+/**
+ * @file cpu_sampler.h
+ * @brief Background CPU load sampling per task and per core
+ *
+ * A task snapshots the FreeRTOS run-time counters every
+ * CONFIG_CPU_SAMPLER_PERIOD_MS and keeps the load of the last interval,
+ * a short history (CONFIG_CPU_SAMPLER_HISTORY samples) and the stack
+ * high-water mark of every task. Readers copy the latest snapshot and never
+ * walk the task lists themselves, so polling the load does not change it.
+ *
+ * Loads are in tenths of a percent of one core: a task can use up to
+ * 100.0 %, all tasks together up to 100.0 % per core.
+ */
+
+#ifndef CPU_SAMPLER_H
+#define CPU_SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CPU_SAMPLER_MAX_TASKS   48
+#define CPU_SAMPLER_HISTORY     CONFIG_CPU_SAMPLER_HISTORY
+#define CPU_SAMPLER_CORES       portNUM_PROCESSORS
+
+/**
+ * @brief Load of one task
+ */
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t number;            // FreeRTOS task number (unique)
+    uint8_t priority;
+    int8_t core;                // Pinned core, -1 if not pinned
+    char state;                 // R(unning), r(eady), B(locked), S(uspended), D(eleted)
+    uint16_t load;              // Last interval (0.1 %)
+    uint16_t load_avg;          // Average over the history (0.1 %)
+    uint16_t load_peak;         // Highest interval in the history (0.1 %)
+    uint32_t stack_free;        // Stack high-water mark (bytes never used)
+    uint64_t runtime_us;        // Run time since boot
+} cpu_task_load_t;
+
+/**
+ * @brief Latest snapshot
+ */
+typedef struct {
+    uint32_t period_ms;
+    uint32_t samples;           // Samples taken since start
+    uint16_t core_load[CPU_SAMPLER_CORES];      // Last interval (0.1 %)
+    uint8_t history_len;        // Valid entries in core_history
+    uint8_t core_history[CPU_SAMPLER_HISTORY][CPU_SAMPLER_CORES];   // Percent, oldest first
+    uint8_t task_count;
+    cpu_task_load_t tasks[CPU_SAMPLER_MAX_TASKS];
+} cpu_load_t;
+
+/**
+ * @brief Start the sampling task
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t cpu_sampler_start(void);
+
+/**
+ * @brief Copy the latest snapshot
+ *
+ * @param load Pointer to store the snapshot (about 2 KB: keep it off small stacks)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE before the
+ *         first interval has been measured
+ */
+esp_err_t cpu_sampler_get(cpu_load_t *load);
+
+/**
+ * @brief Load of one core over the last interval
+ *
+ * @param core Core number
+ * @return uint16_t Load (0.1 %), 0 before the first interval
+ */
+uint16_t cpu_sampler_core_load(int core);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CPU_SAMPLER_H
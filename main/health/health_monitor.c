@@ -16,6 +16,7 @@
 
 #include "wifi_manager.h"
 #include "modbus_rtu.h"
+#include "metrics.h"
 
 static const char *TAG = "HEALTH";
 
@@ -30,6 +31,48 @@ static system_health_t s_health = {0};
 static TaskHandle_t s_health_task_handle = NULL;
 static bool s_initialized = false;
 
+// ============================================================================
+// Metrics (read at scrape time)
+// ============================================================================
+
+static int64_t read_heap_free(void)
+{
+    return esp_get_free_heap_size();
+}
+
+static int64_t read_heap_min_free(void)
+{
+    return esp_get_minimum_free_heap_size();
+}
+
+static int64_t read_uptime(void)
+{
+    return esp_timer_get_time() / 1000000;
+}
+
+static int64_t read_wifi_connected(void)
+{
+    return wifi_manager_is_connected();
+}
+
+static int64_t read_wifi_rssi(void)
+{
+    return wifi_manager_is_connected() ? wifi_manager_get_rssi() : 0;
+}
+
+static int64_t read_filesystem_ok(void)
+{
+    return s_health.filesystem_ok;
+}
+
+METRIC_GAUGE_DEFINE(s_m_heap_free, "heap_free_bytes", "Free heap", read_heap_free);
+METRIC_GAUGE_DEFINE(s_m_heap_min_free, "heap_min_free_bytes", "Lowest free heap since boot", read_heap_min_free);
+METRIC_GAUGE_DEFINE(s_m_uptime, "uptime_seconds", "Time since boot", read_uptime);
+METRIC_GAUGE_DEFINE(s_m_wifi_connected, "wifi_connected", "1 when connected to an access point", read_wifi_connected);
+METRIC_GAUGE_DEFINE(s_m_wifi_rssi, "wifi_rssi_dbm", "Signal strength of the access point (0 when disconnected)", read_wifi_rssi);
+METRIC_GAUGE_DEFINE(s_m_filesystem_ok, "filesystem_ok", "1 when the user data partition is mounted (last health check)", read_filesystem_ok);
+METRIC_GAUGE_DEFINE(s_m_reset_reason, "reset_reason", "esp_reset_reason() of the last reset", NULL);
+
 /**
  * @brief Health monitoring task
  */
@@ -62,16 +105,18 @@ static void health_monitor_task(void *pvParameters)
             // Update heap info
             s_health.free_heap = esp_get_free_heap_size();
             s_health.min_free_heap = esp_get_minimum_free_heap_size();
+            s_health.largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
             
             // Check WiFi
             s_health.wifi_connected = wifi_manager_is_connected();
             
             // Check Modbus (consider active if any TX in last period)
-            const modbus_stats_t *mb_stats = modbus_get_stats();
+            modbus_stats_t mb_stats;
+            modbus_get_stats(&mb_stats);
             static uint32_t last_tx_count = 0;
-            s_health.modbus_active = (mb_stats->tx_count > last_tx_count);
-            last_tx_count = mb_stats->tx_count;
-            s_health.total_error_count = mb_stats->error_count;
+            s_health.modbus_active = (mb_stats.tx_count != last_tx_count);
+            last_tx_count = mb_stats.tx_count;
+            s_health.total_error_count = mb_stats.error_count;
             
             // Check filesystem
             size_t total, used;
@@ -114,6 +159,15 @@ esp_err_t health_monitor_init(void)
     if (reason >= 0 && reason < sizeof(reset_reasons)/sizeof(reset_reasons[0])) {
         ESP_LOGI(TAG, "Reset reason: %s", reset_reasons[reason]);
     }
+
+    metrics_gauge_set(&s_m_reset_reason, reason);
+    metrics_register(&s_m_heap_free);
+    metrics_register(&s_m_heap_min_free);
+    metrics_register(&s_m_uptime);
+    metrics_register(&s_m_wifi_connected);
+    metrics_register(&s_m_wifi_rssi);
+    metrics_register(&s_m_filesystem_ok);
+    metrics_register(&s_m_reset_reason);
     
     // Create health monitoring task
     BaseType_t ret = xTaskCreate(
@@ -160,7 +214,8 @@ void health_monitor_log_status(void)
 {
     ESP_LOGI(TAG, "=== System Health ===");
     ESP_LOGI(TAG, "Uptime: %lu seconds", s_health.uptime_seconds);
-    ESP_LOGI(TAG, "Heap: %lu free, %lu min", s_health.free_heap, s_health.min_free_heap);
+    ESP_LOGI(TAG, "Heap: %lu free, %lu min, %lu largest block", s_health.free_heap,
+             s_health.min_free_heap, s_health.largest_free_block);
     ESP_LOGI(TAG, "WiFi: %s, Modbus: %s, FS: %s",
              s_health.wifi_connected ? "OK" : "DISC",
              s_health.modbus_active ? "ACTIVE" : "IDLE",
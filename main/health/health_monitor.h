@@ -22,6 +22,7 @@ typedef struct {
     uint32_t uptime_seconds;
     uint32_t free_heap;
     uint32_t min_free_heap;
+    uint32_t largest_free_block;    // Internal RAM: the largest allocation that can succeed
     int reset_reason;
     
     // Subsystems
@@ -0,0 +1,222 @@
+/**
+ * @file memprof.c
+ * @brief Heap accounting per subsystem and fragmentation per heap
+ */
+
+#include "memprof.h"
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "cJSON.h"
+
+#include "metrics.h"
+
+static const char *TAG = "MEMPROF";
+
+static const char *const s_tag_names[MEMPROF_TAG_COUNT] = {
+    [MEMPROF_TAG_JSON]   = "json",
+    [MEMPROF_TAG_HTTP]   = "http",
+    [MEMPROF_TAG_FILES]  = "files",
+    [MEMPROF_TAG_CONFIG] = "config",
+    [MEMPROF_TAG_WIFI]   = "wifi",
+    [MEMPROF_TAG_MODBUS] = "modbus",
+    [MEMPROF_TAG_DRIVER] = "driver",
+    [MEMPROF_TAG_DIAG]   = "diag",
+};
+
+static const struct {
+    const char *name;
+    uint32_t caps;
+} s_heaps[] = {
+    { "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+    { "dma",      MALLOC_CAP_DMA },
+    { "spiram",   MALLOC_CAP_SPIRAM },
+};
+
+static memprof_tag_stats_t s_tags[MEMPROF_TAG_COUNT];
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+static int64_t read_largest(uint32_t caps)
+{
+    return heap_caps_get_largest_free_block(caps);
+}
+
+static int64_t read_fragmentation(uint32_t caps)
+{
+    size_t free_bytes = heap_caps_get_free_size(caps);
+    if (free_bytes == 0) {
+        return 0;
+    }
+    return 100 - (int64_t)heap_caps_get_largest_free_block(caps) * 100 / free_bytes;
+}
+
+static int64_t read_internal_largest(void) { return read_largest(s_heaps[0].caps); }
+static int64_t read_internal_frag(void)    { return read_fragmentation(s_heaps[0].caps); }
+static int64_t read_dma_largest(void)      { return read_largest(s_heaps[1].caps); }
+static int64_t read_dma_frag(void)         { return read_fragmentation(s_heaps[1].caps); }
+static int64_t read_spiram_largest(void)   { return read_largest(s_heaps[2].caps); }
+static int64_t read_spiram_frag(void)      { return read_fragmentation(s_heaps[2].caps); }
+
+METRIC_GAUGE_DEFINE(s_m_internal_largest, "heap_internal_largest_free_block_bytes", "Largest free block of internal RAM", read_internal_largest);
+METRIC_GAUGE_DEFINE(s_m_internal_frag, "heap_internal_fragmentation_percent", "Free internal RAM outside the largest free block", read_internal_frag);
+METRIC_GAUGE_DEFINE(s_m_dma_largest, "heap_dma_largest_free_block_bytes", "Largest free block of DMA-capable RAM", read_dma_largest);
+METRIC_GAUGE_DEFINE(s_m_dma_frag, "heap_dma_fragmentation_percent", "Free DMA-capable RAM outside the largest free block", read_dma_frag);
+METRIC_GAUGE_DEFINE(s_m_spiram_largest, "heap_spiram_largest_free_block_bytes", "Largest free block of external RAM", read_spiram_largest);
+METRIC_GAUGE_DEFINE(s_m_spiram_frag, "heap_spiram_fragmentation_percent", "Free external RAM outside the largest free block", read_spiram_frag);
+
+// ============================================================================
+// Accounting
+// ============================================================================
+
+static void account_alloc(memprof_tag_t tag, void *ptr, size_t requested)
+{
+    size_t size = ptr ? heap_caps_get_allocated_size(ptr) : 0;
+
+    portENTER_CRITICAL(&s_mux);
+    memprof_tag_stats_t *t = &s_tags[tag];
+    if (ptr != NULL) {
+        t->bytes += size;
+        t->blocks++;
+        t->allocs++;
+        if (t->bytes > t->peak_bytes) {
+            t->peak_bytes = t->bytes;
+        }
+    } else if (requested > 0) {
+        t->failures++;
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+
+static void account_free(memprof_tag_t tag, size_t size)
+{
+    portENTER_CRITICAL(&s_mux);
+    memprof_tag_stats_t *t = &s_tags[tag];
+    t->bytes = t->bytes > size ? t->bytes - size : 0;
+    t->blocks = t->blocks > 0 ? t->blocks - 1 : 0;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void *memprof_malloc(memprof_tag_t tag, size_t size)
+{
+    void *ptr = malloc(size);
+    account_alloc(tag, ptr, size);
+    return ptr;
+}
+
+void *memprof_calloc(memprof_tag_t tag, size_t n, size_t size)
+{
+    void *ptr = calloc(n, size);
+    account_alloc(tag, ptr, n * size);
+    return ptr;
+}
+
+void *memprof_realloc(memprof_tag_t tag, void *ptr, size_t size)
+{
+    size_t old_size = ptr ? heap_caps_get_allocated_size(ptr) : 0;
+    void *new_ptr = realloc(ptr, size);
+    if (new_ptr == NULL && size > 0) {
+        account_alloc(tag, NULL, size);     // The old block is still allocated
+        return NULL;
+    }
+    if (ptr != NULL) {
+        account_free(tag, old_size);
+    }
+    if (new_ptr != NULL) {
+        account_alloc(tag, new_ptr, size);
+    }
+    return new_ptr;
+}
+
+void memprof_free(memprof_tag_t tag, void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    account_free(tag, heap_caps_get_allocated_size(ptr));
+    free(ptr);
+}
+
+static void *json_malloc(size_t size)
+{
+    return memprof_malloc(MEMPROF_TAG_JSON, size);
+}
+
+static void json_free(void *ptr)
+{
+    memprof_free(MEMPROF_TAG_JSON, ptr);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t memprof_init(void)
+{
+    for (int i = 0; i < MEMPROF_TAG_COUNT; i++) {
+        s_tags[i].name = s_tag_names[i];
+    }
+
+    cJSON_Hooks hooks = {
+        .malloc_fn = json_malloc,
+        .free_fn = json_free,
+    };
+    cJSON_InitHooks(&hooks);
+
+    metrics_register(&s_m_internal_largest);
+    metrics_register(&s_m_internal_frag);
+    metrics_register(&s_m_dma_largest);
+    metrics_register(&s_m_dma_frag);
+    if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+        metrics_register(&s_m_spiram_largest);
+        metrics_register(&s_m_spiram_frag);
+    }
+
+    ESP_LOGI(TAG, "Heap accounting for %d subsystems", MEMPROF_TAG_COUNT);
+    return ESP_OK;
+}
+
+esp_err_t memprof_get_tag_stats(memprof_tag_t tag, memprof_tag_stats_t *stats)
+{
+    if (tag >= MEMPROF_TAG_COUNT || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_mux);
+    *stats = s_tags[tag];
+    portEXIT_CRITICAL(&s_mux);
+    stats->name = s_tag_names[tag];
+    return ESP_OK;
+}
+
+esp_err_t memprof_get_heap_stats(int index, memprof_heap_stats_t *stats)
+{
+    if (index < 0 || index >= (int)(sizeof(s_heaps) / sizeof(s_heaps[0]))) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t caps = s_heaps[index].caps;
+    memset(stats, 0, sizeof(*stats));
+    stats->name = s_heaps[index].name;
+    stats->caps = caps;
+    stats->total = heap_caps_get_total_size(caps);
+    if (stats->total == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    stats->free = info.total_free_bytes;
+    stats->min_free = info.minimum_free_bytes;
+    stats->largest_free_block = info.largest_free_block;
+    stats->fragmentation = info.total_free_bytes > 0
+        ? 100 - (uint64_t)info.largest_free_block * 100 / info.total_free_bytes : 0;
+    return ESP_OK;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file memprof.h
+ * @brief Heap accounting per subsystem and fragmentation per heap
+ *
+ * Allocations made through memprof_malloc() and friends are counted under
+ * a subsystem tag: bytes and blocks in use, peak bytes, allocations and
+ * failures. Sizes are the block sizes reported by the heap, so freeing
+ * needs the tag but no per-block header, and a block freed with plain
+ * free() is only missing from the accounting. cJSON allocates through
+ * MEMPROF_TAG_JSON once memprof_init() has installed its hooks: strings
+ * returned by cJSON_Print*() must be released with cJSON_free().
+ *
+ * Each heap capability (internal, DMA, SPIRAM) is reported with its
+ * largest free block and fragmentation, also exported at /metrics.
+ */
+
+#ifndef MEMPROF_H
+#define MEMPROF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Subsystem an allocation is counted under
+ */
+typedef enum {
+    MEMPROF_TAG_JSON = 0,       // cJSON trees and printed documents
+    MEMPROF_TAG_HTTP,           // Web server scratch buffers
+    MEMPROF_TAG_FILES,          // Whole-file buffers of the file API
+    MEMPROF_TAG_CONFIG,         // Configuration load and save
+    MEMPROF_TAG_WIFI,           // Scan results
+    MEMPROF_TAG_MODBUS,         // Modbus masters and TCP clients
+    MEMPROF_TAG_DRIVER,         // RS485 drivers and device handles
+    MEMPROF_TAG_DIAG,           // Trace and profiler exports
+    MEMPROF_TAG_COUNT,
+} memprof_tag_t;
+
+/**
+ * @brief Accounting of one tag
+ */
+typedef struct {
+    const char *name;
+    uint32_t bytes;             // In use
+    uint32_t peak_bytes;        // Highest bytes in use since boot
+    uint32_t blocks;            // In use
+    uint32_t allocs;            // Allocations since boot
+    uint32_t failures;          // Allocations that returned NULL
+} memprof_tag_stats_t;
+
+/**
+ * @brief State of one heap capability
+ */
+typedef struct {
+    const char *name;
+    uint32_t caps;              // MALLOC_CAP_xxx
+    uint32_t total;
+    uint32_t free;
+    uint32_t min_free;          // Lowest free since boot
+    uint32_t largest_free_block;
+    uint8_t fragmentation;      // Percent of the free bytes outside the largest block
+} memprof_heap_stats_t;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Route cJSON allocations through MEMPROF_TAG_JSON and register the
+ *        heap gauges
+ *
+ * Call before any cJSON object is created.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t memprof_init(void);
+
+/**
+ * @brief malloc() counted under a tag
+ */
+void *memprof_malloc(memprof_tag_t tag, size_t size);
+
+/**
+ * @brief calloc() counted under a tag
+ */
+void *memprof_calloc(memprof_tag_t tag, size_t n, size_t size);
+
+/**
+ * @brief realloc() counted under a tag (ptr must belong to the same tag)
+ */
+void *memprof_realloc(memprof_tag_t tag, void *ptr, size_t size);
+
+/**
+ * @brief free() of a block allocated under a tag (NULL is ignored)
+ */
+void memprof_free(memprof_tag_t tag, void *ptr);
+
+/**
+ * @brief Get the accounting of one tag
+ *
+ * @param tag Tag
+ * @param stats Pointer to store the accounting
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown tag
+ */
+esp_err_t memprof_get_tag_stats(memprof_tag_t tag, memprof_tag_stats_t *stats);
+
+/**
+ * @brief Get the state of one heap capability
+ *
+ * @param index Heap index, from 0 until ESP_ERR_NOT_FOUND
+ * @param stats Pointer to store the state
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the chip has
+ *         no memory with these capabilities, ESP_ERR_NOT_FOUND past the end
+ */
+esp_err_t memprof_get_heap_stats(int index, memprof_heap_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEMPROF_H
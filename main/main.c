@@ -15,102 +15,90 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "dlog.h"
 #include "esp_err.h"
-
-#include "rs485_driver.h"
-#include "modbus_rtu.h"
-#include "mightyzap.h"
+#include "sdkconfig.h"
+
+#include "bus_manager.h"
+#include "modbus_tcp.h"
+#include "modbus_slave.h"
+#include "udp_control.h"
+#include "actuator_registry.h"
+#include "actuator_poller.h"
 #include "wifi_manager.h"
 #include "web_server.h"
 #include "config_manager.h"
 #include "health_monitor.h"
+#include "cpu_sampler.h"
+#include "memprof.h"
+#include "boot.h"
 
 static const char *TAG = "MASTER";
 
-// Global handles (accessible from web_server.c)
-rs485_handle_t g_rs485 = NULL;
-modbus_handle_t g_modbus = NULL;
-mightyzap_handle_t g_actuator = NULL;
-
-// Actuator configuration
-#define ACTUATOR_SLAVE_ID   1   // mightyZAP default ID
-
 /**
- * @brief Initialize RS485 and Modbus using config
+ * @brief Initialize the RS485/Modbus buses using config
  */
 static esp_err_t init_communication(void)
 {
-    esp_err_t ret;
-
-    // Get configuration
-    uint32_t baud = config_get_rs485_baud();
-    uint8_t tx_pin = config_get_rs485_tx_pin();
-    uint8_t rx_pin = config_get_rs485_rx_pin();
-    uint8_t de_pin = config_get_rs485_de_pin();
-    uint32_t timeout = config_get_modbus_timeout();
-
-    ESP_LOGI(TAG, "RS485 Config: TX=%d, RX=%d, DE=%d, Baud=%lu",
-             tx_pin, rx_pin, de_pin, baud);
-
-    // Initialize RS485
-    rs485_config_t rs485_cfg = {
-        .uart_num = UART_NUM_1,
-        .tx_pin = tx_pin,
-        .rx_pin = rx_pin,
-        .de_pin = de_pin,
-        .baud_rate = baud,
-        .rx_buffer_size = 256,
-        .tx_buffer_size = 256,
-    };
-
-    ret = rs485_init(&rs485_cfg, &g_rs485);
+    esp_err_t ret = bus_manager_init(config_get_modbus_timeout());
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize RS485: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to initialize any RS485 bus");
         return ret;
     }
 
-    // Initialize Modbus Master
-    modbus_config_t modbus_cfg = {
-        .rs485 = g_rs485,
-        .response_timeout = timeout,
-    };
+    ESP_LOGI(TAG, "RS485/Modbus communication initialized");
 
-    ret = modbus_init(&modbus_cfg, &g_modbus);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize Modbus: %s", esp_err_to_name(ret));
-        rs485_deinit(g_rs485);
-        g_rs485 = NULL;
-        return ret;
+    // Register saved actuators and start polling them
+    actuator_registry_init();
+    actuator_registry_load_saved();
+    if (actuator_poller_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Actuator poller failed to start, status will be read on demand");
     }
 
-    ESP_LOGI(TAG, "RS485/Modbus communication initialized");
+    return ESP_OK;
+}
 
-    // Initialize mightyZAP actuator
-    esp_err_t act_ret = mightyzap_init(g_modbus, ACTUATOR_SLAVE_ID, &g_actuator);
-    if (act_ret == ESP_OK) {
-        ESP_LOGI(TAG, "mightyZAP actuator initialized (ID=%d)", ACTUATOR_SLAVE_ID);
-    } else {
-        ESP_LOGW(TAG, "mightyZAP init failed (may not be connected)");
-        g_actuator = NULL;
+// ============================================================================
+// Boot phases
+// ============================================================================
+
+static esp_err_t phase_config(void)
+{
+    // Configuration manager (includes SPIFFS)
+    return config_init();
+}
+
+static esp_err_t phase_bus(void)
+{
+    // Nothing on the bus waits for the network: actuators are registered
+    // and polled within milliseconds of power-on
+    esp_err_t ret = init_communication();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "RS485 init failed, web interface will still work");
+        actuator_registry_init();
     }
+    return ret;
+}
 
-    return ESP_OK;
+static esp_err_t phase_rtu_slave(void)
+{
+    // Modbus RTU slave (PLC port, if enabled)
+    return modbus_slave_start();
+}
+
+static esp_err_t phase_wifi(void)
+{
+    // NVS, netif and the default event loop; does not associate
+    return wifi_manager_init(NULL);
 }
 
 /**
- * @brief Initialize WiFi based on configuration
+ * @brief Join the saved network, or start the AP
  */
-static esp_err_t init_wifi(void)
+static esp_err_t phase_wifi_link(void)
 {
     esp_err_t ret;
 
-    // Initialize WiFi manager
-    ret = wifi_manager_init(NULL);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize WiFi manager: %s", esp_err_to_name(ret));
-        return ret;
-    }
-
     // Check if we have saved WiFi credentials
     const char *ssid = config_get_wifi_ssid();
     const char *password = config_get_wifi_password();
@@ -137,71 +125,97 @@ static esp_err_t init_wifi(void)
         ret = wifi_manager_start_ap(ap_ssid, ap_pass);
     }
 
+    // Print access information
+    char ip[16];
+    if (ret == ESP_OK && wifi_manager_get_ip(ip) == ESP_OK) {
+        ESP_LOGI(TAG, "==========================================");
+        ESP_LOGI(TAG, "  Web Interface: http://%s", ip);
+        ESP_LOGI(TAG, "==========================================");
+    }
+
     return ret;
 }
 
+static esp_err_t phase_web(void)
+{
+    // The server listens on every interface, so it does not wait for the
+    // link: it answers as soon as the STA or AP interface comes up
+    web_server_config_t web_cfg = {
+        .port = 80,
+        .username = config_get_web_username(),
+        .password = config_get_web_password(),
+        .auth_enabled = config_get_web_auth_enabled(),
+    };
+    return web_server_init(&web_cfg);
+}
+
+static esp_err_t phase_modbus_tcp(void)
+{
+#if CONFIG_MODBUS_TCP_ENABLE
+    // Modbus TCP gateway
+    return modbus_tcp_start();
+#else
+    return ESP_OK;
+#endif
+}
+
+enum {
+    PHASE_CONFIG,
+    PHASE_BUS,
+    PHASE_RTU_SLAVE,
+    PHASE_WIFI,
+    PHASE_WIFI_LINK,
+    PHASE_WEB,
+    PHASE_MODBUS_TCP,
+    PHASE_UDP_CONTROL,
+    PHASE_HEALTH,
+    PHASE_CPU_SAMPLER,
+    PHASE_COUNT,
+};
+
+static const boot_phase_t s_boot_phases[PHASE_COUNT] = {
+    [PHASE_CONFIG]      = { "config",      phase_config,          0, false, 6144 },
+    [PHASE_BUS]         = { "bus",         phase_bus,             BOOT_DEP(PHASE_CONFIG), true, 0 },
+    [PHASE_RTU_SLAVE]   = { "rtu_slave",   phase_rtu_slave,       BOOT_DEP(PHASE_BUS), true, 0 },
+    [PHASE_WIFI]        = { "wifi",        phase_wifi,            BOOT_DEP(PHASE_CONFIG), false, 0 },
+    [PHASE_WIFI_LINK]   = { "wifi_link",   phase_wifi_link,       BOOT_DEP(PHASE_WIFI), true, 0 },
+    [PHASE_WEB]         = { "web",         phase_web,             BOOT_DEP(PHASE_WIFI) | BOOT_DEP(PHASE_BUS), true, 6144 },
+    [PHASE_MODBUS_TCP]  = { "modbus_tcp",  phase_modbus_tcp,      BOOT_DEP(PHASE_WIFI) | BOOT_DEP(PHASE_BUS), true, 0 },
+    [PHASE_UDP_CONTROL] = { "udp_control", udp_control_start,     BOOT_DEP(PHASE_WIFI) | BOOT_DEP(PHASE_BUS), true, 0 },
+    [PHASE_HEALTH]      = { "health",      health_monitor_init,   BOOT_DEP(PHASE_WIFI) | BOOT_DEP(PHASE_BUS), true, 0 },
+    [PHASE_CPU_SAMPLER] = { "cpu_sampler", cpu_sampler_start,     0, true, 0 },
+};
+
 void app_main(void)
 {
     // Set log level to WARN (suppress INFO and DEBUG messages)
-    esp_log_level_set("*", ESP_LOG_WARN);
+    dlog_level_set("*", ESP_LOG_WARN);
 
     // Allow important startup messages
-    esp_log_level_set("MASTER", ESP_LOG_INFO);
+    dlog_level_set("MASTER", ESP_LOG_INFO);
+    dlog_level_set("BOOT", ESP_LOG_INFO);
+
+    // Print deferred (DLOGx) messages from a low-priority task
+    dlog_init();
+
+    // Count heap use per subsystem; cJSON allocates through it from here on
+    memprof_init();
 
     ESP_LOGI(TAG, "==========================================");
     ESP_LOGI(TAG, "  ESP32 Master - RS485 + Web Interface");
     ESP_LOGI(TAG, "==========================================");
 
-    // Initialize configuration manager (includes SPIFFS)
-    ESP_LOGI(TAG, "Initializing configuration...");
-    if (config_init() != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize configuration!");
-        return;
-    }
-
-    // Initialize RS485/Modbus communication
-    ESP_LOGI(TAG, "Initializing RS485/Modbus...");
-    if (init_communication() != ESP_OK) {
-        ESP_LOGW(TAG, "RS485 init failed, web interface will still work");
-    }
-
-    // Initialize WiFi
-    ESP_LOGI(TAG, "Initializing WiFi...");
-    if (init_wifi() != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize WiFi!");
+    // Each phase starts as soon as the phases it depends on are done
+    if (boot_start(s_boot_phases, PHASE_COUNT) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start boot phases!");
         return;
     }
 
-    // Wait for WiFi to be ready
-    vTaskDelay(pdMS_TO_TICKS(1000));
-
-    // Start web server
-    ESP_LOGI(TAG, "Starting web server...");
-    web_server_config_t web_cfg = {
-        .port = 80,
-        .username = config_get_web_username(),
-        .password = config_get_web_password(),
-        .auth_enabled = config_get_web_auth_enabled(),
-    };
-
-    if (web_server_init(&web_cfg) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start web server!");
-        return;
-    }
-
-    // Print access information
-    char ip[16];
-    if (wifi_manager_get_ip(ip) == ESP_OK) {
-        ESP_LOGI(TAG, "==========================================");
-        ESP_LOGI(TAG, "  Web Interface: http://%s", ip);
-        ESP_LOGI(TAG, "==========================================");
-    }
-
-    // Initialize health monitor (starts monitoring task)
-    ESP_LOGI(TAG, "Starting health monitor...");
-    if (health_monitor_init() != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to start health monitor");
+    esp_err_t ret = boot_wait(0, portMAX_DELAY);
+    int64_t end_us;
+    boot_get_times(NULL, &end_us);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "System ready with failed phases (see /api/boot)");
     }
-
-    ESP_LOGI(TAG, "System ready!");
+    ESP_LOGI(TAG, "System ready! (%lld ms)", end_us / 1000);
 }
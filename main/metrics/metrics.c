@@ -0,0 +1,159 @@
+/**
+ * @file metrics.c
+ * @brief Metrics registry exported as OpenMetrics text
+ */
+
+#include "metrics.h"
+#include <string.h>
+#include "esp_cpu.h"
+#include "export_writer.h"
+
+#define EXPORT_BUF_SIZE         1024
+
+static _Atomic(metric_t *) s_metrics;   // Registered metrics, last registered first
+
+// ============================================================================
+// Registration and updates
+// ============================================================================
+
+void metrics_register(metric_t *metric)
+{
+    if (metric == NULL || atomic_exchange(&metric->registered, true)) {
+        return;
+    }
+
+    metric_t *head = atomic_load(&s_metrics);
+    do {
+        metric->next = head;
+    } while (!atomic_compare_exchange_weak(&s_metrics, &head, metric));
+}
+
+static inline size_t cells_per_core(const metric_t *metric)
+{
+    return metric->type == METRIC_HISTOGRAM ? metric->num_bounds + 2 : 1;
+}
+
+/**
+ * @brief Cells of the calling core
+ *
+ * Call with interrupts masked: the task cannot move to the other core and
+ * nothing else on this core can update the cells, so plain 64-bit
+ * arithmetic is atomic without a lock.
+ */
+static inline uint64_t *local_cells(metric_t *metric)
+{
+    return &metric->cells[esp_cpu_get_core_id() * cells_per_core(metric)];
+}
+
+void metrics_counter_add(metric_t *metric, uint32_t n)
+{
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    local_cells(metric)[0] += n;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+void metrics_gauge_set(metric_t *metric, int32_t value)
+{
+    atomic_store_explicit(&metric->gauge, value, memory_order_relaxed);
+}
+
+void metrics_histogram_observe(metric_t *metric, uint32_t value)
+{
+    uint8_t bucket = 0;
+    while (bucket < metric->num_bounds && value > metric->bounds[bucket]) {
+        bucket++;                       // num_bounds is the +Inf bucket
+    }
+
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint64_t *cells = local_cells(metric);
+    cells[bucket]++;
+    cells[metric->num_bounds + 1] += value;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+/**
+ * @brief Read a cell that the other core may be updating
+ */
+static uint64_t read_cell(const uint64_t *cell)
+{
+    const volatile uint64_t *p = cell;
+    uint64_t a, b;
+    do {
+        a = *p;
+        b = *p;
+    } while (a != b);                   // Torn 32-bit halves
+    return a;
+}
+
+/**
+ * @brief Sum one cell over the cores
+ */
+static uint64_t sum_cell(const metric_t *metric, size_t index)
+{
+    size_t stride = cells_per_core(metric);
+    uint64_t sum = 0;
+    for (int core = 0; core < METRICS_CORES; core++) {
+        sum += read_cell(&metric->cells[core * stride + index]);
+    }
+    return sum;
+}
+
+uint64_t metrics_counter_get(const metric_t *metric)
+{
+    return metric != NULL && metric->type == METRIC_COUNTER ? sum_cell(metric, 0) : 0;
+}
+
+// ============================================================================
+// OpenMetrics export
+// ============================================================================
+
+static void write_metric(export_writer_t *ex, const metric_t *m)
+{
+    static const char *const type_names[] = { "counter", "gauge", "histogram" };
+
+    export_writer_printf(ex, "# TYPE %s %s\n# HELP %s %s\n", m->name, type_names[m->type], m->name, m->help);
+
+    switch (m->type) {
+        case METRIC_COUNTER:
+            export_writer_printf(ex, "%s_total %llu\n", m->name, (unsigned long long)sum_cell(m, 0));
+            break;
+
+        case METRIC_GAUGE: {
+            int64_t value = m->read ? m->read() : atomic_load_explicit(&m->gauge, memory_order_relaxed);
+            export_writer_printf(ex, "%s %lld\n", m->name, (long long)value);
+            break;
+        }
+
+        case METRIC_HISTOGRAM: {
+            // Buckets are stored per range and exported cumulative
+            uint64_t cumulative = 0;
+            for (uint8_t i = 0; i < m->num_bounds; i++) {
+                cumulative += sum_cell(m, i);
+                export_writer_printf(ex, "%s_bucket{le=\"%lu.0\"} %llu\n", m->name,
+                                     (unsigned long)m->bounds[i], (unsigned long long)cumulative);
+            }
+            cumulative += sum_cell(m, m->num_bounds);
+            export_writer_printf(ex, "%s_bucket{le=\"+Inf\"} %llu\n", m->name, (unsigned long long)cumulative);
+            export_writer_printf(ex, "%s_count %llu\n", m->name, (unsigned long long)cumulative);
+            export_writer_printf(ex, "%s_sum %llu\n", m->name, (unsigned long long)sum_cell(m, m->num_bounds + 1));
+            break;
+        }
+    }
+}
+
+esp_err_t metrics_export_openmetrics(metrics_write_fn write, void *ctx)
+{
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    static uint8_t buf[EXPORT_BUF_SIZE];    // Only the web server exports; keeps it off its stack
+    export_writer_t ex;
+    export_writer_init(&ex, buf, sizeof(buf), write, ctx);
+
+    for (const metric_t *m = atomic_load(&s_metrics); m != NULL && ex.err == ESP_OK; m = m->next) {
+        write_metric(&ex, m);
+    }
+    export_writer_printf(&ex, "# EOF\n");
+    return export_writer_finish(&ex);
+}
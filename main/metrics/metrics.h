@@ -0,0 +1,154 @@
+/**
+ * @file metrics.h
+ * @brief Metrics registry exported as OpenMetrics text
+ *
+ * Counters, gauges and fixed-bucket histograms are defined statically by
+ * the module that updates them (METRIC_xxx_DEFINE) and registered once with
+ * metrics_register(). Updates take no lock: counters and histograms keep
+ * one cell per core, updated with interrupts masked on the local core only,
+ * and the cells are summed when read. Gauges are either set explicitly or
+ * read through a callback at scrape time.
+ *
+ * The registry is served at GET /metrics for Prometheus-compatible
+ * scrapers.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_CORES           portNUM_PROCESSORS
+
+/**
+ * @brief Metric type
+ */
+typedef enum {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+} metric_type_t;
+
+/**
+ * @brief Metric (define with the METRIC_xxx_DEFINE macros)
+ */
+typedef struct metric {
+    const char *name;           // Family name; counters get "_total" appended
+    const char *help;
+    metric_type_t type;
+    const uint32_t *bounds;     // Histogram bucket upper bounds, ascending
+    uint8_t num_bounds;
+    int64_t (*read)(void);      // Gauge value read at scrape time (optional)
+    uint64_t *cells;            // Per core: counter 1, histogram num_bounds + 2 (buckets, +Inf, sum)
+    atomic_int gauge;           // Gauge value without a read callback
+    atomic_bool registered;
+    struct metric *next;
+} metric_t;
+
+/**
+ * @brief Write callback of the export
+ *
+ * @param ctx Caller context
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK to continue, anything else aborts the export
+ */
+typedef esp_err_t (*metrics_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+#define METRIC_COUNTER_DEFINE(var, name_, help_)                                \
+    static uint64_t var##_cells[METRICS_CORES];                                 \
+    static metric_t var = {                                                     \
+        .name = name_, .help = help_, .type = METRIC_COUNTER,                   \
+        .cells = var##_cells,                                                   \
+    }
+
+#define METRIC_GAUGE_DEFINE(var, name_, help_, read_fn)                         \
+    static metric_t var = {                                                     \
+        .name = name_, .help = help_, .type = METRIC_GAUGE,                     \
+        .read = read_fn,                                                        \
+    }
+
+#define METRIC_HISTOGRAM_DEFINE(var, name_, help_, ...)                         \
+    static const uint32_t var##_bounds[] = { __VA_ARGS__ };                     \
+    static uint64_t var##_cells[METRICS_CORES *                                 \
+                                (sizeof(var##_bounds) / sizeof(uint32_t) + 2)]; \
+    static metric_t var = {                                                     \
+        .name = name_, .help = help_, .type = METRIC_HISTOGRAM,                 \
+        .bounds = var##_bounds,                                                 \
+        .num_bounds = sizeof(var##_bounds) / sizeof(uint32_t),                  \
+        .cells = var##_cells,                                                   \
+    }
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Add a metric to the registry (calling it again is a no-op)
+ *
+ * Unregistered metrics are updated but not exported.
+ *
+ * @param metric Metric
+ */
+void metrics_register(metric_t *metric);
+
+/**
+ * @brief Add to a counter (safe from any task and from interrupts)
+ *
+ * @param metric Counter
+ * @param n Increment
+ */
+void metrics_counter_add(metric_t *metric, uint32_t n);
+
+static inline void metrics_counter_inc(metric_t *metric)
+{
+    metrics_counter_add(metric, 1);
+}
+
+/**
+ * @brief Get the value of a counter (sum of the cores)
+ *
+ * @param metric Counter
+ * @return uint64_t Value
+ */
+uint64_t metrics_counter_get(const metric_t *metric);
+
+/**
+ * @brief Set a gauge
+ *
+ * @param metric Gauge
+ * @param value Value
+ */
+void metrics_gauge_set(metric_t *metric, int32_t value);
+
+/**
+ * @brief Count an observation in a histogram (safe from any task and from interrupts)
+ *
+ * @param metric Histogram
+ * @param value Observed value, in the unit of the bucket bounds
+ */
+void metrics_histogram_observe(metric_t *metric, uint32_t value);
+
+/**
+ * @brief Write all registered metrics as OpenMetrics text
+ *
+ * @param write Write callback
+ * @param ctx Context passed to the callback
+ * @return esp_err_t ESP_OK on success, the callback's error otherwise
+ */
+esp_err_t metrics_export_openmetrics(metrics_write_fn write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_H
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
+#include "dlog.h"
+#include "tracepoint.h"
+#include "memprof.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -24,7 +27,7 @@ esp_err_t mightyzap_init(modbus_handle_t modbus, uint8_t slave_id, mightyzap_han
         return ESP_ERR_INVALID_ARG;
     }
 
-    struct mightyzap *zap = calloc(1, sizeof(struct mightyzap));
+    struct mightyzap *zap = memprof_calloc(MEMPROF_TAG_DRIVER, 1, sizeof(struct mightyzap));
     if (zap == NULL) {
         ESP_LOGE(TAG, "Failed to allocate mightyZAP structure");
         return ESP_ERR_NO_MEM;
@@ -48,7 +51,7 @@ esp_err_t mightyzap_deinit(mightyzap_handle_t handle)
         return ESP_ERR_INVALID_ARG;
     }
 
-    free(handle);
+    memprof_free(MEMPROF_TAG_DRIVER, handle);
     return ESP_OK;
 }
 
@@ -90,7 +93,7 @@ esp_err_t mightyzap_set_force_enable(mightyzap_handle_t handle, bool enable)
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGD(TAG, "ID=%u: Force %s", handle->slave_id, enable ? "ON" : "OFF");
+    DLOGD(TAG, "ID=%u: Force %s", handle->slave_id, enable ? "ON" : "OFF");
     return modbus_write_single_register(handle->modbus, handle->slave_id,
                                         MZAP_REG_FORCE_ON_OFF, enable ? 1 : 0);
 }
@@ -101,9 +104,12 @@ esp_err_t mightyzap_set_position(mightyzap_handle_t handle, uint16_t position)
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGD(TAG, "ID=%u: Set position=%u", handle->slave_id, position);
-    return modbus_write_single_register(handle->modbus, handle->slave_id,
-                                        MZAP_REG_GOAL_POSITION, position);
+    DLOGD(TAG, "ID=%u: Set position=%u", handle->slave_id, position);
+    TRACE_BEGIN("mzap_set_position");
+    esp_err_t ret = modbus_write_single_register(handle->modbus, handle->slave_id,
+                                                 MZAP_REG_GOAL_POSITION, position);
+    TRACE_END("mzap_set_position");
+    return ret;
 }
 
 esp_err_t mightyzap_set_speed(mightyzap_handle_t handle, uint16_t speed)
@@ -116,12 +122,12 @@ esp_err_t mightyzap_set_speed(mightyzap_handle_t handle, uint16_t speed)
     cache_limits(handle);
 
     if (speed > handle->speed_limit) {
-        ESP_LOGW(TAG, "ID=%u: Clamping speed %u to limit %u",
+        DLOGW(TAG, "ID=%u: Clamping speed %u to limit %u",
                  handle->slave_id, speed, handle->speed_limit);
         speed = handle->speed_limit;
     }
 
-    ESP_LOGD(TAG, "ID=%u: Set speed=%u", handle->slave_id, speed);
+    DLOGD(TAG, "ID=%u: Set speed=%u", handle->slave_id, speed);
     return modbus_write_single_register(handle->modbus, handle->slave_id,
                                         MZAP_REG_GOAL_SPEED, speed);
 }
@@ -136,12 +142,12 @@ esp_err_t mightyzap_set_current(mightyzap_handle_t handle, uint16_t current)
     cache_limits(handle);
 
     if (current > handle->current_limit) {
-        ESP_LOGW(TAG, "ID=%u: Clamping current %u to limit %u",
+        DLOGW(TAG, "ID=%u: Clamping current %u to limit %u",
                  handle->slave_id, current, handle->current_limit);
         current = handle->current_limit;
     }
 
-    ESP_LOGD(TAG, "ID=%u: Set current=%u", handle->slave_id, current);
+    DLOGD(TAG, "ID=%u: Set current=%u", handle->slave_id, current);
     return modbus_write_single_register(handle->modbus, handle->slave_id,
                                         MZAP_REG_GOAL_CURRENT, current);
 }
@@ -157,24 +163,27 @@ esp_err_t mightyzap_set_goal(mightyzap_handle_t handle, uint16_t position, uint1
 
     // Clamp speed and current to their limits
     if (speed > handle->speed_limit) {
-        ESP_LOGW(TAG, "ID=%u: Clamping speed %u to limit %u",
+        DLOGW(TAG, "ID=%u: Clamping speed %u to limit %u",
                  handle->slave_id, speed, handle->speed_limit);
         speed = handle->speed_limit;
     }
     if (current > handle->current_limit) {
-        ESP_LOGW(TAG, "ID=%u: Clamping current %u to limit %u",
+        DLOGW(TAG, "ID=%u: Clamping current %u to limit %u",
                  handle->slave_id, current, handle->current_limit);
         current = handle->current_limit;
     }
 
-    ESP_LOGD(TAG, "ID=%u: Set goal pos=%u, spd=%u, cur=%u",
+    DLOGD(TAG, "ID=%u: Set goal pos=%u, spd=%u, cur=%u",
              handle->slave_id, position, speed, current);
 
     // Write all goal registers in a single transaction (3 consecutive registers)
     // 0x0034: Position, 0x0035: Speed, 0x0036: Current
     uint16_t regs[3] = {position, speed, current};
-    return modbus_write_multiple_registers(handle->modbus, handle->slave_id,
-                                          MZAP_REG_GOAL_POSITION, 3, regs);
+    TRACE_BEGIN("mzap_set_goal");
+    esp_err_t ret = modbus_write_multiple_registers(handle->modbus, handle->slave_id,
+                                                    MZAP_REG_GOAL_POSITION, 3, regs);
+    TRACE_END("mzap_set_goal");
+    return ret;
 }
 
 esp_err_t mightyzap_get_position(mightyzap_handle_t handle, uint16_t *position)
@@ -196,19 +205,58 @@ esp_err_t mightyzap_get_status(mightyzap_handle_t handle, mightyzap_status_t *st
     // Read all status registers in a single transaction (5 consecutive registers)
     // 0x0037: Position, 0x0038: Current, 0x0039: Motor Op, 0x003A: Voltage, 0x003B: Moving
     uint16_t regs[5];
+    TRACE_BEGIN("mzap_get_status");
     esp_err_t ret = modbus_read_holding_registers(handle->modbus, handle->slave_id,
                                                    MZAP_REG_PRESENT_POSITION, 5, regs);
+    TRACE_END("mzap_get_status");
     if (ret != ESP_OK) return ret;
 
     status->position = regs[0];  // 0x0037
     status->current = regs[1];   // 0x0038
-    // regs[2] is Motor Operating Rate (0x0039) - not used in status struct
+    status->motor_op = regs[2];  // 0x0039
     status->voltage = regs[3];   // 0x003A
     status->moving = regs[4] & 0xFF;  // 0x003B
 
     return ESP_OK;
 }
 
+esp_err_t mightyzap_get_hw_error(mightyzap_handle_t handle, uint16_t *error)
+{
+    if (handle == NULL || error == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return modbus_read_holding_registers(handle->modbus, handle->slave_id,
+                                         MZAP_REG_HW_ERROR_STATE, 1, error);
+}
+
+esp_err_t mightyzap_get_info(mightyzap_handle_t handle, mightyzap_info_t *info)
+{
+    if (handle == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Read the whole non-volatile block in a single transaction (0x0000-0x000E)
+    uint16_t regs[MZAP_REG_CURRENT_LIMIT + 1];
+    esp_err_t ret = modbus_read_holding_registers(handle->modbus, handle->slave_id,
+                                                   MZAP_REG_MODEL_NUMBER,
+                                                   MZAP_REG_CURRENT_LIMIT + 1, regs);
+    if (ret != ESP_OK) return ret;
+
+    info->model = regs[MZAP_REG_MODEL_NUMBER];
+    info->firmware = regs[MZAP_REG_FIRMWARE_VERSION];
+    info->short_stroke = regs[MZAP_REG_SHORT_STROKE_LIM];
+    info->long_stroke = regs[MZAP_REG_LONG_STROKE_LIM];
+    info->speed_limit = regs[MZAP_REG_SPEED_LIMIT];
+    info->current_limit = regs[MZAP_REG_CURRENT_LIMIT];
+
+    handle->speed_limit = info->speed_limit;
+    handle->current_limit = info->current_limit;
+    handle->limits_cached = true;
+
+    return ESP_OK;
+}
+
 esp_err_t mightyzap_is_moving(mightyzap_handle_t handle, bool *moving)
 {
     if (handle == NULL || moving == NULL) {
@@ -271,3 +319,52 @@ esp_err_t mightyzap_factory_reset(mightyzap_handle_t handle)
     return modbus_write_single_register(handle->modbus, handle->slave_id,
                                         MZAP_REG_FACTORY_RESET, 1);
 }
+
+esp_err_t mightyzap_read_registers(mightyzap_handle_t handle, uint16_t start_reg,
+                                   uint16_t count, uint16_t *values)
+{
+    if (handle == NULL || values == NULL || count == 0 || count > 125) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return modbus_read_holding_registers(handle->modbus, handle->slave_id,
+                                         start_reg, count, values);
+}
+
+esp_err_t mightyzap_write_registers(mightyzap_handle_t handle, uint16_t start_reg,
+                                    uint16_t count, const uint16_t *values)
+{
+    if (handle == NULL || values == NULL || count == 0 || count > MZAP_WRITE_MAX_REGS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t regs[MZAP_WRITE_MAX_REGS];
+    memcpy(regs, values, count * sizeof(uint16_t));
+
+    // Same limits as the single-register setters
+    uint16_t *speed = NULL, *current = NULL;
+    if (start_reg <= MZAP_REG_GOAL_SPEED && start_reg + count > MZAP_REG_GOAL_SPEED) {
+        speed = &regs[MZAP_REG_GOAL_SPEED - start_reg];
+    }
+    if (start_reg <= MZAP_REG_GOAL_CURRENT && start_reg + count > MZAP_REG_GOAL_CURRENT) {
+        current = &regs[MZAP_REG_GOAL_CURRENT - start_reg];
+    }
+    if (speed != NULL || current != NULL) {
+        cache_limits(handle);
+    }
+    if (speed != NULL && *speed > handle->speed_limit) {
+        DLOGW(TAG, "ID=%u: Clamping speed %u to limit %u",
+                 handle->slave_id, *speed, handle->speed_limit);
+        *speed = handle->speed_limit;
+    }
+    if (current != NULL && *current > handle->current_limit) {
+        DLOGW(TAG, "ID=%u: Clamping current %u to limit %u",
+                 handle->slave_id, *current, handle->current_limit);
+        *current = handle->current_limit;
+    }
+
+    if (count == 1) {
+        return modbus_write_single_register(handle->modbus, handle->slave_id, start_reg, regs[0]);
+    }
+    return modbus_write_multiple_registers(handle->modbus, handle->slave_id, start_reg, count, regs);
+}
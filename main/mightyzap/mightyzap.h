@@ -72,10 +72,23 @@ typedef struct mightyzap* mightyzap_handle_t;
 typedef struct {
     uint16_t position;          // Present position (0-4095 typical)
     uint16_t current;           // Present current (mA)
+    uint16_t motor_op;          // Motor operating rate
     uint16_t voltage;           // Present voltage (0.1V units)
     uint8_t moving;             // Moving status (0=stopped, 1=moving)
 } mightyzap_status_t;
 
+/**
+ * @brief mightyZAP identity and limits (non-volatile memory)
+ */
+typedef struct {
+    uint16_t model;             // Model number
+    uint16_t firmware;          // Firmware version
+    uint16_t short_stroke;      // Short stroke limit
+    uint16_t long_stroke;       // Long stroke limit
+    uint16_t speed_limit;       // Speed limit
+    uint16_t current_limit;     // Current limit
+} mightyzap_info_t;
+
 /**
  * @brief Initialize mightyZAP driver
  *
@@ -168,6 +181,26 @@ esp_err_t mightyzap_get_position(mightyzap_handle_t handle, uint16_t *position);
  */
 esp_err_t mightyzap_get_status(mightyzap_handle_t handle, mightyzap_status_t *status);
 
+/**
+ * @brief Read hardware error state
+ *
+ * @param handle mightyZAP handle
+ * @param error Pointer to store error bits (0 = no error)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t mightyzap_get_hw_error(mightyzap_handle_t handle, uint16_t *error);
+
+/**
+ * @brief Read identity and limits from non-volatile memory
+ *
+ * Also refreshes the cached speed/current limits used to clamp goals.
+ *
+ * @param handle mightyZAP handle
+ * @param info Pointer to store info
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t mightyzap_get_info(mightyzap_handle_t handle, mightyzap_info_t *info);
+
 /**
  * @brief Check if motor is moving
  *
@@ -211,6 +244,39 @@ esp_err_t mightyzap_restart(mightyzap_handle_t handle);
  */
 esp_err_t mightyzap_factory_reset(mightyzap_handle_t handle);
 
+/**
+ * @brief Maximum registers per mightyzap_write_registers() call (FC 0x10 limit)
+ */
+#define MZAP_WRITE_MAX_REGS     123
+
+/**
+ * @brief Read consecutive registers (FC 0x03)
+ *
+ * @param handle mightyZAP handle
+ * @param start_reg First register
+ * @param count Number of registers (1-125)
+ * @param values Buffer to store the values
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t mightyzap_read_registers(mightyzap_handle_t handle, uint16_t start_reg,
+                                   uint16_t count, uint16_t *values);
+
+/**
+ * @brief Write consecutive registers in one transaction
+ *
+ * FC 0x06 for one register, FC 0x10 otherwise. Goal speed and goal current
+ * are clamped to the actuator's limits as in mightyzap_set_speed() and
+ * mightyzap_set_current().
+ *
+ * @param handle mightyZAP handle
+ * @param start_reg First register
+ * @param count Number of registers (1-MZAP_WRITE_MAX_REGS)
+ * @param values Values to write
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t mightyzap_write_registers(mightyzap_handle_t handle, uint16_t start_reg,
+                                    uint16_t count, const uint16_t *values);
+
 #ifdef __cplusplus
 }
 #endif
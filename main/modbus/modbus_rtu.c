@@ -1,9 +1,15 @@
 #include "modbus_rtu.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "esp_log.h"
+#include "dlog.h"
+#include "tracepoint.h"
+#include "metrics.h"
+#include "memprof.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 
 static const char *TAG = "MODBUS";
 
@@ -11,6 +17,22 @@ static const char *TAG = "MODBUS";
 #define MODBUS_RETRY_COUNT 3
 #define MODBUS_RETRY_BASE_DELAY_MS 100
 
+#define MODBUS_MAX_SLAVE_ADDR   247
+#define MODBUS_BROADCAST_ADDR   0       // Every slave acts on it, none replies
+#define MODBUS_HEADER_LEN       3       // Addr + FC + first data byte
+#define MODBUS_EXCEPTION_LEN    5       // Addr + FC|0x80 + code + CRC
+#define MODBUS_BITS_PER_CHAR    10      // 8N1
+#define MODBUS_MIN_TIMEOUT_US   1000
+
+/**
+ * @brief Response timing estimator state for one slave
+ */
+typedef struct {
+    uint32_t srtt_us;
+    uint32_t rttvar_us;
+    uint32_t rto_us;
+} slave_rtt_t;
+
 /**
  * @brief Internal Modbus RTU structure
  */
@@ -18,10 +40,23 @@ struct modbus_rtu {
     rs485_handle_t rs485;
     uint32_t response_timeout;
     modbus_exception_t last_exception;
+    uint32_t char_time_us;              // Time on the wire for one character
+    uint32_t min_timeout_us;            // Lower bound for the response timeout
+    uint32_t max_timeout_us;            // Upper bound (configured timeout)
+    slave_rtt_t rtt[MODBUS_MAX_SLAVE_ADDR + 1];
 };
 
-// Global statistics for diagnostics
-static modbus_stats_t s_modbus_stats = {0};
+// Statistics for diagnostics, summed over all buses
+METRIC_COUNTER_DEFINE(s_m_requests, "modbus_requests", "Modbus RTU requests sent");
+METRIC_COUNTER_DEFINE(s_m_responses, "modbus_responses", "Valid Modbus RTU responses received");
+METRIC_COUNTER_DEFINE(s_m_errors, "modbus_errors", "Failed Modbus RTU transactions");
+METRIC_COUNTER_DEFINE(s_m_timeouts, "modbus_timeouts", "Modbus RTU transactions without a response");
+METRIC_COUNTER_DEFINE(s_m_crc_errors, "modbus_crc_errors", "Modbus RTU responses with a bad CRC");
+METRIC_HISTOGRAM_DEFINE(s_m_exchange_us, "modbus_exchange_microseconds",
+                        "Modbus RTU exchange time, lock wait included",
+                        1000, 2000, 5000, 10000, 20000, 50000, 100000, 250000);
+
+static modbus_stats_t s_stats_base;     // Values at the last modbus_reset_stats()
 
 // CRC16 lookup table for Modbus
 static const uint16_t crc_table[256] = {
@@ -71,13 +106,48 @@ uint16_t modbus_crc16(const uint8_t *data, size_t len)
     return crc;
 }
 
+size_t modbus_frame_build(uint8_t *frame, uint8_t slave_addr, const uint8_t *pdu, size_t pdu_len)
+{
+    frame[0] = slave_addr;
+    memcpy(&frame[1], pdu, pdu_len);
+
+    uint16_t crc = modbus_crc16(frame, pdu_len + 1);
+    frame[pdu_len + 1] = crc & 0xFF;
+    frame[pdu_len + 2] = (crc >> 8) & 0xFF;
+    return pdu_len + 3;
+}
+
+bool modbus_frame_valid(const uint8_t *frame, size_t len)
+{
+    // Address + function code + CRC at least; CRC over the whole frame is 0
+    return len >= 4 && modbus_crc16(frame, len) == 0;
+}
+
+size_t modbus_request_frame_len(const uint8_t *frame, size_t len)
+{
+    if (len < 2) {
+        return 0;
+    }
+
+    switch (frame[1]) {
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            return 8;   // Addr, FC, 2 x 16-bit field, CRC
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return len < 7 ? 0 : 9 + frame[6];
+        default:
+            return SIZE_MAX;
+    }
+}
+
 esp_err_t modbus_init(const modbus_config_t *config, modbus_handle_t *handle)
 {
     if (config == NULL || handle == NULL || config->rs485 == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    struct modbus_rtu *mb = calloc(1, sizeof(struct modbus_rtu));
+    struct modbus_rtu *mb = memprof_calloc(MEMPROF_TAG_MODBUS, 1, sizeof(struct modbus_rtu));
     if (mb == NULL) {
         ESP_LOGE(TAG, "Failed to allocate Modbus structure");
         return ESP_ERR_NO_MEM;
@@ -87,7 +157,32 @@ esp_err_t modbus_init(const modbus_config_t *config, modbus_handle_t *handle)
     mb->response_timeout = config->response_timeout > 0 ? config->response_timeout : 100;
     mb->last_exception = MODBUS_EX_NONE;
 
-    ESP_LOGI(TAG, "Modbus RTU master initialized, timeout=%lu ms", mb->response_timeout);
+    // A slave must keep the line silent for 3.5 characters before replying
+    int baud = rs485_get_baud_rate(mb->rs485);
+    mb->char_time_us = baud > 0 ? (MODBUS_BITS_PER_CHAR * 1000000 + baud - 1) / baud : 200;
+    mb->max_timeout_us = mb->response_timeout * 1000;
+    mb->min_timeout_us = 4 * mb->char_time_us;
+    if (mb->min_timeout_us < MODBUS_MIN_TIMEOUT_US) {
+        mb->min_timeout_us = MODBUS_MIN_TIMEOUT_US;
+    }
+    if (mb->min_timeout_us > mb->max_timeout_us) {
+        mb->min_timeout_us = mb->max_timeout_us;
+    }
+
+    // Slaves without samples use the configured maximum
+    for (int i = 0; i <= MODBUS_MAX_SLAVE_ADDR; i++) {
+        mb->rtt[i].rto_us = mb->max_timeout_us;
+    }
+
+    metrics_register(&s_m_requests);
+    metrics_register(&s_m_responses);
+    metrics_register(&s_m_errors);
+    metrics_register(&s_m_timeouts);
+    metrics_register(&s_m_crc_errors);
+    metrics_register(&s_m_exchange_us);
+
+    ESP_LOGI(TAG, "Modbus RTU master initialized, timeout=%lu..%lu us",
+             mb->min_timeout_us, mb->max_timeout_us);
 
     *handle = mb;
     return ESP_OK;
@@ -99,7 +194,7 @@ esp_err_t modbus_deinit(modbus_handle_t handle)
         return ESP_ERR_INVALID_ARG;
     }
 
-    free(handle);
+    memprof_free(MEMPROF_TAG_MODBUS, handle);
     return ESP_OK;
 }
 
@@ -111,14 +206,203 @@ modbus_exception_t modbus_get_last_exception(modbus_handle_t handle)
     return handle->last_exception;
 }
 
-const modbus_stats_t* modbus_get_stats(void)
+/**
+ * @brief Read the counters since boot
+ */
+static void read_counters(modbus_stats_t *stats)
+{
+    stats->tx_count = metrics_counter_get(&s_m_requests);
+    stats->rx_count = metrics_counter_get(&s_m_responses);
+    stats->error_count = metrics_counter_get(&s_m_errors);
+    stats->timeout_count = metrics_counter_get(&s_m_timeouts);
+    stats->crc_error_count = metrics_counter_get(&s_m_crc_errors);
+    stats->retry_count = 0;
+}
+
+void modbus_get_stats(modbus_stats_t *stats)
 {
-    return &s_modbus_stats;
+    if (stats == NULL) {
+        return;
+    }
+    read_counters(stats);
+    stats->tx_count -= s_stats_base.tx_count;
+    stats->rx_count -= s_stats_base.rx_count;
+    stats->error_count -= s_stats_base.error_count;
+    stats->timeout_count -= s_stats_base.timeout_count;
+    stats->crc_error_count -= s_stats_base.crc_error_count;
 }
 
 void modbus_reset_stats(void)
 {
-    memset(&s_modbus_stats, 0, sizeof(s_modbus_stats));
+    // The exported counters keep counting; only this view restarts at zero
+    read_counters(&s_stats_base);
+}
+
+esp_err_t modbus_get_slave_timing(modbus_handle_t handle, uint8_t slave_addr,
+                                  modbus_slave_timing_t *timing)
+{
+    if (handle == NULL || timing == NULL || slave_addr > MODBUS_MAX_SLAVE_ADDR) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const slave_rtt_t *rtt = &handle->rtt[slave_addr];
+    timing->srtt_us = rtt->srtt_us;
+    timing->rttvar_us = rtt->rttvar_us;
+    timing->timeout_us = rtt->rto_us;
+    return ESP_OK;
+}
+
+// ============================================================================
+// Response timing
+// ============================================================================
+
+static uint32_t clamp_timeout(modbus_handle_t handle, uint32_t timeout_us)
+{
+    if (timeout_us < handle->min_timeout_us) return handle->min_timeout_us;
+    if (timeout_us > handle->max_timeout_us) return handle->max_timeout_us;
+    return timeout_us;
+}
+
+/**
+ * @brief Feed a round-trip sample into the slave's estimator
+ */
+static void rtt_sample(modbus_handle_t handle, uint8_t slave_addr, uint32_t sample_us)
+{
+    slave_rtt_t *rtt = &handle->rtt[slave_addr];
+
+    if (rtt->srtt_us == 0) {
+        rtt->srtt_us = sample_us > 0 ? sample_us : 1;
+        rtt->rttvar_us = sample_us / 2;
+    } else {
+        uint32_t delta = sample_us > rtt->srtt_us ? sample_us - rtt->srtt_us
+                                                  : rtt->srtt_us - sample_us;
+        rtt->rttvar_us = (3 * rtt->rttvar_us + delta) / 4;
+        rtt->srtt_us = (7 * rtt->srtt_us + sample_us) / 8;
+    }
+
+    rtt->rto_us = clamp_timeout(handle, rtt->srtt_us + 4 * rtt->rttvar_us);
+}
+
+/**
+ * @brief Back off the slave's timeout after a missed response
+ */
+static void rtt_backoff(modbus_handle_t handle, uint8_t slave_addr)
+{
+    slave_rtt_t *rtt = &handle->rtt[slave_addr];
+    rtt->rto_us = clamp_timeout(handle, rtt->rto_us * 2);
+}
+
+static inline uint32_t us_to_ms(uint32_t us)
+{
+    // Round up, plus one tick of slack for the phase of the tick counter
+    return (us + 999) / 1000 + portTICK_PERIOD_MS;
+}
+
+/**
+ * @brief Run one request/response exchange on the bus
+ *
+ * The slave's adaptive timeout covers its turnaround time; the time the
+ * expected response spends on the wire is added on top. Once the header is
+ * in, the remaining length is known (normal or exception response), so the
+ * rest of the frame is read with a deadline based on its wire time instead
+ * of the full response timeout.
+ *
+ * A broadcast request is only sent: no response is awaited and no sample
+ * is taken.
+ */
+static esp_err_t modbus_exchange(modbus_handle_t handle,
+                                 const uint8_t *request, size_t req_len,
+                                 uint8_t *response, size_t *received,
+                                 size_t expected_len)
+{
+    uint8_t slave_addr = request[0];
+    esp_err_t ret;
+
+    *received = 0;
+    if (slave_addr > MODBUS_MAX_SLAVE_ADDR) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (slave_addr == MODBUS_BROADCAST_ADDR) {
+        ret = rs485_lock(handle->rs485, handle->response_timeout);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        ret = rs485_send(handle->rs485, request, req_len, handle->response_timeout);
+        rs485_unlock(handle->rs485);
+        return ret;
+    }
+
+    if (expected_len < MODBUS_EXCEPTION_LEN || expected_len > MODBUS_MAX_PDU_SIZE) {
+        expected_len = MODBUS_MAX_PDU_SIZE;
+    }
+
+    // Bytes are handed over by the UART once the frame ends (RX idle timeout)
+    uint32_t wire_us = (expected_len + RS485_RX_TIMEOUT_SYMBOLS) * handle->char_time_us;
+    uint32_t lo_us = wire_us + handle->min_timeout_us;
+    uint32_t hi_us = handle->max_timeout_us > lo_us ? handle->max_timeout_us : lo_us;
+    uint32_t timeout_us = handle->rtt[slave_addr].rto_us + wire_us;
+    if (timeout_us < lo_us) timeout_us = lo_us;
+    if (timeout_us > hi_us) timeout_us = hi_us;
+
+    TRACE_COUNTER("mb_timeout_us", timeout_us);
+
+    ret = rs485_lock(handle->rs485, handle->response_timeout);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    rs485_flush_rx(handle->rs485);
+
+    ret = rs485_send(handle->rs485, request, req_len, handle->response_timeout);
+    if (ret != ESP_OK) {
+        rs485_unlock(handle->rs485);
+        return ret;
+    }
+
+    // Turnaround: from the end of the request to the response header
+    TRACE_BEGIN("mb_turnaround");
+    int64_t start = esp_timer_get_time();
+    size_t got = 0;
+    ret = rs485_receive(handle->rs485, response, MODBUS_HEADER_LEN, &got, us_to_ms(timeout_us));
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start);
+    TRACE_END("mb_turnaround");
+
+    if (ret == ESP_ERR_TIMEOUT) {
+        rtt_backoff(handle, slave_addr);
+    }
+    if (ret != ESP_OK || got < MODBUS_HEADER_LEN) {
+        rs485_trace_rx(handle->rs485, response, got);
+        rs485_unlock(handle->rs485);
+        *received = got;
+        return ret;
+    }
+
+    size_t frame_len = (response[1] & 0x80) ? MODBUS_EXCEPTION_LEN : expected_len;
+
+    if (response[0] == slave_addr) {
+        uint32_t frame_us = (frame_len + RS485_RX_TIMEOUT_SYMBOLS) * handle->char_time_us;
+        rtt_sample(handle, slave_addr, elapsed_us > frame_us ? elapsed_us - frame_us : 0);
+    }
+
+    if (frame_len > got) {
+        size_t remaining = frame_len - got;
+        uint32_t tail_us = (remaining + RS485_RX_TIMEOUT_SYMBOLS) * handle->char_time_us;
+        size_t tail = 0;
+
+        TRACE_BEGIN("mb_rx_tail");
+        ret = rs485_receive(handle->rs485, response + got, remaining, &tail, us_to_ms(tail_us));
+        TRACE_END("mb_rx_tail");
+        got += tail;
+        if (ret == ESP_ERR_TIMEOUT) {
+            ret = ESP_OK;  // Short frame, rejected by the length/CRC checks
+        }
+    }
+
+    rs485_trace_rx(handle->rs485, response, got);
+    rs485_unlock(handle->rs485);
+    *received = got;
+    return ret;
 }
 
 static esp_err_t modbus_send_receive(modbus_handle_t handle,
@@ -129,27 +413,33 @@ static esp_err_t modbus_send_receive(modbus_handle_t handle,
     esp_err_t ret;
     size_t received = 0;
 
-    s_modbus_stats.tx_count++;
+    metrics_counter_inc(&s_m_requests);
 
     // Send request and receive response
-    ret = rs485_transaction(handle->rs485,
-                           request, req_len,
-                           response, MODBUS_MAX_PDU_SIZE, &received,
-                           handle->response_timeout);
+    TRACE_BEGIN("mb_exchange");
+    int64_t start = esp_timer_get_time();
+    ret = modbus_exchange(handle, request, req_len, response, &received, expected_len);
+    metrics_histogram_observe(&s_m_exchange_us, (uint32_t)(esp_timer_get_time() - start));
+    TRACE_END("mb_exchange");
 
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "RS485 transaction failed: %s", esp_err_to_name(ret));
-        s_modbus_stats.error_count++;
+        DLOGE(TAG, "RS485 transaction failed: %s", esp_err_to_name(ret));
+        metrics_counter_inc(&s_m_errors);
         if (ret == ESP_ERR_TIMEOUT) {
-            s_modbus_stats.timeout_count++;
+            metrics_counter_inc(&s_m_timeouts);
         }
         return ret;
     }
 
+    if (request[0] == MODBUS_BROADCAST_ADDR) {
+        *resp_len = 0;
+        return ESP_OK;
+    }
+
     // Check minimum response length (addr + fc + crc)
     if (received < 4) {
-        ESP_LOGE(TAG, "Response too short: %u bytes", received);
-        s_modbus_stats.error_count++;
+        DLOGE(TAG, "Response too short: %u bytes", received);
+        metrics_counter_inc(&s_m_errors);
         return ESP_ERR_INVALID_RESPONSE;
     }
 
@@ -158,22 +448,23 @@ static esp_err_t modbus_send_receive(modbus_handle_t handle,
     uint16_t calc_crc = modbus_crc16(response, received - 2);
 
     if (recv_crc != calc_crc) {
-        ESP_LOGE(TAG, "CRC mismatch: recv=0x%04X, calc=0x%04X", recv_crc, calc_crc);
-        s_modbus_stats.error_count++;
-        s_modbus_stats.crc_error_count++;
+        DLOGE(TAG, "CRC mismatch: recv=0x%04X, calc=0x%04X", recv_crc, calc_crc);
+        metrics_counter_inc(&s_m_errors);
+        metrics_counter_inc(&s_m_crc_errors);
         return ESP_ERR_INVALID_CRC;
     }
 
-    // Check for exception response
+    // Check for exception response (length kept for modbus_transact())
     if (response[1] & 0x80) {
         handle->last_exception = response[2];
-        ESP_LOGE(TAG, "Modbus exception: 0x%02X", response[2]);
-        s_modbus_stats.error_count++;
+        DLOGE(TAG, "Modbus exception: 0x%02X", response[2]);
+        metrics_counter_inc(&s_m_errors);
+        *resp_len = received;
         return ESP_ERR_INVALID_RESPONSE;
     }
 
     handle->last_exception = MODBUS_EX_NONE;
-    s_modbus_stats.rx_count++;
+    metrics_counter_inc(&s_m_responses);
     *resp_len = received;
     return ESP_OK;
 }
@@ -184,7 +475,8 @@ esp_err_t modbus_read_holding_registers(modbus_handle_t handle,
                                         uint16_t num_regs,
                                         uint16_t *values)
 {
-    if (handle == NULL || values == NULL || num_regs == 0 || num_regs > 125) {
+    if (handle == NULL || values == NULL || num_regs == 0 || num_regs > 125 ||
+        slave_addr == MODBUS_BROADCAST_ADDR || slave_addr > MODBUS_MAX_SLAVE_ADDR) {
         return ESP_ERR_INVALID_ARG;
     }
 
@@ -204,7 +496,7 @@ esp_err_t modbus_read_holding_registers(modbus_handle_t handle,
     request[6] = crc & 0xFF;
     request[7] = (crc >> 8) & 0xFF;
 
-    ESP_LOGD(TAG, "Read regs: addr=%u, start=0x%04X, count=%u",
+    DLOGD(TAG, "Read regs: addr=%u, start=0x%04X, count=%u",
              slave_addr, start_reg, num_regs);
 
     esp_err_t ret = modbus_send_receive(handle, request, 8, response, &resp_len,
@@ -216,7 +508,7 @@ esp_err_t modbus_read_holding_registers(modbus_handle_t handle,
     // Parse response: [Addr][FC][ByteCount][Data...][CRC]
     uint8_t byte_count = response[2];
     if (byte_count != num_regs * 2) {
-        ESP_LOGE(TAG, "Unexpected byte count: %u (expected %u)", byte_count, num_regs * 2);
+        DLOGE(TAG, "Unexpected byte count: %u (expected %u)", byte_count, num_regs * 2);
         return ESP_ERR_INVALID_RESPONSE;
     }
 
@@ -233,7 +525,7 @@ esp_err_t modbus_write_single_register(modbus_handle_t handle,
                                        uint16_t reg_addr,
                                        uint16_t value)
 {
-    if (handle == NULL) {
+    if (handle == NULL || slave_addr > MODBUS_MAX_SLAVE_ADDR) {
         return ESP_ERR_INVALID_ARG;
     }
 
@@ -253,17 +545,17 @@ esp_err_t modbus_write_single_register(modbus_handle_t handle,
     request[6] = crc & 0xFF;
     request[7] = (crc >> 8) & 0xFF;
 
-    ESP_LOGD(TAG, "Write reg: addr=%u, reg=0x%04X, value=0x%04X",
+    DLOGD(TAG, "Write reg: addr=%u, reg=0x%04X, value=0x%04X",
              slave_addr, reg_addr, value);
 
     esp_err_t ret = modbus_send_receive(handle, request, 8, response, &resp_len, 8);
-    if (ret != ESP_OK) {
+    if (ret != ESP_OK || slave_addr == MODBUS_BROADCAST_ADDR) {
         return ret;
     }
 
     // Response should echo request (without CRC comparison already done)
     if (response[0] != slave_addr || response[1] != MODBUS_FC_WRITE_SINGLE_REGISTER) {
-        ESP_LOGE(TAG, "Unexpected response");
+        DLOGE(TAG, "Unexpected response");
         return ESP_ERR_INVALID_RESPONSE;
     }
 
@@ -276,7 +568,8 @@ esp_err_t modbus_write_multiple_registers(modbus_handle_t handle,
                                           uint16_t num_regs,
                                           const uint16_t *values)
 {
-    if (handle == NULL || values == NULL || num_regs == 0 || num_regs > 123) {
+    if (handle == NULL || values == NULL || num_regs == 0 || num_regs > 123 ||
+        slave_addr > MODBUS_MAX_SLAVE_ADDR) {
         return ESP_ERR_INVALID_ARG;
     }
 
@@ -304,7 +597,7 @@ esp_err_t modbus_write_multiple_registers(modbus_handle_t handle,
     request[req_len] = crc & 0xFF;
     request[req_len + 1] = (crc >> 8) & 0xFF;
 
-    ESP_LOGD(TAG, "Write multi regs: addr=%u, start=0x%04X, count=%u",
+    DLOGD(TAG, "Write multi regs: addr=%u, start=0x%04X, count=%u",
              slave_addr, start_reg, num_regs);
 
     esp_err_t ret = modbus_send_receive(handle, request, req_len + 2, response, &resp_len, 8);
@@ -314,3 +607,51 @@ esp_err_t modbus_write_multiple_registers(modbus_handle_t handle,
 
     return ESP_OK;
 }
+
+esp_err_t modbus_transact(modbus_handle_t handle,
+                          uint8_t slave_addr,
+                          const uint8_t *pdu, size_t pdu_len,
+                          uint8_t *rsp_pdu, size_t *rsp_len)
+{
+    if (handle == NULL || pdu == NULL || rsp_pdu == NULL || rsp_len == NULL ||
+        pdu_len < 1 || pdu_len > MODBUS_MAX_PDU_LEN || slave_addr > MODBUS_MAX_SLAVE_ADDR) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The expected length lets the exchange stop as soon as the frame is in
+    size_t expected_len;
+    switch (pdu[0]) {
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            if (pdu_len != 5 || slave_addr == MODBUS_BROADCAST_ADDR) return ESP_ERR_INVALID_ARG;
+            expected_len = 5 + ((pdu[3] << 8) | pdu[4]) * 2;
+            break;
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            expected_len = 8;
+            break;
+        default:
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uint8_t request[MODBUS_MAX_PDU_SIZE];
+    uint8_t response[MODBUS_MAX_PDU_SIZE];
+    size_t resp_len = 0;
+
+    size_t req_len = modbus_frame_build(request, slave_addr, pdu, pdu_len);
+    esp_err_t ret = modbus_send_receive(handle, request, req_len, response, &resp_len,
+                                        expected_len);
+    bool exception = ret == ESP_ERR_INVALID_RESPONSE && resp_len == MODBUS_EXCEPTION_LEN;
+    if (ret != ESP_OK && !exception) {
+        return ret;
+    }
+    if (slave_addr == MODBUS_BROADCAST_ADDR) {
+        *rsp_len = 0;
+        return ESP_OK;
+    }
+
+    // Strip address and CRC
+    *rsp_len = resp_len - 3;
+    memcpy(rsp_pdu, &response[1], *rsp_len);
+    return ESP_OK;
+}
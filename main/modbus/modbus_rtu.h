@@ -46,7 +46,7 @@ typedef struct modbus_rtu* modbus_handle_t;
  */
 typedef struct {
     rs485_handle_t rs485;       // RS485 handle
-    uint32_t response_timeout;  // Response timeout in ms (default 100)
+    uint32_t response_timeout;  // Maximum response timeout in ms (default 100)
 } modbus_config_t;
 
 #define MODBUS_DEFAULT_CONFIG() {   \
@@ -79,7 +79,7 @@ esp_err_t modbus_deinit(modbus_handle_t handle);
  * @param start_reg Starting register address
  * @param num_regs Number of registers to read (1-125)
  * @param values Buffer to store read values
- * @return esp_err_t ESP_OK on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for address 0 or above 247
  */
 esp_err_t modbus_read_holding_registers(modbus_handle_t handle,
                                         uint8_t slave_addr,
@@ -91,10 +91,10 @@ esp_err_t modbus_read_holding_registers(modbus_handle_t handle,
  * @brief Write single register (FC 0x06)
  *
  * @param handle Modbus handle
- * @param slave_addr Slave address (1-247)
+ * @param slave_addr Slave address (1-247, 0 = broadcast: sent without awaiting a reply)
  * @param reg_addr Register address
  * @param value Value to write
- * @return esp_err_t ESP_OK on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an address above 247
  */
 esp_err_t modbus_write_single_register(modbus_handle_t handle,
                                        uint8_t slave_addr,
@@ -105,11 +105,11 @@ esp_err_t modbus_write_single_register(modbus_handle_t handle,
  * @brief Write multiple registers (FC 0x10)
  *
  * @param handle Modbus handle
- * @param slave_addr Slave address (1-247)
+ * @param slave_addr Slave address (1-247, 0 = broadcast: sent without awaiting a reply)
  * @param start_reg Starting register address
  * @param num_regs Number of registers to write
  * @param values Values to write
- * @return esp_err_t ESP_OK on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an address above 247
  */
 esp_err_t modbus_write_multiple_registers(modbus_handle_t handle,
                                           uint8_t slave_addr,
@@ -117,6 +117,69 @@ esp_err_t modbus_write_multiple_registers(modbus_handle_t handle,
                                           uint16_t num_regs,
                                           const uint16_t *values);
 
+/**
+ * @brief Maximum size of a Modbus PDU (function code + data)
+ */
+#define MODBUS_MAX_PDU_LEN  253
+
+/**
+ * @brief Run a request given as a PDU and return the response PDU
+ *
+ * Used to forward requests from other Modbus transports. Supports the
+ * function codes in modbus_function_code_t. An exception response from the
+ * slave is a valid result: it is returned as a PDU (function code | 0x80,
+ * exception code) with ESP_OK. A write to broadcast address 0 is sent
+ * without awaiting a reply and returns an empty PDU.
+ *
+ * @param handle Modbus handle
+ * @param slave_addr Slave address (1-247, 0 = broadcast for writes)
+ * @param pdu Request PDU (function code + data)
+ * @param pdu_len Length of the request PDU
+ * @param rsp_pdu Buffer for the response PDU (MODBUS_MAX_PDU_LEN bytes)
+ * @param rsp_len Pointer to store the response PDU length
+ * @return esp_err_t ESP_OK if a response was received,
+ *         ESP_ERR_NOT_SUPPORTED for other function codes,
+ *         ESP_ERR_INVALID_ARG for an address above 247 or a broadcast read
+ */
+esp_err_t modbus_transact(modbus_handle_t handle,
+                          uint8_t slave_addr,
+                          const uint8_t *pdu, size_t pdu_len,
+                          uint8_t *rsp_pdu, size_t *rsp_len);
+
+// ============================================================================
+// RTU framing (shared by the master and the slave)
+// ============================================================================
+
+/**
+ * @brief Build an RTU frame: slave address, PDU, CRC
+ *
+ * @param frame Buffer for the frame (pdu_len + 3 bytes)
+ * @param slave_addr Slave address
+ * @param pdu PDU (function code + data)
+ * @param pdu_len Length of the PDU
+ * @return size_t Frame length
+ */
+size_t modbus_frame_build(uint8_t *frame, uint8_t slave_addr, const uint8_t *pdu, size_t pdu_len);
+
+/**
+ * @brief Check the length and CRC of a received RTU frame
+ *
+ * @param frame Frame
+ * @param len Frame length
+ * @return true if the frame is valid
+ */
+bool modbus_frame_valid(const uint8_t *frame, size_t len);
+
+/**
+ * @brief Get the length of an RTU request frame from its first bytes
+ *
+ * @param frame Bytes received so far
+ * @param len Number of bytes received
+ * @return size_t Total frame length, 0 if more bytes are needed to tell,
+ *         SIZE_MAX if the function code is not supported
+ */
+size_t modbus_request_frame_len(const uint8_t *frame, size_t len);
+
 /**
  * @brief Calculate Modbus CRC16
  *
@@ -134,6 +197,32 @@ uint16_t modbus_crc16(const uint8_t *data, size_t len);
  */
 modbus_exception_t modbus_get_last_exception(modbus_handle_t handle);
 
+/**
+ * @brief Per-slave response timing
+ *
+ * The response timeout of each slave is derived from a smoothed round-trip
+ * time and its mean deviation (RFC 6298 style), measured from the end of
+ * the request to the arrival of the response header. It is bounded by a
+ * minimum derived from the baud rate and by the configured
+ * response_timeout, and doubles after every timeout.
+ */
+typedef struct {
+    uint32_t srtt_us;           // Smoothed round-trip time (0 = no sample yet)
+    uint32_t rttvar_us;         // Round-trip time mean deviation
+    uint32_t timeout_us;        // Current response timeout
+} modbus_slave_timing_t;
+
+/**
+ * @brief Get response timing for a slave
+ *
+ * @param handle Modbus handle
+ * @param slave_addr Slave address (1-247)
+ * @param timing Pointer to store timing
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t modbus_get_slave_timing(modbus_handle_t handle, uint8_t slave_addr,
+                                  modbus_slave_timing_t *timing);
+
 /**
  * @brief Modbus communication statistics
  */
@@ -147,11 +236,13 @@ typedef struct {
 } modbus_stats_t;
 
 /**
- * @brief Get Modbus communication statistics
+ * @brief Get Modbus communication statistics (all buses, since the last reset)
+ *
+ * The counters are also exported at /metrics, where they are never reset.
  *
- * @return const modbus_stats_t* Pointer to stats structure
+ * @param stats Pointer to store statistics
  */
-const modbus_stats_t* modbus_get_stats(void);
+void modbus_get_stats(modbus_stats_t *stats);
 
 /**
  * @brief Reset Modbus statistics
@@ -0,0 +1,477 @@
+/**
+ * @file modbus_slave.c
+ * @brief Modbus RTU slave serving an aggregated actuator image to a PLC
+ */
+
+#include "modbus_slave.h"
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#include "rs485_driver.h"
+#include "modbus_rtu.h"
+#include "bus_manager.h"
+#include "actuator_poller.h"
+#include "config_manager.h"
+#include "metrics.h"
+
+static const char *TAG = "MB_SLAVE";
+
+#define FRAME_MAX               (MODBUS_MAX_PDU_LEN + 3)    // Address + PDU + CRC
+#define READ_MAX_REGS           125
+#define IMAGE_READ_ATTEMPTS     4
+#define IMAGE_PERIOD_MS         CONFIG_ACTUATOR_POLL_FAST_MS
+#define AGE_NEVER               0xFFFF
+
+#define SLAVE_TASK_STACK        4096
+#define IMAGE_TASK_STACK        3072
+#define SLAVE_TASK_PRIORITY     (tskIDLE_PRIORITY + 7)  // Reply latency is seen by the PLC
+#define IMAGE_TASK_PRIORITY     (tskIDLE_PRIORITY + 3)
+
+/**
+ * @brief Published register image
+ *
+ * Two buffers: the builder writes the one readers are not directed to, then
+ * flips s_current. The sequence number is odd while a buffer is written, so
+ * a reader that raced with a rebuild of its buffer (two flips later) sees
+ * a changed sequence and retries.
+ */
+typedef struct {
+    atomic_uint seq;
+    int64_t built_us;
+    uint16_t regs[MODBUS_SLAVE_IMAGE_REGS];
+} image_buf_t;
+
+static rs485_handle_t s_rs485 = NULL;
+static modbus_slave_stats_t s_stats = {0};     // Counters are kept in the metrics below
+
+METRIC_COUNTER_DEFINE(s_m_requests, "rtu_slave_requests", "Valid RTU slave frames addressed to us");
+METRIC_COUNTER_DEFINE(s_m_exceptions, "rtu_slave_exceptions", "RTU slave exception responses sent");
+METRIC_COUNTER_DEFINE(s_m_crc_errors, "rtu_slave_crc_errors", "RTU slave frames dropped on CRC or framing errors");
+METRIC_COUNTER_DEFINE(s_m_other_address, "rtu_slave_other_address", "RTU slave frames for other slaves or broadcast");
+METRIC_COUNTER_DEFINE(s_m_retries, "rtu_slave_image_retries", "RTU slave image reads retried after a concurrent rebuild");
+
+#if !CONFIG_RS485_SIMULATOR     // The simulator has no UART to serve the slave on
+
+METRIC_HISTOGRAM_DEFINE(s_m_reply_us, "rtu_slave_reply_microseconds",
+                        "RTU slave time from end of request to reply",
+                        100, 200, 500, 1000, 2000, 5000);
+
+static image_buf_t s_image[2];
+static atomic_uint s_current;
+static uint16_t s_sequence = 0;
+
+static uint8_t s_slave_id = 0;
+static uint32_t s_char_us = 0;
+
+// ============================================================================
+// Image
+// ============================================================================
+
+static uint16_t age_ms(int64_t now, int64_t then)
+{
+    if (then == 0) {
+        return AGE_NEVER;
+    }
+    int64_t ms = (now - then) / 1000;
+    return ms >= AGE_NEVER ? AGE_NEVER - 1 : (uint16_t)ms;
+}
+
+/**
+ * @brief Fill an image from the registry cache and the bus statistics
+ */
+static void build_image(image_buf_t *img)
+{
+    uint16_t *r = img->regs;
+    int64_t now = esp_timer_get_time();
+    uint16_t quarantined = 0;
+
+    memset(r, 0, sizeof(img->regs));
+
+    actuator_registry_lock();
+    uint8_t count = actuator_registry_count();
+    for (uint8_t slot = 0; slot < count; slot++) {
+        actuator_state_t state;
+        if (actuator_registry_get_state(slot, &state) != ESP_OK) {
+            continue;
+        }
+
+        uint16_t flags = 0;
+        if (state.connected) flags |= MODBUS_SLAVE_FLAG_CONNECTED;
+        if (state.moving) flags |= MODBUS_SLAVE_FLAG_MOVING;
+        if (state.health == ACTUATOR_SUSPECT) flags |= MODBUS_SLAVE_FLAG_SUSPECT;
+        if (state.health == ACTUATOR_QUARANTINED) {
+            flags |= MODBUS_SLAVE_FLAG_QUARANTINED;
+            quarantined++;
+        }
+        if (state.hw_error) flags |= MODBUS_SLAVE_FLAG_HW_ERROR;
+
+        uint16_t *a = &r[MODBUS_SLAVE_HEADER_REGS + slot * MODBUS_SLAVE_ACT_REGS];
+        a[MODBUS_SLAVE_ACT_ADDRESS] = (state.bus << 8) | state.id;
+        a[MODBUS_SLAVE_ACT_FLAGS] = flags;
+        a[MODBUS_SLAVE_ACT_POSITION] = state.position;
+        a[MODBUS_SLAVE_ACT_CURRENT] = state.current;
+        a[MODBUS_SLAVE_ACT_VOLTAGE] = state.voltage;
+        a[MODBUS_SLAVE_ACT_HW_ERROR] = state.hw_error;
+        a[MODBUS_SLAVE_ACT_AGE_MS] = age_ms(now, state.updated_us);
+        a[MODBUS_SLAVE_ACT_FAILURES] = state.failures;
+    }
+    actuator_registry_unlock();
+
+    uint16_t bus_up = 0;
+    for (uint8_t bus = 0; bus < bus_manager_count(); bus++) {
+        if (bus_manager_is_up(bus)) {
+            bus_up |= 1 << bus;
+        }
+        if (bus < 2) {
+            actuator_poller_stats_t poller;
+            actuator_poller_get_stats(bus, &poller);
+            r[MODBUS_SLAVE_REG_BUS0_BUSY + bus] = poller.busy_pct;
+        }
+    }
+
+    modbus_stats_t modbus;
+    modbus_get_stats(&modbus);
+    uint32_t uptime_s = (uint32_t)(now / 1000000);
+
+    r[MODBUS_SLAVE_REG_VERSION] = MODBUS_SLAVE_IMAGE_VERSION;
+    r[MODBUS_SLAVE_REG_COUNT] = count;
+    r[MODBUS_SLAVE_REG_SEQUENCE] = ++s_sequence;
+    r[MODBUS_SLAVE_REG_BUS_UP] = bus_up;
+    r[MODBUS_SLAVE_REG_QUARANTINED] = quarantined;
+    r[MODBUS_SLAVE_REG_TX] = modbus.tx_count & 0xFFFF;
+    r[MODBUS_SLAVE_REG_ERRORS] = modbus.error_count & 0xFFFF;
+    r[MODBUS_SLAVE_REG_TIMEOUTS] = modbus.timeout_count & 0xFFFF;
+    r[MODBUS_SLAVE_REG_UPTIME_HI] = uptime_s >> 16;
+    r[MODBUS_SLAVE_REG_UPTIME_LO] = uptime_s & 0xFFFF;
+    img->built_us = now;
+}
+
+/**
+ * @brief Rebuild the idle buffer and direct readers to it
+ *
+ * Only called from the image task (single writer).
+ */
+static void publish_image(void)
+{
+    unsigned next = atomic_load_explicit(&s_current, memory_order_relaxed) ^ 1;
+    image_buf_t *img = &s_image[next];
+
+    atomic_fetch_add_explicit(&img->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    build_image(img);
+    atomic_fetch_add_explicit(&img->seq, 1, memory_order_release);
+
+    atomic_store_explicit(&s_current, next, memory_order_release);
+}
+
+/**
+ * @brief Copy registers out of the published image without locking
+ *
+ * @return true if a consistent copy was made
+ */
+static bool read_image(uint16_t start, uint16_t count, uint16_t *out)
+{
+    for (int attempt = 0; attempt < IMAGE_READ_ATTEMPTS; attempt++) {
+        const image_buf_t *img = &s_image[atomic_load_explicit(&s_current, memory_order_acquire)];
+
+        unsigned seq = atomic_load_explicit(&img->seq, memory_order_acquire);
+        if ((seq & 1) == 0) {
+            memcpy(out, &img->regs[start], count * sizeof(uint16_t));
+            int64_t built_us = img->built_us;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&img->seq, memory_order_relaxed) == seq) {
+                // The age register is the only one computed at request time
+                if (start <= MODBUS_SLAVE_REG_AGE_MS && MODBUS_SLAVE_REG_AGE_MS < start + count) {
+                    out[MODBUS_SLAVE_REG_AGE_MS - start] = age_ms(esp_timer_get_time(), built_us);
+                }
+                return true;
+            }
+        }
+        metrics_counter_inc(&s_m_retries);
+    }
+    return false;
+}
+
+static void image_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(IMAGE_PERIOD_MS));
+        publish_image();
+    }
+}
+
+// ============================================================================
+// RTU framing
+// ============================================================================
+
+/**
+ * @brief Time for a number of characters on the line, in ms (rounded up, plus a tick)
+ */
+static uint32_t chars_ms(size_t chars)
+{
+    return (uint32_t)((chars * s_char_us + 999) / 1000) + portTICK_PERIOD_MS;
+}
+
+/**
+ * @brief Read until the line has been silent for a few characters
+ *
+ * @return size_t Total bytes in frame (those already there plus those read,
+ *         up to FRAME_MAX)
+ */
+static size_t read_to_gap(uint8_t *frame, size_t got)
+{
+    uint8_t discard[32];
+
+    while (1) {
+        size_t n = 0;
+        uint8_t *dst = got < FRAME_MAX ? &frame[got] : discard;
+        size_t room = got < FRAME_MAX ? FRAME_MAX - got : sizeof(discard);
+        if (room > sizeof(discard)) room = sizeof(discard);
+
+        if (rs485_receive(s_rs485, dst, room, &n, chars_ms(4)) != ESP_OK || n == 0) {
+            return got < FRAME_MAX ? got : FRAME_MAX;
+        }
+        if (dst != discard) {
+            got += n;
+        }
+    }
+}
+
+/**
+ * @brief Receive one request frame
+ *
+ * Waits for the first byte, then reads exactly the frame length given by the
+ * function code, so the reply can go out as soon as the last byte is in.
+ *
+ * @param frame Buffer of FRAME_MAX bytes
+ * @param len Pointer to store the number of bytes received
+ * @return esp_err_t ESP_OK with a valid frame, ESP_ERR_NOT_SUPPORTED with a
+ *         valid frame of an unsupported function code, ESP_ERR_INVALID_CRC or
+ *         ESP_ERR_TIMEOUT on a garbled or truncated frame
+ */
+static esp_err_t receive_frame(uint8_t *frame, size_t *len)
+{
+    size_t got = 0;
+    size_t n = 0;
+
+    *len = 0;
+    esp_err_t ret = rs485_receive(s_rs485, frame, 1, &n, RS485_WAIT_FOREVER);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    got = n;
+
+    size_t need = 2;
+    while (got < need) {
+        n = 0;
+        rs485_receive(s_rs485, &frame[got], need - got, &n, chars_ms(need - got + 2));
+        got += n;
+        *len = got;
+        if (got < need) {
+            return ESP_ERR_TIMEOUT;     // Silence inside a frame
+        }
+
+        size_t total = modbus_request_frame_len(frame, got);
+        if (total == SIZE_MAX) {
+            // Length unknown: the frame ends at the next gap
+            *len = read_to_gap(frame, got);
+            return modbus_frame_valid(frame, *len) ? ESP_ERR_NOT_SUPPORTED : ESP_ERR_INVALID_CRC;
+        }
+        if (total > FRAME_MAX) {
+            return ESP_ERR_INVALID_CRC;
+        }
+        need = total ? total : 7;     // FC 0x10 length is known from byte 7
+    }
+
+    *len = got;
+    return modbus_frame_valid(frame, got) ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+static size_t exception_pdu(uint8_t *pdu, uint8_t fc, modbus_exception_t code)
+{
+    pdu[0] = fc | 0x80;
+    pdu[1] = code;
+    metrics_counter_inc(&s_m_exceptions);
+    return 2;
+}
+
+/**
+ * @brief Build the response PDU of a valid request
+ */
+static size_t handle_request(const uint8_t *frame, uint8_t *pdu)
+{
+    uint8_t fc = frame[1];
+
+    if (fc != MODBUS_FC_READ_HOLDING_REGISTERS && fc != MODBUS_FC_READ_INPUT_REGISTERS) {
+        return exception_pdu(pdu, fc, MODBUS_EX_ILLEGAL_FUNCTION);
+    }
+
+    uint16_t start = (frame[2] << 8) | frame[3];
+    uint16_t count = (frame[4] << 8) | frame[5];
+    if (count == 0 || count > READ_MAX_REGS) {
+        return exception_pdu(pdu, fc, MODBUS_EX_ILLEGAL_DATA_VALUE);
+    }
+    if ((uint32_t)start + count > MODBUS_SLAVE_IMAGE_REGS) {
+        return exception_pdu(pdu, fc, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+    }
+
+    uint16_t regs[READ_MAX_REGS];
+    if (!read_image(start, count, regs)) {
+        return exception_pdu(pdu, fc, MODBUS_EX_SLAVE_DEVICE_BUSY);
+    }
+
+    pdu[0] = fc;
+    pdu[1] = count * 2;
+    for (uint16_t i = 0; i < count; i++) {
+        pdu[2 + i * 2] = regs[i] >> 8;
+        pdu[3 + i * 2] = regs[i] & 0xFF;
+    }
+    return 2 + count * 2;
+}
+
+static void slave_task(void *arg)
+{
+    uint8_t frame[FRAME_MAX];
+    uint8_t pdu[MODBUS_MAX_PDU_LEN];
+    uint8_t reply[FRAME_MAX];
+
+    while (1) {
+        size_t len = 0;
+        esp_err_t ret = receive_frame(frame, &len);
+        int64_t received_us = esp_timer_get_time();
+        rs485_trace_rx(s_rs485, frame, len);
+
+        if (ret == ESP_ERR_INVALID_CRC || ret == ESP_ERR_TIMEOUT) {
+            // Resynchronise on the next gap
+            metrics_counter_inc(&s_m_crc_errors);
+            read_to_gap(frame, FRAME_MAX);
+            rs485_flush_rx(s_rs485);
+            continue;
+        }
+        if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        if (frame[0] != s_slave_id) {
+            metrics_counter_inc(&s_m_other_address);    // Includes broadcast: never answered
+            continue;
+        }
+
+        metrics_counter_inc(&s_m_requests);
+        size_t pdu_len = ret == ESP_OK ? handle_request(frame, pdu)
+                                       : exception_pdu(pdu, frame[1], MODBUS_EX_ILLEGAL_FUNCTION);
+        size_t reply_len = modbus_frame_build(reply, s_slave_id, pdu, pdu_len);
+
+        uint32_t reply_us = (uint32_t)(esp_timer_get_time() - received_us);
+        metrics_histogram_observe(&s_m_reply_us, reply_us);
+        if (reply_us > s_stats.max_reply_us) {
+            s_stats.max_reply_us = reply_us;
+        }
+        rs485_send(s_rs485, reply, reply_len, chars_ms(reply_len) + 10);
+    }
+}
+
+#endif // !CONFIG_RS485_SIMULATOR
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t modbus_slave_start(void)
+{
+    if (s_rs485 != NULL) {
+        return ESP_OK;
+    }
+
+    config_rtu_slave_t cfg;
+    config_get_rtu_slave(&cfg);
+    if (!cfg.enabled) {
+        ESP_LOGI(TAG, "Modbus RTU slave disabled");
+        return ESP_OK;
+    }
+
+#if CONFIG_RS485_SIMULATOR
+    ESP_LOGW(TAG, "Modbus RTU slave not available with the RS485 simulator");
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (cfg.port.uart == 0 || cfg.slave_id == 0 || cfg.slave_id > 247) {
+        ESP_LOGE(TAG, "Invalid slave config (UART%d, ID %d)", cfg.port.uart, cfg.slave_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint8_t bus = 0; bus < bus_manager_count(); bus++) {
+        if (bus_manager_is_up(bus) && bus_manager_get_uart(bus) == cfg.port.uart) {
+            ESP_LOGE(TAG, "UART%d is used by bus %d", cfg.port.uart, bus);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (cfg.port.baud == 0) {
+        ESP_LOGW(TAG, "No baud rate configured, using 57600");
+        cfg.port.baud = 57600;
+    }
+
+    rs485_config_t rs485_cfg = {
+        .uart_num = cfg.port.uart,
+        .tx_pin = cfg.port.tx_pin,
+        .rx_pin = cfg.port.rx_pin,
+        .de_pin = cfg.port.de_pin,
+        .baud_rate = cfg.port.baud,
+        .rx_buffer_size = 512,
+        .tx_buffer_size = 512,
+    };
+
+    esp_err_t ret = rs485_init(&rs485_cfg, &s_rs485);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize UART%d: %s", cfg.port.uart, esp_err_to_name(ret));
+        s_rs485 = NULL;
+        return ret;
+    }
+
+    s_slave_id = cfg.slave_id;
+    s_char_us = 11000000 / cfg.port.baud;      // 11 bits per character (8N1 plus margin)
+
+    // First image before the first request can arrive
+    publish_image();
+
+    if (xTaskCreate(image_task, "rtu_image", IMAGE_TASK_STACK, NULL,
+                    IMAGE_TASK_PRIORITY, NULL) != pdPASS ||
+        xTaskCreate(slave_task, "rtu_slave", SLAVE_TASK_STACK, NULL,
+                    SLAVE_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create slave tasks");
+        return ESP_FAIL;
+    }
+
+    metrics_register(&s_m_requests);
+    metrics_register(&s_m_exceptions);
+    metrics_register(&s_m_crc_errors);
+    metrics_register(&s_m_other_address);
+    metrics_register(&s_m_retries);
+    metrics_register(&s_m_reply_us);
+
+    s_stats.running = true;
+    s_stats.uart = cfg.port.uart;
+    s_stats.slave_id = cfg.slave_id;
+    ESP_LOGI(TAG, "Modbus RTU slave %d on UART%d at %lu baud (%d registers)",
+             cfg.slave_id, cfg.port.uart, (unsigned long)cfg.port.baud, MODBUS_SLAVE_IMAGE_REGS);
+    return ESP_OK;
+#endif
+}
+
+void modbus_slave_get_stats(modbus_slave_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = s_stats;
+    stats->requests = metrics_counter_get(&s_m_requests);
+    stats->exceptions = metrics_counter_get(&s_m_exceptions);
+    stats->crc_errors = metrics_counter_get(&s_m_crc_errors);
+    stats->other_address = metrics_counter_get(&s_m_other_address);
+    stats->retries = metrics_counter_get(&s_m_retries);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file modbus_slave.h
+ * @brief Modbus RTU slave serving an aggregated actuator image to a PLC
+ *
+ * Answers FC 0x03 and 0x04 on its own UART (the "rtu_slave" config section)
+ * from a register image of every registered actuator and the bus health.
+ * The image is rebuilt from the registry cache every fast poll period and
+ * published lock-free, so a request is answered from RAM without waiting
+ * for the registry or a bus. Both function codes read the same image; it is
+ * read-only.
+ *
+ * Register map (one 16-bit register each):
+ *
+ *   0   .. 15            Header (MODBUS_SLAVE_REG_*)
+ *   16 + 8 * n .. +7     Actuator in registry slot n (MODBUS_SLAVE_ACT_*)
+ *
+ * Slots are filled in registry order; unused blocks read as zero.
+ */
+
+#ifndef MODBUS_SLAVE_H
+#define MODBUS_SLAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "actuator_registry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MODBUS_SLAVE_IMAGE_VERSION  1
+#define MODBUS_SLAVE_HEADER_REGS    16
+#define MODBUS_SLAVE_ACT_REGS       8
+#define MODBUS_SLAVE_IMAGE_REGS     (MODBUS_SLAVE_HEADER_REGS + \
+                                     MODBUS_SLAVE_ACT_REGS * ACTUATOR_REGISTRY_MAX)
+
+/**
+ * @brief Header registers
+ */
+typedef enum {
+    MODBUS_SLAVE_REG_VERSION = 0,       // Image layout version
+    MODBUS_SLAVE_REG_COUNT,             // Actuators in the image
+    MODBUS_SLAVE_REG_SEQUENCE,          // Incremented on every rebuild
+    MODBUS_SLAVE_REG_AGE_MS,            // Time since the rebuild (at request time)
+    MODBUS_SLAVE_REG_BUS_UP,            // Bit n set: bus n is up
+    MODBUS_SLAVE_REG_QUARANTINED,       // Actuators in quarantine
+    MODBUS_SLAVE_REG_TX,                // Modbus requests sent (low 16 bits)
+    MODBUS_SLAVE_REG_ERRORS,            // Modbus errors (low 16 bits)
+    MODBUS_SLAVE_REG_TIMEOUTS,          // Modbus timeouts (low 16 bits)
+    MODBUS_SLAVE_REG_UPTIME_HI,         // Uptime in seconds, high word
+    MODBUS_SLAVE_REG_UPTIME_LO,         // Uptime in seconds, low word
+    MODBUS_SLAVE_REG_BUS0_BUSY,         // Bus 0 measured busy time (%)
+    MODBUS_SLAVE_REG_BUS1_BUSY,         // Bus 1 measured busy time (%)
+} modbus_slave_reg_t;
+
+/**
+ * @brief Registers of an actuator block
+ */
+typedef enum {
+    MODBUS_SLAVE_ACT_ADDRESS = 0,       // Bus << 8 | slave ID
+    MODBUS_SLAVE_ACT_FLAGS,             // MODBUS_SLAVE_FLAG_*
+    MODBUS_SLAVE_ACT_POSITION,          // Present position
+    MODBUS_SLAVE_ACT_CURRENT,           // Present current (mA)
+    MODBUS_SLAVE_ACT_VOLTAGE,           // Present voltage (0.1V units)
+    MODBUS_SLAVE_ACT_HW_ERROR,          // Hardware error state
+    MODBUS_SLAVE_ACT_AGE_MS,            // Age of the telemetry at rebuild (0xFFFF = never/stale)
+    MODBUS_SLAVE_ACT_FAILURES,          // Consecutive failed reads
+} modbus_slave_act_reg_t;
+
+#define MODBUS_SLAVE_FLAG_CONNECTED     0x0001
+#define MODBUS_SLAVE_FLAG_MOVING        0x0002
+#define MODBUS_SLAVE_FLAG_SUSPECT       0x0004
+#define MODBUS_SLAVE_FLAG_QUARANTINED   0x0008
+#define MODBUS_SLAVE_FLAG_HW_ERROR      0x0010
+
+/**
+ * @brief Slave statistics
+ */
+typedef struct {
+    bool running;
+    uint8_t uart;               // UART port
+    uint8_t slave_id;           // Address answered
+    uint32_t requests;          // Valid frames addressed to us
+    uint32_t exceptions;        // Exception responses sent
+    uint32_t crc_errors;        // Frames dropped on CRC or framing errors
+    uint32_t other_address;     // Valid frames for other slaves (or broadcast)
+    uint32_t retries;           // Image reads retried after a concurrent rebuild
+    uint32_t max_reply_us;      // Longest time from end of request to reply
+} modbus_slave_stats_t;
+
+/**
+ * @brief Start the slave if enabled in the configuration
+ *
+ * Call after the RS485 buses are up. The slave UART must differ from every
+ * bus UART and from the console.
+ *
+ * @return esp_err_t ESP_OK if started or disabled, ESP_ERR_INVALID_ARG on a
+ *         UART conflict
+ */
+esp_err_t modbus_slave_start(void);
+
+/**
+ * @brief Get slave statistics
+ *
+ * @param stats Pointer to store statistics
+ */
+void modbus_slave_get_stats(modbus_slave_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_SLAVE_H
@@ -0,0 +1,700 @@
+/**
+ * @file modbus_tcp.c
+ * @brief Modbus TCP gateway to the RS485 buses
+ */
+
+#include "modbus_tcp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "memprof.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+
+#include "modbus_rtu.h"
+#include "mightyzap.h"
+#include "bus_manager.h"
+#include "actuator_registry.h"
+
+static const char *TAG = "MB_TCP";
+
+#define MBAP_HEADER_LEN         7       // Transaction, protocol, length, unit
+#define MBAP_PROTOCOL_MODBUS    0
+#define MBAP_FRAME_MAX          (MBAP_HEADER_LEN + MODBUS_MAX_PDU_LEN)
+
+#define MAX_CLIENTS             CONFIG_MODBUS_TCP_MAX_CLIENTS
+#define JOB_MAX                 MAX_CLIENTS     // One request in flight per client
+#define CACHE_MAX_AGE_US        (CONFIG_MODBUS_TCP_CACHE_MAX_AGE_MS * 1000LL)
+#define CLIENT_IDLE_TIMEOUT_S   60
+#define WRITE_ALLOW_MAX         8       // Entries of CONFIG_MODBUS_TCP_WRITE_ALLOW
+
+// Registers served from the telemetry cache (MOTION register group)
+#define CACHE_REG_FIRST         MZAP_REG_PRESENT_POSITION
+#define CACHE_REG_LAST          MZAP_REG_MOVING
+
+#define LISTEN_TASK_STACK       3072
+#define CLIENT_TASK_STACK       4096
+#define WORKER_TASK_STACK       4096
+#define LISTEN_TASK_PRIORITY    (tskIDLE_PRIORITY + 4)
+#define CLIENT_TASK_PRIORITY    (tskIDLE_PRIORITY + 4)
+#define WORKER_TASK_PRIORITY    (tskIDLE_PRIORITY + 5)  // Below the poller
+
+/**
+ * @brief Bus transaction shared by one or more requests
+ */
+typedef enum {
+    JOB_FREE = 0,
+    JOB_PENDING,        // Queued or on the bus; identical reads may join
+    JOB_DONE,           // Result waiting to be collected
+} job_state_t;
+
+typedef struct {
+    job_state_t state;
+    uint8_t bus;
+    uint8_t unit;
+    bool shared;                        // Read, may be joined
+    uint8_t waiters;                    // Requests waiting for the result
+    uint8_t pdu[MODBUS_MAX_PDU_LEN];
+    size_t pdu_len;
+    uint8_t rsp[MODBUS_MAX_PDU_LEN];
+    size_t rsp_len;
+    esp_err_t err;
+    SemaphoreHandle_t done;             // Given once per waiter
+} gw_job_t;
+
+/**
+ * @brief Client connection
+ */
+typedef struct {
+    int sock;
+    uint8_t bus;
+    bool may_write;                     // Address in CONFIG_MODBUS_TCP_WRITE_ALLOW
+} gw_client_t;
+
+/**
+ * @brief Network allowed to write (host byte order)
+ */
+typedef struct {
+    uint32_t addr;
+    uint32_t mask;
+} gw_allow_t;
+
+static gw_job_t s_jobs[JOB_MAX];
+static SemaphoreHandle_t s_jobs_lock = NULL;
+static QueueHandle_t s_queue[BUS_MAX];
+static SemaphoreHandle_t s_client_slots = NULL;
+static bool s_running;
+static gw_allow_t s_write_allow[WRITE_ALLOW_MAX];
+static int s_write_allow_count;
+
+static int64_t read_clients(void)
+{
+    return s_client_slots != NULL ? MAX_CLIENTS - uxSemaphoreGetCount(s_client_slots) : 0;
+}
+
+METRIC_GAUGE_DEFINE(s_m_clients, "mbtcp_clients", "Connected Modbus TCP clients", read_clients);
+METRIC_COUNTER_DEFINE(s_m_connections, "mbtcp_connections", "Accepted Modbus TCP connections");
+METRIC_COUNTER_DEFINE(s_m_rejected, "mbtcp_rejected", "Modbus TCP connections refused (client limit)");
+METRIC_COUNTER_DEFINE(s_m_requests, "mbtcp_requests", "Modbus TCP requests received");
+METRIC_COUNTER_DEFINE(s_m_cache_hits, "mbtcp_cache_hits", "Modbus TCP reads answered from the telemetry cache");
+METRIC_COUNTER_DEFINE(s_m_coalesced, "mbtcp_coalesced", "Modbus TCP reads joined to an identical pending read");
+METRIC_COUNTER_DEFINE(s_m_transactions, "mbtcp_transactions", "Bus transactions performed for Modbus TCP clients");
+METRIC_COUNTER_DEFINE(s_m_exceptions, "mbtcp_exceptions", "Modbus TCP exception responses sent");
+METRIC_COUNTER_DEFINE(s_m_writes_refused, "mbtcp_writes_refused", "Modbus TCP writes from clients not allowed to write");
+
+// ============================================================================
+// Write allowlist
+// ============================================================================
+
+/**
+ * @brief Parse "a.b.c.d" or "a.b.c.d/bits"
+ *
+ * @return const char* Character after the entry, NULL if it is malformed
+ */
+static const char *parse_allow_entry(const char *p, gw_allow_t *entry)
+{
+    uint32_t addr = 0;
+    for (int i = 0; i < 4; i++) {
+        if (i > 0 && *p++ != '.') {
+            return NULL;
+        }
+        if (*p < '0' || *p > '9') {
+            return NULL;
+        }
+        unsigned octet = 0;
+        while (*p >= '0' && *p <= '9' && octet <= 255) {
+            octet = octet * 10 + (*p++ - '0');
+        }
+        if (octet > 255) {
+            return NULL;
+        }
+        addr = (addr << 8) | octet;
+    }
+
+    unsigned bits = 32;
+    if (*p == '/') {
+        p++;
+        if (*p < '0' || *p > '9') {
+            return NULL;
+        }
+        bits = 0;
+        while (*p >= '0' && *p <= '9' && bits <= 32) {
+            bits = bits * 10 + (*p++ - '0');
+        }
+        if (bits > 32) {
+            return NULL;
+        }
+    }
+
+    entry->mask = bits == 0 ? 0 : 0xFFFFFFFFu << (32 - bits);
+    entry->addr = addr & entry->mask;
+    return p;
+}
+
+static esp_err_t parse_write_allow(const char *list)
+{
+    s_write_allow_count = 0;
+    const char *p = list;
+    while (*p != '\0') {
+        if (*p == ',' || *p == ' ') {
+            p++;
+            continue;
+        }
+        if (s_write_allow_count == WRITE_ALLOW_MAX) {
+            ESP_LOGE(TAG, "More than %d write allowlist entries", WRITE_ALLOW_MAX);
+            return ESP_ERR_INVALID_ARG;
+        }
+        const char *end = parse_allow_entry(p, &s_write_allow[s_write_allow_count]);
+        if (end == NULL || (*end != '\0' && *end != ',' && *end != ' ')) {
+            ESP_LOGE(TAG, "Bad write allowlist entry: %s", p);
+            s_write_allow_count = 0;
+            return ESP_ERR_INVALID_ARG;
+        }
+        s_write_allow_count++;
+        p = end;
+    }
+    return ESP_OK;
+}
+
+static bool write_allowed(const struct sockaddr_in *addr)
+{
+    uint32_t ip = ntohl(addr->sin_addr.s_addr);
+    for (int i = 0; i < s_write_allow_count; i++) {
+        if ((ip & s_write_allow[i].mask) == s_write_allow[i].addr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Transaction queue
+// ============================================================================
+
+static bool is_read(const uint8_t *pdu)
+{
+    return pdu[0] == MODBUS_FC_READ_HOLDING_REGISTERS ||
+           pdu[0] == MODBUS_FC_READ_INPUT_REGISTERS;
+}
+
+/**
+ * @brief Queue a request, or join an identical pending read
+ *
+ * @return gw_job_t* Job to wait for, or NULL if the queue is full
+ */
+static gw_job_t *job_submit(uint8_t bus, uint8_t unit, const uint8_t *pdu, size_t len)
+{
+    bool shared = is_read(pdu);
+    gw_job_t *job = NULL;
+
+    xSemaphoreTake(s_jobs_lock, portMAX_DELAY);
+
+    if (shared) {
+        for (int i = 0; i < JOB_MAX; i++) {
+            gw_job_t *j = &s_jobs[i];
+            if (j->state == JOB_PENDING && j->shared && j->bus == bus && j->unit == unit &&
+                j->pdu_len == len && memcmp(j->pdu, pdu, len) == 0) {
+                j->waiters++;
+                metrics_counter_inc(&s_m_coalesced);
+                xSemaphoreGive(s_jobs_lock);
+                return j;
+            }
+        }
+    }
+
+    for (int i = 0; i < JOB_MAX; i++) {
+        if (s_jobs[i].state == JOB_FREE) {
+            job = &s_jobs[i];
+            break;
+        }
+    }
+    if (job != NULL) {
+        job->state = JOB_PENDING;
+        job->bus = bus;
+        job->unit = unit;
+        job->shared = shared;
+        job->waiters = 1;
+        memcpy(job->pdu, pdu, len);
+        job->pdu_len = len;
+    }
+
+    xSemaphoreGive(s_jobs_lock);
+
+    if (job != NULL && xQueueSend(s_queue[bus], &job, 0) != pdTRUE) {
+        xSemaphoreTake(s_jobs_lock, portMAX_DELAY);
+        job->state = JOB_FREE;
+        xSemaphoreGive(s_jobs_lock);
+        job = NULL;
+    }
+    return job;
+}
+
+/**
+ * @brief Wait for a job and take a copy of its result
+ */
+static esp_err_t job_wait(gw_job_t *job, uint8_t *rsp, size_t *rsp_len)
+{
+    // The worker always completes a job; the Modbus timeout bounds the wait
+    xSemaphoreTake(job->done, portMAX_DELAY);
+
+    xSemaphoreTake(s_jobs_lock, portMAX_DELAY);
+    esp_err_t err = job->err;
+    if (err == ESP_OK) {
+        memcpy(rsp, job->rsp, job->rsp_len);
+        *rsp_len = job->rsp_len;
+    }
+    if (--job->waiters == 0) {
+        job->state = JOB_FREE;
+    }
+    xSemaphoreGive(s_jobs_lock);
+
+    return err;
+}
+
+static void worker_task(void *arg)
+{
+    uint8_t bus = (uint8_t)(uintptr_t)arg;
+    modbus_handle_t modbus = bus_manager_get_modbus(bus);
+    gw_job_t *job;
+
+    while (1) {
+        if (xQueueReceive(s_queue[bus], &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        job->rsp_len = 0;
+        job->err = modbus_transact(modbus, job->unit, job->pdu, job->pdu_len,
+                                   job->rsp, &job->rsp_len);
+        metrics_counter_inc(&s_m_transactions);
+
+        // No more joins from here on; release every waiter
+        xSemaphoreTake(s_jobs_lock, portMAX_DELAY);
+        job->state = JOB_DONE;
+        uint8_t waiters = job->waiters;
+        xSemaphoreGive(s_jobs_lock);
+
+        for (uint8_t i = 0; i < waiters; i++) {
+            xSemaphoreGive(job->done);
+        }
+    }
+}
+
+// ============================================================================
+// Request processing
+// ============================================================================
+
+static size_t exception_pdu(uint8_t *rsp, uint8_t fc, modbus_exception_t code)
+{
+    rsp[0] = fc | 0x80;
+    rsp[1] = code;
+    metrics_counter_inc(&s_m_exceptions);
+    return 2;
+}
+
+/**
+ * @brief Answer a read of the present-state registers from the telemetry cache
+ *
+ * @return size_t Response PDU length, 0 if the cache can not answer
+ */
+static size_t cache_lookup(uint8_t bus, uint8_t unit, const uint8_t *pdu, uint8_t *rsp)
+{
+    if (CACHE_MAX_AGE_US == 0 || pdu[0] != MODBUS_FC_READ_HOLDING_REGISTERS) {
+        return 0;
+    }
+
+    uint16_t start = (pdu[1] << 8) | pdu[2];
+    uint16_t count = (pdu[3] << 8) | pdu[4];
+    if (start < CACHE_REG_FIRST || start + count > CACHE_REG_LAST + 1) {
+        return 0;
+    }
+
+    actuator_state_t state;
+    actuator_registry_lock();
+    int slot = actuator_registry_find(bus, unit);
+    bool found = slot >= 0 && actuator_registry_get_state(slot, &state) == ESP_OK;
+    actuator_registry_unlock();
+
+    if (!found || !state.connected || state.updated_us == 0 ||
+        esp_timer_get_time() - state.updated_us > CACHE_MAX_AGE_US) {
+        return 0;
+    }
+
+    // Same layout as the MOTION group read (0x0037-0x003B)
+    const uint16_t regs[CACHE_REG_LAST - CACHE_REG_FIRST + 1] = {
+        state.position, state.current, state.motor_op, state.voltage, state.moving,
+    };
+
+    rsp[0] = pdu[0];
+    rsp[1] = count * 2;
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t value = regs[start - CACHE_REG_FIRST + i];
+        rsp[2 + i * 2] = value >> 8;
+        rsp[3 + i * 2] = value & 0xFF;
+    }
+    metrics_counter_inc(&s_m_cache_hits);
+    return 2 + count * 2;
+}
+
+/**
+ * @brief Validate the length of a request PDU
+ */
+static modbus_exception_t check_request(const uint8_t *pdu, size_t len)
+{
+    switch (pdu[0]) {
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS: {
+            if (len != 5) return MODBUS_EX_ILLEGAL_DATA_VALUE;
+            uint16_t count = (pdu[3] << 8) | pdu[4];
+            return (count >= 1 && count <= 125) ? MODBUS_EX_NONE : MODBUS_EX_ILLEGAL_DATA_VALUE;
+        }
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            return len == 5 ? MODBUS_EX_NONE : MODBUS_EX_ILLEGAL_DATA_VALUE;
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return (len >= 6 && len == 6u + pdu[5]) ? MODBUS_EX_NONE : MODBUS_EX_ILLEGAL_DATA_VALUE;
+        default:
+            return MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+}
+
+/**
+ * @brief Execute a request PDU on a bus
+ *
+ * @return size_t Response PDU length
+ */
+static size_t gateway_execute(const gw_client_t *client, uint8_t unit, const uint8_t *pdu,
+                              size_t len, uint8_t *rsp)
+{
+    uint8_t bus = client->bus;
+
+    metrics_counter_inc(&s_m_requests);
+
+    if (!bus_manager_is_up(bus) || unit < 1 || unit > ACTUATOR_ID_MAX) {
+        return exception_pdu(rsp, pdu[0], MODBUS_EX_GATEWAY_PATH_UNAVAILABLE);
+    }
+
+    modbus_exception_t ex = check_request(pdu, len);
+    if (ex != MODBUS_EX_NONE) {
+        return exception_pdu(rsp, pdu[0], ex);
+    }
+    if (!is_read(pdu) && !client->may_write) {
+        metrics_counter_inc(&s_m_writes_refused);
+        return exception_pdu(rsp, pdu[0], MODBUS_EX_ILLEGAL_FUNCTION);
+    }
+
+    size_t rsp_len = cache_lookup(bus, unit, pdu, rsp);
+    if (rsp_len > 0) {
+        return rsp_len;
+    }
+
+    gw_job_t *job = job_submit(bus, unit, pdu, len);
+    if (job == NULL) {
+        return exception_pdu(rsp, pdu[0], MODBUS_EX_SLAVE_DEVICE_BUSY);
+    }
+
+    if (job_wait(job, rsp, &rsp_len) != ESP_OK) {
+        return exception_pdu(rsp, pdu[0], MODBUS_EX_GATEWAY_TARGET_FAILED);
+    }
+
+    if (rsp[0] & 0x80) {
+        metrics_counter_inc(&s_m_exceptions);
+    }
+    return rsp_len;
+}
+
+// ============================================================================
+// Connections
+// ============================================================================
+
+static bool recv_all(int sock, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int n = recv(sock, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool send_all(int sock, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int n = send(sock, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void client_task(void *arg)
+{
+    gw_client_t client = *(gw_client_t *)arg;
+    memprof_free(MEMPROF_TAG_MODBUS, arg);
+
+    uint8_t req[MBAP_FRAME_MAX];
+    uint8_t rsp[MBAP_FRAME_MAX];
+
+    while (recv_all(client.sock, req, MBAP_HEADER_LEN)) {
+        uint16_t protocol = (req[2] << 8) | req[3];
+        uint16_t length = (req[4] << 8) | req[5];   // Unit ID + PDU
+
+        if (protocol != MBAP_PROTOCOL_MODBUS || length < 2 || length > MODBUS_MAX_PDU_LEN + 1) {
+            DLOGW(TAG, "Bad MBAP header (protocol %u, length %u), closing",
+                     protocol, length);
+            break;
+        }
+        if (!recv_all(client.sock, &req[MBAP_HEADER_LEN], length - 1)) {
+            break;
+        }
+
+        uint8_t unit = req[6];
+        size_t rsp_len = gateway_execute(&client, unit, &req[MBAP_HEADER_LEN], length - 1,
+                                         &rsp[MBAP_HEADER_LEN]);
+
+        // Echo transaction ID and unit ID
+        memcpy(rsp, req, 4);
+        rsp[4] = (rsp_len + 1) >> 8;
+        rsp[5] = (rsp_len + 1) & 0xFF;
+        rsp[6] = unit;
+
+        if (!send_all(client.sock, rsp, MBAP_HEADER_LEN + rsp_len)) {
+            break;
+        }
+    }
+
+    close(client.sock);
+    xSemaphoreGive(s_client_slots);
+    vTaskDelete(NULL);
+}
+
+static void accept_client(int listen_sock, uint8_t bus)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    int sock = accept(listen_sock, (struct sockaddr *)&addr, &addr_len);
+    if (sock < 0) {
+        return;
+    }
+
+    if (xSemaphoreTake(s_client_slots, 0) != pdTRUE) {
+        metrics_counter_inc(&s_m_rejected);
+        close(sock);
+        return;
+    }
+
+    // Free the slot of clients that went away without closing
+    struct timeval tv = { .tv_sec = CLIENT_IDLE_TIMEOUT_S, .tv_usec = 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    gw_client_t *client = memprof_malloc(MEMPROF_TAG_MODBUS, sizeof(gw_client_t));
+    if (client != NULL) {
+        client->sock = sock;
+        client->bus = bus;
+        client->may_write = write_allowed(&addr);
+        if (xTaskCreate(client_task, "mbtcp_client", CLIENT_TASK_STACK, client,
+                        CLIENT_TASK_PRIORITY, NULL) == pdPASS) {
+            metrics_counter_inc(&s_m_connections);
+            ESP_LOGI(TAG, "Client %s connected to bus %d%s", inet_ntoa(addr.sin_addr), bus,
+                     client->may_write ? "" : " (read-only)");
+            return;
+        }
+        memprof_free(MEMPROF_TAG_MODBUS, client);
+    }
+
+    ESP_LOGE(TAG, "Failed to start client task");
+    close(sock);
+    xSemaphoreGive(s_client_slots);
+}
+
+static int open_listener(uint16_t port)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, 2) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void listen_task(void *arg)
+{
+    int socks[BUS_MAX];
+    int max_fd = -1;
+
+    for (uint8_t bus = 0; bus < BUS_MAX; bus++) {
+        socks[bus] = -1;
+        if (!bus_manager_is_up(bus)) {
+            continue;
+        }
+        uint16_t port = CONFIG_MODBUS_TCP_PORT + bus;
+        socks[bus] = open_listener(port);
+        if (socks[bus] < 0) {
+            ESP_LOGE(TAG, "Failed to listen on port %u", port);
+            continue;
+        }
+        if (socks[bus] > max_fd) max_fd = socks[bus];
+        ESP_LOGI(TAG, "Bus %d served on port %u", bus, port);
+    }
+
+    while (max_fd >= 0) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        for (uint8_t bus = 0; bus < BUS_MAX; bus++) {
+            if (socks[bus] >= 0) FD_SET(socks[bus], &fds);
+        }
+
+        if (select(max_fd + 1, &fds, NULL, NULL, NULL) <= 0) {
+            continue;
+        }
+        for (uint8_t bus = 0; bus < BUS_MAX; bus++) {
+            if (socks[bus] >= 0 && FD_ISSET(socks[bus], &fds)) {
+                accept_client(socks[bus], bus);
+            }
+        }
+    }
+
+    ESP_LOGE(TAG, "No listening sockets, gateway stopped");
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t modbus_tcp_start(void)
+{
+    if (s_jobs_lock != NULL) {
+        return ESP_OK;
+    }
+    if (parse_write_allow(CONFIG_MODBUS_TCP_WRITE_ALLOW) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_jobs_lock = xSemaphoreCreateMutex();
+    s_client_slots = xSemaphoreCreateCounting(MAX_CLIENTS, MAX_CLIENTS);
+    if (s_jobs_lock == NULL || s_client_slots == NULL) {
+        ESP_LOGE(TAG, "Failed to create gateway locks");
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < JOB_MAX; i++) {
+        s_jobs[i].done = xSemaphoreCreateCounting(MAX_CLIENTS, 0);
+        if (s_jobs[i].done == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    int workers = 0;
+    for (uint8_t bus = 0; bus < bus_manager_count(); bus++) {
+        if (!bus_manager_is_up(bus)) {
+            continue;
+        }
+
+        s_queue[bus] = xQueueCreate(JOB_MAX, sizeof(gw_job_t *));
+        if (s_queue[bus] == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        char name[16];
+        snprintf(name, sizeof(name), "mbtcp_bus%d", bus);
+        if (xTaskCreatePinnedToCore(worker_task, name, WORKER_TASK_STACK, (void *)(uintptr_t)bus,
+                                    WORKER_TASK_PRIORITY, NULL,
+                                    bus_manager_get_core(bus)) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker for bus %d", bus);
+            return ESP_FAIL;
+        }
+        workers++;
+    }
+
+    if (workers == 0) {
+        ESP_LOGW(TAG, "No bus up, gateway not started");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (xTaskCreate(listen_task, "mbtcp_listen", LISTEN_TASK_STACK, NULL,
+                    LISTEN_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create listener task");
+        return ESP_FAIL;
+    }
+
+    metrics_register(&s_m_clients);
+    metrics_register(&s_m_connections);
+    metrics_register(&s_m_rejected);
+    metrics_register(&s_m_requests);
+    metrics_register(&s_m_cache_hits);
+    metrics_register(&s_m_coalesced);
+    metrics_register(&s_m_transactions);
+    metrics_register(&s_m_exceptions);
+    metrics_register(&s_m_writes_refused);
+
+    s_running = true;
+    ESP_LOGI(TAG, "Modbus TCP gateway started (%d clients, cache %d ms, %s)",
+             MAX_CLIENTS, CONFIG_MODBUS_TCP_CACHE_MAX_AGE_MS,
+             s_write_allow_count > 0 ? "writes from allowlist" : "read-only");
+    return ESP_OK;
+}
+
+void modbus_tcp_get_stats(modbus_tcp_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    stats->running = s_running;
+    stats->clients = read_clients();
+    stats->connections = metrics_counter_get(&s_m_connections);
+    stats->rejected = metrics_counter_get(&s_m_rejected);
+    stats->requests = metrics_counter_get(&s_m_requests);
+    stats->cache_hits = metrics_counter_get(&s_m_cache_hits);
+    stats->coalesced = metrics_counter_get(&s_m_coalesced);
+    stats->transactions = metrics_counter_get(&s_m_transactions);
+    stats->exceptions = metrics_counter_get(&s_m_exceptions);
+    stats->writes_refused = metrics_counter_get(&s_m_writes_refused);
+}
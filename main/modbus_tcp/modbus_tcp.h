@@ -0,0 +1,67 @@
+/**
+ * @file modbus_tcp.h
+ * @brief Modbus TCP gateway to the RS485 buses
+ *
+ * Serves Modbus TCP (MBAP framing) on one port per bus: CONFIG_MODBUS_TCP_PORT
+ * for bus 0, the next port for bus 1. The MBAP unit ID is the slave ID on
+ * the bus. Requests of all clients go through one transaction queue per
+ * bus, served by a worker pinned to the bus's core.
+ *
+ * - Reads of the mightyZAP present-state registers of a registered actuator
+ *   are answered from the poller's telemetry cache while it is fresh enough.
+ * - Identical reads queued or in flight at the same time are sent to the
+ *   bus once and the response is given to every requester.
+ * - Bus failures are reported with the gateway exception codes (0x0A, 0x0B).
+ * - Modbus TCP is not authenticated. Write requests are only forwarded for
+ *   clients in CONFIG_MODBUS_TCP_WRITE_ALLOW (read-only when empty); others
+ *   get exception 0x01.
+ */
+
+#ifndef MODBUS_TCP_H
+#define MODBUS_TCP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Gateway statistics
+ */
+typedef struct {
+    bool running;
+    uint8_t clients;            // Connected clients
+    uint32_t connections;       // Accepted connections
+    uint32_t rejected;          // Connections refused (client limit)
+    uint32_t requests;          // Requests received
+    uint32_t cache_hits;        // Reads answered from the telemetry cache
+    uint32_t coalesced;         // Reads joined to an identical pending read
+    uint32_t transactions;      // Bus transactions performed
+    uint32_t exceptions;        // Exception responses sent
+    uint32_t writes_refused;    // Writes from clients not allowed to write
+} modbus_tcp_stats_t;
+
+/**
+ * @brief Start the gateway on every bus that is up
+ *
+ * Call once the network is up.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t modbus_tcp_start(void);
+
+/**
+ * @brief Get gateway statistics
+ *
+ * @param stats Pointer to store statistics
+ */
+void modbus_tcp_get_stats(modbus_tcp_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_TCP_H
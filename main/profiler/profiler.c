@@ -0,0 +1,421 @@
+/**
+ * @file profiler.c
+ * @brief Statistical sampling profiler
+ */
+
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gptimer.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "memprof.h"
+#include "export_writer.h"
+
+#if CONFIG_PROFILER_ENABLE
+
+#include "xtensa_context.h"
+
+static const char *TAG = "PROF";
+
+#define PROF_BUCKETS            CONFIG_PROFILER_BUCKETS
+#define PROF_MAX_PROBES         8       // Slots tried before a sample is dropped
+#define PROF_TIMER_RES_HZ       1000000
+#define PROF_SETUP_STACK        3072
+#define EXPORT_BUF_SIZE         1024
+
+_Static_assert((PROF_BUCKETS & (PROF_BUCKETS - 1)) == 0, "CONFIG_PROFILER_BUCKETS must be a power of two");
+
+/**
+ * @brief Distinct sample and its count (count 0 = free slot)
+ */
+typedef struct {
+    uint32_t pc;                // Interrupted program counter, 0 inside an interrupt handler
+    uint32_t ret;               // Return address of the interrupted function (a0)
+    uint32_t task;              // Interrupted task handle
+    uint32_t count;
+} prof_bucket_t;
+
+/**
+ * @brief Sampling state of one core, written only by that core's timer interrupt
+ */
+typedef struct {
+    int core;
+    gptimer_handle_t timer;
+    prof_bucket_t *buckets;
+    uint32_t samples;
+    uint32_t in_isr;
+    uint32_t dropped;
+    uint32_t used;
+} prof_core_t;
+
+static prof_core_t s_cores[portNUM_PROCESSORS];
+static prof_bucket_t *s_buckets = NULL;     // PROF_BUCKETS per core
+static volatile bool s_running = false;
+static int64_t s_start_us;
+static int64_t s_stop_us;
+static esp_timer_handle_t s_stop_timer = NULL;
+static SemaphoreHandle_t s_lock = NULL;     // Serializes start and stop
+
+// ============================================================================
+// Sampling
+// ============================================================================
+
+static void record(prof_core_t *pc, uint32_t addr, uint32_t ret, uint32_t task)
+{
+    uint32_t hash = (addr ^ (ret * 31) ^ (task * 17)) * 2654435761u;
+    for (unsigned probe = 0; probe < PROF_MAX_PROBES; probe++) {
+        prof_bucket_t *b = &pc->buckets[((hash >> 16) + probe) & (PROF_BUCKETS - 1)];
+        if (b->count == 0) {
+            b->pc = addr;
+            b->ret = ret;
+            b->task = task;
+            b->count = 1;
+            pc->used++;
+            return;
+        }
+        if (b->pc == addr && b->ret == ret && b->task == task) {
+            b->count++;
+            return;
+        }
+    }
+    pc->dropped++;
+}
+
+static bool on_sample(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg)
+{
+    prof_core_t *pc = arg;
+    if (!s_running) {
+        return false;
+    }
+    pc->samples++;
+
+    if (xPortInterruptedFromISRContext()) {
+        // The frame of a nested interrupt is not reachable from here
+        pc->in_isr++;
+        record(pc, 0, 0, 0);
+        return false;
+    }
+
+    // On the first interrupt level the port saves the interrupted context on
+    // the task's stack and stores that stack pointer in the first word of
+    // the TCB (pxTopOfStack): it points at the interrupt frame
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    const XtExcFrame *frame = *(const XtExcFrame *const *)task;
+    record(pc, frame->pc, frame->a0, (uint32_t)(uintptr_t)task);
+    return false;
+}
+
+// ============================================================================
+// Timers
+// ============================================================================
+
+/**
+ * @brief Create the sampling timer of the calling core
+ *
+ * The timer interrupt is allocated on the core that registers the callback.
+ */
+static esp_err_t create_timer(prof_core_t *pc)
+{
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = PROF_TIMER_RES_HZ,
+    };
+    esp_err_t ret = gptimer_new_timer(&timer_config, &pc->timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = PROF_TIMER_RES_HZ / CONFIG_PROFILER_SAMPLE_HZ,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = on_sample,
+    };
+    ret = gptimer_set_alarm_action(pc->timer, &alarm);
+    if (ret == ESP_OK) {
+        ret = gptimer_register_event_callbacks(pc->timer, &callbacks, pc);
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_enable(pc->timer);
+    }
+    if (ret != ESP_OK) {
+        gptimer_del_timer(pc->timer);
+        pc->timer = NULL;
+    }
+    return ret;
+}
+
+typedef struct {
+    prof_core_t *pc;
+    SemaphoreHandle_t done;
+    esp_err_t err;
+} timer_setup_t;
+
+static void timer_setup_task(void *arg)
+{
+    timer_setup_t *setup = arg;
+    setup->err = create_timer(setup->pc);
+    xSemaphoreGive(setup->done);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t create_timer_on_core(prof_core_t *pc)
+{
+    timer_setup_t setup = {
+        .pc = pc,
+        .done = xSemaphoreCreateBinary(),
+        .err = ESP_FAIL,
+    };
+    if (setup.done == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (xTaskCreatePinnedToCore(timer_setup_task, "prof_setup", PROF_SETUP_STACK, &setup,
+                                uxTaskPriorityGet(NULL), NULL, pc->core) == pdPASS) {
+        xSemaphoreTake(setup.done, portMAX_DELAY);
+        ret = setup.err;
+    }
+    vSemaphoreDelete(setup.done);
+    return ret;
+}
+
+static void stop_timer_cb(void *arg)
+{
+    profiler_stop();
+}
+
+// ============================================================================
+// Control
+// ============================================================================
+
+static esp_err_t start_locked(uint32_t duration_s)
+{
+    if (s_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (s_buckets == NULL) {
+        s_buckets = heap_caps_calloc(portNUM_PROCESSORS * PROF_BUCKETS, sizeof(prof_bucket_t),
+                                     MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (s_buckets == NULL) {
+            ESP_LOGE(TAG, "No memory for %d buckets", portNUM_PROCESSORS * PROF_BUCKETS);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (s_stop_timer == NULL) {
+        esp_timer_create_args_t args = {
+            .callback = stop_timer_cb,
+            .name = "prof_stop",
+        };
+        esp_err_t ret = esp_timer_create(&args, &s_stop_timer);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        prof_core_t *pc = &s_cores[core];
+        pc->core = core;
+        pc->buckets = &s_buckets[core * PROF_BUCKETS];
+        if (pc->timer == NULL) {
+            esp_err_t ret = create_timer_on_core(pc);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to create the timer of core %d: %s", core, esp_err_to_name(ret));
+                return ret;
+            }
+        }
+        memset(pc->buckets, 0, PROF_BUCKETS * sizeof(prof_bucket_t));
+        pc->samples = 0;
+        pc->in_isr = 0;
+        pc->dropped = 0;
+        pc->used = 0;
+    }
+
+    s_start_us = esp_timer_get_time();
+    s_stop_us = 0;
+    s_running = true;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        gptimer_start(s_cores[core].timer);
+    }
+    if (duration_s > 0) {
+        esp_timer_start_once(s_stop_timer, (uint64_t)duration_s * 1000000);
+    }
+
+    ESP_LOGI(TAG, "Profiling at %d Hz per core%s", CONFIG_PROFILER_SAMPLE_HZ,
+             duration_s > 0 ? "" : " until stopped");
+    return ESP_OK;
+}
+
+esp_err_t profiler_start(uint32_t duration_s)
+{
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        if (s_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    esp_err_t ret = start_locked(duration_s);
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+esp_err_t profiler_stop(void)
+{
+    if (s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (s_running) {
+        s_running = false;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            gptimer_stop(s_cores[core].timer);
+        }
+        esp_timer_stop(s_stop_timer);   // Not running when stopped by it
+        s_stop_us = esp_timer_get_time();
+
+        profiler_status_t status;
+        profiler_get_status(&status);
+        ESP_LOGI(TAG, "Profile stopped: %lu samples, %lu distinct, %lu dropped",
+                 (unsigned long)status.samples, (unsigned long)status.buckets_used,
+                 (unsigned long)status.dropped);
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+void profiler_get_status(profiler_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+    memset(status, 0, sizeof(*status));
+    status->running = s_running;
+    status->rate_hz = CONFIG_PROFILER_SAMPLE_HZ;
+    status->buckets = PROF_BUCKETS;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        status->buckets_used += s_cores[core].used;
+        status->samples += s_cores[core].samples;
+        status->in_isr += s_cores[core].in_isr;
+        status->dropped += s_cores[core].dropped;
+    }
+    if (s_start_us != 0) {
+        int64_t end = s_running ? esp_timer_get_time() : s_stop_us;
+        status->elapsed_ms = (end - s_start_us) / 1000;
+    }
+}
+
+// ============================================================================
+// Text export
+// ============================================================================
+
+/**
+ * @brief Name of a task as a single word, its handle if it no longer exists
+ */
+static const char *task_label(const TaskStatus_t *tasks, UBaseType_t count, uint32_t handle,
+                              char *out, size_t out_size)
+{
+    if (handle == 0) {
+        return "-";
+    }
+    for (UBaseType_t i = 0; i < count; i++) {
+        if ((uint32_t)(uintptr_t)tasks[i].xHandle == handle) {
+            strncpy(out, tasks[i].pcTaskName, out_size - 1);
+            out[out_size - 1] = '\0';
+            for (char *c = out; *c; c++) {
+                if (*c == ' ') *c = '_';
+            }
+            return out;
+        }
+    }
+    snprintf(out, out_size, "0x%08lx", (unsigned long)handle);
+    return out;
+}
+
+esp_err_t profiler_export(profiler_write_fn write, void *ctx)
+{
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_buckets == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    static uint8_t buf[EXPORT_BUF_SIZE];    // Only the web server exports; keeps it off its stack
+    export_writer_t ex;
+    export_writer_init(&ex, buf, sizeof(buf), write, ctx);
+
+    UBaseType_t num_tasks = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = memprof_malloc(MEMPROF_TAG_DIAG, num_tasks * sizeof(TaskStatus_t));
+    UBaseType_t task_count = tasks ? uxTaskGetSystemState(tasks, num_tasks, NULL) : 0;
+
+    profiler_status_t status;
+    profiler_get_status(&status);
+    export_writer_printf(&ex, "# bocal-dinamico profile\n"
+                              "# rate_hz %lu\n# elapsed_ms %lu\n# samples %lu\n# in_isr %lu\n# dropped %lu\n"
+                              "# core task pc return count\n",
+                         (unsigned long)status.rate_hz, (unsigned long)status.elapsed_ms,
+                         (unsigned long)status.samples, (unsigned long)status.in_isr,
+                         (unsigned long)status.dropped);
+
+    char name[configMAX_TASK_NAME_LEN + 4];
+    for (int core = 0; core < portNUM_PROCESSORS && ex.err == ESP_OK; core++) {
+        const prof_bucket_t *buckets = &s_buckets[core * PROF_BUCKETS];
+        for (int i = 0; i < PROF_BUCKETS && ex.err == ESP_OK; i++) {
+            const prof_bucket_t *b = &buckets[i];
+            if (b->count == 0) {
+                continue;
+            }
+            export_writer_printf(&ex, "%d %s 0x%08lx 0x%08lx %lu\n", core,
+                                 task_label(tasks, task_count, b->task, name, sizeof(name)),
+                                 (unsigned long)b->pc, (unsigned long)b->ret, (unsigned long)b->count);
+        }
+    }
+    esp_err_t err = export_writer_finish(&ex);
+    memprof_free(MEMPROF_TAG_DIAG, tasks);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Export aborted: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+#else
+
+esp_err_t profiler_start(uint32_t duration_s)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t profiler_stop(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void profiler_get_status(profiler_status_t *status)
+{
+    if (status) memset(status, 0, sizeof(*status));
+}
+
+esp_err_t profiler_export(profiler_write_fn write, void *ctx)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_PROFILER_ENABLE
@@ -0,0 +1,107 @@
+/**
+ * @file profiler.h
+ * @brief Statistical sampling profiler
+ *
+ * While running, one hardware timer per core interrupts that core at
+ * CONFIG_PROFILER_SAMPLE_HZ and records the interrupted program counter,
+ * the return address of the interrupted function and the running task.
+ * Identical samples are counted in a small hash table per core
+ * (CONFIG_PROFILER_BUCKETS entries), so a profile of any length takes a
+ * fixed amount of RAM, allocated on the first start.
+ *
+ * The profile is downloaded as text (GET /api/profiler) and symbolized on
+ * the host against the application ELF by tools/profile_fold.py, which
+ * writes folded stacks for flamegraph.pl or speedscope. No debug probe is
+ * needed.
+ *
+ * Samples that interrupt another interrupt handler are counted but not
+ * attributed. Non-IRAM interrupts are masked during flash writes, so time
+ * spent inside SPI flash operations is under-represented.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Profiler state
+ */
+typedef struct {
+    bool running;
+    uint32_t rate_hz;           // Samples per second and core (0 = profiler disabled)
+    uint32_t buckets;           // Distinct samples kept per core
+    uint32_t buckets_used;      // Distinct samples recorded, both cores
+    uint32_t samples;           // Samples taken since the last start, both cores
+    uint32_t in_isr;            // Samples that landed in an interrupt handler
+    uint32_t dropped;           // Samples lost to a full table
+    uint32_t elapsed_ms;        // Duration of the last (or current) run
+} profiler_status_t;
+
+/**
+ * @brief Write callback of the export
+ *
+ * @param ctx Caller context
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK to continue, anything else aborts the export
+ */
+typedef esp_err_t (*profiler_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Clear the profile and start sampling
+ *
+ * @param duration_s Stop automatically after this many seconds (0 = run
+ *                   until profiler_stop())
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if already
+ *         running, ESP_ERR_NO_MEM if the tables cannot be allocated,
+ *         ESP_ERR_NOT_SUPPORTED if the profiler is disabled
+ */
+esp_err_t profiler_start(uint32_t duration_s);
+
+/**
+ * @brief Stop sampling (the profile is kept until the next start)
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if not running
+ */
+esp_err_t profiler_stop(void);
+
+/**
+ * @brief Get the profiler state
+ *
+ * @param status Pointer to store the state
+ */
+void profiler_get_status(profiler_status_t *status);
+
+/**
+ * @brief Write the profile as text
+ *
+ * Comment lines start with '#'. Each other line is one distinct sample:
+ * "<core> <task> <pc> <return address> <count>", addresses in hex; pc 0
+ * counts the samples taken inside interrupt handlers. Task names of tasks
+ * that no longer exist are replaced by their handle.
+ *
+ * @param write Write callback
+ * @param ctx Context passed to the callback
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if nothing was
+ *         recorded, the callback's error otherwise
+ */
+esp_err_t profiler_export(profiler_write_fn write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROFILER_H
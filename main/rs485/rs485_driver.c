@@ -2,34 +2,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
+#include "dlog.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "rs485_sim.h"
+#include "rs485_trace.h"
+#include "tracepoint.h"
+#include "memprof.h"
 
 static const char *TAG = "RS485";
 
-// Enable verbose hex dump of TX/RX data (set to 1 for debugging)
-#ifndef RS485_DEBUG_HEX_DUMP
-#define RS485_DEBUG_HEX_DUMP 1
-#endif
-
-#if RS485_DEBUG_HEX_DUMP
-static void hex_dump(const char *prefix, const uint8_t *data, size_t len)
-{
-    if (len == 0) return;
-
-    char buf[128];
-    size_t pos = 0;
-
-    for (size_t i = 0; i < len && pos < sizeof(buf) - 4; i++) {
-        pos += snprintf(buf + pos, sizeof(buf) - pos, "%02X ", data[i]);
-    }
-
-    ESP_LOGI(TAG, "%s [%u bytes]: %s", prefix, (unsigned)len, buf);
-}
-#else
-#define hex_dump(prefix, data, len) do {} while(0)
-#endif
-
 /**
  * @brief Internal RS485 driver structure
  */
@@ -38,8 +22,25 @@ struct rs485_driver {
     gpio_num_t de_pin;
     SemaphoreHandle_t mutex;
     int baud_rate;
+#if CONFIG_RS485_SIMULATOR
+    uint8_t sim_rx[256];        // Pending response of the simulated slave
+    size_t sim_rx_len;
+    size_t sim_rx_pos;
+#endif
 };
 
+#if CONFIG_RS485_SIMULATOR
+/**
+ * @brief Block for the time a number of characters takes on the wire
+ */
+static void sim_wire_delay(const struct rs485_driver *drv, size_t chars)
+{
+    uint32_t us = chars * 10 * 1000000ULL / (drv->baud_rate > 0 ? drv->baud_rate : 57600);
+    TickType_t ticks = us / (portTICK_PERIOD_MS * 1000);
+    vTaskDelay(ticks > 0 ? ticks : 1);
+}
+#endif
+
 esp_err_t rs485_init(const rs485_config_t *config, rs485_handle_t *handle)
 {
     if (config == NULL || handle == NULL) {
@@ -47,7 +48,7 @@ esp_err_t rs485_init(const rs485_config_t *config, rs485_handle_t *handle)
     }
 
     // Allocate driver structure
-    struct rs485_driver *drv = calloc(1, sizeof(struct rs485_driver));
+    struct rs485_driver *drv = memprof_calloc(MEMPROF_TAG_DRIVER, 1, sizeof(struct rs485_driver));
     if (drv == NULL) {
         ESP_LOGE(TAG, "Failed to allocate driver structure");
         return ESP_ERR_NO_MEM;
@@ -61,10 +62,14 @@ esp_err_t rs485_init(const rs485_config_t *config, rs485_handle_t *handle)
     drv->mutex = xSemaphoreCreateMutex();
     if (drv->mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create mutex");
-        free(drv);
+        memprof_free(MEMPROF_TAG_DRIVER, drv);
         return ESP_ERR_NO_MEM;
     }
 
+#if CONFIG_RS485_SIMULATOR
+    ESP_LOGW(TAG, "RS485 simulated: UART%d, %d actuators, Baud=%d",
+             config->uart_num, CONFIG_RS485_SIM_SLAVES, config->baud_rate);
+#else
     // Configure UART
     uart_config_t uart_config = {
         .baud_rate = config->baud_rate,
@@ -79,7 +84,7 @@ esp_err_t rs485_init(const rs485_config_t *config, rs485_handle_t *handle)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure UART parameters: %s", esp_err_to_name(ret));
         vSemaphoreDelete(drv->mutex);
-        free(drv);
+        memprof_free(MEMPROF_TAG_DRIVER, drv);
         return ret;
     }
 
@@ -89,7 +94,7 @@ esp_err_t rs485_init(const rs485_config_t *config, rs485_handle_t *handle)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set UART pins: %s", esp_err_to_name(ret));
         vSemaphoreDelete(drv->mutex);
-        free(drv);
+        memprof_free(MEMPROF_TAG_DRIVER, drv);
         return ret;
     }
 
@@ -99,7 +104,7 @@ esp_err_t rs485_init(const rs485_config_t *config, rs485_handle_t *handle)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to install UART driver: %s", esp_err_to_name(ret));
         vSemaphoreDelete(drv->mutex);
-        free(drv);
+        memprof_free(MEMPROF_TAG_DRIVER, drv);
         return ret;
     }
 
@@ -109,13 +114,20 @@ esp_err_t rs485_init(const rs485_config_t *config, rs485_handle_t *handle)
         ESP_LOGE(TAG, "Failed to set RS485 mode: %s", esp_err_to_name(ret));
         uart_driver_delete(config->uart_num);
         vSemaphoreDelete(drv->mutex);
-        free(drv);
+        memprof_free(MEMPROF_TAG_DRIVER, drv);
         return ret;
     }
 
+    // Deliver RX data promptly after the line goes idle
+    ret = uart_set_rx_timeout(config->uart_num, RS485_RX_TIMEOUT_SYMBOLS);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set RX timeout: %s", esp_err_to_name(ret));
+    }
+
     ESP_LOGI(TAG, "RS485 initialized: UART%d, TX=%d, RX=%d, DE=%d, Baud=%d",
              config->uart_num, config->tx_pin, config->rx_pin,
              config->de_pin, config->baud_rate);
+#endif
 
     *handle = drv;
     return ESP_OK;
@@ -129,9 +141,11 @@ esp_err_t rs485_deinit(rs485_handle_t handle)
 
     struct rs485_driver *drv = handle;
 
+#if !CONFIG_RS485_SIMULATOR
     uart_driver_delete(drv->uart_num);
+#endif
     vSemaphoreDelete(drv->mutex);
-    free(drv);
+    memprof_free(MEMPROF_TAG_DRIVER, drv);
 
     return ESP_OK;
 }
@@ -144,22 +158,32 @@ esp_err_t rs485_send(rs485_handle_t handle, const uint8_t *data, size_t len, uin
 
     struct rs485_driver *drv = handle;
 
-    hex_dump("TX", data, len);
+    rs485_trace_record(drv->uart_num, RS485_TRACE_TX, data, len);
 
+#if CONFIG_RS485_SIMULATOR
+    sim_wire_delay(drv, len);
+    drv->sim_rx_pos = 0;
+    return rs485_sim_request(drv->uart_num, data, len, drv->sim_rx, sizeof(drv->sim_rx),
+                             &drv->sim_rx_len);
+#else
+    TRACE_BEGIN("uart_tx");
     int written = uart_write_bytes(drv->uart_num, data, len);
     if (written < 0) {
-        ESP_LOGE(TAG, "UART write failed");
+        TRACE_END("uart_tx");
+        DLOGE(TAG, "UART write failed");
         return ESP_FAIL;
     }
 
     // Wait for transmission to complete
     esp_err_t ret = uart_wait_tx_done(drv->uart_num, pdMS_TO_TICKS(timeout_ms));
+    TRACE_END("uart_tx");
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "UART TX timeout");
+        DLOGE(TAG, "UART TX timeout");
         return ESP_ERR_TIMEOUT;
     }
 
     return ESP_OK;
+#endif
 }
 
 esp_err_t rs485_receive(rs485_handle_t handle, uint8_t *data, size_t max_len, size_t *received, uint32_t timeout_ms)
@@ -169,25 +193,78 @@ esp_err_t rs485_receive(rs485_handle_t handle, uint8_t *data, size_t max_len, si
     }
 
     struct rs485_driver *drv = handle;
+    TickType_t ticks = timeout_ms == RS485_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
     *received = 0;
 
-    int len = uart_read_bytes(drv->uart_num, data, max_len, pdMS_TO_TICKS(timeout_ms));
+#if CONFIG_RS485_SIMULATOR
+    int len = 0;
+    if (drv->sim_rx_pos < drv->sim_rx_len) {
+        len = drv->sim_rx_len - drv->sim_rx_pos;
+        if ((size_t)len > max_len) len = max_len;
+        sim_wire_delay(drv, len);
+        memcpy(data, drv->sim_rx + drv->sim_rx_pos, len);
+        drv->sim_rx_pos += len;
+    } else {
+        vTaskDelay(ticks);
+    }
+#else
+    TRACE_BEGIN("uart_rx");
+    int len = uart_read_bytes(drv->uart_num, data, max_len, ticks);
+    TRACE_END("uart_rx");
+#endif
     if (len < 0) {
-        ESP_LOGE(TAG, "UART read failed");
+        DLOGE(TAG, "UART read failed");
         return ESP_FAIL;
     }
 
+    // Reported by the caller: a timeout is expected when polling an idle line
     if (len == 0) {
-        ESP_LOGW(TAG, "RX timeout - no response from slave");
+        DLOGD(TAG, "RX timeout");
         return ESP_ERR_TIMEOUT;
     }
 
-    hex_dump("RX", data, len);
-
     *received = len;
     return ESP_OK;
 }
 
+int rs485_get_baud_rate(rs485_handle_t handle)
+{
+    if (handle == NULL) {
+        return 0;
+    }
+    return handle->baud_rate;
+}
+
+esp_err_t rs485_lock(rs485_handle_t handle, uint32_t timeout_ms)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    TRACE_BEGIN("bus_lock");
+    BaseType_t taken = xSemaphoreTake(handle->mutex, pdMS_TO_TICKS(timeout_ms));
+    TRACE_END("bus_lock");
+    if (taken != pdTRUE) {
+        DLOGE(TAG, "Failed to acquire mutex");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void rs485_unlock(rs485_handle_t handle)
+{
+    if (handle != NULL) {
+        xSemaphoreGive(handle->mutex);
+    }
+}
+
+void rs485_trace_rx(rs485_handle_t handle, const uint8_t *frame, size_t len)
+{
+    if (handle != NULL) {
+        rs485_trace_record(handle->uart_num, RS485_TRACE_RX, frame, len);
+    }
+}
+
 esp_err_t rs485_flush_rx(rs485_handle_t handle)
 {
     if (handle == NULL) {
@@ -195,7 +272,13 @@ esp_err_t rs485_flush_rx(rs485_handle_t handle)
     }
 
     struct rs485_driver *drv = handle;
+#if CONFIG_RS485_SIMULATOR
+    drv->sim_rx_len = 0;
+    drv->sim_rx_pos = 0;
+    return ESP_OK;
+#else
     return uart_flush_input(drv->uart_num);
+#endif
 }
 
 esp_err_t rs485_transaction(rs485_handle_t handle,
@@ -212,12 +295,12 @@ esp_err_t rs485_transaction(rs485_handle_t handle,
 
     // Take mutex for thread safety
     if (xSemaphoreTake(drv->mutex, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire mutex");
+        DLOGE(TAG, "Failed to acquire mutex");
         return ESP_ERR_TIMEOUT;
     }
 
     // Flush RX buffer before transaction
-    uart_flush_input(drv->uart_num);
+    rs485_flush_rx(handle);
 
     // Send request
     ret = rs485_send(handle, tx_data, tx_len, timeout_ms);
@@ -226,13 +309,10 @@ esp_err_t rs485_transaction(rs485_handle_t handle,
         return ret;
     }
 
-    // Small delay for slave to process (Modbus requires 3.5 char times minimum)
-    // At 57600 baud, 3.5 chars ~= 0.6ms, we use 2ms for safety
-    vTaskDelay(pdMS_TO_TICKS(2));
-
     // Receive response
     if (rx_data != NULL && rx_max_len > 0 && rx_received != NULL) {
         ret = rs485_receive(handle, rx_data, rx_max_len, rx_received, timeout_ms);
+        rs485_trace_rx(handle, rx_data, *rx_received);
     }
 
     xSemaphoreGive(drv->mutex);
@@ -24,6 +24,20 @@ typedef struct {
     int tx_buffer_size;         // TX buffer size (default 256)
 } rs485_config_t;
 
+/**
+ * @brief UART RX idle timeout in symbol times
+ *
+ * Received bytes are handed to the driver after this many idle symbols
+ * (instead of the UART default of 10), so short Modbus frames become
+ * visible to readers shortly after their last byte.
+ */
+#define RS485_RX_TIMEOUT_SYMBOLS    3
+
+/**
+ * @brief Timeout for rs485_receive() that waits until data arrives
+ */
+#define RS485_WAIT_FOREVER          UINT32_MAX
+
 /**
  * @brief RS485 handle
  */
@@ -77,11 +91,51 @@ esp_err_t rs485_send(rs485_handle_t handle, const uint8_t *data, size_t len, uin
  * @param data Pointer to buffer to store received data
  * @param max_len Maximum length to receive
  * @param received Pointer to store actual received length
- * @param timeout_ms Timeout in milliseconds
+ * @param timeout_ms Timeout in milliseconds, or RS485_WAIT_FOREVER
  * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if timeout
  */
 esp_err_t rs485_receive(rs485_handle_t handle, uint8_t *data, size_t max_len, size_t *received, uint32_t timeout_ms);
 
+/**
+ * @brief Get the configured baud rate
+ *
+ * @param handle RS485 handle
+ * @return int Baud rate, or 0 if handle is NULL
+ */
+int rs485_get_baud_rate(rs485_handle_t handle);
+
+/**
+ * @brief Take exclusive access to the bus
+ *
+ * Use around a sequence of rs485_send()/rs485_receive() calls that must not
+ * be interleaved with other transactions. rs485_transaction() takes the
+ * lock itself.
+ *
+ * @param handle RS485 handle
+ * @param timeout_ms Maximum time to wait for the bus
+ * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if the bus is busy
+ */
+esp_err_t rs485_lock(rs485_handle_t handle, uint32_t timeout_ms);
+
+/**
+ * @brief Release the bus taken with rs485_lock()
+ *
+ * @param handle RS485 handle
+ */
+void rs485_unlock(rs485_handle_t handle);
+
+/**
+ * @brief Record a received frame in the bus trace
+ *
+ * Sent frames are traced by rs485_send(). Received frames may be read in
+ * pieces, so the protocol layer records them once complete.
+ *
+ * @param handle RS485 handle
+ * @param frame Frame bytes
+ * @param len Frame length
+ */
+void rs485_trace_rx(rs485_handle_t handle, const uint8_t *frame, size_t len);
+
 /**
  * @brief Flush RX buffer
  *
@@ -0,0 +1,204 @@
+/**
+ * @file rs485_sim.c
+ * @brief Simulated mightyZAP actuators behind an RS485 port
+ */
+
+#include "rs485_sim.h"
+#include "sdkconfig.h"
+
+#if CONFIG_RS485_SIMULATOR
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "modbus_rtu.h"
+#include "mightyzap.h"
+
+static const char *TAG = "RS485_SIM";
+
+#define SIM_SLAVES          CONFIG_RS485_SIM_SLAVES
+#define SIM_REG_COUNT       (MZAP_REG_HW_ERROR_STATE + 1)
+#define SIM_MODEL           350
+#define SIM_FIRMWARE        0x0014
+#define SIM_SPEED_DIVISOR   64      // Goal speed / this = counts per ms
+
+/**
+ * @brief Simulated actuator
+ */
+typedef struct {
+    bool initialized;
+    uint16_t regs[SIM_REG_COUNT];
+    int64_t updated_us;
+} sim_slave_t;
+
+static sim_slave_t s_slaves[UART_NUM_MAX][SIM_SLAVES];
+
+// ============================================================================
+// Actuator model
+// ============================================================================
+
+static void slave_reset(sim_slave_t *slave, uint8_t id)
+{
+    memset(slave->regs, 0, sizeof(slave->regs));
+    slave->regs[MZAP_REG_MODEL_NUMBER] = SIM_MODEL;
+    slave->regs[MZAP_REG_FIRMWARE_VERSION] = SIM_FIRMWARE;
+    slave->regs[MZAP_REG_ID] = id;
+    slave->regs[MZAP_REG_BAUD_RATE] = 32;
+    slave->regs[MZAP_REG_LONG_STROKE_LIM] = 4095;
+    slave->regs[MZAP_REG_LOWEST_VOLTAGE] = 70;
+    slave->regs[MZAP_REG_HIGHEST_VOLTAGE] = 130;
+    slave->regs[MZAP_REG_SPEED_LIMIT] = 1023;
+    slave->regs[MZAP_REG_CURRENT_LIMIT] = 800;
+    slave->regs[MZAP_REG_GOAL_SPEED] = 1023;
+    slave->regs[MZAP_REG_GOAL_CURRENT] = 800;
+    slave->regs[MZAP_REG_PRESENT_VOLTAGE] = 120;
+    slave->updated_us = esp_timer_get_time();
+    slave->initialized = true;
+}
+
+/**
+ * @brief Move the actuator towards its goal for the time since the last call
+ */
+static void slave_update(sim_slave_t *slave)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed_ms = (now - slave->updated_us) / 1000;
+    if (elapsed_ms <= 0) {
+        return;
+    }
+    slave->updated_us = now;
+
+    uint16_t *r = slave->regs;
+    int pos = r[MZAP_REG_PRESENT_POSITION];
+    int goal = r[MZAP_REG_GOAL_POSITION];
+    bool force = r[MZAP_REG_FORCE_ON_OFF] != 0;
+
+    if (force && pos != goal) {
+        int step = (int)(elapsed_ms * (r[MZAP_REG_GOAL_SPEED] + 1) / SIM_SPEED_DIVISOR);
+        if (step < 1) step = 1;
+        pos = goal > pos ? (pos + step > goal ? goal : pos + step)
+                         : (pos - step < goal ? goal : pos - step);
+        r[MZAP_REG_PRESENT_POSITION] = pos;
+    }
+
+    bool moving = force && pos != goal;
+    r[MZAP_REG_MOVING] = moving;
+    r[MZAP_REG_PRESENT_MOTOR_OP] = moving ? 512 : 0;
+    r[MZAP_REG_PRESENT_CURRENT] = moving ? r[MZAP_REG_GOAL_CURRENT] / 4 : 20;
+}
+
+// ============================================================================
+// Modbus
+// ============================================================================
+
+static size_t exception(uint8_t *rsp, uint8_t fc, modbus_exception_t code)
+{
+    rsp[1] = fc | 0x80;
+    rsp[2] = code;
+    return 3;
+}
+
+/**
+ * @brief Execute a request on a slave
+ *
+ * @return size_t Response length without CRC
+ */
+static size_t slave_execute(sim_slave_t *slave, const uint8_t *req, size_t len, uint8_t *rsp)
+{
+    uint8_t fc = req[1];
+    uint16_t addr = (req[2] << 8) | req[3];
+    uint16_t count = (req[4] << 8) | req[5];
+    uint16_t *r = slave->regs;
+
+    rsp[0] = req[0];
+    rsp[1] = fc;
+
+    switch (fc) {
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            if (count == 0 || count > 125) {
+                return exception(rsp, fc, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            }
+            if (addr + count > SIM_REG_COUNT) {
+                return exception(rsp, fc, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            }
+            slave_update(slave);
+            rsp[2] = count * 2;
+            for (uint16_t i = 0; i < count; i++) {
+                rsp[3 + i * 2] = r[addr + i] >> 8;
+                rsp[4 + i * 2] = r[addr + i] & 0xFF;
+            }
+            return 3 + count * 2;
+
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            if (addr >= SIM_REG_COUNT) {
+                return exception(rsp, fc, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            }
+            slave_update(slave);
+            r[addr] = count;    // Value field
+            memcpy(&rsp[2], &req[2], 4);
+            return 6;
+
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            if (count == 0 || count > 123 || len < 9 + count * 2u || req[6] != count * 2) {
+                return exception(rsp, fc, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            }
+            if (addr + count > SIM_REG_COUNT) {
+                return exception(rsp, fc, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            }
+            slave_update(slave);
+            for (uint16_t i = 0; i < count; i++) {
+                r[addr + i] = (req[7 + i * 2] << 8) | req[8 + i * 2];
+            }
+            memcpy(&rsp[2], &req[2], 4);
+            return 6;
+
+        default:
+            return exception(rsp, fc, MODBUS_EX_ILLEGAL_FUNCTION);
+    }
+}
+
+esp_err_t rs485_sim_request(int port, const uint8_t *request, size_t req_len,
+                            uint8_t *response, size_t max_len, size_t *resp_len)
+{
+    if (request == NULL || response == NULL || resp_len == NULL ||
+        port < 0 || port >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *resp_len = 0;
+
+    // Garbled frames are ignored, as a real slave would
+    if (req_len < 8 || modbus_crc16(request, req_len) != 0) {
+        ESP_LOGD(TAG, "Ignoring invalid frame (%u bytes)", (unsigned)req_len);
+        return ESP_OK;
+    }
+
+    uint8_t id = request[0];
+    if (id == 0 || id > SIM_SLAVES || max_len < 5 + 125 * 2) {
+        return ESP_OK;     // No such slave (or broadcast): no response
+    }
+
+    sim_slave_t *slave = &s_slaves[port][id - 1];
+    if (!slave->initialized) {
+        slave_reset(slave, id);
+    }
+
+    size_t len = slave_execute(slave, request, req_len, response);
+    uint16_t crc = modbus_crc16(response, len);
+    response[len] = crc & 0xFF;
+    response[len + 1] = crc >> 8;
+    *resp_len = len + 2;
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t rs485_sim_request(int port, const uint8_t *request, size_t req_len,
+                            uint8_t *response, size_t max_len, size_t *resp_len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_RS485_SIMULATOR
@@ -0,0 +1,41 @@
+/**
+ * @file rs485_sim.h
+ * @brief Simulated mightyZAP actuators behind an RS485 port
+ *
+ * Used by the RS485 driver instead of the UART when CONFIG_RS485_SIMULATOR
+ * is set. Each port has its own set of actuators answering Modbus RTU
+ * requests (FC 0x03, 0x04, 0x06, 0x10) on slave IDs 1 to
+ * CONFIG_RS485_SIM_SLAVES. Goal position writes make the actuator move
+ * towards the goal at its goal speed.
+ */
+
+#ifndef RS485_SIM_H
+#define RS485_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handle a request frame sent on a simulated port
+ *
+ * @param port UART port number
+ * @param request Request frame (including CRC)
+ * @param req_len Length of the request frame
+ * @param response Buffer for the response frame
+ * @param max_len Size of the response buffer
+ * @param resp_len Pointer to store the response length (0 = no response)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t rs485_sim_request(int port, const uint8_t *request, size_t req_len,
+                            uint8_t *response, size_t max_len, size_t *resp_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_SIM_H
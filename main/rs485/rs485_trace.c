@@ -0,0 +1,244 @@
+/**
+ * @file rs485_trace.c
+ * @brief Binary trace of the RS485 frames, exported as pcapng
+ */
+
+#include "rs485_trace.h"
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/time.h>
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "sdkconfig.h"
+#include "export_writer.h"
+
+#if CONFIG_RS485_TRACE
+
+#define TRACE_RECORDS           CONFIG_RS485_TRACE_RECORDS
+#define TRACE_SNAPLEN           CONFIG_RS485_TRACE_SNAPLEN
+
+// pcapng block types and options
+#define PCAPNG_SHB              0x0A0D0D0A
+#define PCAPNG_IDB              0x00000001
+#define PCAPNG_EPB              0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_OPT_END          0
+#define PCAPNG_OPT_IF_NAME      2
+#define PCAPNG_OPT_EPB_FLAGS    2
+#define PCAPNG_FLAG_INBOUND     0x1
+#define PCAPNG_FLAG_OUTBOUND    0x2
+
+#define PAD4(n)                 (((n) + 3) & ~3u)
+#define EXPORT_BUF_SIZE         512
+
+// Every block fits the export buffer, so export_writer_reserve() never fails
+_Static_assert(28 + PAD4(TRACE_SNAPLEN) + 16 <= EXPORT_BUF_SIZE, "Packet block larger than the export buffer");
+
+/**
+ * @brief Trace record
+ *
+ * seq holds the record's index + 1 once it is complete and 0 while it is
+ * being written, so a reader can tell a finished record from one being
+ * overwritten.
+ */
+typedef struct {
+    atomic_uint seq;
+    int64_t time_us;
+    uint16_t len;               // Original frame length
+    uint8_t port;
+    uint8_t dir;
+    uint8_t data[TRACE_SNAPLEN];
+} trace_record_t;
+
+static trace_record_t s_ring[TRACE_RECORDS];
+static atomic_uint s_head;      // Index of the next record to write
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+void rs485_trace_record(uint8_t port, rs485_trace_dir_t dir, const uint8_t *frame, size_t len)
+{
+    if (frame == NULL || len == 0) {
+        return;
+    }
+
+    unsigned index = atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+    trace_record_t *rec = &s_ring[index % TRACE_RECORDS];
+
+    atomic_store_explicit(&rec->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    rec->time_us = esp_timer_get_time();
+    rec->len = len > UINT16_MAX ? UINT16_MAX : len;
+    rec->port = port;
+    rec->dir = dir;
+    memcpy(rec->data, frame, len < TRACE_SNAPLEN ? len : TRACE_SNAPLEN);
+
+    atomic_store_explicit(&rec->seq, index + 1, memory_order_release);
+}
+
+/**
+ * @brief Copy a record if it is complete and still holds the given index
+ */
+static bool copy_record(unsigned index, trace_record_t *out)
+{
+    const trace_record_t *rec = &s_ring[index % TRACE_RECORDS];
+
+    unsigned seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+    if (seq != index + 1) {
+        return false;
+    }
+
+    out->time_us = rec->time_us;
+    out->len = rec->len;
+    out->port = rec->port;
+    out->dir = rec->dir;
+    memcpy(out->data, rec->data, TRACE_SNAPLEN);
+
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&rec->seq, memory_order_relaxed) == seq;
+}
+
+// ============================================================================
+// pcapng export
+// ============================================================================
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    memcpy(p, &v, sizeof(v));   // pcapng is written in host byte order
+    return p + sizeof(v);
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+    return p + sizeof(v);
+}
+
+static void write_section_header(export_writer_t *ex)
+{
+    const uint32_t block_len = 28;
+    uint8_t *p = export_writer_reserve(ex, block_len);
+
+    p = put_u32(p, PCAPNG_SHB);
+    p = put_u32(p, block_len);
+    p = put_u32(p, PCAPNG_BYTE_ORDER_MAGIC);
+    p = put_u16(p, 1);                      // Version 1.0
+    p = put_u16(p, 0);
+    p = put_u32(p, 0xFFFFFFFF);             // Section length unknown (-1)
+    p = put_u32(p, 0xFFFFFFFF);
+    put_u32(p, block_len);
+}
+
+/**
+ * @brief One interface per UART, so the interface ID is the port number
+ */
+static void write_interface(export_writer_t *ex, uint8_t port)
+{
+    char name[8] = "uart0";
+    name[4] = '0' + port;
+    const uint32_t name_len = strlen(name);
+    const uint32_t block_len = 20 + 4 + PAD4(name_len) + 4;
+    uint8_t *p = export_writer_reserve(ex, block_len);
+
+    p = put_u32(p, PCAPNG_IDB);
+    p = put_u32(p, block_len);
+    p = put_u16(p, RS485_TRACE_LINKTYPE);
+    p = put_u16(p, 0);
+    p = put_u32(p, TRACE_SNAPLEN);
+    p = put_u16(p, PCAPNG_OPT_IF_NAME);
+    p = put_u16(p, name_len);
+    memcpy(p, name, name_len);
+    p += PAD4(name_len);
+    p = put_u32(p, PCAPNG_OPT_END);
+    put_u32(p, block_len);
+}
+
+static void write_packet(export_writer_t *ex, const trace_record_t *rec, int64_t time_offset_us)
+{
+    const uint32_t caplen = rec->len < TRACE_SNAPLEN ? rec->len : TRACE_SNAPLEN;
+    const uint32_t block_len = 28 + PAD4(caplen) + 8 + 4 + 4;
+    uint64_t ts = (uint64_t)(rec->time_us + time_offset_us);   // Microseconds (default resolution)
+    uint8_t *p = export_writer_reserve(ex, block_len);
+
+    p = put_u32(p, PCAPNG_EPB);
+    p = put_u32(p, block_len);
+    p = put_u32(p, rec->port);
+    p = put_u32(p, (uint32_t)(ts >> 32));
+    p = put_u32(p, (uint32_t)ts);
+    p = put_u32(p, caplen);
+    p = put_u32(p, rec->len);
+    memcpy(p, rec->data, caplen);
+    p += PAD4(caplen);
+    p = put_u16(p, PCAPNG_OPT_EPB_FLAGS);
+    p = put_u16(p, 4);
+    p = put_u32(p, rec->dir == RS485_TRACE_RX ? PCAPNG_FLAG_INBOUND : PCAPNG_FLAG_OUTBOUND);
+    p = put_u32(p, PCAPNG_OPT_END);
+    put_u32(p, block_len);
+}
+
+esp_err_t rs485_trace_export_pcapng(rs485_trace_write_fn write, void *ctx)
+{
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    static uint8_t buf[EXPORT_BUF_SIZE];    // Only the web server exports; keeps it off its stack
+    export_writer_t ex;
+    export_writer_init(&ex, buf, sizeof(buf), write, ctx);
+
+    // Timestamps are since boot; shift them to wall time once the clock is set
+    int64_t time_offset_us = 0;
+    struct timeval tv;
+    if (gettimeofday(&tv, NULL) == 0 && tv.tv_sec > 1600000000) {
+        time_offset_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - esp_timer_get_time();
+    }
+
+    write_section_header(&ex);
+    for (uint8_t port = 0; port < UART_NUM_MAX; port++) {
+        write_interface(&ex, port);
+    }
+
+    unsigned head = atomic_load_explicit(&s_head, memory_order_acquire);
+    unsigned first = head > TRACE_RECORDS ? head - TRACE_RECORDS : 0;
+    trace_record_t rec;
+
+    for (unsigned index = first; index != head && ex.err == ESP_OK; index++) {
+        if (copy_record(index, &rec)) {
+            write_packet(&ex, &rec, time_offset_us);
+        }
+    }
+
+    return export_writer_finish(&ex);
+}
+
+void rs485_trace_get_stats(rs485_trace_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    unsigned head = atomic_load_explicit(&s_head, memory_order_relaxed);
+    stats->capacity = TRACE_RECORDS;
+    stats->snaplen = TRACE_SNAPLEN;
+    stats->recorded = head;
+    stats->overwritten = head > TRACE_RECORDS ? head - TRACE_RECORDS : 0;
+}
+
+#else
+
+void rs485_trace_record(uint8_t port, rs485_trace_dir_t dir, const uint8_t *frame, size_t len)
+{
+}
+
+esp_err_t rs485_trace_export_pcapng(rs485_trace_write_fn write, void *ctx)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void rs485_trace_get_stats(rs485_trace_stats_t *stats)
+{
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+#endif // CONFIG_RS485_TRACE
@@ -0,0 +1,90 @@
+/**
+ * @file rs485_trace.h
+ * @brief Binary trace of the RS485 frames, exported as pcapng
+ *
+ * Every frame sent or received on an RS485 port is copied into a ring of
+ * fixed-size records (timestamp, port, direction, length, first bytes).
+ * Recording is lock-free and safe from any task, so it stays enabled in
+ * production. The ring is exported as pcapng with one interface per UART
+ * and the link type LINKTYPE_USER0 (147); map it to the "mbrtu" dissector
+ * in Wireshark (Preferences > Protocols > DLT_USER).
+ */
+
+#ifndef RS485_TRACE_H
+#define RS485_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RS485_TRACE_LINKTYPE    147     // LINKTYPE_USER0
+
+/**
+ * @brief Frame direction
+ */
+typedef enum {
+    RS485_TRACE_TX = 0,
+    RS485_TRACE_RX,
+} rs485_trace_dir_t;
+
+/**
+ * @brief Trace statistics
+ */
+typedef struct {
+    uint32_t capacity;          // Records in the ring (0 = tracing disabled)
+    uint32_t snaplen;           // Bytes kept per frame
+    uint32_t recorded;          // Frames recorded since boot
+    uint32_t overwritten;       // Frames lost to wrap-around
+} rs485_trace_stats_t;
+
+/**
+ * @brief Write callback of the export
+ *
+ * @param ctx Caller context
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK to continue, anything else aborts the export
+ */
+typedef esp_err_t (*rs485_trace_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Record a frame
+ *
+ * Frames longer than the snap length are truncated; the original length is
+ * kept.
+ *
+ * @param port UART port number
+ * @param dir Direction
+ * @param frame Frame bytes
+ * @param len Frame length
+ */
+void rs485_trace_record(uint8_t port, rs485_trace_dir_t dir, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Write the ring, oldest frame first, as a pcapng file
+ *
+ * Frames recorded while exporting may or may not be included. A record
+ * overwritten while being copied is skipped.
+ *
+ * @param write Write callback
+ * @param ctx Context passed to the callback
+ * @return esp_err_t ESP_OK on success, the callback's error otherwise
+ */
+esp_err_t rs485_trace_export_pcapng(rs485_trace_write_fn write, void *ctx);
+
+/**
+ * @brief Get trace statistics
+ *
+ * @param stats Pointer to store statistics
+ */
+void rs485_trace_get_stats(rs485_trace_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_TRACE_H
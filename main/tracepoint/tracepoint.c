@@ -0,0 +1,262 @@
+/**
+ * @file tracepoint.c
+ * @brief Trace points exported as Chrome Trace Event JSON
+ */
+
+#include "tracepoint.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_ipc.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "memprof.h"
+#include "export_writer.h"
+
+#if CONFIG_TRACEPOINT_ENABLE
+
+static const char *TAG = "TRACE";
+
+#define TRACE_EVENTS            CONFIG_TRACEPOINT_EVENTS
+#define TRACE_TYPE_MASK         0x3u    // Event type in the low bits of the task handle
+#define TRACE_MAX_TASKS         32      // Tasks named in the export
+#define EXPORT_BUF_SIZE         1024
+
+_Static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0, "CONFIG_TRACEPOINT_EVENTS must be a power of two");
+
+/**
+ * @brief Trace event
+ */
+typedef struct {
+    uint32_t cycles;            // Cycle count of the recording core
+    const char *name;
+    uint32_t task;              // Task handle | event type (handles are word aligned)
+    int32_t value;
+} trace_event_t;
+
+/**
+ * @brief Events of one core
+ */
+typedef struct {
+    trace_event_t events[TRACE_EVENTS];
+    atomic_uint head;           // Index of the next event to write
+} trace_ring_t;
+
+static trace_ring_t s_rings[portNUM_PROCESSORS];
+static atomic_bool s_paused;
+
+static const char s_phase[] = { 'B', 'E', 'C', 'i' };
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+void tracepoint_record(tracepoint_type_t type, const char *name, int32_t value)
+{
+    if (atomic_load_explicit(&s_paused, memory_order_relaxed)) {
+        return;
+    }
+
+    // The cycle counters of the cores are not synchronized: read the count
+    // on the core whose ring gets the event
+    int core;
+    uint32_t cycles;
+    do {
+        core = esp_cpu_get_core_id();
+        cycles = esp_cpu_get_cycle_count();
+    } while (core != esp_cpu_get_core_id());
+
+    trace_ring_t *ring = &s_rings[core];
+    unsigned index = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    trace_event_t *ev = &ring->events[index & (TRACE_EVENTS - 1)];
+
+    ev->cycles = cycles;
+    ev->name = name;
+    ev->task = (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle() | type;
+    ev->value = value;
+}
+
+// ============================================================================
+// Chrome Trace Event JSON export
+// ============================================================================
+
+/**
+ * @brief Cycle count and esp_timer time read together on one core
+ */
+typedef struct {
+    uint32_t cycles;
+    int64_t time_us;
+} clock_ref_t;
+
+typedef struct {
+    export_writer_t out;
+    uint32_t tasks[TRACE_MAX_TASKS];
+    size_t task_count;
+} export_t;
+
+static void sample_clock(void *arg)
+{
+    clock_ref_t *ref = arg;
+    ref->cycles = esp_cpu_get_cycle_count();
+    ref->time_us = esp_timer_get_time();
+}
+
+static void note_task(export_t *ex, uint32_t task)
+{
+    for (size_t i = 0; i < ex->task_count; i++) {
+        if (ex->tasks[i] == task) {
+            return;
+        }
+    }
+    if (ex->task_count < TRACE_MAX_TASKS) {
+        ex->tasks[ex->task_count++] = task;
+    }
+}
+
+/**
+ * @brief Write the events of one core, newest first
+ *
+ * Each event is placed by its distance in cycles to the next newer event;
+ * the newest one by its distance to the clock reference.
+ */
+static void write_core(export_t *ex, int core, const clock_ref_t *ref, uint32_t ticks_per_us)
+{
+    trace_ring_t *ring = &s_rings[core];
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    unsigned count = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+    uint32_t newer = ref->cycles;
+    int64_t age = 0;            // Cycles before the reference
+
+    for (unsigned i = 1; i <= count && ex->out.err == ESP_OK; i++) {
+        const trace_event_t *ev = &ring->events[(head - i) & (TRACE_EVENTS - 1)];
+
+        // Signed: a task preempted between reading the counter and taking
+        // its slot leaves events slightly out of order
+        age += (int32_t)(newer - ev->cycles);
+        newer = ev->cycles;
+
+        if (ev->name == NULL) {
+            continue;
+        }
+
+        uint32_t task = ev->task & ~TRACE_TYPE_MASK;
+        tracepoint_type_t type = ev->task & TRACE_TYPE_MASK;
+        double ts = (double)ref->time_us - (double)age / ticks_per_us;
+
+        note_task(ex, task);
+        if (type == TRACEPOINT_COUNTER) {
+            export_writer_printf(&ex->out, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%ld}}",
+                                 ev->name, ts, (long)ev->value);
+        } else {
+            export_writer_printf(&ex->out, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"core\":%d}%s}",
+                                 ev->name, s_phase[type], ts, (unsigned long)task, core,
+                                 type == TRACEPOINT_INSTANT ? ",\"s\":\"t\"" : "");
+        }
+    }
+}
+
+/**
+ * @brief Name the tasks seen in the trace that are still running
+ */
+static void write_task_names(export_t *ex)
+{
+    UBaseType_t num_tasks = uxTaskGetNumberOfTasks();
+    TaskStatus_t *task_array = memprof_malloc(MEMPROF_TAG_DIAG, num_tasks * sizeof(TaskStatus_t));
+    if (task_array == NULL) {
+        return;
+    }
+
+    UBaseType_t tasks_returned = uxTaskGetSystemState(task_array, num_tasks, NULL);
+    for (size_t t = 0; t < ex->task_count; t++) {
+        for (UBaseType_t i = 0; i < tasks_returned; i++) {
+            if ((uint32_t)(uintptr_t)task_array[i].xHandle == ex->tasks[t]) {
+                export_writer_printf(&ex->out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                                     (unsigned long)ex->tasks[t], task_array[i].pcTaskName);
+                break;
+            }
+        }
+    }
+    memprof_free(MEMPROF_TAG_DIAG, task_array);
+}
+
+esp_err_t tracepoint_export_json(tracepoint_write_fn write, void *ctx, bool clear)
+{
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    static uint8_t buf[EXPORT_BUF_SIZE];    // Only the web server exports; keeps it off its stack
+    export_t ex;
+    export_writer_init(&ex.out, buf, sizeof(buf), write, ctx);
+    ex.task_count = 0;
+
+    // Let events being written complete
+    atomic_store(&s_paused, true);
+    vTaskDelay(pdMS_TO_TICKS(2));
+
+    clock_ref_t ref[portNUM_PROCESSORS];
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        esp_ipc_call_blocking(core, sample_clock, &ref[core]);
+    }
+    uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+
+    export_writer_printf(&ex.out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                                  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"bocal-dinamico\"}}");
+    for (int core = 0; core < portNUM_PROCESSORS && ex.out.err == ESP_OK; core++) {
+        write_core(&ex, core, &ref[core], ticks_per_us);
+    }
+    write_task_names(&ex);
+    export_writer_printf(&ex.out, "\n]}\n");
+    esp_err_t err = export_writer_finish(&ex.out);
+
+    if (clear && err == ESP_OK) {
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            memset(s_rings[core].events, 0, sizeof(s_rings[core].events));
+            atomic_store(&s_rings[core].head, 0);
+        }
+    }
+    atomic_store(&s_paused, false);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Export aborted: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void tracepoint_get_stats(tracepoint_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    stats->capacity = TRACE_EVENTS;
+    stats->recorded = 0;
+    stats->overwritten = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        unsigned head = atomic_load_explicit(&s_rings[core].head, memory_order_relaxed);
+        stats->recorded += head;
+        stats->overwritten += head > TRACE_EVENTS ? head - TRACE_EVENTS : 0;
+    }
+}
+
+#else
+
+void tracepoint_record(tracepoint_type_t type, const char *name, int32_t value)
+{
+}
+
+esp_err_t tracepoint_export_json(tracepoint_write_fn write, void *ctx, bool clear)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void tracepoint_get_stats(tracepoint_stats_t *stats)
+{
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+#endif // CONFIG_TRACEPOINT_ENABLE
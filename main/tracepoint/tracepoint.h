@@ -0,0 +1,122 @@
+/**
+ * @file tracepoint.h
+ * @brief Trace points exported as Chrome Trace Event JSON
+ *
+ * TRACE_BEGIN()/TRACE_END() mark the start and end of a span,
+ * TRACE_COUNTER() a value over time and TRACE_INSTANT() a point in time.
+ * Each call records a 16-byte event (cycle count, name, task, value) into
+ * a ring of the calling core: no lock, no formatting, no allocation, about
+ * a hundred cycles. Names must be string literals; only their address is
+ * kept.
+ *
+ * The rings are exported as Chrome Trace Event JSON (GET /api/trace),
+ * which opens in Perfetto (ui.perfetto.dev) or chrome://tracing. Spans
+ * show per task, counters as tracks of the process.
+ *
+ * Timestamps come from the CPU cycle counter of each core and are aligned
+ * to esp_timer when exporting. The counter wraps every 17 s at 240 MHz:
+ * events are placed by their distance to the next event of the same core,
+ * so a gap of more than half a wrap (about 9 s) without any event on a
+ * core shifts the older events. Bus polling keeps the gaps short.
+ */
+
+#ifndef TRACEPOINT_H
+#define TRACEPOINT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Event type (Chrome trace phase)
+ */
+typedef enum {
+    TRACEPOINT_BEGIN = 0,       // "B"
+    TRACEPOINT_END,             // "E"
+    TRACEPOINT_COUNTER,         // "C"
+    TRACEPOINT_INSTANT,         // "i"
+} tracepoint_type_t;
+
+/**
+ * @brief Trace point statistics
+ */
+typedef struct {
+    uint32_t capacity;          // Events per core (0 = trace points disabled)
+    uint32_t recorded;          // Events recorded since the last clear
+    uint32_t overwritten;       // Events lost to wrap-around
+} tracepoint_stats_t;
+
+/**
+ * @brief Write callback of the export
+ *
+ * @param ctx Caller context
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK to continue, anything else aborts the export
+ */
+typedef esp_err_t (*tracepoint_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+#if CONFIG_TRACEPOINT_ENABLE
+
+#define TRACE_BEGIN(name)           tracepoint_record(TRACEPOINT_BEGIN, "" name, 0)
+#define TRACE_END(name)             tracepoint_record(TRACEPOINT_END, "" name, 0)
+#define TRACE_COUNTER(name, value)  tracepoint_record(TRACEPOINT_COUNTER, "" name, (int32_t)(value))
+#define TRACE_INSTANT(name)         tracepoint_record(TRACEPOINT_INSTANT, "" name, 0)
+
+#else
+
+#define TRACE_BEGIN(name)           do { } while (0)
+#define TRACE_END(name)             do { } while (0)
+#define TRACE_COUNTER(name, value)  do { (void)(value); } while (0)
+#define TRACE_INSTANT(name)         do { } while (0)
+
+#endif // CONFIG_TRACEPOINT_ENABLE
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Record an event (use the TRACE_xxx macros)
+ *
+ * Safe from any task; not from interrupts.
+ *
+ * @param type Event type
+ * @param name Event name (string literal)
+ * @param value Counter value (TRACEPOINT_COUNTER only)
+ */
+void tracepoint_record(tracepoint_type_t type, const char *name, int32_t value);
+
+/**
+ * @brief Write the rings as Chrome Trace Event JSON
+ *
+ * Recording is paused while exporting; events of both cores are written
+ * oldest first per core. Task names are resolved for the tasks still
+ * running.
+ *
+ * @param write Write callback
+ * @param ctx Context passed to the callback
+ * @param clear Empty the rings once written
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_SUPPORTED when disabled,
+ *         the callback's error otherwise
+ */
+esp_err_t tracepoint_export_json(tracepoint_write_fn write, void *ctx, bool clear);
+
+/**
+ * @brief Get trace point statistics
+ *
+ * @param stats Pointer to store statistics
+ */
+void tracepoint_get_stats(tracepoint_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACEPOINT_H
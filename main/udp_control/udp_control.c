@@ -0,0 +1,530 @@
+/**
+ * @file udp_control.c
+ * @brief Authenticated UDP setpoint and telemetry channel
+ */
+
+#include "udp_control.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "mbedtls/md.h"
+#include "sdkconfig.h"
+
+#include "metrics.h"
+#include "mightyzap.h"
+#include "bus_manager.h"
+#include "actuator_registry.h"
+#include "actuator_poller.h"
+#include "config_manager.h"
+
+static const char *TAG = "UDP_CTRL";
+
+#define TELEMETRY_PERIOD_US     (CONFIG_UDP_CONTROL_TELEMETRY_MS * 1000LL)
+#define LEASE_US                (CONFIG_UDP_CONTROL_LEASE_MS * 1000LL)
+#define TELEMETRY_PER_DATAGRAM  64      // 804-byte datagrams, below any MTU
+#define DATAGRAM_MAX            (UDP_CONTROL_HEADER_LEN + 255 * UDP_CONTROL_SETPOINT_LEN + \
+                                 UDP_CONTROL_TAG_LEN)
+
+#define RX_TASK_STACK           4096
+#define WORKER_TASK_STACK       3072
+#define RX_TASK_PRIORITY        (tskIDLE_PRIORITY + 5)
+#define WORKER_TASK_PRIORITY    (tskIDLE_PRIORITY + 5)  // Below the poller
+
+/**
+ * @brief Setpoint waiting for the bus worker (one per registry slot)
+ */
+typedef struct {
+    uint8_t bus;
+    uint8_t id;
+    uint8_t flags;              // UDP_CONTROL_SET_*, 0 = nothing pending
+    uint16_t position;
+    uint16_t speed;
+    uint16_t current;
+} pending_t;
+
+static pending_t s_pending[ACTUATOR_REGISTRY_MAX];
+static portMUX_TYPE s_pending_mux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_workers[BUS_MAX];
+
+static int s_sock = -1;
+static char s_key[sizeof(((config_udp_control_t *)0)->key)];
+static size_t s_key_len;
+
+// Controller state, only touched by the receive task
+static uint32_t s_session;              // Active session, 0 = none
+static uint32_t s_session_nonce;        // Nonce of the HELLO that opened it
+static uint32_t s_last_seq;             // Last packet accepted in the session
+static uint32_t s_ack_seq;              // Last setpoint packet accepted in the session
+static uint32_t s_offered;              // Issued by the last HELLO, 0 = none
+static uint32_t s_offered_nonce;
+static struct sockaddr_in s_peer;
+static int64_t s_lease_until_us;
+static uint32_t s_tx_seq;
+
+METRIC_COUNTER_DEFINE(s_m_packets, "udp_control_packets", "Authenticated UDP control packets accepted");
+METRIC_COUNTER_DEFINE(s_m_rejected, "udp_control_rejected", "UDP control packets dropped (malformed or bad HMAC)");
+METRIC_COUNTER_DEFINE(s_m_replayed, "udp_control_replayed", "UDP control packets dropped as stale, duplicate or out of order");
+METRIC_COUNTER_DEFINE(s_m_sessions, "udp_control_sessions", "UDP control sessions opened");
+METRIC_COUNTER_DEFINE(s_m_applied, "udp_control_setpoints_applied", "UDP setpoints sent to actuators");
+METRIC_COUNTER_DEFINE(s_m_superseded, "udp_control_setpoints_superseded", "UDP setpoints replaced by a newer one before being sent");
+METRIC_COUNTER_DEFINE(s_m_failed, "udp_control_setpoints_failed", "UDP setpoints for unknown actuators or that failed on the bus");
+METRIC_COUNTER_DEFINE(s_m_telemetry, "udp_control_telemetry_sent", "UDP telemetry datagrams sent");
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+static inline uint16_t get_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static inline uint32_t get_u32(const uint8_t *p) { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+static inline void put_u16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static inline void put_u32(uint8_t *p, uint32_t v) { put_u16(p, v); put_u16(p + 2, v >> 16); }
+
+static void compute_tag(const uint8_t *data, size_t len, uint8_t tag[UDP_CONTROL_TAG_LEN])
+{
+    uint8_t mac[32];
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                    (const unsigned char *)s_key, s_key_len, data, len, mac);
+    memcpy(tag, mac, UDP_CONTROL_TAG_LEN);
+}
+
+static bool tag_valid(const uint8_t *data, size_t len)
+{
+    uint8_t tag[UDP_CONTROL_TAG_LEN];
+    compute_tag(data, len - UDP_CONTROL_TAG_LEN, tag);
+
+    // Constant time: do not reveal how many bytes matched
+    uint8_t diff = 0;
+    for (int i = 0; i < UDP_CONTROL_TAG_LEN; i++) {
+        diff |= tag[i] ^ data[len - UDP_CONTROL_TAG_LEN + i];
+    }
+    return diff == 0;
+}
+
+// ============================================================================
+// Bus workers
+// ============================================================================
+
+static esp_err_t apply(mightyzap_handle_t handle, const pending_t *sp)
+{
+    esp_err_t err = ESP_OK;
+
+    if (sp->flags & UDP_CONTROL_SET_FORCE_OFF) {
+        err = mightyzap_set_force_enable(handle, false);
+    } else if (sp->flags & UDP_CONTROL_SET_FORCE_ON) {
+        err = mightyzap_set_force_enable(handle, true);
+    }
+
+    const uint8_t goal = UDP_CONTROL_SET_POSITION | UDP_CONTROL_SET_SPEED | UDP_CONTROL_SET_CURRENT;
+    if ((sp->flags & goal) == goal) {
+        // One transaction for the common case
+        return err == ESP_OK ? mightyzap_set_goal(handle, sp->position, sp->speed, sp->current) : err;
+    }
+    if (err == ESP_OK && (sp->flags & UDP_CONTROL_SET_SPEED)) {
+        err = mightyzap_set_speed(handle, sp->speed);
+    }
+    if (err == ESP_OK && (sp->flags & UDP_CONTROL_SET_CURRENT)) {
+        err = mightyzap_set_current(handle, sp->current);
+    }
+    if (err == ESP_OK && (sp->flags & UDP_CONTROL_SET_POSITION)) {
+        err = mightyzap_set_position(handle, sp->position);
+    }
+    return err;
+}
+
+static void worker_task(void *arg)
+{
+    uint8_t bus = (uint8_t)(uintptr_t)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (int slot = 0; slot < ACTUATOR_REGISTRY_MAX; slot++) {
+            pending_t sp;
+            portENTER_CRITICAL(&s_pending_mux);
+            sp = s_pending[slot];
+            bool mine = sp.flags != 0 && sp.bus == bus;
+            if (mine) {
+                s_pending[slot].flags = 0;
+            }
+            portEXIT_CRITICAL(&s_pending_mux);
+            if (!mine) {
+                continue;
+            }
+
+            // The bus lock keeps the handle valid for the whole command sequence
+            bus_manager_lock(bus);
+            mightyzap_handle_t handle = actuator_registry_get(bus, sp.id);
+            esp_err_t err = handle != NULL ? apply(handle, &sp) : ESP_ERR_NOT_FOUND;
+            bus_manager_unlock(bus);
+
+            if (err != ESP_OK) {
+                DLOGW(TAG, "Setpoint for %d:%d failed: %s", bus, sp.id, esp_err_to_name(err));
+                metrics_counter_add(&s_m_failed, 1);
+                continue;
+            }
+            metrics_counter_add(&s_m_applied, 1);
+            if (sp.flags & UDP_CONTROL_SET_POSITION) {
+                // Follow the motion at the fast poll rate
+                actuator_poller_kick(bus, sp.id);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Queue the setpoints of a packet, replacing older pending ones
+ *
+ * @return uint32_t Bit n set: bus n has new setpoints
+ */
+static uint32_t queue_setpoints(const uint8_t *entries, uint8_t count)
+{
+    uint32_t buses = 0;
+
+    actuator_registry_lock();
+    for (int i = 0; i < count; i++) {
+        const uint8_t *e = entries + i * UDP_CONTROL_SETPOINT_LEN;
+        uint8_t bus = e[0];
+        uint8_t id = e[1];
+        uint8_t flags = e[2] & (UDP_CONTROL_SET_POSITION | UDP_CONTROL_SET_SPEED |
+                                UDP_CONTROL_SET_CURRENT | UDP_CONTROL_SET_FORCE_ON |
+                                UDP_CONTROL_SET_FORCE_OFF);
+        int slot = bus < BUS_MAX ? actuator_registry_find(bus, id) : -1;
+        if (slot < 0 || s_workers[bus] == NULL) {
+            metrics_counter_add(&s_m_failed, 1);
+            continue;
+        }
+        if (flags == 0) {
+            continue;
+        }
+
+        portENTER_CRITICAL(&s_pending_mux);
+        pending_t *sp = &s_pending[slot];
+        if (sp->flags != 0 && (sp->bus != bus || sp->id != id)) {
+            sp->flags = 0;      // Left behind by an actuator that moved slots
+        }
+        bool superseded = (sp->flags & flags) != 0;
+        if (flags & (UDP_CONTROL_SET_FORCE_ON | UDP_CONTROL_SET_FORCE_OFF)) {
+            sp->flags &= ~(UDP_CONTROL_SET_FORCE_ON | UDP_CONTROL_SET_FORCE_OFF);
+        }
+        sp->bus = bus;
+        sp->id = id;
+        sp->flags |= flags;
+        if (flags & UDP_CONTROL_SET_POSITION) sp->position = get_u16(e + 4);
+        if (flags & UDP_CONTROL_SET_SPEED) sp->speed = get_u16(e + 6);
+        if (flags & UDP_CONTROL_SET_CURRENT) sp->current = get_u16(e + 8);
+        portEXIT_CRITICAL(&s_pending_mux);
+
+        if (superseded) {
+            metrics_counter_add(&s_m_superseded, 1);
+        }
+        buses |= 1u << bus;
+    }
+    actuator_registry_unlock();
+
+    return buses;
+}
+
+// ============================================================================
+// Datagrams
+// ============================================================================
+
+static void put_header(uint8_t *buf, uint8_t type, uint32_t session, uint32_t seq, uint32_t ack,
+                       uint8_t count)
+{
+    put_u16(buf, UDP_CONTROL_MAGIC);
+    buf[2] = UDP_CONTROL_VERSION;
+    buf[3] = type;
+    put_u32(buf + 4, session);
+    put_u32(buf + 8, seq);
+    put_u32(buf + 12, ack);
+    buf[16] = count;
+    buf[17] = buf[18] = buf[19] = 0;
+}
+
+/**
+ * @brief Answer a HELLO with a new session
+ *
+ * The session only replaces the active one once a packet of it arrives, so
+ * a replayed HELLO cannot end the session of the controller.
+ */
+static void offer_session(uint32_t nonce, const struct sockaddr_in *from)
+{
+    if ((s_offered != 0 && nonce == s_offered_nonce) || (s_session != 0 && nonce == s_session_nonce)) {
+        metrics_counter_add(&s_m_replayed, 1);
+        return;
+    }
+
+    do {
+        s_offered = esp_random();
+    } while (s_offered == 0 || s_offered == s_session);
+    s_offered_nonce = nonce;
+
+    uint8_t buf[UDP_CONTROL_HEADER_LEN + UDP_CONTROL_TAG_LEN];
+    put_header(buf, UDP_CONTROL_TYPE_WELCOME, s_offered, 0, nonce, 0);
+    compute_tag(buf, UDP_CONTROL_HEADER_LEN, buf + UDP_CONTROL_HEADER_LEN);
+    sendto(s_sock, buf, sizeof(buf), 0, (const struct sockaddr *)from, sizeof(*from));
+}
+
+/**
+ * @brief Check that a packet belongs to the session and is newer than the last one
+ *
+ * The first packet of an offered session makes it the active one.
+ */
+static bool packet_fresh(uint32_t session, uint32_t seq)
+{
+    if (session != 0 && session == s_session) {
+        return seq > s_last_seq;
+    }
+    if (session == 0 || session != s_offered || seq == 0) {
+        return false;
+    }
+
+    s_session = s_offered;
+    s_session_nonce = s_offered_nonce;
+    s_offered = 0;
+    s_last_seq = 0;
+    s_ack_seq = 0;
+    metrics_counter_add(&s_m_sessions, 1);
+    return true;
+}
+
+static void handle_datagram(const uint8_t *data, size_t len, const struct sockaddr_in *from)
+{
+    if (len < UDP_CONTROL_HEADER_LEN + UDP_CONTROL_TAG_LEN ||
+        get_u16(data) != UDP_CONTROL_MAGIC || data[2] != UDP_CONTROL_VERSION) {
+        metrics_counter_add(&s_m_rejected, 1);
+        return;
+    }
+
+    uint8_t type = data[3];
+    uint8_t count = data[16];
+    size_t entry_len = type == UDP_CONTROL_TYPE_SETPOINT ? UDP_CONTROL_SETPOINT_LEN : 0;
+    if ((type != UDP_CONTROL_TYPE_SETPOINT && type != UDP_CONTROL_TYPE_SUBSCRIBE &&
+         type != UDP_CONTROL_TYPE_HELLO) ||
+        len != UDP_CONTROL_HEADER_LEN + count * entry_len + UDP_CONTROL_TAG_LEN ||
+        !tag_valid(data, len)) {
+        metrics_counter_add(&s_m_rejected, 1);
+        return;
+    }
+
+    uint32_t session = get_u32(data + 4);
+    uint32_t seq = get_u32(data + 8);
+    if (type == UDP_CONTROL_TYPE_HELLO) {
+        offer_session(seq, from);
+        return;
+    }
+
+    uint32_t previous = s_session;
+    if (!packet_fresh(session, seq)) {
+        metrics_counter_add(&s_m_replayed, 1);
+        return;
+    }
+    s_last_seq = seq;
+    if (s_session != previous) {
+        ESP_LOGI(TAG, "Controller session %08lx from %s", (unsigned long)s_session,
+                 inet_ntoa(from->sin_addr));
+    }
+
+    // Fresh and authenticated: the sender gets the telemetry
+    s_peer = *from;
+    s_lease_until_us = esp_timer_get_time() + LEASE_US;
+
+    if (type == UDP_CONTROL_TYPE_SETPOINT) {
+        s_ack_seq = seq;
+        uint32_t buses = queue_setpoints(data + UDP_CONTROL_HEADER_LEN, count);
+        for (uint8_t bus = 0; bus < BUS_MAX; bus++) {
+            if (buses & (1u << bus)) {
+                xTaskNotifyGive(s_workers[bus]);
+            }
+        }
+    }
+    metrics_counter_add(&s_m_packets, 1);
+}
+
+static void send_telemetry(void)
+{
+    static uint8_t buf[UDP_CONTROL_HEADER_LEN + TELEMETRY_PER_DATAGRAM * UDP_CONTROL_TELEMETRY_LEN +
+                       UDP_CONTROL_TAG_LEN];
+    int64_t now = esp_timer_get_time();
+    uint8_t slot = 0;
+    uint8_t total;
+
+    do {
+        // Slots are stable while the registry is locked; not held while sending
+        actuator_registry_lock();
+        total = actuator_registry_count();
+        uint8_t count = 0;
+        uint8_t *e = buf + UDP_CONTROL_HEADER_LEN;
+        for (; slot < total && count < TELEMETRY_PER_DATAGRAM; slot++) {
+            actuator_state_t st;
+            if (actuator_registry_get_state(slot, &st) != ESP_OK) {
+                continue;
+            }
+            int64_t age_ms = st.updated_us ? (now - st.updated_us) / 1000 : 0xFFFF;
+            e[0] = st.bus;
+            e[1] = st.id;
+            e[2] = (st.connected ? UDP_CONTROL_TLM_CONNECTED : 0) |
+                   (st.moving ? UDP_CONTROL_TLM_MOVING : 0);
+            e[3] = st.health;
+            put_u16(e + 4, st.position);
+            put_u16(e + 6, st.current);
+            put_u16(e + 8, st.voltage);
+            put_u16(e + 10, age_ms < 0xFFFF ? age_ms : 0xFFFF);
+            e += UDP_CONTROL_TELEMETRY_LEN;
+            count++;
+        }
+        actuator_registry_unlock();
+
+        put_header(buf, UDP_CONTROL_TYPE_TELEMETRY, s_session, ++s_tx_seq, s_ack_seq, count);
+        compute_tag(buf, e - buf, e);
+        e += UDP_CONTROL_TAG_LEN;
+
+        if (sendto(s_sock, buf, e - buf, 0, (struct sockaddr *)&s_peer, sizeof(s_peer)) > 0) {
+            metrics_counter_add(&s_m_telemetry, 1);
+        }
+    } while (slot < total);
+}
+
+static void rx_task(void *arg)
+{
+    static uint8_t buf[DATAGRAM_MAX];
+    int64_t next_tx_us = esp_timer_get_time();
+
+    while (1) {
+        // Wake up for datagrams or when the next telemetry is due
+        int64_t now = esp_timer_get_time();
+        bool streaming = now < s_lease_until_us;
+        if (streaming && now >= next_tx_us) {
+            send_telemetry();
+            next_tx_us += TELEMETRY_PERIOD_US;
+            if (next_tx_us < now) {
+                next_tx_us = now + TELEMETRY_PERIOD_US;     // Do not burst after a stall
+            }
+            continue;
+        }
+
+        int64_t wait_us = streaming ? next_tx_us - now : LEASE_US;
+        struct timeval tv = {
+            .tv_sec = wait_us / 1000000,
+            .tv_usec = wait_us % 1000000,
+        };
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(s_sock, &fds);
+        if (select(s_sock + 1, &fds, NULL, NULL, &tv) <= 0) {
+            continue;
+        }
+
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(s_sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if (len > 0) {
+            if (!streaming) {
+                next_tx_us = esp_timer_get_time();
+            }
+            handle_datagram(buf, len, &from);
+        }
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t udp_control_start(void)
+{
+    if (s_sock >= 0) {
+        return ESP_OK;
+    }
+
+    config_udp_control_t cfg;
+    config_get_udp_control(&cfg);
+    if (!cfg.enabled) {
+        ESP_LOGI(TAG, "UDP control disabled");
+        return ESP_OK;
+    }
+    s_key_len = strlen(cfg.key);
+    if (s_key_len < UDP_CONTROL_KEY_MIN) {
+        ESP_LOGE(TAG, "Key must have at least %d characters", UDP_CONTROL_KEY_MIN);
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(s_key, cfg.key, sizeof(s_key));
+
+    esp_err_t ret = ESP_FAIL;
+    int sock = -1;
+    int workers = 0;
+    for (uint8_t bus = 0; bus < bus_manager_count(); bus++) {
+        if (!bus_manager_is_up(bus)) {
+            continue;
+        }
+        char name[16];
+        snprintf(name, sizeof(name), "udpctl_bus%d", bus);
+        if (xTaskCreatePinnedToCore(worker_task, name, WORKER_TASK_STACK, (void *)(uintptr_t)bus,
+                                    WORKER_TASK_PRIORITY, &s_workers[bus],
+                                    bus_manager_get_core(bus)) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker for bus %d", bus);
+            s_workers[bus] = NULL;
+            goto fail;
+        }
+        workers++;
+    }
+    if (workers == 0) {
+        ESP_LOGW(TAG, "No bus up, UDP control not started");
+        ret = ESP_ERR_INVALID_STATE;
+        goto fail;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket");
+        goto fail;
+    }
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(cfg.port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "Failed to bind UDP port %u", cfg.port);
+        goto fail;
+    }
+    s_sock = sock;
+
+    if (xTaskCreate(rx_task, "udpctl_rx", RX_TASK_STACK, NULL, RX_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create receive task");
+        goto fail;
+    }
+
+    metrics_register(&s_m_packets);
+    metrics_register(&s_m_rejected);
+    metrics_register(&s_m_replayed);
+    metrics_register(&s_m_sessions);
+    metrics_register(&s_m_applied);
+    metrics_register(&s_m_superseded);
+    metrics_register(&s_m_failed);
+    metrics_register(&s_m_telemetry);
+
+    ESP_LOGI(TAG, "Listening on UDP port %u", cfg.port);
+    return ESP_OK;
+
+fail:
+    // Workers only block on their notification, so they can be deleted as is
+    for (uint8_t bus = 0; bus < BUS_MAX; bus++) {
+        if (s_workers[bus] != NULL) {
+            vTaskDelete(s_workers[bus]);
+            s_workers[bus] = NULL;
+        }
+    }
+    if (sock >= 0) {
+        close(sock);
+    }
+    s_sock = -1;
+    return ret;
+}
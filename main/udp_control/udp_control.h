@@ -0,0 +1,121 @@
+/**
+ * @file udp_control.h
+ * @brief Authenticated UDP setpoint and telemetry channel
+ *
+ * A supervisory controller sends setpoints for any number of actuators in
+ * one datagram and receives the telemetry cache back at a fixed rate,
+ * without the TCP handshake, HTTP parsing and JSON of /api/actuator/control.
+ *
+ * Setpoints are latest-wins: each actuator keeps one pending setpoint, and
+ * a newer one replaces it if the bus worker has not sent it yet. One worker
+ * per bus applies them through the mightyzap layer.
+ *
+ * Datagram (all fields little-endian):
+ *
+ *   0   u16  magic      UDP_CONTROL_MAGIC
+ *   2   u8   version    UDP_CONTROL_VERSION
+ *   3   u8   type       UDP_CONTROL_TYPE_*
+ *   4   u32  session    Issued by the device (0 in HELLO)
+ *   8   u32  seq        HELLO: nonce chosen by the controller
+ *                       Setpoint, subscribe: increasing within the session
+ *                       Telemetry: datagram counter of the device
+ *   12  u32  ack        WELCOME: nonce of the HELLO it answers
+ *                       Telemetry: seq of the last accepted setpoint packet
+ *   16  u8   count      Entries following the header
+ *   17  u8[3] reserved
+ *   20  entries         count x 10 bytes (setpoint) or 12 bytes (telemetry)
+ *   ..  u8[16] tag      HMAC-SHA256 of everything before, truncated
+ *
+ * Setpoint entry: u8 bus, u8 id, u8 flags (UDP_CONTROL_SET_*), u8 reserved,
+ * u16 position, u16 speed, u16 current. Fields without their flag are ignored.
+ *
+ * Telemetry entry: u8 bus, u8 id, u8 flags (UDP_CONTROL_TLM_*), u8 health
+ * (actuator_health_t), u16 position, u16 current (mA), u16 voltage (0.1 V),
+ * u16 age (ms since the poller read it, 0xFFFF = older or never).
+ *
+ * Sessions: the controller sends a HELLO with a random nonce; the device
+ * answers with a WELCOME carrying a random session and the nonce, so the
+ * controller knows the answer is fresh. Every setpoint and subscribe packet
+ * carries the session, which the tag covers, and a seq starting at 1. The
+ * device accepts a packet only if its session is the active one and its seq
+ * is above the last accepted one, or if it is the first packet of the
+ * session offered by the last WELCOME, which then replaces the active one.
+ * Anything else is dropped as a replay before it has any effect, so a
+ * packet recorded in an earlier session, or earlier in this one, is never
+ * accepted. A replayed HELLO only produces an offer that nobody can use; a
+ * HELLO repeating the nonce of the offered or active session is ignored.
+ * The controller starts over with a HELLO when the seq would wrap, and when
+ * its packets go unanswered (the device restarted or another controller
+ * took over).
+ *
+ * An accepted packet makes its sender the telemetry destination for
+ * CONFIG_UDP_CONTROL_LEASE_MS; a controller without setpoints to send keeps
+ * the stream with UDP_CONTROL_TYPE_SUBSCRIBE packets (count 0).
+ *
+ * Configured by the "udp_control" section of config.json (enabled, port, key).
+ */
+
+#ifndef UDP_CONTROL_H
+#define UDP_CONTROL_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UDP_CONTROL_MAGIC           0x4442      // "BD"
+#define UDP_CONTROL_VERSION         2
+#define UDP_CONTROL_HEADER_LEN      20
+#define UDP_CONTROL_TAG_LEN         16
+#define UDP_CONTROL_SETPOINT_LEN    10
+#define UDP_CONTROL_TELEMETRY_LEN   12
+#define UDP_CONTROL_KEY_MIN         16
+
+/**
+ * @brief Datagram types
+ */
+typedef enum {
+    UDP_CONTROL_TYPE_SETPOINT = 1,      // Controller -> device
+    UDP_CONTROL_TYPE_TELEMETRY = 2,     // Device -> controller
+    UDP_CONTROL_TYPE_SUBSCRIBE = 3,     // Controller -> device, renews the lease
+    UDP_CONTROL_TYPE_HELLO = 4,         // Controller -> device, asks for a session
+    UDP_CONTROL_TYPE_WELCOME = 5,       // Device -> controller, issues the session
+} udp_control_type_t;
+
+/**
+ * @brief Setpoint entry flags
+ */
+#define UDP_CONTROL_SET_POSITION    0x01
+#define UDP_CONTROL_SET_SPEED       0x02
+#define UDP_CONTROL_SET_CURRENT     0x04
+#define UDP_CONTROL_SET_FORCE_ON    0x08
+#define UDP_CONTROL_SET_FORCE_OFF   0x10
+
+/**
+ * @brief Telemetry entry flags
+ */
+#define UDP_CONTROL_TLM_CONNECTED   0x01
+#define UDP_CONTROL_TLM_MOVING      0x02
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Start the UDP control channel if it is enabled
+ *
+ * Call once the buses and the network stack are up.
+ *
+ * @return esp_err_t ESP_OK on success (or disabled), ESP_ERR_INVALID_ARG if
+ *         the key is shorter than UDP_CONTROL_KEY_MIN, ESP_ERR_INVALID_STATE
+ *         if no bus is up
+ */
+esp_err_t udp_control_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UDP_CONTROL_H
@@ -0,0 +1,377 @@
+/**
+ * @file web_gzip.c
+ * @brief Streaming gzip encoder with a small window
+ *
+ * LZ77 over a buffer of two windows: matches are searched in the window
+ * behind the current position through hash chains, and the buffer slides
+ * by one window when it is full. Everything is coded in one fixed Huffman
+ * block (RFC 1951 3.2.6), closed by an empty final block.
+ */
+
+#include "web_gzip.h"
+#include <string.h>
+#include <stdbool.h>
+#include "esp_rom_crc.h"
+
+#include "memprof.h"
+
+#define GZ_MIN_MATCH        3
+#define GZ_MAX_MATCH        258
+#define GZ_MAX_CHAIN        8           // Candidates tried per position
+#define GZ_NIL              0xFFFF
+#define GZ_OUT_SIZE         512
+
+struct web_gzip {
+    web_gzip_write_fn write;
+    void *ctx;
+    esp_err_t err;                      // First callback error
+    uint32_t wsize;                     // Window (power of two)
+    uint32_t hash_shift;
+    uint32_t pos;                       // Next byte to code, in buf
+    uint32_t end;                       // Bytes in buf
+    uint32_t crc;
+    size_t total_in;
+    size_t total_out;
+    uint32_t bits;                      // Output bits not yet in out, LSB first
+    uint8_t nbits;
+    size_t out_len;
+    uint8_t out[GZ_OUT_SIZE];
+    uint16_t *head;                     // Last position of each hash, GZ_NIL if none
+    uint16_t *prev;                     // Previous position with the same hash, by position % wsize
+    uint8_t *buf;                       // Two windows
+};
+
+// Length codes 257-285 and distance codes 0-29 (RFC 1951 3.2.5)
+static const uint16_t s_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t s_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t s_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t s_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+// Fixed Huffman codes, bit-reversed for LSB-first output
+static uint16_t s_sym_code[288];
+static uint8_t s_sym_len[288];
+static uint8_t s_dist_code[30];
+static bool s_codes_ready = false;
+
+// ============================================================================
+// Output
+// ============================================================================
+
+static uint32_t reverse_bits(uint32_t code, uint8_t len)
+{
+    uint32_t r = 0;
+    while (len--) {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+static void init_codes(void)
+{
+    for (int sym = 0; sym < 288; sym++) {
+        uint32_t code;
+        uint8_t len;
+        if (sym < 144) {
+            code = 0x30 + sym;
+            len = 8;
+        } else if (sym < 256) {
+            code = 0x190 + sym - 144;
+            len = 9;
+        } else if (sym < 280) {
+            code = sym - 256;
+            len = 7;
+        } else {
+            code = 0xC0 + sym - 280;
+            len = 8;
+        }
+        s_sym_code[sym] = (uint16_t)reverse_bits(code, len);
+        s_sym_len[sym] = len;
+    }
+    for (int d = 0; d < 30; d++) {
+        s_dist_code[d] = (uint8_t)reverse_bits(d, 5);
+    }
+    s_codes_ready = true;
+}
+
+static void flush_out(struct web_gzip *gz)
+{
+    if (gz->out_len > 0 && gz->err == ESP_OK) {
+        gz->err = gz->write(gz->ctx, gz->out, gz->out_len);
+    }
+    gz->total_out += gz->out_len;
+    gz->out_len = 0;
+}
+
+static inline void put_byte(struct web_gzip *gz, uint8_t b)
+{
+    gz->out[gz->out_len++] = b;
+    if (gz->out_len == GZ_OUT_SIZE) {
+        flush_out(gz);
+    }
+}
+
+static inline void put_bits(struct web_gzip *gz, uint32_t value, uint8_t n)
+{
+    gz->bits |= value << gz->nbits;
+    gz->nbits += n;
+    while (gz->nbits >= 8) {
+        put_byte(gz, gz->bits & 0xFF);
+        gz->bits >>= 8;
+        gz->nbits -= 8;
+    }
+}
+
+static inline void put_symbol(struct web_gzip *gz, uint32_t sym)
+{
+    put_bits(gz, s_sym_code[sym], s_sym_len[sym]);
+}
+
+static void put_match(struct web_gzip *gz, uint32_t len, uint32_t dist)
+{
+    int i = 28;
+    while (s_len_base[i] > len) {
+        i--;
+    }
+    put_symbol(gz, 257 + i);
+    if (s_len_extra[i] > 0) {
+        put_bits(gz, len - s_len_base[i], s_len_extra[i]);
+    }
+
+    int d = 29;
+    while (s_dist_base[d] > dist) {
+        d--;
+    }
+    put_bits(gz, s_dist_code[d], 5);
+    if (s_dist_extra[d] > 0) {
+        put_bits(gz, dist - s_dist_base[d], s_dist_extra[d]);
+    }
+}
+
+static void put_le32(struct web_gzip *gz, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        put_byte(gz, (v >> (8 * i)) & 0xFF);
+    }
+}
+
+// ============================================================================
+// Matching
+// ============================================================================
+
+static inline uint32_t hash3(const struct web_gzip *gz, const uint8_t *p)
+{
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> gz->hash_shift;
+}
+
+static inline void insert(struct web_gzip *gz, uint32_t p)
+{
+    uint32_t h = hash3(gz, gz->buf + p);
+    gz->prev[p & (gz->wsize - 1)] = gz->head[h];
+    gz->head[h] = (uint16_t)p;
+}
+
+/**
+ * @brief Drop the oldest window: the buffer and every position move down by wsize
+ */
+static void slide(struct web_gzip *gz)
+{
+    uint32_t w = gz->wsize;
+    memmove(gz->buf, gz->buf + w, gz->end - w);
+    gz->pos -= w;
+    gz->end -= w;
+
+    for (uint32_t i = 0; i < (w >> 1); i++) {
+        uint16_t v = gz->head[i];
+        gz->head[i] = (v == GZ_NIL || v < w) ? GZ_NIL : v - w;
+    }
+    for (uint32_t i = 0; i < w; i++) {
+        uint16_t v = gz->prev[i];
+        gz->prev[i] = (v == GZ_NIL || v < w) ? GZ_NIL : v - w;
+    }
+}
+
+/**
+ * @brief Code the buffered bytes that have a full lookahead, or all of them
+ */
+static void deflate_buffered(struct web_gzip *gz, bool finish)
+{
+    uint32_t limit = finish ? gz->end : (gz->end > GZ_MAX_MATCH ? gz->end - GZ_MAX_MATCH : 0);
+
+    while (gz->pos < limit) {
+        uint32_t avail = gz->end - gz->pos;
+        uint32_t best_len = 0;
+        uint32_t best_dist = 0;
+
+        if (avail >= GZ_MIN_MATCH) {
+            const uint8_t *cur = gz->buf + gz->pos;
+            uint32_t max_len = avail < GZ_MAX_MATCH ? avail : GZ_MAX_MATCH;
+            uint32_t cand = gz->head[hash3(gz, cur)];
+
+            // Candidates get older along the chain; one a window away or
+            // more may have had its chain link reused
+            for (int chain = 0; cand != GZ_NIL && chain < GZ_MAX_CHAIN; chain++) {
+                uint32_t dist = gz->pos - cand;
+                if (dist >= gz->wsize) {
+                    break;
+                }
+                const uint8_t *m = gz->buf + cand;
+                if (m[best_len] == cur[best_len] && m[0] == cur[0]) {
+                    uint32_t len = 0;
+                    while (len < max_len && m[len] == cur[len]) {
+                        len++;
+                    }
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = dist;
+                        if (len == max_len) {
+                            break;
+                        }
+                    }
+                }
+                cand = gz->prev[cand & (gz->wsize - 1)];
+            }
+        }
+
+        if (best_len >= GZ_MIN_MATCH) {
+            put_match(gz, best_len, best_dist);
+            for (uint32_t i = 0; i < best_len; i++, gz->pos++) {
+                if (gz->pos + GZ_MIN_MATCH <= gz->end) {
+                    insert(gz, gz->pos);
+                }
+            }
+        } else {
+            put_symbol(gz, gz->buf[gz->pos]);
+            if (avail >= GZ_MIN_MATCH) {
+                insert(gz, gz->pos);
+            }
+            gz->pos++;
+        }
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t web_gzip_create(uint8_t window_bits, web_gzip_handle_t *out_handle)
+{
+    if (window_bits < WEB_GZIP_MIN_WINDOW_BITS || window_bits > WEB_GZIP_MAX_WINDOW_BITS ||
+        out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Hash heads: half a window; chain links: one window; bytes: two windows
+    uint32_t w = 1u << window_bits;
+    size_t size = sizeof(struct web_gzip) + (w >> 1) * sizeof(uint16_t) + w * sizeof(uint16_t) + 2 * w;
+    struct web_gzip *gz = memprof_malloc(MEMPROF_TAG_HTTP, size);
+    if (gz == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(gz, 0, sizeof(*gz));
+    gz->wsize = w;
+    gz->hash_shift = 32 - (window_bits - 1);
+    gz->head = (uint16_t *)(gz + 1);
+    gz->prev = gz->head + (w >> 1);
+    gz->buf = (uint8_t *)(gz->prev + w);
+
+    if (!s_codes_ready) {
+        init_codes();
+    }
+
+    *out_handle = gz;
+    return ESP_OK;
+}
+
+void web_gzip_delete(web_gzip_handle_t gz)
+{
+    memprof_free(MEMPROF_TAG_HTTP, gz);
+}
+
+esp_err_t web_gzip_begin(web_gzip_handle_t gz, web_gzip_write_fn write, void *ctx)
+{
+    if (gz == NULL || write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    gz->write = write;
+    gz->ctx = ctx;
+    gz->err = ESP_OK;
+    gz->pos = 0;
+    gz->end = 0;
+    gz->crc = 0;
+    gz->total_in = 0;
+    gz->total_out = 0;
+    gz->bits = 0;
+    gz->nbits = 0;
+    gz->out_len = 0;
+    memset(gz->head, 0xFF, (gz->wsize >> 1) * sizeof(uint16_t));
+    memset(gz->prev, 0xFF, gz->wsize * sizeof(uint16_t));
+
+    // Member header: deflate, no name, no mtime, unknown OS
+    static const uint8_t header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+    for (size_t i = 0; i < sizeof(header); i++) {
+        put_byte(gz, header[i]);
+    }
+    put_bits(gz, 1 << 1, 3);            // Block: not final, fixed Huffman
+    return gz->err;
+}
+
+esp_err_t web_gzip_write(web_gzip_handle_t gz, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    gz->crc = esp_rom_crc32_le(gz->crc, p, len);
+    gz->total_in += len;
+
+    while (len > 0 && gz->err == ESP_OK) {
+        if (gz->end == 2 * gz->wsize) {
+            slide(gz);
+        }
+        size_t n = 2 * gz->wsize - gz->end;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(gz->buf + gz->end, p, n);
+        gz->end += n;
+        p += n;
+        len -= n;
+        deflate_buffered(gz, false);
+    }
+    return gz->err;
+}
+
+esp_err_t web_gzip_finish(web_gzip_handle_t gz, size_t *in_len, size_t *out_len)
+{
+    deflate_buffered(gz, true);
+    put_symbol(gz, 256);                // End of the block
+    put_bits(gz, 1 | (1 << 1), 3);      // Final block, fixed Huffman, empty
+    put_symbol(gz, 256);
+    if (gz->nbits > 0) {
+        put_bits(gz, 0, 8 - gz->nbits);
+    }
+    put_le32(gz, gz->crc);
+    put_le32(gz, (uint32_t)gz->total_in);
+    flush_out(gz);
+
+    if (in_len != NULL) {
+        *in_len = gz->total_in;
+    }
+    if (out_len != NULL) {
+        *out_len = gz->total_out;
+    }
+    return gz->err;
+}
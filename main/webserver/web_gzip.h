@@ -0,0 +1,96 @@
+/**
+ * @file web_gzip.h
+ * @brief Streaming gzip encoder with a small window
+ *
+ * Compresses a response while it is produced, into a gzip stream that
+ * browsers, curl --compressed and Prometheus inflate. Deflate's usual
+ * 32 KB window and dynamic Huffman trees need over 100 KB of state; this
+ * encoder looks back 2^window_bits bytes and emits fixed Huffman codes, for
+ * about 5 windows of state (20 KB at 4 KB). JSON and text are repetitive
+ * enough that most of the gain comes from the matches, not the codes.
+ *
+ * An encoder is reused from one stream to the next: begin, write any
+ * number of times, finish.
+ */
+
+#ifndef WEB_GZIP_H
+#define WEB_GZIP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WEB_GZIP_MIN_WINDOW_BITS    9
+#define WEB_GZIP_MAX_WINDOW_BITS    14
+
+typedef struct web_gzip *web_gzip_handle_t;
+
+/**
+ * @brief Output callback
+ *
+ * @param ctx Caller context
+ * @param data Compressed bytes
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK to continue, anything else fails the stream
+ */
+typedef esp_err_t (*web_gzip_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Allocate an encoder
+ *
+ * @param window_bits log2 of the window (WEB_GZIP_MIN_WINDOW_BITS-WEB_GZIP_MAX_WINDOW_BITS)
+ * @param out_handle Pointer to store the encoder handle
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t web_gzip_create(uint8_t window_bits, web_gzip_handle_t *out_handle);
+
+/**
+ * @brief Free an encoder
+ */
+void web_gzip_delete(web_gzip_handle_t gz);
+
+/**
+ * @brief Start a stream; the gzip header goes to the callback
+ *
+ * @param gz Encoder
+ * @param write Output callback, called with up to 512 bytes at a time
+ * @param ctx Callback context
+ * @return esp_err_t Result of the callback
+ */
+esp_err_t web_gzip_begin(web_gzip_handle_t gz, web_gzip_write_fn write, void *ctx);
+
+/**
+ * @brief Compress bytes
+ *
+ * The last few hundred bytes are held until more data or finish.
+ *
+ * @param gz Encoder
+ * @param data Bytes
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK, or the first error of the callback
+ */
+esp_err_t web_gzip_write(web_gzip_handle_t gz, const void *data, size_t len);
+
+/**
+ * @brief Compress the rest and end the stream
+ *
+ * @param gz Encoder
+ * @param in_len Pointer to store the bytes written to the stream (can be NULL)
+ * @param out_len Pointer to store the compressed size, header included (can be NULL)
+ * @return esp_err_t ESP_OK, or the first error of the callback
+ */
+esp_err_t web_gzip_finish(web_gzip_handle_t gz, size_t *in_len, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEB_GZIP_H
@@ -0,0 +1,108 @@
+/**
+ * @file web_router.c
+ * @brief Route table for the web server
+ */
+
+#include "web_router.h"
+#include <string.h>
+#include "esp_log.h"
+
+#include "memprof.h"
+
+static const char *TAG = "WEB_ROUTER";
+
+#define ROUTER_MAX_ROUTES       255     // Slots hold an 8-bit route index + 1
+
+struct web_router {
+    const web_route_t *routes;
+    size_t mask;                // Slots - 1 (power of two, at least twice the routes)
+    uint8_t slots[];            // Route index + 1, 0 = empty
+};
+
+// ============================================================================
+// Hashing
+// ============================================================================
+
+/**
+ * @brief FNV-1a of the method and the path up to '?', and the path length
+ */
+static uint32_t route_hash(int method, const char *path, size_t *len)
+{
+    uint32_t hash = 2166136261u ^ (uint32_t)method;
+    hash *= 16777619u;
+    size_t i = 0;
+    for (; path[i] != '\0' && path[i] != '?'; i++) {
+        hash = (hash ^ (uint8_t)path[i]) * 16777619u;
+    }
+    *len = i;
+    return hash;
+}
+
+static bool route_matches(const web_route_t *route, int method, const char *path, size_t len)
+{
+    return (int)route->method == method && strncmp(route->path, path, len) == 0 &&
+           route->path[len] == '\0';
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+esp_err_t web_router_create(const web_route_t *routes, size_t count, web_router_handle_t *out_handle)
+{
+    if (routes == NULL || count == 0 || count > ROUTER_MAX_ROUTES || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t slots = 4;
+    while (slots < count * 2) {
+        slots <<= 1;
+    }
+
+    struct web_router *router = memprof_calloc(MEMPROF_TAG_HTTP, 1, sizeof(struct web_router) + slots);
+    if (router == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    router->routes = routes;
+    router->mask = slots - 1;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t len;
+        size_t slot = route_hash(routes[i].method, routes[i].path, &len) & router->mask;
+        while (router->slots[slot] != 0) {
+            if (route_matches(&routes[router->slots[slot] - 1], routes[i].method, routes[i].path, len)) {
+                ESP_LOGE(TAG, "Duplicate route: %s", routes[i].path);
+                memprof_free(MEMPROF_TAG_HTTP, router);
+                return ESP_ERR_INVALID_ARG;
+            }
+            slot = (slot + 1) & router->mask;
+        }
+        router->slots[slot] = (uint8_t)(i + 1);
+    }
+
+    *out_handle = router;
+    return ESP_OK;
+}
+
+void web_router_delete(web_router_handle_t router)
+{
+    memprof_free(MEMPROF_TAG_HTTP, router);
+}
+
+const web_route_t *web_router_find(web_router_handle_t router, int method, const char *uri)
+{
+    if (router == NULL || uri == NULL) {
+        return NULL;
+    }
+
+    size_t len;
+    size_t slot = route_hash(method, uri, &len) & router->mask;
+    while (router->slots[slot] != 0) {
+        const web_route_t *route = &router->routes[router->slots[slot] - 1];
+        if (route_matches(route, method, uri, len)) {
+            return route;
+        }
+        slot = (slot + 1) & router->mask;
+    }
+    return NULL;
+}
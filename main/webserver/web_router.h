@@ -0,0 +1,83 @@
+/**
+ * @file web_router.h
+ * @brief Route table for the web server
+ *
+ * The web server registers one wildcard URI handler per method and looks
+ * the route up here, instead of registering every endpoint with
+ * esp_http_server: its table is limited to max_uri_handlers and matched
+ * linearly on every request. Routes are hashed on method and path (the
+ * query string is ignored) into an open-addressing table built once, so
+ * a lookup hashes the path once and usually probes a single slot,
+ * however many routes there are.
+ */
+
+#ifndef WEB_ROUTER_H
+#define WEB_ROUTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Route flags
+ */
+#define WEB_ROUTE_AUTH          0x01    // Needs a session when authentication is enabled
+#define WEB_ROUTE_ASYNC         0x02    // May answer after returning: no request arena
+#define WEB_ROUTE_CACHEABLE     0x04    // Static content, sent with Cache-Control
+#define WEB_ROUTE_COMPRESS      0x08    // Large responses gzip-compressed for clients that accept it
+
+/**
+ * @brief Route
+ */
+typedef struct {
+    httpd_method_t method;
+    const char *path;                   // Exact path, without query string
+    esp_err_t (*handler)(httpd_req_t *req);
+    uint8_t flags;                      // WEB_ROUTE_*
+    uint32_t body_max;                  // Largest request body accepted (bytes), 0 = any
+} web_route_t;
+
+typedef struct web_router *web_router_handle_t;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+/**
+ * @brief Build the lookup table of a route array
+ *
+ * The array is referenced, not copied, and must outlive the router.
+ *
+ * @param routes Routes
+ * @param count Number of routes (at most 255)
+ * @param out_handle Pointer to store the router handle
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if a method and
+ *         path appear twice, ESP_ERR_NO_MEM if the table cannot be allocated
+ */
+esp_err_t web_router_create(const web_route_t *routes, size_t count, web_router_handle_t *out_handle);
+
+/**
+ * @brief Free a router
+ */
+void web_router_delete(web_router_handle_t router);
+
+/**
+ * @brief Find the route of a request
+ *
+ * @param router Router
+ * @param method Request method
+ * @param uri Request URI; anything from '?' on is ignored
+ * @return const web_route_t* Route, NULL if none matches
+ */
+const web_route_t *web_router_find(web_router_handle_t router, int method, const char *uri);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEB_ROUTER_H
@@ -5,65 +5,398 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "esp_log.h"
+#include "dlog.h"
 #include "esp_littlefs.h"
 #include "cJSON.h"
 #include "mbedtls/base64.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
 
 #include "wifi_manager.h"
 #include "config_manager.h"
 #include "rs485_driver.h"
 #include "modbus_rtu.h"
 #include "mightyzap.h"
+#include "actuator_registry.h"
+#include "actuator_poller.h"
+#include "actuator_batch.h"
+#include "bus_manager.h"
+#include "modbus_tcp.h"
+#include "modbus_slave.h"
+#include "rs485_trace.h"
+#include "tracepoint.h"
+#include "metrics.h"
+#include "cpu_sampler.h"
+#include "memprof.h"
+#include "profiler.h"
+#include "arena.h"
+#include "boot.h"
+#include "web_router.h"
+#include "web_gzip.h"
 
 static const char *TAG = "WEB_SRV";
 
-// External globals from main
-extern rs485_handle_t g_rs485;
-extern modbus_handle_t g_modbus;
-extern mightyzap_handle_t g_actuator;
-
 // Server handle
 static httpd_handle_t s_server = NULL;
 static web_server_config_t s_config;
 static bool s_running = false;
+static arena_handle_t s_req_arena = NULL;  // cJSON memory of the request being handled
+static web_router_handle_t s_router = NULL;
 
 // Forward declarations
 static esp_err_t serve_file(httpd_req_t *req, const char *filepath, const char *content_type);
-static bool check_auth(httpd_req_t *req);
+
+// ============================================================================
+// Response Compression
+// ============================================================================
+
+/**
+ * Routes flagged WEB_ROUTE_COMPRESS send their body through resp_send_chunk()
+ * (send_json() does). When the client accepts gzip, the start of the body is
+ * held until it reaches CONFIG_HTTPD_GZIP_MIN_SIZE bytes: smaller responses
+ * go out as they are, larger ones through the encoder. Handlers run one at
+ * a time on the server task, so one state and one encoder serve them all.
+ */
+typedef struct {
+    httpd_req_t *req;               // Request whose client accepts gzip, NULL if none
+    bool compressing;
+    size_t held;                    // Bytes of the body held in head
+    uint8_t head[CONFIG_HTTPD_GZIP_MIN_SIZE];
+} resp_gzip_t;
+
+static resp_gzip_t s_resp_gzip;
+static web_gzip_handle_t s_gzip = NULL;     // Allocated by the first compressed response
+
+METRIC_COUNTER_DEFINE(s_m_gzip_responses, "http_gzip_responses", "Responses sent gzip-compressed");
+METRIC_COUNTER_DEFINE(s_m_gzip_in, "http_gzip_in_bytes", "Body bytes of gzip-compressed responses before compression");
+METRIC_COUNTER_DEFINE(s_m_gzip_out, "http_gzip_out_bytes", "Body bytes of gzip-compressed responses sent");
+
+/**
+ * @brief Whether Accept-Encoding lists gzip with a non-zero quality
+ */
+static bool accepts_gzip(httpd_req_t *req)
+{
+    char value[96];
+    esp_err_t ret = httpd_req_get_hdr_value_str(req, "Accept-Encoding", value, sizeof(value));
+    if (ret != ESP_OK && ret != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return false;
+    }
+
+    for (const char *tok = strstr(value, "gzip"); tok != NULL; tok = strstr(tok + 4, "gzip")) {
+        if (tok != value && tok[-1] != ' ' && tok[-1] != ',') {
+            continue;               // x-gzip
+        }
+        const char *p = tok + 4;
+        while (*p == ' ') {
+            p++;
+        }
+        if (*p == ';') {
+            const char *q = strstr(p, "q=");
+            return q == NULL || strtod(q + 2, NULL) > 0;
+        }
+        return *p == ',' || *p == '\0';
+    }
+    return false;
+}
+
+static esp_err_t gzip_out(void *ctx, const uint8_t *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, (const char *)data, len);
+}
+
+/**
+ * @brief Switch the response to gzip; false if the encoder cannot be allocated
+ */
+static bool resp_gzip_start(httpd_req_t *req)
+{
+    if (s_gzip == NULL && web_gzip_create(CONFIG_HTTPD_GZIP_WINDOW_BITS, &s_gzip) != ESP_OK) {
+        DLOGW(TAG, "No memory for the gzip encoder, sending uncompressed");
+        return false;
+    }
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    s_resp_gzip.compressing = true;
+    return true;
+}
+
+/**
+ * @brief Send part of a chunked body, compressed when the route and client allow
+ *
+ * @param req Request
+ * @param data Bytes, NULL to end the body
+ * @param len Number of bytes
+ * @return esp_err_t Result of the send
+ */
+static esp_err_t resp_send_chunk(httpd_req_t *req, const char *data, size_t len)
+{
+    resp_gzip_t *z = &s_resp_gzip;
+    if (z->req != req) {
+        return httpd_resp_send_chunk(req, data, data != NULL ? len : 0);
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (!z->compressing) {
+        if (data != NULL && z->held + len < sizeof(z->head)) {
+            memcpy(z->head + z->held, data, len);
+            z->held += len;
+            return ESP_OK;
+        }
+        if (data == NULL || !resp_gzip_start(req)) {
+            // Too small to be worth it, or no encoder: plain from here on
+            z->req = NULL;
+            if (z->held > 0) {
+                ret = httpd_resp_send_chunk(req, (const char *)z->head, z->held);
+            }
+            if (ret == ESP_OK) {
+                ret = httpd_resp_send_chunk(req, data, data != NULL ? len : 0);
+            }
+            return ret;
+        }
+        ret = web_gzip_begin(s_gzip, gzip_out, req);
+        if (ret == ESP_OK) {
+            ret = web_gzip_write(s_gzip, z->head, z->held);
+        }
+    }
+
+    if (data != NULL) {
+        return ret == ESP_OK ? web_gzip_write(s_gzip, data, len) : ret;
+    }
+
+    size_t in_len = 0;
+    size_t out_len = 0;
+    if (ret == ESP_OK) {
+        ret = web_gzip_finish(s_gzip, &in_len, &out_len);
+    }
+    z->req = NULL;
+    z->compressing = false;
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    metrics_counter_inc(&s_m_gzip_responses);
+    metrics_counter_add(&s_m_gzip_in, in_len);
+    metrics_counter_add(&s_m_gzip_out, out_len);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// ============================================================================
+// Response Helpers
+// ============================================================================
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+/**
+ * @brief Send a JSON string, gzip-compressed if large and the route allows
+ */
+static esp_err_t send_json_str(httpd_req_t *req, const char *json_str)
+{
+    size_t len = strlen(json_str);
+    httpd_resp_set_type(req, "application/json");
+    if (s_resp_gzip.req != req || len < sizeof(s_resp_gzip.head)) {
+        return httpd_resp_send(req, json_str, len);
+    }
+    esp_err_t ret = resp_send_chunk(req, json_str, len);
+    if (ret == ESP_OK) {
+        ret = resp_send_chunk(req, NULL, 0);
+    }
+    return ret;
+}
+
+/**
+ * @brief Send a JSON document and delete it
+ */
+static esp_err_t send_json(httpd_req_t *req, cJSON *root)
+{
+    char *json_str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (json_str == NULL) {
+        return httpd_resp_send_500(req);
+    }
+    esp_err_t ret = send_json_str(req, json_str);
+    cJSON_free(json_str);
+    return ret;
+}
 
 // ============================================================================
 // Authentication
 // ============================================================================
 
-static bool check_auth(httpd_req_t *req)
+#define SESSION_COOKIE      "bd_session"
+#define SESSION_TOKEN_LEN   16      // Random bytes, sent as 32 hex digits
+
+/**
+ * @brief Logged-in session
+ *
+ * The token is only compared, never derived, so checking a request costs
+ * a hex decode and a few memory compares instead of base64 and string work.
+ */
+typedef struct {
+    uint8_t token[SESSION_TOKEN_LEN];
+    int64_t expires_us;             // 0 = free slot
+} web_session_t;
+
+static web_session_t s_sessions[CONFIG_HTTPD_SESSION_MAX];
+static portMUX_TYPE s_session_lock = portMUX_INITIALIZER_UNLOCKED;
+
+METRIC_COUNTER_DEFINE(s_m_logins, "http_logins", "Successful logins to the web interface");
+METRIC_COUNTER_DEFINE(s_m_auth_rejected, "http_auth_rejected", "Requests and logins rejected for missing or bad credentials");
+
+static bool ct_equal(const void *a, const void *b, size_t len)
 {
-    if (!s_config.auth_enabled) return true;
+    const uint8_t *pa = a, *pb = b;
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= pa[i] ^ pb[i];
+    }
+    return diff == 0;
+}
 
-    char auth_header[256] = {0};
-    if (httpd_req_get_hdr_value_str(req, "Authorization", auth_header, sizeof(auth_header)) != ESP_OK) {
-        ESP_LOGD(TAG, "No Authorization header");
+static bool ct_streq(const char *a, const char *b)
+{
+    size_t len = strlen(a);
+    return len == strlen(b) && ct_equal(a, b, len);
+}
+
+static void token_to_hex(const uint8_t *token, char *hex)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < SESSION_TOKEN_LEN; i++) {
+        hex[2 * i] = digits[token[i] >> 4];
+        hex[2 * i + 1] = digits[token[i] & 0x0F];
+    }
+    hex[2 * SESSION_TOKEN_LEN] = '\0';
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool token_from_hex(const char *hex, uint8_t *token)
+{
+    for (int i = 0; i < SESSION_TOKEN_LEN; i++) {
+        int hi = hex_nibble(hex[2 * i]);
+        int lo = hi < 0 ? -1 : hex_nibble(hex[2 * i + 1]);
+        if (lo < 0) return false;
+        token[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return hex[2 * SESSION_TOKEN_LEN] == '\0';
+}
+
+/**
+ * @brief Open a session, evicting the one closest to expiry if all are in use
+ */
+static void session_create(uint8_t *token)
+{
+    esp_fill_random(token, SESSION_TOKEN_LEN);
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_session_lock);
+    int slot = 0;
+    for (int i = 0; i < CONFIG_HTTPD_SESSION_MAX; i++) {
+        if (s_sessions[i].expires_us < now) {
+            slot = i;
+            break;
+        }
+        if (s_sessions[i].expires_us < s_sessions[slot].expires_us) {
+            slot = i;
+        }
+    }
+    memcpy(s_sessions[slot].token, token, SESSION_TOKEN_LEN);
+    s_sessions[slot].expires_us = now + (int64_t)CONFIG_HTTPD_SESSION_TTL_S * 1000000;
+    portEXIT_CRITICAL(&s_session_lock);
+}
+
+/**
+ * @brief Check a token and push its expiry back (idle timeout)
+ *
+ * All slots are compared so the time taken does not depend on which one
+ * matches.
+ */
+static bool session_touch(const uint8_t *token)
+{
+    int64_t now = esp_timer_get_time();
+    bool found = false;
+
+    portENTER_CRITICAL(&s_session_lock);
+    for (int i = 0; i < CONFIG_HTTPD_SESSION_MAX; i++) {
+        bool match = ct_equal(s_sessions[i].token, token, SESSION_TOKEN_LEN);
+        if (match && s_sessions[i].expires_us >= now) {
+            s_sessions[i].expires_us = now + (int64_t)CONFIG_HTTPD_SESSION_TTL_S * 1000000;
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_session_lock);
+    return found;
+}
+
+static void session_revoke(const uint8_t *token)
+{
+    portENTER_CRITICAL(&s_session_lock);
+    for (int i = 0; i < CONFIG_HTTPD_SESSION_MAX; i++) {
+        if (ct_equal(s_sessions[i].token, token, SESSION_TOKEN_LEN)) {
+            memset(&s_sessions[i], 0, sizeof(s_sessions[i]));
+        }
+    }
+    portEXIT_CRITICAL(&s_session_lock);
+}
+
+static void session_revoke_all(void)
+{
+    portENTER_CRITICAL(&s_session_lock);
+    memset(s_sessions, 0, sizeof(s_sessions));
+    portEXIT_CRITICAL(&s_session_lock);
+}
+
+/**
+ * @brief Get the session token of a request
+ *
+ * From "Authorization: Bearer <token>" (scripts) or the session cookie
+ * (browser).
+ */
+static bool request_token(httpd_req_t *req, const char *auth_header, uint8_t *token)
+{
+    if (strncmp(auth_header, "Bearer ", 7) == 0) {
+        return token_from_hex(auth_header + 7, token);
+    }
+
+    char hex[2 * SESSION_TOKEN_LEN + 1];
+    size_t len = sizeof(hex);
+    if (httpd_req_get_cookie_val(req, SESSION_COOKIE, hex, &len) != ESP_OK) {
         return false;
     }
+    return token_from_hex(hex, token);
+}
 
-    // Parse "Basic base64credentials"
+/**
+ * @brief Check "Authorization: Basic" credentials
+ *
+ * Kept for scripts that do not log in; the web interface uses a session.
+ */
+static bool check_basic_auth(const char *auth_header)
+{
     if (strncmp(auth_header, "Basic ", 6) != 0) {
-        ESP_LOGD(TAG, "Not Basic auth");
+        DLOGD(TAG, "Not Basic auth");
         return false;
     }
 
     // Decode base64
     const char *b64_credentials = auth_header + 6;
     size_t b64_len = strlen(b64_credentials);
-    
+
     unsigned char decoded[128] = {0};
     size_t decoded_len = 0;
-    
+
     int ret = mbedtls_base64_decode(decoded, sizeof(decoded) - 1, &decoded_len,
                                     (const unsigned char*)b64_credentials, b64_len);
     if (ret != 0) {
-        ESP_LOGW(TAG, "Failed to decode base64 credentials");
+        DLOGW(TAG, "Failed to decode base64 credentials");
         return false;
     }
     decoded[decoded_len] = '\0';
@@ -72,22 +405,106 @@ static bool check_auth(httpd_req_t *req)
     char expected[128];
     snprintf(expected, sizeof(expected), "%s:%s", s_config.username, s_config.password);
 
-    // Secure comparison
-    bool match = (strlen(expected) == decoded_len) && 
-                 (memcmp(decoded, expected, decoded_len) == 0);
-    
-    if (!match) {
-        ESP_LOGW(TAG, "Authentication failed");
+    return ct_streq((const char *)decoded, expected);
+}
+
+static bool check_auth(httpd_req_t *req)
+{
+    if (!s_config.auth_enabled) return true;
+
+    char auth_header[256] = {0};
+    httpd_req_get_hdr_value_str(req, "Authorization", auth_header, sizeof(auth_header));
+
+    uint8_t token[SESSION_TOKEN_LEN];
+    if (request_token(req, auth_header, token) && session_touch(token)) {
+        return true;
     }
-    
-    return match;
+
+    if (auth_header[0] != '\0' && check_basic_auth(auth_header)) {
+        return true;
+    }
+
+    DLOGW(TAG, "Unauthorized: %s", req->uri);
+    metrics_counter_add(&s_m_auth_rejected, 1);
+    return false;
 }
 
 static esp_err_t send_unauthorized(httpd_req_t *req)
 {
+    // No WWW-Authenticate: the browser would show its own dialog and then
+    // send Basic credentials on every request instead of logging in
     httpd_resp_set_status(req, "401 Unauthorized");
-    httpd_resp_set_hdr(req, "WWW-Authenticate", "Basic realm=\"ESP32\"");
-    httpd_resp_send(req, "Unauthorized", HTTPD_RESP_USE_STRLEN);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Unauthorized\"}");
+    return ESP_OK;
+}
+
+// POST /api/login - {"username", "password"} -> session cookie and token
+static esp_err_t api_login_handler(httpd_req_t *req)
+{
+    char buf[256];
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No data");
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+
+    cJSON *root = cJSON_Parse(buf);
+    if (root == NULL) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *user_json = cJSON_GetObjectItem(root, "username");
+    cJSON *pass_json = cJSON_GetObjectItem(root, "password");
+    bool valid = cJSON_IsString(user_json) && cJSON_IsString(pass_json);
+    // Evaluate both compares so a wrong username takes as long as a wrong password
+    bool user_ok = valid && ct_streq(user_json->valuestring, s_config.username);
+    bool pass_ok = valid && ct_streq(pass_json->valuestring, s_config.password);
+    cJSON_Delete(root);
+
+    if (!user_ok || !pass_ok) {
+        DLOGW(TAG, "Login failed");
+        metrics_counter_add(&s_m_auth_rejected, 1);
+        return send_unauthorized(req);
+    }
+
+    uint8_t token[SESSION_TOKEN_LEN];
+    char hex[2 * SESSION_TOKEN_LEN + 1];
+    session_create(token);
+    token_to_hex(token, hex);
+    metrics_counter_add(&s_m_logins, 1);
+
+    // The header value must stay valid until the response is sent
+    char cookie[96];
+    snprintf(cookie, sizeof(cookie), SESSION_COOKIE "=%s; Path=/; Max-Age=%d; HttpOnly; SameSite=Strict",
+             hex, CONFIG_HTTPD_SESSION_TTL_S);
+    httpd_resp_set_hdr(req, "Set-Cookie", cookie);
+
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "success", true);
+    cJSON_AddStringToObject(response, "token", hex);
+    cJSON_AddNumberToObject(response, "expires_in", CONFIG_HTTPD_SESSION_TTL_S);
+
+    send_json(req, response);
+    return ESP_OK;
+}
+
+// POST /api/logout - Close the session of the request
+static esp_err_t api_logout_handler(httpd_req_t *req)
+{
+    char auth_header[64] = {0};
+    httpd_req_get_hdr_value_str(req, "Authorization", auth_header, sizeof(auth_header));
+
+    uint8_t token[SESSION_TOKEN_LEN];
+    if (request_token(req, auth_header, token)) {
+        session_revoke(token);
+    }
+
+    httpd_resp_set_hdr(req, "Set-Cookie", SESSION_COOKIE "=; Path=/; Max-Age=0");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"success\":true}");
     return ESP_OK;
 }
 
@@ -234,81 +651,334 @@ static void build_full_path(char *dest, size_t dest_size, const char *base, cons
     }
 }
 
-// GET /api/files/list - List files in directory
+// Directory listing: entries are written to the response as they are
+// produced, in chunks, so a page costs a fixed buffer whatever the size of
+// the directory. Sorted pages keep only the best offset + limit entries.
+#define LIST_MAX_LIMIT      100     // Entries per page
+#define LIST_CHUNK_SIZE     1024
+#define LIST_NAME_MAX       CONFIG_LITTLEFS_OBJ_NAME_LEN
+
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t err;                  // First send error; later writes are dropped
+    size_t len;
+    char buf[LIST_CHUNK_SIZE];
+} list_writer_t;
+
+typedef struct {
+    bool is_dir;
+    char name[LIST_NAME_MAX + 1];
+} list_entry_t;
+
+static void list_flush(list_writer_t *w)
+{
+    if (w->len > 0 && w->err == ESP_OK) {
+        w->err = resp_send_chunk(w->req, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+static void list_write(list_writer_t *w, const char *data, size_t len)
+{
+    if (w->len + len > sizeof(w->buf)) {
+        list_flush(w);
+    }
+    if (len > sizeof(w->buf)) {
+        if (w->err == ESP_OK) {
+            w->err = resp_send_chunk(w->req, data, len);
+        }
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+static void list_write_str(list_writer_t *w, const char *s)
+{
+    list_write(w, s, strlen(s));
+}
+
+/**
+ * @brief Write a string escaped for JSON, without quotes
+ */
+static void list_write_escaped(list_writer_t *w, const char *s)
+{
+    while (*s != '\0') {
+        size_t run = 0;
+        while (s[run] != '\0' && s[run] != '"' && s[run] != '\\' && (unsigned char)s[run] >= 0x20) {
+            run++;
+        }
+        list_write(w, s, run);
+        s += run;
+        if (*s == '\0') {
+            break;
+        }
+        char esc[8];
+        if (*s == '"' || *s == '\\') {
+            esc[0] = '\\';
+            esc[1] = *s;
+            list_write(w, esc, 2);
+        } else {
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)*s);
+            list_write(w, esc, 6);
+        }
+        s++;
+    }
+}
+
+/**
+ * @brief Write one entry; with_stat adds the size of files (one stat() each)
+ */
+static void list_write_entry(list_writer_t *w, const char *dir_path, const char *name,
+                             bool is_dir, bool with_stat, bool first)
+{
+    list_write_str(w, first ? "{\"name\":\"" : ",{\"name\":\"");
+    list_write_escaped(w, name);
+
+    char field[48];
+    if (with_stat && !is_dir) {
+        char file_path[320];
+        snprintf(file_path, sizeof(file_path), "%.159s/%.159s", dir_path, name);
+        struct stat st;
+        long size = stat(file_path, &st) == 0 ? (long)st.st_size : 0;
+        snprintf(field, sizeof(field), "\",\"size\":%ld,\"isDir\":false}", size);
+    } else {
+        snprintf(field, sizeof(field), "\",\"isDir\":%s}", is_dir ? "true" : "false");
+    }
+    list_write_str(w, field);
+}
+
+/**
+ * @brief Whether a directory entry is a directory, from d_type when the
+ *        file system fills it in, else from stat()
+ */
+static bool list_is_dir(const char *dir_path, const struct dirent *entry)
+{
+    if (entry->d_type != DT_UNKNOWN) {
+        return entry->d_type == DT_DIR;
+    }
+    char path[320];
+    snprintf(path, sizeof(path), "%.159s/%.159s", dir_path, entry->d_name);
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Listing order: directories first, then by name (byte order)
+static int list_entry_cmp(bool a_dir, const char *a_name, const list_entry_t *b)
+{
+    if (a_dir != b->is_dir) {
+        return a_dir ? -1 : 1;
+    }
+    return strcmp(a_name, b->name);
+}
+
+/**
+ * @brief Restore the max-heap property below node i
+ */
+static void list_heap_down(list_entry_t *heap, int n, int i)
+{
+    while (true) {
+        int largest = i;
+        int l = 2 * i + 1;
+        int r = l + 1;
+        if (l < n && list_entry_cmp(heap[l].is_dir, heap[l].name, &heap[largest]) > 0) largest = l;
+        if (r < n && list_entry_cmp(heap[r].is_dir, heap[r].name, &heap[largest]) > 0) largest = r;
+        if (largest == i) {
+            return;
+        }
+        list_entry_t tmp = heap[i];
+        heap[i] = heap[largest];
+        heap[largest] = tmp;
+        i = largest;
+    }
+}
+
+/**
+ * @brief Keep an entry if it is among the k first seen so far
+ *
+ * The heap holds the k first entries in listing order, the last of them
+ * at the root, so an entry is compared once with the root and most are
+ * dropped there.
+ */
+static void list_heap_offer(list_entry_t *heap, int *n, int k, bool is_dir, const char *name)
+{
+    int i;
+    if (*n < k) {
+        i = (*n)++;
+        while (i > 0 && list_entry_cmp(is_dir, name, &heap[(i - 1) / 2]) > 0) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else if (list_entry_cmp(is_dir, name, &heap[0]) < 0) {
+        i = 0;
+        heap[0].is_dir = is_dir;
+        strcpy(heap[0].name, name);
+        list_heap_down(heap, *n, 0);
+        return;
+    } else {
+        return;
+    }
+    heap[i].is_dir = is_dir;
+    strcpy(heap[i].name, name);
+}
+
+// GET /api/files/list - List a directory, one page at a time
+// Query: partition, dir, limit (1-100), offset, cursor ("next" of the previous page),
+//        sort=name|none, stat=1|0 (0: no sizes, no stat() per file)
 static esp_err_t api_files_list_handler(httpd_req_t *req)
 {
-    char query_buf[256] = {0};
+    char query_buf[384] = {0};
     char dir_param[128] = "/";
+    char cursor[LIST_NAME_MAX * 3 + 8] = "";
+    char value[16];
+    int limit = LIST_MAX_LIMIT;
+    int offset = 0;
+    bool sorted = true;
+    bool with_stat = true;
 
     const char *base_path = get_partition_path(req, query_buf, sizeof(query_buf));
 
-    // Get dir parameter
     if (httpd_req_get_url_query_str(req, query_buf, sizeof(query_buf)) == ESP_OK) {
-        httpd_query_key_value(query_buf, "dir", dir_param, sizeof(dir_param));
-        url_decode(dir_param);
+        if (httpd_query_key_value(query_buf, "dir", dir_param, sizeof(dir_param)) == ESP_OK) {
+            url_decode(dir_param);
+        }
+        if (httpd_query_key_value(query_buf, "cursor", cursor, sizeof(cursor)) == ESP_OK) {
+            url_decode(cursor);
+        }
+        if (httpd_query_key_value(query_buf, "limit", value, sizeof(value)) == ESP_OK) {
+            limit = atoi(value);
+        }
+        if (httpd_query_key_value(query_buf, "offset", value, sizeof(value)) == ESP_OK) {
+            offset = atoi(value);
+        }
+        if (httpd_query_key_value(query_buf, "sort", value, sizeof(value)) == ESP_OK) {
+            sorted = strcmp(value, "none") != 0;
+        }
+        if (httpd_query_key_value(query_buf, "stat", value, sizeof(value)) == ESP_OK) {
+            with_stat = strcmp(value, "0") != 0;
+        }
     }
 
     if (!is_valid_path(dir_param)) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid path");
         return ESP_FAIL;
     }
+    if (limit < 1 || limit > LIST_MAX_LIMIT || offset < 0 || (sorted && offset + limit > LIST_MAX_LIMIT)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "limit is 1-" STR(LIST_MAX_LIMIT)
+                            ", offset + limit at most " STR(LIST_MAX_LIMIT) " when sorted: use cursor");
+        return ESP_FAIL;
+    }
+
+    // Sorted cursor: "d/<name>" or "f/<name>", the last entry sent. Unsorted: entries read.
+    list_entry_t after = { 0 };
+    bool has_after = false;
+    long skip = offset;
+    if (cursor[0] != '\0') {
+        if (sorted && (cursor[0] == 'd' || cursor[0] == 'f') && cursor[1] == '/') {
+            after.is_dir = cursor[0] == 'd';
+            snprintf(after.name, sizeof(after.name), "%s", cursor + 2);
+            has_after = true;
+        } else if (!sorted && cursor[0] >= '0' && cursor[0] <= '9') {
+            skip += atol(cursor);
+        } else {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid cursor");
+            return ESP_FAIL;
+        }
+    }
 
     char full_path[160];
     build_full_path(full_path, sizeof(full_path), base_path, dir_param);
 
-    DIR *dir = opendir(full_path);
-    if (!dir) {
-        // If directory doesn't exist, return empty list
-        cJSON *root = cJSON_CreateObject();
-        cJSON *files = cJSON_CreateArray();
-        cJSON_AddItemToObject(root, "files", files);
-
-        char *json_str = cJSON_PrintUnformatted(root);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_str, strlen(json_str));
-        free(json_str);
-        cJSON_Delete(root);
-        return ESP_OK;
+    int k = sorted ? offset + limit : 0;
+    list_writer_t *w = memprof_malloc(MEMPROF_TAG_HTTP, sizeof(list_writer_t) + k * sizeof(list_entry_t));
+    if (w == NULL) {
+        return httpd_resp_send_500(req);
     }
+    list_entry_t *heap = (list_entry_t *)(w + 1);
+    w->req = req;
+    w->err = ESP_OK;
+    w->len = 0;
 
-    cJSON *root = cJSON_CreateObject();
-    cJSON *files = cJSON_CreateArray();
+    httpd_resp_set_type(req, "application/json");
+    list_write_str(w, "{\"files\":[");
 
+    // A missing directory lists as empty
+    DIR *dir = opendir(full_path);
+    int sent = 0;
+    bool more = false;
+    long position = 0;
+    int n = 0;
     struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
+
+    while (dir != NULL && w->err == ESP_OK && (entry = readdir(dir)) != NULL) {
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
             continue;
         }
-
-        cJSON *file_obj = cJSON_CreateObject();
-        cJSON_AddStringToObject(file_obj, "name", entry->d_name);
-
-        // Get file info
-        char file_path[320];
-        snprintf(file_path, sizeof(file_path), "%.159s/%.159s", full_path, entry->d_name);
-
-        struct stat st;
-        if (stat(file_path, &st) == 0) {
-            cJSON_AddNumberToObject(file_obj, "size", st.st_size);
-            cJSON_AddBoolToObject(file_obj, "isDir", S_ISDIR(st.st_mode));
-        } else {
-            cJSON_AddNumberToObject(file_obj, "size", 0);
-            cJSON_AddBoolToObject(file_obj, "isDir", entry->d_type == DT_DIR);
+        if (!sorted) {
+            if (position++ < skip) {
+                continue;
+            }
+            if (sent == limit) {
+                more = true;
+                break;
+            }
+            list_write_entry(w, full_path, entry->d_name, list_is_dir(full_path, entry), with_stat, sent == 0);
+            sent++;
+            continue;
         }
 
-        cJSON_AddItemToArray(files, file_obj);
-    }
-    closedir(dir);
-
-    cJSON_AddItemToObject(root, "files", files);
+        if (strlen(entry->d_name) > LIST_NAME_MAX) {
+            continue;
+        }
+        bool is_dir = list_is_dir(full_path, entry);
+        if (has_after && list_entry_cmp(is_dir, entry->d_name, &after) <= 0) {
+            continue;
+        }
+        if (n == k) {
+            more = true;
+        }
+        list_heap_offer(heap, &n, k, is_dir, entry->d_name);
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
+    if (sorted) {
+        // Heap sort: ascending order, the largest popped to the end each time
+        for (int end = n - 1; end > 0; end--) {
+            list_entry_t tmp = heap[0];
+            heap[0] = heap[end];
+            heap[end] = tmp;
+            list_heap_down(heap, end, 0);
+        }
+        for (int i = offset; i < n; i++) {
+            list_write_entry(w, full_path, heap[i].name, heap[i].is_dir, with_stat, sent == 0);
+            sent++;
+        }
+    }
 
-    return ESP_OK;
+    char tail[48];
+    snprintf(tail, sizeof(tail), "],\"count\":%d,\"next\":", sent);
+    list_write_str(w, tail);
+    if (!more) {
+        list_write_str(w, "null");
+    } else if (sorted) {
+        list_write_str(w, heap[n - 1].is_dir ? "\"d/" : "\"f/");
+        list_write_escaped(w, heap[n - 1].name);
+        list_write_str(w, "\"");
+    } else {
+        snprintf(tail, sizeof(tail), "\"%ld\"", skip + sent);
+        list_write_str(w, tail);
+    }
+    list_write_str(w, "}");
+    list_flush(w);
+
+    esp_err_t ret = w->err;
+    memprof_free(MEMPROF_TAG_HTTP, w);
+    if (ret != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return resp_send_chunk(req, NULL, 0);
 }
 
 // GET /api/files/info - Get storage info for all partitions
@@ -334,11 +1004,7 @@ static esp_err_t api_files_info_handler(httpd_req_t *req)
         cJSON_AddItemToObject(root, "userdata", userdata);
     }
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
 
     return ESP_OK;
 }
@@ -459,7 +1125,7 @@ static esp_err_t api_files_read_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    char *content = malloc(fsize + 1);
+    char *content = memprof_malloc(MEMPROF_TAG_FILES, fsize + 1);
     if (!content) {
         fclose(f);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
@@ -475,13 +1141,9 @@ static esp_err_t api_files_read_handler(httpd_req_t *req)
     cJSON_AddStringToObject(root, "content", content);
     cJSON_AddNumberToObject(root, "size", fsize);
 
-    free(content);
+    memprof_free(MEMPROF_TAG_FILES, content);
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
 
     return ESP_OK;
 }
@@ -499,7 +1161,7 @@ static esp_err_t api_files_write_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    char *buf = malloc(total_len + 1);
+    char *buf = memprof_malloc(MEMPROF_TAG_FILES, total_len + 1);
     if (!buf) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
@@ -509,7 +1171,7 @@ static esp_err_t api_files_write_handler(httpd_req_t *req)
     while (received < total_len) {
         int ret = httpd_req_recv(req, buf + received, total_len - received);
         if (ret <= 0) {
-            free(buf);
+            memprof_free(MEMPROF_TAG_FILES, buf);
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
             return ESP_FAIL;
         }
@@ -555,13 +1217,13 @@ static esp_err_t api_files_write_handler(httpd_req_t *req)
     }
 
     if (!file_param[0] || !content_start) {
-        free(buf);
+        memprof_free(MEMPROF_TAG_FILES, buf);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing parameters");
         return ESP_FAIL;
     }
 
     if (!is_valid_path(file_param)) {
-        free(buf);
+        memprof_free(MEMPROF_TAG_FILES, buf);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid path");
         return ESP_FAIL;
     }
@@ -571,23 +1233,19 @@ static esp_err_t api_files_write_handler(httpd_req_t *req)
 
     FILE *f = fopen(full_path, "w");
     if (!f) {
-        free(buf);
+        memprof_free(MEMPROF_TAG_FILES, buf);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to open file");
         return ESP_FAIL;
     }
 
     fwrite(content_start, 1, content_len, f);
     fclose(f);
-    free(buf);
+    memprof_free(MEMPROF_TAG_FILES, buf);
 
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "status", "ok");
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
 
     return ESP_OK;
 }
@@ -658,11 +1316,7 @@ static esp_err_t api_files_delete_handler(httpd_req_t *req)
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "status", "ok");
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
 
     return ESP_OK;
 }
@@ -720,11 +1374,7 @@ static esp_err_t api_files_mkdir_handler(httpd_req_t *req)
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "status", "ok");
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
 
     return ESP_OK;
 }
@@ -755,7 +1405,7 @@ static esp_err_t api_files_upload_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    char *buf = malloc(total_len + 1);
+    char *buf = memprof_malloc(MEMPROF_TAG_FILES, total_len + 1);
     if (!buf) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
@@ -765,7 +1415,7 @@ static esp_err_t api_files_upload_handler(httpd_req_t *req)
     while (received < total_len) {
         int ret = httpd_req_recv(req, buf + received, total_len - received);
         if (ret <= 0) {
-            free(buf);
+            memprof_free(MEMPROF_TAG_FILES, buf);
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
             return ESP_FAIL;
         }
@@ -785,7 +1435,7 @@ static esp_err_t api_files_upload_handler(httpd_req_t *req)
     }
 
     if (!filename[0]) {
-        free(buf);
+        memprof_free(MEMPROF_TAG_FILES, buf);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No filename");
         return ESP_FAIL;
     }
@@ -793,7 +1443,7 @@ static esp_err_t api_files_upload_handler(httpd_req_t *req)
     // Find file content (after double CRLF)
     char *content_start = strstr(buf, "\r\n\r\n");
     if (!content_start) {
-        free(buf);
+        memprof_free(MEMPROF_TAG_FILES, buf);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid format");
         return ESP_FAIL;
     }
@@ -819,23 +1469,19 @@ static esp_err_t api_files_upload_handler(httpd_req_t *req)
 
     FILE *f = fopen(full_path, "w");
     if (!f) {
-        free(buf);
+        memprof_free(MEMPROF_TAG_FILES, buf);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to create file");
         return ESP_FAIL;
     }
 
     fwrite(content_start, 1, content_len, f);
     fclose(f);
-    free(buf);
+    memprof_free(MEMPROF_TAG_FILES, buf);
 
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "status", "ok");
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
 
     ESP_LOGI(TAG, "File uploaded: %s", full_path);
     return ESP_OK;
@@ -845,7 +1491,34 @@ static esp_err_t api_files_upload_handler(httpd_req_t *req)
 // API Handlers - System
 // ============================================================================
 
-static esp_err_t api_status_handler(httpd_req_t *req)
+/**
+ * @brief State of every configured bus
+ *
+ * @param all_up Pointer to store whether at least one bus is configured and all are up
+ */
+static cJSON *buses_json(bool *all_up)
+{
+    cJSON *buses = cJSON_CreateArray();
+    uint8_t count = bus_manager_count();
+    *all_up = count > 0;
+
+    for (uint8_t bus = 0; bus < count; bus++) {
+        bool up = bus_manager_is_up(bus);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "bus", bus);
+        cJSON_AddNumberToObject(item, "uart", bus_manager_get_uart(bus));
+        cJSON_AddBoolToObject(item, "rs485_ready", bus_manager_get_rs485(bus) != NULL);
+        cJSON_AddBoolToObject(item, "modbus_ready", up);
+        cJSON_AddItemToArray(buses, item);
+        *all_up = *all_up && up;
+    }
+    return buses;
+}
+
+/**
+ * @brief System and WiFi status (GET /api/status, "status" event)
+ */
+static cJSON *status_json(void)
 {
     cJSON *root = cJSON_CreateObject();
 
@@ -864,92 +1537,219 @@ static esp_err_t api_status_handler(httpd_req_t *req)
     cJSON_AddNumberToObject(root, "wifi_rssi", wifi_manager_get_rssi());
     cJSON_AddNumberToObject(root, "wifi_status", wifi_manager_get_status());
 
-    // Modbus status
-    cJSON_AddBoolToObject(root, "modbus_ready", g_modbus != NULL);
+    wifi_connect_stats_t wifi_stats;
+    wifi_manager_get_connect_stats(&wifi_stats);
+    cJSON_AddNumberToObject(root, "wifi_connect_ms", wifi_stats.last_connect_ms);
+    cJSON_AddNumberToObject(root, "wifi_fast_connects", wifi_stats.fast_connects);
+    cJSON_AddNumberToObject(root, "wifi_fast_fallbacks", wifi_stats.fast_fallbacks);
+    cJSON_AddNumberToObject(root, "wifi_reconnects", wifi_stats.reconnects);
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
+    // Modbus status: ready once every configured bus is up
+    bool all_up;
+    cJSON_AddItemToObject(root, "buses", buses_json(&all_up));
+    cJSON_AddBoolToObject(root, "modbus_ready", all_up);
 
-    free(json_str);
-    cJSON_Delete(root);
+    return root;
+}
+
+static esp_err_t api_status_handler(httpd_req_t *req)
+{
+    send_json(req, status_json());
     return ESP_OK;
 }
 
-// GET /api/tasks - Get FreeRTOS task statistics
-static esp_err_t api_tasks_handler(httpd_req_t *req)
+/**
+ * @brief Task statistics of a CPU load sample (GET /api/tasks, "tasks" event)
+ */
+static cJSON *tasks_json(const cpu_load_t *load)
 {
     cJSON *root = cJSON_CreateObject();
-    
+
     // System overview
     cJSON_AddNumberToObject(root, "heap_free", esp_get_free_heap_size());
     cJSON_AddNumberToObject(root, "heap_min", esp_get_minimum_free_heap_size());
     cJSON_AddNumberToObject(root, "uptime_s", xTaskGetTickCount() / configTICK_RATE_HZ);
-    cJSON_AddNumberToObject(root, "task_count", uxTaskGetNumberOfTasks());
-    
-    // Get task statistics
-    UBaseType_t num_tasks = uxTaskGetNumberOfTasks();
-    TaskStatus_t *task_array = malloc(num_tasks * sizeof(TaskStatus_t));
-    
-    if (task_array == NULL) {
-        cJSON_AddStringToObject(root, "error", "Out of memory");
-        char *json_str = cJSON_PrintUnformatted(root);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_str, strlen(json_str));
-        free(json_str);
-        cJSON_Delete(root);
-        return ESP_OK;
+    cJSON_AddNumberToObject(root, "task_count", load->task_count);
+    cJSON_AddNumberToObject(root, "period_ms", load->period_ms);
+
+    // Core load, last interval and history (oldest first)
+    cJSON *cores = cJSON_CreateArray();
+    for (int core = 0; core < CPU_SAMPLER_CORES; core++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "core", core);
+        cJSON_AddNumberToObject(item, "load", load->core_load[core] / 10.0);
+
+        cJSON *history = cJSON_CreateArray();
+        for (int i = 0; i < load->history_len; i++) {
+            cJSON_AddItemToArray(history, cJSON_CreateNumber(load->core_history[i][core]));
+        }
+        cJSON_AddItemToObject(item, "history", history);
+        cJSON_AddItemToArray(cores, item);
     }
-    
-    configRUN_TIME_COUNTER_TYPE total_runtime;
-    UBaseType_t tasks_returned = uxTaskGetSystemState(task_array, num_tasks, &total_runtime);
-    
+    cJSON_AddItemToObject(root, "cores", cores);
+
     cJSON *tasks = cJSON_CreateArray();
-    
-    for (UBaseType_t i = 0; i < tasks_returned; i++) {
+    for (int i = 0; i < load->task_count; i++) {
+        const cpu_task_load_t *t = &load->tasks[i];
         cJSON *task = cJSON_CreateObject();
-        
-        cJSON_AddStringToObject(task, "name", task_array[i].pcTaskName);
-        cJSON_AddNumberToObject(task, "priority", task_array[i].uxCurrentPriority);
-        cJSON_AddNumberToObject(task, "stack_hwm", task_array[i].usStackHighWaterMark);
-        cJSON_AddNumberToObject(task, "task_num", task_array[i].xTaskNumber);
-        
-        // Task state
+
+        cJSON_AddStringToObject(task, "name", t->name);
+        cJSON_AddNumberToObject(task, "priority", t->priority);
+        cJSON_AddNumberToObject(task, "core", t->core);
+        cJSON_AddNumberToObject(task, "stack_hwm", t->stack_free);
+        cJSON_AddNumberToObject(task, "task_num", t->number);
+
         const char *state_str;
-        switch (task_array[i].eCurrentState) {
-            case eRunning:  state_str = "Running"; break;
-            case eReady:    state_str = "Ready"; break;
-            case eBlocked:  state_str = "Blocked"; break;
-            case eSuspended: state_str = "Suspended"; break;
-            case eDeleted:  state_str = "Deleted"; break;
-            default:        state_str = "Unknown"; break;
+        switch (t->state) {
+            case 'R': state_str = "Running"; break;
+            case 'r': state_str = "Ready"; break;
+            case 'B': state_str = "Blocked"; break;
+            case 'S': state_str = "Suspended"; break;
+            case 'D': state_str = "Deleted"; break;
+            default:  state_str = "Unknown"; break;
         }
         cJSON_AddStringToObject(task, "state", state_str);
-        
-        // CPU percentage (if runtime stats enabled)
-        if (total_runtime > 0) {
-            uint32_t cpu_percent = (uint32_t)((task_array[i].ulRunTimeCounter * 100) / total_runtime);
-            cJSON_AddNumberToObject(task, "cpu_percent", cpu_percent);
-            cJSON_AddNumberToObject(task, "runtime", (double)task_array[i].ulRunTimeCounter);
-        } else {
-            cJSON_AddNumberToObject(task, "cpu_percent", 0);
-            cJSON_AddNumberToObject(task, "runtime", 0);
-        }
-        
+
+        // Percent of one core: last interval, average and peak over the history
+        cJSON_AddNumberToObject(task, "cpu_percent", t->load / 10.0);
+        cJSON_AddNumberToObject(task, "cpu_avg", t->load_avg / 10.0);
+        cJSON_AddNumberToObject(task, "cpu_peak", t->load_peak / 10.0);
+        cJSON_AddNumberToObject(task, "runtime", (double)t->runtime_us);
+
         cJSON_AddItemToArray(tasks, task);
     }
-    
-    free(task_array);
-    
     cJSON_AddItemToObject(root, "tasks", tasks);
-    cJSON_AddNumberToObject(root, "total_runtime", total_runtime);
-    
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free(json_str);
-    cJSON_Delete(root);
-    
+
+    return root;
+}
+
+// GET /api/tasks - Get FreeRTOS task statistics (from the CPU load sampler)
+static esp_err_t api_tasks_handler(httpd_req_t *req)
+{
+    static cpu_load_t load;     // Only the web server task reads it; keeps it off the stack
+
+    if (cpu_sampler_get(&load) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "CPU load not sampled yet");
+        return ESP_FAIL;
+    }
+
+    send_json(req, tasks_json(&load));
+    return ESP_OK;
+}
+
+// GET /api/memory - Heap state per capability and allocations per subsystem
+static esp_err_t api_memory_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateObject();
+
+    cJSON *heaps = cJSON_AddArrayToObject(root, "heaps");
+    memprof_heap_stats_t heap;
+    esp_err_t ret;
+    for (int i = 0; (ret = memprof_get_heap_stats(i, &heap)) != ESP_ERR_NOT_FOUND; i++) {
+        if (ret != ESP_OK) {
+            continue;
+        }
+        cJSON *h = cJSON_CreateObject();
+        cJSON_AddStringToObject(h, "name", heap.name);
+        cJSON_AddNumberToObject(h, "total", heap.total);
+        cJSON_AddNumberToObject(h, "free", heap.free);
+        cJSON_AddNumberToObject(h, "min_free", heap.min_free);
+        cJSON_AddNumberToObject(h, "largest_free_block", heap.largest_free_block);
+        cJSON_AddNumberToObject(h, "fragmentation", heap.fragmentation);
+        cJSON_AddItemToArray(heaps, h);
+    }
+
+    // Subsystems by bytes in use, largest first
+    memprof_tag_stats_t tags[MEMPROF_TAG_COUNT];
+    for (int i = 0; i < MEMPROF_TAG_COUNT; i++) {
+        memprof_get_tag_stats(i, &tags[i]);
+        for (int j = i; j > 0 && tags[j].bytes > tags[j - 1].bytes; j--) {
+            memprof_tag_stats_t tmp = tags[j];
+            tags[j] = tags[j - 1];
+            tags[j - 1] = tmp;
+        }
+    }
+
+    uint32_t tracked = 0;
+    cJSON *allocators = cJSON_AddArrayToObject(root, "allocators");
+    for (int i = 0; i < MEMPROF_TAG_COUNT; i++) {
+        cJSON *t = cJSON_CreateObject();
+        cJSON_AddStringToObject(t, "tag", tags[i].name);
+        cJSON_AddNumberToObject(t, "bytes", tags[i].bytes);
+        cJSON_AddNumberToObject(t, "peak_bytes", tags[i].peak_bytes);
+        cJSON_AddNumberToObject(t, "blocks", tags[i].blocks);
+        cJSON_AddNumberToObject(t, "allocs", tags[i].allocs);
+        cJSON_AddNumberToObject(t, "failures", tags[i].failures);
+        cJSON_AddItemToArray(allocators, t);
+        tracked += tags[i].bytes;
+    }
+
+    uint32_t total = heap_caps_get_total_size(MALLOC_CAP_DEFAULT);
+    uint32_t used = total - esp_get_free_heap_size();
+    cJSON_AddNumberToObject(root, "tracked_bytes", tracked);
+    cJSON_AddNumberToObject(root, "untracked_bytes", used > tracked ? used - tracked : 0);
+
+    // Usage of this request is included: the handler runs in the arena
+    arena_stats_t arena;
+    arena_get_stats(s_req_arena, &arena);
+    cJSON *a = cJSON_AddObjectToObject(root, "request_arena");
+    cJSON_AddNumberToObject(a, "size", arena.size);
+    cJSON_AddNumberToObject(a, "used", arena.used);
+    cJSON_AddNumberToObject(a, "high_water", arena.high_water);
+    cJSON_AddNumberToObject(a, "requests", arena.resets);
+    cJSON_AddNumberToObject(a, "allocs", arena.allocs);
+    cJSON_AddNumberToObject(a, "overflows", arena.overflows);
+    cJSON_AddNumberToObject(a, "overflow_bytes", arena.overflow_bytes);
+
+    send_json(req, root);
+    return ESP_OK;
+}
+
+// GET /api/boot - Start and end of every boot phase (ms since reset)
+static esp_err_t api_boot_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateObject();
+
+    int64_t start_us, end_us;
+    boot_get_times(&start_us, &end_us);
+    cJSON_AddNumberToObject(root, "start_ms", start_us / 1000.0);
+    if (end_us > 0) {
+        cJSON_AddNumberToObject(root, "ready_ms", end_us / 1000.0);
+    } else {
+        cJSON_AddNullToObject(root, "ready_ms");
+    }
+
+    cJSON *phases = cJSON_AddArrayToObject(root, "phases");
+    boot_phase_info_t info;
+    for (size_t i = 0; boot_get_phase(i, &info) == ESP_OK; i++) {
+        cJSON *p = cJSON_CreateObject();
+        cJSON_AddStringToObject(p, "name", info.name);
+        cJSON_AddStringToObject(p, "state", boot_state_name(info.state));
+
+        cJSON *deps = cJSON_AddArrayToObject(p, "deps");
+        boot_phase_info_t dep;
+        for (size_t d = 0; boot_get_phase(d, &dep) == ESP_OK; d++) {
+            if (info.deps & BOOT_DEP(d)) {
+                cJSON_AddItemToArray(deps, cJSON_CreateString(dep.name));
+            }
+        }
+
+        if (info.start_us > 0) {
+            cJSON_AddNumberToObject(p, "start_ms", info.start_us / 1000.0);
+        }
+        if (info.end_us > 0) {
+            cJSON_AddNumberToObject(p, "end_ms", info.end_us / 1000.0);
+            if (info.start_us > 0) {
+                cJSON_AddNumberToObject(p, "duration_ms", (info.end_us - info.start_us) / 1000.0);
+            }
+        }
+        if (info.result != ESP_OK) {
+            cJSON_AddStringToObject(p, "error", esp_err_to_name(info.result));
+        }
+        cJSON_AddItemToArray(phases, p);
+    }
+
+    send_json(req, root);
     return ESP_OK;
 }
 
@@ -957,32 +1757,45 @@ static esp_err_t api_tasks_handler(httpd_req_t *req)
 // API Handlers - WiFi
 // ============================================================================
 
+// GET /api/wifi/scan[?refresh=1] - Cached scan results, never waits for a scan
 static esp_err_t api_wifi_scan_handler(httpd_req_t *req)
 {
-    wifi_scan_result_t results[20];
+    static wifi_scan_result_t results[20];  // Only the web server task reads it
     uint16_t found = 0;
+    uint32_t age_ms = 0;
 
-    esp_err_t ret = wifi_manager_scan(results, 20, &found);
-    if (ret != ESP_OK) {
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
+    bool refresh = false;
+    char query[32];
+    char value[4];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "refresh", value, sizeof(value)) == ESP_OK) {
+        refresh = strcmp(value, "1") == 0;
+    }
+
+    esp_err_t ret = wifi_manager_get_scan_results(results, 20, &found, &age_ms);
+    if (refresh || ret != ESP_OK || age_ms > CONFIG_WIFI_SCAN_MAX_AGE_S * 1000) {
+        // Coalesced with a scan already running; the client polls for the results
+        wifi_manager_scan_start();
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "scanning", wifi_manager_is_scanning());
+    if (ret == ESP_OK) {
+        cJSON_AddNumberToObject(root, "age_ms", age_ms);
+    } else {
+        cJSON_AddNullToObject(root, "age_ms");
     }
 
-    cJSON *root = cJSON_CreateArray();
+    cJSON *networks = cJSON_AddArrayToObject(root, "networks");
     for (int i = 0; i < found; i++) {
         cJSON *net = cJSON_CreateObject();
         cJSON_AddStringToObject(net, "ssid", results[i].ssid);
         cJSON_AddNumberToObject(net, "rssi", results[i].rssi);
         cJSON_AddNumberToObject(net, "auth", results[i].authmode);
-        cJSON_AddItemToArray(root, net);
+        cJSON_AddItemToArray(networks, net);
     }
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
     return ESP_OK;
 }
 
@@ -1028,12 +1841,7 @@ static esp_err_t api_wifi_connect_handler(httpd_req_t *req)
     cJSON_AddBoolToObject(response, "success", err == ESP_OK);
     cJSON_AddStringToObject(response, "message", err == ESP_OK ? "Connected" : "Failed to connect");
 
-    char *json_str = cJSON_PrintUnformatted(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(response);
+    send_json(req, response);
     cJSON_Delete(root);
     return ESP_OK;
 }
@@ -1053,12 +1861,7 @@ static esp_err_t api_wifi_status_handler(httpd_req_t *req)
     cJSON_AddNumberToObject(root, "status", wifi_manager_get_status());
     cJSON_AddBoolToObject(root, "connected", wifi_manager_is_connected());
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
     return ESP_OK;
 }
 
@@ -1066,162 +1869,170 @@ static esp_err_t api_wifi_status_handler(httpd_req_t *req)
 // API Handlers - Actuator Control (mightyZAP) - Multi-actuator support
 // ============================================================================
 
-#define MAX_ACTUATORS 10
+/**
+ * @brief Get the optional "bus" field of a request (default: first bus)
+ *
+ * @return bool false if the field is present but not a bus that is up
+ */
+static bool get_request_bus(const cJSON *root, uint8_t *bus)
+{
+    const cJSON *bus_json = cJSON_GetObjectItem(root, "bus");
+    if (bus_json == NULL) {
+        *bus = 0;
+        return true;
+    }
+    if (!cJSON_IsNumber(bus_json) || bus_json->valuedouble < 0 ||
+        bus_json->valuedouble >= bus_manager_count() || bus_json->valuedouble != bus_json->valueint ||
+        !bus_manager_is_up(bus_json->valueint)) {
+        return false;
+    }
+    *bus = bus_json->valueint;
+    return true;
+}
 
-// Structure to hold multiple actuator handles
-typedef struct {
-    uint8_t id;
-    mightyzap_handle_t handle;
-    bool active;
-} actuator_slot_t;
+/**
+ * @brief Reply 400 to a request whose "bus" field is invalid or down
+ */
+static esp_err_t send_bad_bus(httpd_req_t *req, cJSON *root)
+{
+    cJSON_Delete(root);
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid or down bus");
+    return ESP_FAIL;
+}
 
-static actuator_slot_t s_actuators[MAX_ACTUATORS] = {0};
-static uint8_t s_num_actuators = 0;
+/**
+ * @brief Cached state of every registered actuator (GET /api/actuator/status, "actuators" event)
+ */
+static cJSON *actuators_json(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *actuators = cJSON_CreateArray();
+    int64_t now_us = esp_timer_get_time();
 
-// Helper: Find actuator by ID
-static actuator_slot_t* find_actuator(uint8_t id) {
-    for (int i = 0; i < MAX_ACTUATORS; i++) {
-        if (s_actuators[i].active && s_actuators[i].id == id) {
-            return &s_actuators[i];
-        }
-    }
-    return NULL;
-}
+    actuator_registry_lock();
+    uint8_t count = actuator_registry_count();
 
-// Helper: Add actuator
-static esp_err_t add_actuator(uint8_t id) {
-    if (find_actuator(id) != NULL) return ESP_OK; // Already exists
-    if (g_modbus == NULL) return ESP_ERR_INVALID_STATE;
+    for (uint8_t slot = 0; slot < count; slot++) {
+        actuator_state_t state;
+        actuator_registry_get_state(slot, &state);
 
-    for (int i = 0; i < MAX_ACTUATORS; i++) {
-        if (!s_actuators[i].active) {
-            mightyzap_handle_t handle = NULL;
-            esp_err_t ret = mightyzap_init(g_modbus, id, &handle);
-            if (ret == ESP_OK) {
-                s_actuators[i].id = id;
-                s_actuators[i].handle = handle;
-                s_actuators[i].active = true;
-                s_num_actuators++;
-                return ESP_OK;
-            }
-            return ret;
-        }
-    }
-    return ESP_ERR_NO_MEM;
-}
+        cJSON *act = cJSON_CreateObject();
+        cJSON_AddNumberToObject(act, "bus", state.bus);
+        cJSON_AddNumberToObject(act, "id", state.id);
 
-// Helper: Remove actuator
-static void remove_actuator(uint8_t id) {
-    for (int i = 0; i < MAX_ACTUATORS; i++) {
-        if (s_actuators[i].active && s_actuators[i].id == id) {
-            if (s_actuators[i].handle) {
-                mightyzap_deinit(s_actuators[i].handle);
+        // Add actuator name (or default if not set)
+        const char *name = config_get_actuator_name(state.bus, state.id);
+        if (name && strlen(name) > 0) {
+            cJSON_AddStringToObject(act, "name", name);
+        } else {
+            char default_name[32];
+            if (state.bus > 0) {
+                snprintf(default_name, sizeof(default_name), "Actuator #%d:%d", state.bus, state.id);
+            } else {
+                snprintf(default_name, sizeof(default_name), "Actuator #%d", state.id);
             }
-            s_actuators[i].active = false;
-            s_actuators[i].handle = NULL;
-            s_num_actuators--;
-            break;
+            cJSON_AddStringToObject(act, "name", default_name);
         }
-    }
-}
 
-// Helper: Load saved actuators from config on startup
-static void load_saved_actuators(void) {
-    uint8_t count = config_get_saved_actuator_count();
-    if (count == 0) {
-        ESP_LOGI(TAG, "No saved actuators to load");
-        return;
-    }
-
-    const uint8_t *ids = config_get_saved_actuator_ids();
-    if (ids == NULL) {
-        ESP_LOGW(TAG, "Failed to get saved actuator IDs");
-        return;
-    }
+        if (state.connected) {
+            cJSON_AddBoolToObject(act, "connected", true);
+            cJSON_AddNumberToObject(act, "position", state.position);
+            cJSON_AddNumberToObject(act, "current", state.current);
+            cJSON_AddNumberToObject(act, "voltage", state.voltage / 10.0);
+            cJSON_AddBoolToObject(act, "moving", state.moving != 0);
+        } else {
+            cJSON_AddBoolToObject(act, "connected", false);
+        }
 
-    ESP_LOGI(TAG, "Loading %d saved actuators from config", count);
+        if (state.updated_us > 0) {
+            cJSON_AddNumberToObject(act, "age_ms", (now_us - state.updated_us) / 1000);
+        }
+        if (state.hw_error != 0) {
+            cJSON_AddNumberToObject(act, "hw_error", state.hw_error);
+        }
+        cJSON_AddStringToObject(act, "health", actuator_health_name(state.health));
+        cJSON_AddNumberToObject(act, "failures", state.failures);
+        if (state.health == ACTUATOR_QUARANTINED) {
+            int64_t wait_us = state.next_probe_us - now_us;
+            cJSON_AddNumberToObject(act, "next_probe_ms", wait_us > 0 ? wait_us / 1000 : 0);
+        }
 
-    int loaded = 0;
-    for (uint8_t i = 0; i < count; i++) {
-        uint8_t id = ids[i];
-        esp_err_t ret = add_actuator(id);
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "Loaded saved actuator ID %d", id);
-            loaded++;
-        } else {
-            ESP_LOGW(TAG, "Failed to load actuator ID %d: %s", id, esp_err_to_name(ret));
+        modbus_slave_timing_t timing;
+        if (modbus_get_slave_timing(bus_manager_get_modbus(state.bus), state.id, &timing) == ESP_OK) {
+            cJSON_AddNumberToObject(act, "rtt_us", timing.srtt_us);
+            cJSON_AddNumberToObject(act, "timeout_us", timing.timeout_us);
         }
+        cJSON_AddItemToArray(actuators, act);
     }
+    actuator_registry_unlock();
 
-    ESP_LOGI(TAG, "Loaded %d of %d saved actuators", loaded, count);
+    cJSON_AddItemToObject(root, "actuators", actuators);
+    cJSON_AddNumberToObject(root, "count", count);
+
+    return root;
 }
 
 // GET /api/actuator/status - Get status of all active actuators
 static esp_err_t api_actuator_status_handler(httpd_req_t *req)
 {
-    cJSON *root = cJSON_CreateObject();
-    cJSON *actuators = cJSON_CreateArray();
-
-    for (int i = 0; i < MAX_ACTUATORS; i++) {
-        if (s_actuators[i].active && s_actuators[i].handle) {
-            cJSON *act = cJSON_CreateObject();
-            cJSON_AddNumberToObject(act, "id", s_actuators[i].id);
-
-            // Add actuator name (or default if not set)
-            const char *name = config_get_actuator_name(s_actuators[i].id);
-            if (name && strlen(name) > 0) {
-                cJSON_AddStringToObject(act, "name", name);
-            } else {
-                char default_name[32];
-                snprintf(default_name, sizeof(default_name), "Actuator #%d", s_actuators[i].id);
-                cJSON_AddStringToObject(act, "name", default_name);
-            }
-
-            mightyzap_status_t status;
-            esp_err_t ret = mightyzap_get_status(s_actuators[i].handle, &status);
+    TRACE_BEGIN("api_actuator_status");
+
+    // Serve from the poller's cache; read on demand if it is not running.
+    // Quarantined actuators are skipped until their next probe.
+    if (!actuator_poller_is_running()) {
+        uint8_t buses[ACTUATOR_REGISTRY_MAX];
+        uint8_t ids[ACTUATOR_REGISTRY_MAX];
+
+        // Bus reads must not hold the registry lock
+        actuator_registry_lock();
+        uint8_t n = actuator_registry_count();
+        for (uint8_t slot = 0; slot < n; slot++) {
+            buses[slot] = actuator_registry_bus_at(slot);
+            ids[slot] = actuator_registry_id_at(slot);
+        }
+        actuator_registry_unlock();
 
-            if (ret == ESP_OK) {
-                cJSON_AddBoolToObject(act, "connected", true);
-                cJSON_AddNumberToObject(act, "position", status.position);
-                cJSON_AddNumberToObject(act, "current", status.current);
-                cJSON_AddNumberToObject(act, "voltage", status.voltage / 10.0);
-                cJSON_AddBoolToObject(act, "moving", status.moving != 0);
-            } else {
-                cJSON_AddBoolToObject(act, "connected", false);
-            }
-            cJSON_AddItemToArray(actuators, act);
+        for (uint8_t i = 0; i < n; i++) {
+            actuator_registry_refresh(buses[i], ids[i]);
         }
     }
 
-    cJSON_AddItemToObject(root, "actuators", actuators);
-    cJSON_AddNumberToObject(root, "count", s_num_actuators);
+    cJSON *root = actuators_json();
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
+    TRACE_BEGIN("http_send");
+    esp_err_t ret = send_json(req, root);
+    TRACE_END("http_send");
 
-    free(json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
+    TRACE_END("api_actuator_status");
+    return ret;
 }
 
 // POST /api/actuator/control - Control specific actuator by ID
 static esp_err_t api_actuator_control_handler(httpd_req_t *req)
 {
     char buf[256];
+    TRACE_BEGIN("http_recv");
     int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    TRACE_END("http_recv");
     if (ret <= 0) {
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
     buf[ret] = '\0';
 
+    TRACE_BEGIN("json_parse");
     cJSON *root = cJSON_Parse(buf);
+    TRACE_END("json_parse");
     if (root == NULL) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
 
+    uint8_t bus;
+    if (!get_request_bus(root, &bus)) {
+        return send_bad_bus(req, root);
+    }
+
     cJSON *response = cJSON_CreateObject();
     esp_err_t err = ESP_FAIL;
 
@@ -1234,16 +2045,20 @@ static esp_err_t api_actuator_control_handler(httpd_req_t *req)
     }
 
     uint8_t act_id = id_json->valueint;
-    actuator_slot_t *slot = find_actuator(act_id);
 
-    if (slot == NULL || slot->handle == NULL) {
+    // The bus lock keeps the handle valid for the whole command sequence
+    TRACE_BEGIN("actuator_command");
+    bus_manager_lock(bus);
+    mightyzap_handle_t handle = actuator_registry_get(bus, act_id);
+
+    if (handle == NULL) {
+        bus_manager_unlock(bus);
+        TRACE_END("actuator_command");
         cJSON_AddBoolToObject(response, "success", false);
         cJSON_AddStringToObject(response, "message", "Actuator not found");
         goto send_response;
     }
 
-    mightyzap_handle_t handle = slot->handle;
-
     // Check for force enable/disable
     cJSON *force_enable = cJSON_GetObjectItem(root, "force");
     if (cJSON_IsBool(force_enable)) {
@@ -1291,83 +2106,120 @@ static esp_err_t api_actuator_control_handler(httpd_req_t *req)
                                      g_cur->valueint);
         }
     }
+    bus_manager_unlock(bus);
+    TRACE_END("actuator_command");
+
+    // Follow the motion at the fast poll rate
+    if (err == ESP_OK && (cJSON_IsNumber(position) || cJSON_IsObject(goal))) {
+        actuator_poller_kick(bus, act_id);
+    }
 
     cJSON_AddBoolToObject(response, "success", err == ESP_OK);
     cJSON_AddStringToObject(response, "message", err == ESP_OK ? "OK" : "Command failed");
 
 send_response:
-    {
-        char *json_str = cJSON_PrintUnformatted(response);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_str, strlen(json_str));
-        free(json_str);
-    }
-
-    cJSON_Delete(response);
+    send_json(req, response);
     cJSON_Delete(root);
     return ESP_OK;
 }
 
+/**
+ * @brief Actuators found on one bus by a scan
+ */
+typedef struct {
+    uint8_t max_id;
+    uint8_t count[BUS_MAX];
+    uint8_t id[BUS_MAX][ACTUATOR_ID_MAX];
+    uint16_t model[BUS_MAX][ACTUATOR_ID_MAX];
+} scan_result_t;
+
+/**
+ * @brief Scan one bus for mightyZAP actuators (bus_manager_run_parallel() job)
+ */
+static void scan_bus(uint8_t bus, void *arg)
+{
+    scan_result_t *result = arg;
+    modbus_handle_t modbus = bus_manager_get_modbus(bus);
+
+    for (uint8_t id = 1; id <= result->max_id; id++) {
+        uint16_t model = 0;
+        esp_err_t ret = modbus_read_holding_registers(modbus, id,
+                                                       MZAP_REG_MODEL_NUMBER, 1, &model);
+        // mightyZAP models are typically > 100 (e.g., 350, 500, etc.)
+        if (ret == ESP_OK && model > 100) {
+            ESP_LOGI(TAG, "Found actuator at %d:%d, model: %u", bus, id, model);
+            uint8_t n = result->count[bus]++;
+            result->id[bus][n] = id;
+            result->model[bus][n] = model;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
 // GET /api/actuator/scan - Scan for actuators and auto-add them
 static esp_err_t api_actuator_scan_handler(httpd_req_t *req)
 {
     cJSON *root = cJSON_CreateObject();
     cJSON *found = cJSON_CreateArray();
 
-    if (g_modbus == NULL) {
+    bool any_up = false;
+    for (uint8_t bus = 0; bus < bus_manager_count(); bus++) {
+        any_up |= bus_manager_is_up(bus);
+    }
+
+    scan_result_t *result = any_up ? memprof_calloc(MEMPROF_TAG_HTTP, 1, sizeof(scan_result_t)) : NULL;
+    if (result == NULL) {
         cJSON_AddItemToObject(root, "found", found);
         cJSON_AddNumberToObject(root, "count", 0);
         cJSON_AddStringToObject(root, "error", "Modbus not initialized");
 
-        char *json_str = cJSON_PrintUnformatted(root);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_str, strlen(json_str));
-        free(json_str);
-        cJSON_Delete(root);
+        send_json(req, root);
         return ESP_OK;
     }
 
     uint8_t max_id = config_get_scan_max_id();
     if (max_id < 1) max_id = 1;
     if (max_id > 247) max_id = 247;
+    result->max_id = max_id;
 
-    ESP_LOGI(TAG, "Scanning for mightyZAP actuators (IDs 1-%d)...", max_id);
+    ESP_LOGI(TAG, "Scanning for mightyZAP actuators (IDs 1-%d) on %d buses...",
+             max_id, bus_manager_count());
 
     // Suppress timeout warnings during scan
-    esp_log_level_set("RS485", ESP_LOG_ERROR);
-    esp_log_level_set("MODBUS", ESP_LOG_ERROR);
+    dlog_level_set("RS485", ESP_LOG_ERROR);
+    dlog_level_set("MODBUS", ESP_LOG_ERROR);
+
+    // Buses are scanned at the same time
+    bus_manager_run_parallel(scan_bus, result);
+
+    // Restore log levels
+    dlog_level_set("RS485", ESP_LOG_WARN);
+    dlog_level_set("MODBUS", ESP_LOG_WARN);
 
     int count = 0;
     bool config_changed = false;
-    for (uint8_t id = 1; id <= max_id; id++) {
-        uint16_t model = 0;
-        esp_err_t ret = modbus_read_holding_registers(g_modbus, id,
-                                                       MZAP_REG_MODEL_NUMBER, 1, &model);
-        // mightyZAP models are typically > 100 (e.g., 350, 500, etc.)
-        if (ret == ESP_OK && model > 100) {
-            ESP_LOGI(TAG, "Found actuator at ID %d, model: %u", id, model);
+    for (uint8_t bus = 0; bus < BUS_MAX; bus++) {
+        for (uint8_t i = 0; i < result->count[bus]; i++) {
+            uint8_t id = result->id[bus][i];
 
             // Auto-add to active actuators
-            add_actuator(id);
+            actuator_registry_add(bus, id);
 
             // Persist to config (idempotent - won't duplicate)
-            if (config_add_saved_actuator_id(id)) {
-                ESP_LOGI(TAG, "Persisted actuator ID %d to config", id);
+            if (config_add_saved_actuator_id(bus, id)) {
+                ESP_LOGI(TAG, "Persisted actuator %d:%d to config", bus, id);
                 config_changed = true;
             }
 
             cJSON *item = cJSON_CreateObject();
+            cJSON_AddNumberToObject(item, "bus", bus);
             cJSON_AddNumberToObject(item, "id", id);
-            cJSON_AddNumberToObject(item, "model", model);
+            cJSON_AddNumberToObject(item, "model", result->model[bus][i]);
             cJSON_AddItemToArray(found, item);
             count++;
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
-
-    // Restore log levels
-    esp_log_level_set("RS485", ESP_LOG_WARN);
-    esp_log_level_set("MODBUS", ESP_LOG_WARN);
+    memprof_free(MEMPROF_TAG_HTTP, result);
 
     // Save config if any new actuators were persisted
     if (config_changed) {
@@ -1378,12 +2230,7 @@ static esp_err_t api_actuator_scan_handler(httpd_req_t *req)
     cJSON_AddItemToObject(root, "found", found);
     cJSON_AddNumberToObject(root, "count", count);
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
     return ESP_OK;
 }
 
@@ -1404,6 +2251,11 @@ static esp_err_t api_actuator_add_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    uint8_t bus;
+    if (!get_request_bus(root, &bus)) {
+        return send_bad_bus(req, root);
+    }
+
     cJSON *id_json = cJSON_GetObjectItem(root, "id");
     cJSON *response = cJSON_CreateObject();
 
@@ -1412,12 +2264,13 @@ static esp_err_t api_actuator_add_handler(httpd_req_t *req)
         cJSON_AddStringToObject(response, "message", "Invalid ID (1-247)");
     } else {
         uint8_t new_id = id_json->valueint;
-        esp_err_t err = add_actuator(new_id);
+        esp_err_t err = actuator_registry_add(bus, new_id);
 
         if (err == ESP_OK) {
-            ESP_LOGI(TAG, "Actuator added with ID %d", new_id);
+            ESP_LOGI(TAG, "Actuator added at %d:%d", bus, new_id);
             cJSON_AddBoolToObject(response, "success", true);
             cJSON_AddStringToObject(response, "message", "Actuator added");
+            cJSON_AddNumberToObject(response, "bus", bus);
             cJSON_AddNumberToObject(response, "id", new_id);
         } else {
             cJSON_AddBoolToObject(response, "success", false);
@@ -1425,12 +2278,7 @@ static esp_err_t api_actuator_add_handler(httpd_req_t *req)
         }
     }
 
-    char *json_str = cJSON_PrintUnformatted(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(response);
+    send_json(req, response);
     cJSON_Delete(root);
     return ESP_OK;
 }
@@ -1452,6 +2300,11 @@ static esp_err_t api_actuator_remove_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    uint8_t bus;
+    if (!get_request_bus(root, &bus)) {
+        return send_bad_bus(req, root);
+    }
+
     cJSON *id_json = cJSON_GetObjectItem(root, "id");
     cJSON *response = cJSON_CreateObject();
 
@@ -1460,25 +2313,20 @@ static esp_err_t api_actuator_remove_handler(httpd_req_t *req)
         cJSON_AddStringToObject(response, "message", "Invalid ID");
     } else {
         uint8_t id = id_json->valueint;
-        remove_actuator(id);
+        actuator_registry_remove(bus, id);
 
         // Also remove from persisted config
-        if (config_remove_saved_actuator_id(id)) {
+        if (config_remove_saved_actuator_id(bus, id)) {
             config_save();
-            ESP_LOGI(TAG, "Actuator removed from config: ID %d", id);
+            ESP_LOGI(TAG, "Actuator removed from config: %d:%d", bus, id);
         }
 
-        ESP_LOGI(TAG, "Actuator removed: ID %d", id);
+        ESP_LOGI(TAG, "Actuator removed: %d:%d", bus, id);
         cJSON_AddBoolToObject(response, "success", true);
         cJSON_AddStringToObject(response, "message", "Actuator removed");
     }
 
-    char *json_str = cJSON_PrintUnformatted(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(response);
+    send_json(req, response);
     cJSON_Delete(root);
     return ESP_OK;
 }
@@ -1500,6 +2348,11 @@ static esp_err_t api_actuator_set_name_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    uint8_t bus;
+    if (!get_request_bus(root, &bus)) {
+        return send_bad_bus(req, root);
+    }
+
     cJSON *id_json = cJSON_GetObjectItem(root, "id");
     cJSON *name_json = cJSON_GetObjectItem(root, "name");
     cJSON *response = cJSON_CreateObject();
@@ -1515,14 +2368,15 @@ static esp_err_t api_actuator_set_name_handler(httpd_req_t *req)
         const char *name = name_json->valuestring;
 
         // Set the actuator name
-        bool success = config_set_actuator_name(id, name);
+        bool success = config_set_actuator_name(bus, id, name);
 
         if (success) {
             // Persist to config
             config_save();
-            ESP_LOGI(TAG, "Actuator name set: ID %d -> '%s'", id, name);
+            ESP_LOGI(TAG, "Actuator name set: %d:%d -> '%s'", bus, id, name);
             cJSON_AddBoolToObject(response, "success", true);
             cJSON_AddStringToObject(response, "message", "Name set successfully");
+            cJSON_AddNumberToObject(response, "bus", bus);
             cJSON_AddNumberToObject(response, "id", id);
             cJSON_AddStringToObject(response, "name", name);
         } else {
@@ -1531,44 +2385,262 @@ static esp_err_t api_actuator_set_name_handler(httpd_req_t *req)
         }
     }
 
-    char *json_str = cJSON_PrintUnformatted(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(response);
+    send_json(req, response);
     cJSON_Delete(root);
     return ESP_OK;
 }
 
 // ============================================================================
-// API Handlers - RS485 Configuration
+// API Handlers - Batch
 // ============================================================================
 
-static esp_err_t api_rs485_config_handler(httpd_req_t *req)
+#define BATCH_BODY_MAX      4096
+
+static const char *const s_batch_types[] = {
+    [ACTUATOR_BATCH_CONTROL] = "control",
+    [ACTUATOR_BATCH_STATUS] = "status",
+    [ACTUATOR_BATCH_READ] = "read",
+    [ACTUATOR_BATCH_WRITE] = "write",
+};
+
+static const char *const s_batch_status[] = {
+    [ACTUATOR_BATCH_PENDING] = "pending",
+    [ACTUATOR_BATCH_DONE] = "done",
+    [ACTUATOR_BATCH_FAILED] = "failed",
+    [ACTUATOR_BATCH_SKIPPED] = "skipped",
+};
+
+/**
+ * @brief Read an optional integer field in 0..max
+ *
+ * @return int 1 if present and valid, 0 if absent, -1 if invalid
+ */
+static int json_get_uint(const cJSON *obj, const char *key, int max, int *value)
 {
-    if (req->method == HTTP_GET) {
-        cJSON *root = cJSON_CreateObject();
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    if (item == NULL) {
+        return 0;
+    }
+    if (!cJSON_IsNumber(item) || item->valuedouble < 0 || item->valuedouble > max) {
+        return -1;
+    }
+    *value = item->valueint;
+    return 1;
+}
 
-        cJSON_AddNumberToObject(root, "baud_rate", config_get_rs485_baud());
-        cJSON_AddNumberToObject(root, "tx_pin", config_get_rs485_tx_pin());
-        cJSON_AddNumberToObject(root, "rx_pin", config_get_rs485_rx_pin());
-        cJSON_AddNumberToObject(root, "de_pin", config_get_rs485_de_pin());
-        cJSON_AddNumberToObject(root, "slave_id", config_get_modbus_slave_id());
+/**
+ * @brief Fill an operation from its JSON object (ranges are checked by actuator_batch_validate())
+ */
+static bool parse_batch_op(const cJSON *item, actuator_batch_op_t *op)
+{
+    const cJSON *type = cJSON_GetObjectItem(item, "op");
+    if (!cJSON_IsString(type)) {
+        return false;
+    }
+    size_t t = 0;
+    while (t < sizeof(s_batch_types) / sizeof(s_batch_types[0]) &&
+           strcmp(type->valuestring, s_batch_types[t]) != 0) {
+        t++;
+    }
+    if (t == sizeof(s_batch_types) / sizeof(s_batch_types[0])) {
+        return false;
+    }
+    op->type = (actuator_batch_type_t)t;
 
-        char *json_str = cJSON_PrintUnformatted(root);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_str, strlen(json_str));
+    int bus = 0, id = 0, value = 0;
+    if (json_get_uint(item, "bus", UINT8_MAX, &bus) < 0 || json_get_uint(item, "id", UINT8_MAX, &id) != 1) {
+        return false;
+    }
+    op->bus = bus;
+    op->id = id;
 
-        free(json_str);
-        cJSON_Delete(root);
-    } else {
-        // POST - update config
-        char buf[256];
-        int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
-        if (ret <= 0) {
-            httpd_resp_send_500(req);
-            return ESP_FAIL;
+    if (op->type == ACTUATOR_BATCH_STATUS) {
+        return true;
+    }
+
+    if (op->type == ACTUATOR_BATCH_CONTROL) {
+        const cJSON *force = cJSON_GetObjectItem(item, "force");
+        if (cJSON_IsBool(force)) {
+            op->set |= ACTUATOR_BATCH_SET_FORCE;
+            op->force = cJSON_IsTrue(force);
+        }
+        static const struct { const char *key; uint8_t flag; size_t offset; } fields[] = {
+            { "position", ACTUATOR_BATCH_SET_POSITION, offsetof(actuator_batch_op_t, position) },
+            { "speed",    ACTUATOR_BATCH_SET_SPEED,    offsetof(actuator_batch_op_t, speed) },
+            { "current",  ACTUATOR_BATCH_SET_CURRENT,  offsetof(actuator_batch_op_t, current) },
+        };
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            int found = json_get_uint(item, fields[i].key, UINT16_MAX, &value);
+            if (found < 0) {
+                return false;
+            }
+            if (found) {
+                op->set |= fields[i].flag;
+                *(uint16_t *)((uint8_t *)op + fields[i].offset) = value;
+            }
+        }
+        return true;
+    }
+
+    // Register operations
+    if (json_get_uint(item, "reg", UINT16_MAX, &value) != 1) {
+        return false;
+    }
+    op->reg = value;
+
+    if (op->type == ACTUATOR_BATCH_READ) {
+        int found = json_get_uint(item, "count", UINT8_MAX, &value);
+        op->count = found ? value : 1;
+        return found >= 0;
+    }
+
+    const cJSON *values = cJSON_GetObjectItem(item, "values");
+    if (!cJSON_IsArray(values) || cJSON_GetArraySize(values) > ACTUATOR_BATCH_MAX_REGS) {
+        return false;
+    }
+    const cJSON *v;
+    cJSON_ArrayForEach(v, values) {
+        if (!cJSON_IsNumber(v) || v->valuedouble < 0 || v->valuedouble > UINT16_MAX) {
+            return false;
+        }
+        op->values[op->count++] = v->valueint;
+    }
+    return true;
+}
+
+static cJSON *batch_result_json(const actuator_batch_op_t *op)
+{
+    cJSON *result = cJSON_CreateObject();
+    cJSON_AddStringToObject(result, "status", s_batch_status[op->status]);
+    if (op->status == ACTUATOR_BATCH_FAILED) {
+        cJSON_AddStringToObject(result, "error", esp_err_to_name(op->err));
+    }
+    if (op->status != ACTUATOR_BATCH_DONE) {
+        return result;
+    }
+
+    if (op->type == ACTUATOR_BATCH_READ) {
+        cJSON *values = cJSON_AddArrayToObject(result, "values");
+        for (int i = 0; i < op->count; i++) {
+            cJSON_AddItemToArray(values, cJSON_CreateNumber(op->values[i]));
+        }
+    } else if (op->type == ACTUATOR_BATCH_STATUS) {
+        // Registers 0x37-0x3C
+        cJSON_AddNumberToObject(result, "position", op->values[0]);
+        cJSON_AddNumberToObject(result, "current", op->values[1]);
+        cJSON_AddNumberToObject(result, "motor_op", op->values[2]);
+        cJSON_AddNumberToObject(result, "voltage", op->values[3]);
+        cJSON_AddBoolToObject(result, "moving", op->values[4] != 0);
+        cJSON_AddNumberToObject(result, "hw_error", op->values[5]);
+    }
+    return result;
+}
+
+// POST /api/batch - Run many actuator operations in one request
+// Body: {"ops": [{"op": "control"|"status"|"read"|"write", "bus": 0, "id": 1, ...}], "stop_on_error": false}
+static esp_err_t api_batch_handler(httpd_req_t *req)
+{
+    if (req->content_len == 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No data");
+        return ESP_FAIL;
+    }
+
+    char *buf = memprof_malloc(MEMPROF_TAG_HTTP, req->content_len + 1);
+    if (buf == NULL) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, buf + received, req->content_len - received);
+        if (ret <= 0) {
+            memprof_free(MEMPROF_TAG_HTTP, buf);
+            httpd_resp_send_500(req);
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+    buf[received] = '\0';
+
+    cJSON *root = cJSON_Parse(buf);
+    memprof_free(MEMPROF_TAG_HTTP, buf);
+    const cJSON *ops_json = cJSON_GetObjectItem(root, "ops");
+    int count = cJSON_GetArraySize(ops_json);
+    if (!cJSON_IsArray(ops_json) || count < 1 || count > ACTUATOR_BATCH_MAX_OPS) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Expected 1-" STR(ACTUATOR_BATCH_MAX_OPS) " ops");
+        return ESP_FAIL;
+    }
+    bool stop_on_error = cJSON_IsTrue(cJSON_GetObjectItem(root, "stop_on_error"));
+
+    actuator_batch_op_t *ops = memprof_calloc(MEMPROF_TAG_HTTP, count, sizeof(actuator_batch_op_t));
+    if (ops == NULL) {
+        cJSON_Delete(root);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    // Nothing is sent unless every operation is valid
+    size_t bad = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, ops_json) {
+        if (!parse_batch_op(item, &ops[bad])) {
+            break;
+        }
+        bad++;
+    }
+    cJSON_Delete(root);
+    if (bad == (size_t)count && actuator_batch_validate(ops, count, &bad) == ESP_OK) {
+        bad = count;
+    }
+    if (bad < (size_t)count) {
+        memprof_free(MEMPROF_TAG_HTTP, ops);
+        char msg[40];
+        snprintf(msg, sizeof(msg), "Invalid operation %d", (int)bad);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, msg);
+        return ESP_FAIL;
+    }
+
+    actuator_batch_stats_t stats = {0};
+    esp_err_t err = actuator_batch_run(ops, count, stop_on_error, &stats);
+
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "success", err == ESP_OK);
+    cJSON_AddNumberToObject(response, "transactions", stats.transactions);
+    cJSON_AddNumberToObject(response, "failed", stats.failed);
+    cJSON_AddNumberToObject(response, "elapsed_ms", stats.elapsed_us / 1000.0);
+    cJSON *results = cJSON_AddArrayToObject(response, "results");
+    for (int i = 0; i < count; i++) {
+        cJSON_AddItemToArray(results, batch_result_json(&ops[i]));
+    }
+    memprof_free(MEMPROF_TAG_HTTP, ops);
+
+    return send_json(req, response);
+}
+
+// ============================================================================
+// API Handlers - RS485 Configuration
+// ============================================================================
+
+static esp_err_t api_rs485_config_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        cJSON *root = cJSON_CreateObject();
+
+        cJSON_AddNumberToObject(root, "baud_rate", config_get_rs485_baud());
+        cJSON_AddNumberToObject(root, "tx_pin", config_get_rs485_tx_pin());
+        cJSON_AddNumberToObject(root, "rx_pin", config_get_rs485_rx_pin());
+        cJSON_AddNumberToObject(root, "de_pin", config_get_rs485_de_pin());
+        cJSON_AddNumberToObject(root, "slave_id", config_get_modbus_slave_id());
+
+        send_json(req, root);
+    } else {
+        // POST - update config
+        char buf[256];
+        int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+        if (ret <= 0) {
+            httpd_resp_send_500(req);
+            return ESP_FAIL;
         }
         buf[ret] = '\0';
 
@@ -1594,12 +2666,7 @@ static esp_err_t api_rs485_config_handler(httpd_req_t *req)
         cJSON_AddBoolToObject(response, "success", true);
         cJSON_AddStringToObject(response, "message", "Config saved. Restart to apply.");
 
-        char *json_str = cJSON_PrintUnformatted(response);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_str, strlen(json_str));
-
-        free(json_str);
-        cJSON_Delete(response);
+        send_json(req, response);
         cJSON_Delete(root);
     }
     return ESP_OK;
@@ -1609,14 +2676,45 @@ static esp_err_t api_rs485_config_handler(httpd_req_t *req)
 // API Handlers - RS485 Diagnostics
 // ============================================================================
 
+/**
+ * @brief Build the polling schedule object of a bus
+ */
+static cJSON *schedule_to_json(uint8_t bus)
+{
+    actuator_poller_stats_t poll;
+    actuator_poller_get_stats(bus, &poll);
+    cJSON *schedule = cJSON_CreateObject();
+    cJSON_AddBoolToObject(schedule, "running", poll.running);
+    if (poll.running) {
+        cJSON_AddNumberToObject(schedule, "minor_cycle_ms", poll.minor_cycle_ms);
+        cJSON *periods = cJSON_CreateObject();
+        for (int c = 0; c < ACTUATOR_RATE_COUNT; c++) {
+            cJSON_AddNumberToObject(periods, actuator_rate_name(c), poll.period_ms[c]);
+        }
+        cJSON_AddItemToObject(schedule, "period_ms", periods);
+        cJSON_AddNumberToObject(schedule, "scale", poll.scale);
+        cJSON_AddNumberToObject(schedule, "demand_pct", poll.demand_pct);
+        cJSON_AddNumberToObject(schedule, "utilisation_pct", poll.utilisation_pct);
+        cJSON_AddNumberToObject(schedule, "busy_pct", poll.busy_pct);
+        cJSON_AddNumberToObject(schedule, "cycles", poll.cycles);
+        cJSON_AddNumberToObject(schedule, "polls", poll.polls);
+        cJSON_AddNumberToObject(schedule, "probes", poll.probes);
+        cJSON_AddNumberToObject(schedule, "deferred", poll.deferred);
+        cJSON_AddNumberToObject(schedule, "late", poll.late);
+        cJSON_AddNumberToObject(schedule, "overruns", poll.overruns);
+    }
+    return schedule;
+}
+
 // GET /api/rs485/diag - Get RS485/Modbus diagnostics
 static esp_err_t api_rs485_diag_handler(httpd_req_t *req)
 {
     cJSON *root = cJSON_CreateObject();
 
-    // RS485 status
-    cJSON_AddBoolToObject(root, "rs485_ready", g_rs485 != NULL);
-    cJSON_AddBoolToObject(root, "modbus_ready", g_modbus != NULL);
+    // RS485 status of every bus
+    bool all_up;
+    cJSON_AddItemToObject(root, "buses", buses_json(&all_up));
+    cJSON_AddBoolToObject(root, "modbus_ready", all_up);
 
     // Configuration
     cJSON *config = cJSON_CreateObject();
@@ -1628,32 +2726,248 @@ static esp_err_t api_rs485_diag_handler(httpd_req_t *req)
     cJSON_AddItemToObject(root, "config", config);
 
     // Modbus statistics
-    const modbus_stats_t *stats = modbus_get_stats();
-    if (stats) {
-        cJSON *modbus_stats = cJSON_CreateObject();
-        cJSON_AddNumberToObject(modbus_stats, "tx_count", stats->tx_count);
-        cJSON_AddNumberToObject(modbus_stats, "rx_count", stats->rx_count);
-        cJSON_AddNumberToObject(modbus_stats, "error_count", stats->error_count);
-        cJSON_AddNumberToObject(modbus_stats, "timeout_count", stats->timeout_count);
-        cJSON_AddNumberToObject(modbus_stats, "crc_error_count", stats->crc_error_count);
-        cJSON_AddNumberToObject(modbus_stats, "retry_count", stats->retry_count);
-
-        // Calculate success rate
-        if (stats->tx_count > 0) {
-            double success_rate = (double)stats->rx_count / (double)stats->tx_count * 100.0;
-            cJSON_AddNumberToObject(modbus_stats, "success_rate", success_rate);
-        } else {
-            cJSON_AddNumberToObject(modbus_stats, "success_rate", 0);
-        }
-        cJSON_AddItemToObject(root, "stats", modbus_stats);
+    modbus_stats_t stats;
+    modbus_get_stats(&stats);
+    cJSON *modbus_stats = cJSON_CreateObject();
+    cJSON_AddNumberToObject(modbus_stats, "tx_count", stats.tx_count);
+    cJSON_AddNumberToObject(modbus_stats, "rx_count", stats.rx_count);
+    cJSON_AddNumberToObject(modbus_stats, "error_count", stats.error_count);
+    cJSON_AddNumberToObject(modbus_stats, "timeout_count", stats.timeout_count);
+    cJSON_AddNumberToObject(modbus_stats, "crc_error_count", stats.crc_error_count);
+    cJSON_AddNumberToObject(modbus_stats, "retry_count", stats.retry_count);
+
+    // Calculate success rate
+    if (stats.tx_count > 0) {
+        double success_rate = (double)stats.rx_count / (double)stats.tx_count * 100.0;
+        cJSON_AddNumberToObject(modbus_stats, "success_rate", success_rate);
+    } else {
+        cJSON_AddNumberToObject(modbus_stats, "success_rate", 0);
+    }
+    cJSON_AddItemToObject(root, "stats", modbus_stats);
+
+    // Polling schedule of the first bus, then every bus
+    cJSON_AddItemToObject(root, "schedule", schedule_to_json(0));
+
+    cJSON *buses = cJSON_CreateArray();
+    for (uint8_t bus = 0; bus < bus_manager_count(); bus++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "bus", bus);
+        cJSON_AddNumberToObject(item, "uart", bus_manager_get_uart(bus));
+        cJSON_AddBoolToObject(item, "up", bus_manager_is_up(bus));
+        cJSON_AddNumberToObject(item, "core", bus_manager_get_core(bus));
+        cJSON_AddItemToObject(item, "schedule", schedule_to_json(bus));
+        cJSON_AddItemToArray(buses, item);
+    }
+    cJSON_AddItemToObject(root, "buses", buses);
+
+    // Modbus TCP gateway
+    modbus_tcp_stats_t gw;
+    modbus_tcp_get_stats(&gw);
+    cJSON *gateway = cJSON_CreateObject();
+    cJSON_AddBoolToObject(gateway, "running", gw.running);
+    cJSON_AddNumberToObject(gateway, "clients", gw.clients);
+    cJSON_AddNumberToObject(gateway, "connections", gw.connections);
+    cJSON_AddNumberToObject(gateway, "rejected", gw.rejected);
+    cJSON_AddNumberToObject(gateway, "requests", gw.requests);
+    cJSON_AddNumberToObject(gateway, "cache_hits", gw.cache_hits);
+    cJSON_AddNumberToObject(gateway, "coalesced", gw.coalesced);
+    cJSON_AddNumberToObject(gateway, "transactions", gw.transactions);
+    cJSON_AddNumberToObject(gateway, "exceptions", gw.exceptions);
+    cJSON_AddNumberToObject(gateway, "writes_refused", gw.writes_refused);
+    cJSON_AddItemToObject(root, "gateway", gateway);
+
+    // Modbus RTU slave (PLC port)
+    modbus_slave_stats_t sl;
+    modbus_slave_get_stats(&sl);
+    cJSON *rtu_slave = cJSON_CreateObject();
+    cJSON_AddBoolToObject(rtu_slave, "running", sl.running);
+    cJSON_AddNumberToObject(rtu_slave, "uart", sl.uart);
+    cJSON_AddNumberToObject(rtu_slave, "slave_id", sl.slave_id);
+    cJSON_AddNumberToObject(rtu_slave, "requests", sl.requests);
+    cJSON_AddNumberToObject(rtu_slave, "exceptions", sl.exceptions);
+    cJSON_AddNumberToObject(rtu_slave, "crc_errors", sl.crc_errors);
+    cJSON_AddNumberToObject(rtu_slave, "other_address", sl.other_address);
+    cJSON_AddNumberToObject(rtu_slave, "retries", sl.retries);
+    cJSON_AddNumberToObject(rtu_slave, "max_reply_us", sl.max_reply_us);
+    cJSON_AddItemToObject(root, "rtu_slave", rtu_slave);
+
+    // Frame trace
+    rs485_trace_stats_t tr;
+    rs485_trace_get_stats(&tr);
+    cJSON *trace = cJSON_CreateObject();
+    cJSON_AddNumberToObject(trace, "capacity", tr.capacity);
+    cJSON_AddNumberToObject(trace, "snaplen", tr.snaplen);
+    cJSON_AddNumberToObject(trace, "recorded", tr.recorded);
+    cJSON_AddNumberToObject(trace, "overwritten", tr.overwritten);
+    cJSON_AddItemToObject(root, "trace", trace);
+
+    // Trace points
+    tracepoint_stats_t tp;
+    tracepoint_get_stats(&tp);
+    cJSON *tracepoints = cJSON_CreateObject();
+    cJSON_AddNumberToObject(tracepoints, "capacity", tp.capacity);
+    cJSON_AddNumberToObject(tracepoints, "recorded", tp.recorded);
+    cJSON_AddNumberToObject(tracepoints, "overwritten", tp.overwritten);
+    cJSON_AddItemToObject(root, "tracepoints", tracepoints);
+
+    send_json(req, root);
+    return ESP_OK;
+}
+
+static esp_err_t send_chunk(void *ctx, const uint8_t *data, size_t len)
+{
+    return resp_send_chunk((httpd_req_t *)ctx, (const char *)data, len);
+}
+
+// GET /api/rs485/trace - Download the RS485 frame trace (pcapng)
+static esp_err_t api_rs485_trace_handler(httpd_req_t *req)
+{
+    rs485_trace_stats_t stats;
+    rs485_trace_get_stats(&stats);
+    if (stats.capacity == 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Trace disabled (CONFIG_RS485_TRACE)");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"rs485.pcapng\"");
+
+    esp_err_t ret = rs485_trace_export_pcapng(send_chunk, req);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Trace export aborted: %s", esp_err_to_name(ret));
+        return ESP_FAIL;
+    }
+    resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// GET /api/trace[?clear=1] - Download the trace points (Chrome Trace Event JSON)
+static esp_err_t api_trace_handler(httpd_req_t *req)
+{
+    tracepoint_stats_t stats;
+    tracepoint_get_stats(&stats);
+    if (stats.capacity == 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Trace points disabled (CONFIG_TRACEPOINT_ENABLE)");
+        return ESP_FAIL;
+    }
+
+    bool clear = false;
+    char query[32];
+    char value[4];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "clear", value, sizeof(value)) == ESP_OK) {
+        clear = strcmp(value, "1") == 0;
     }
 
-    char *json_str = cJSON_PrintUnformatted(root);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"trace.json\"");
 
-    free(json_str);
+    esp_err_t ret = tracepoint_export_json(send_chunk, req, clear);
+    if (ret != ESP_OK) {
+        return ESP_FAIL;
+    }
+    resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// GET /metrics - Metrics registry (OpenMetrics text, for Prometheus)
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    // Scrapers that do not ask for OpenMetrics get the Prometheus text format
+    char accept[128] = {0};
+    httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept));
+    if (strstr(accept, "application/openmetrics-text") != NULL) {
+        httpd_resp_set_type(req, "application/openmetrics-text; version=1.0.0; charset=utf-8");
+    } else {
+        httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+    }
+
+    esp_err_t ret = metrics_export_openmetrics(send_chunk, req);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Metrics export aborted: %s", esp_err_to_name(ret));
+        return ESP_FAIL;
+    }
+    resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// GET /api/profiler - Download the sampling profile (text, see tools/profile_fold.py)
+static esp_err_t api_profiler_get_handler(httpd_req_t *req)
+{
+    profiler_status_t status;
+    profiler_get_status(&status);
+    if (status.rate_hz == 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Profiler disabled (CONFIG_PROFILER_ENABLE)");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"profile.txt\"");
+
+    esp_err_t ret = profiler_export(send_chunk, req);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No profile recorded");
+        return ESP_FAIL;
+    }
+    if (ret != ESP_OK) {
+        return ESP_FAIL;
+    }
+    resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// POST /api/profiler - Start or stop the profiler
+// Body: {"action": "start"|"stop"|"status", "seconds": 10}
+static esp_err_t api_profiler_post_handler(httpd_req_t *req)
+{
+    char buf[128];
+    int len = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (len <= 0) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    buf[len] = '\0';
+
+    cJSON *root = cJSON_Parse(buf);
+    if (root == NULL) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    const char *action = cJSON_GetStringValue(cJSON_GetObjectItem(root, "action"));
+    cJSON *seconds = cJSON_GetObjectItem(root, "seconds");
+    esp_err_t err = ESP_OK;
+
+    if (action != NULL && strcmp(action, "start") == 0) {
+        uint32_t duration = cJSON_IsNumber(seconds) && seconds->valueint > 0 ? seconds->valueint : 0;
+        err = profiler_start(duration);
+    } else if (action != NULL && strcmp(action, "stop") == 0) {
+        err = profiler_stop();
+    } else if (action == NULL || strcmp(action, "status") != 0) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "action must be start, stop or status");
+        return ESP_FAIL;
+    }
     cJSON_Delete(root);
+
+    profiler_status_t status;
+    profiler_get_status(&status);
+
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "success", err == ESP_OK);
+    if (err != ESP_OK) {
+        cJSON_AddStringToObject(response, "message", esp_err_to_name(err));
+    }
+    cJSON_AddBoolToObject(response, "running", status.running);
+    cJSON_AddNumberToObject(response, "rate_hz", status.rate_hz);
+    cJSON_AddNumberToObject(response, "elapsed_ms", status.elapsed_ms);
+    cJSON_AddNumberToObject(response, "samples", status.samples);
+    cJSON_AddNumberToObject(response, "in_isr", status.in_isr);
+    cJSON_AddNumberToObject(response, "dropped", status.dropped);
+    cJSON_AddNumberToObject(response, "buckets_used", status.buckets_used);
+    cJSON_AddNumberToObject(response, "buckets", status.buckets);
+
+    send_json(req, response);
     return ESP_OK;
 }
 
@@ -1674,18 +2988,28 @@ static esp_err_t api_rs485_test_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    // Get slave ID (default 1 for mightyZAP); a broadcast gets no reply to test
+    cJSON *id_json = cJSON_GetObjectItem(root, "slave_id");
+    int slave_id = cJSON_IsNumber(id_json) ? id_json->valueint : 1;
+    if (slave_id < 1 || slave_id > ACTUATOR_ID_MAX) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "slave_id must be 1-247");
+        return ESP_FAIL;
+    }
+    uint8_t bus;
+    if (!get_request_bus(root, &bus)) {
+        return send_bad_bus(req, root);
+    }
+
     cJSON *response = cJSON_CreateObject();
 
-    if (g_modbus == NULL) {
+    modbus_handle_t modbus = bus_manager_get_modbus(bus);
+    if (modbus == NULL) {
         cJSON_AddBoolToObject(response, "success", false);
         cJSON_AddStringToObject(response, "error", "Modbus not initialized");
         goto send_test_response;
     }
 
-    // Get slave ID (default 1 for mightyZAP)
-    cJSON *id_json = cJSON_GetObjectItem(root, "slave_id");
-    uint8_t slave_id = cJSON_IsNumber(id_json) ? id_json->valueint : 1;
-
     // Get register to read (default 0x0000 for model number)
     cJSON *reg_json = cJSON_GetObjectItem(root, "register");
     uint16_t reg_addr = cJSON_IsNumber(reg_json) ? reg_json->valueint : 0x0000;
@@ -1698,7 +3022,7 @@ static esp_err_t api_rs485_test_handler(httpd_req_t *req)
     ESP_LOGI(TAG, "RS485 Test: slave=%d, reg=0x%04X, count=%d", slave_id, reg_addr, count);
 
     uint16_t values[10] = {0};
-    esp_err_t err = modbus_read_holding_registers(g_modbus, slave_id, reg_addr, count, values);
+    esp_err_t err = modbus_read_holding_registers(modbus, (uint8_t)slave_id, reg_addr, count, values);
 
     cJSON_AddNumberToObject(response, "slave_id", slave_id);
     cJSON_AddNumberToObject(response, "register", reg_addr);
@@ -1724,21 +3048,14 @@ static esp_err_t api_rs485_test_handler(httpd_req_t *req)
         cJSON_AddStringToObject(response, "error", esp_err_to_name(err));
 
         // Get last Modbus exception if available
-        modbus_exception_t ex = modbus_get_last_exception(g_modbus);
+        modbus_exception_t ex = modbus_get_last_exception(modbus);
         if (ex != MODBUS_EX_NONE) {
             cJSON_AddNumberToObject(response, "exception_code", ex);
         }
     }
 
 send_test_response:
-    {
-        char *json_str = cJSON_PrintUnformatted(response);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_str, strlen(json_str));
-        free(json_str);
-    }
-
-    cJSON_Delete(response);
+    send_json(req, response);
     cJSON_Delete(root);
     return ESP_OK;
 }
@@ -1752,12 +3069,7 @@ static esp_err_t api_rs485_reset_stats_handler(httpd_req_t *req)
     cJSON_AddBoolToObject(response, "success", true);
     cJSON_AddStringToObject(response, "message", "Statistics reset");
 
-    char *json_str = cJSON_PrintUnformatted(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(response);
+    send_json(req, response);
     return ESP_OK;
 }
 
@@ -1771,12 +3083,7 @@ static esp_err_t api_restart_handler(httpd_req_t *req)
     cJSON_AddBoolToObject(root, "success", true);
     cJSON_AddStringToObject(root, "message", "Restarting...");
 
-    char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    free(json_str);
-    cJSON_Delete(root);
+    send_json(req, root);
 
     // Delay before restart
     vTaskDelay(pdMS_TO_TICKS(1000));
@@ -1785,6 +3092,529 @@ static esp_err_t api_restart_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// ============================================================================
+// Server-Sent Events
+// ============================================================================
+
+/**
+ * GET /api/events streams what the interface used to poll: the handler
+ * answers the headers, hands the request to the event task and returns, so
+ * a stream holds a socket but no server task. The task builds each event
+ * once per tick and sends it to every client it is due for, so clients
+ * cost a send each, not a JSON build.
+ */
+
+typedef enum {
+    SSE_STATUS = 0,                 // /api/status, every SSE_STATUS_PERIOD_MS
+    SSE_ACTUATORS,                  // /api/actuator/status, every client interval
+    SSE_HEALTH,                     // Health of every actuator, when one changes
+    SSE_TASKS,                      // /api/tasks, every SSE_TASKS_PERIOD_MS
+    SSE_TOPIC_COUNT
+} sse_topic_t;
+
+#define SSE_ALL_TOPICS          ((1 << SSE_TOPIC_COUNT) - 1)
+#define SSE_TICK_MS             100
+#define SSE_STATUS_PERIOD_MS    10000   // Also keeps idle streams alive
+#define SSE_TASKS_PERIOD_MS     2000    // CPU sampler period
+#define SSE_DEFAULT_INTERVAL_MS 1000
+#define SSE_MAX_INTERVAL_MS     60000
+#define SSE_RETRY_MS            3000    // Browser reconnect delay
+#define SSE_TASK_STACK          6144
+#define SSE_TASK_PRIORITY       (tskIDLE_PRIORITY + 2)
+
+static const char *const s_sse_topics[SSE_TOPIC_COUNT] = { "status", "actuators", "health", "tasks" };
+static const uint32_t s_sse_periods_ms[SSE_TOPIC_COUNT] = { SSE_STATUS_PERIOD_MS, 0, 0, SSE_TASKS_PERIOD_MS };
+
+typedef struct {
+    bool used;                      // Claimed by the handler
+    httpd_req_t *req;               // Async copy of the request, NULL until the stream is open
+    uint8_t topics;                 // Bit per sse_topic_t
+    uint32_t interval_ms;           // Least time between two events of a topic
+    uint32_t health_gen;            // s_sse_health_gen of the last health event sent
+    int64_t due_us[SSE_TOPIC_COUNT];
+} sse_client_t;
+
+static sse_client_t s_sse_clients[CONFIG_HTTPD_SSE_MAX_CLIENTS];
+static portMUX_TYPE s_sse_lock = portMUX_INITIALIZER_UNLOCKED;     // used, req
+static SemaphoreHandle_t s_sse_mutex = NULL;                        // Held by the task while sending
+static TaskHandle_t s_sse_task = NULL;
+static cpu_load_t s_sse_load;       // Only the event task reads it
+
+// Bus, id, health and connected of every registry slot, as last seen
+static uint32_t s_sse_health[ACTUATOR_REGISTRY_MAX];
+static uint8_t s_sse_health_count = 0;
+static uint32_t s_sse_health_gen = 1;
+
+static int64_t read_sse_streams(void)
+{
+    int64_t n = 0;
+    for (int i = 0; i < CONFIG_HTTPD_SSE_MAX_CLIENTS; i++) {
+        n += s_sse_clients[i].req != NULL;
+    }
+    return n;
+}
+
+METRIC_GAUGE_DEFINE(s_m_sse_streams, "http_event_streams", "Open /api/events streams", read_sse_streams);
+METRIC_COUNTER_DEFINE(s_m_sse_events, "http_events_sent", "Events sent on /api/events streams");
+
+/**
+ * @brief Count a new health generation if an actuator changed health,
+ *        connection, or was added or removed
+ */
+static void sse_poll_health(void)
+{
+    bool changed = false;
+
+    actuator_registry_lock();
+    uint8_t count = actuator_registry_count();
+    if (count != s_sse_health_count) {
+        s_sse_health_count = count;
+        changed = true;
+    }
+    for (uint8_t slot = 0; slot < count; slot++) {
+        actuator_state_t state;
+        actuator_registry_get_state(slot, &state);
+        uint32_t key = ((uint32_t)state.bus << 24) | ((uint32_t)state.id << 16) |
+                       ((uint32_t)state.health << 1) | (state.connected ? 1 : 0);
+        if (s_sse_health[slot] != key) {
+            s_sse_health[slot] = key;
+            changed = true;
+        }
+    }
+    actuator_registry_unlock();
+
+    if (changed) {
+        s_sse_health_gen++;
+    }
+}
+
+/**
+ * @brief Health of every actuator ("health" event)
+ */
+static cJSON *health_json(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *actuators = cJSON_CreateArray();
+    for (uint8_t slot = 0; slot < s_sse_health_count; slot++) {
+        uint32_t key = s_sse_health[slot];
+        cJSON *act = cJSON_CreateObject();
+        cJSON_AddNumberToObject(act, "bus", key >> 24);
+        cJSON_AddNumberToObject(act, "id", (key >> 16) & 0xFF);
+        cJSON_AddBoolToObject(act, "connected", key & 1);
+        cJSON_AddStringToObject(act, "health", actuator_health_name((actuator_health_t)((key >> 1) & 0x7F)));
+        cJSON_AddItemToArray(actuators, act);
+    }
+    cJSON_AddItemToObject(root, "actuators", actuators);
+    return root;
+}
+
+/**
+ * @brief Build one event: "event: <topic>\ndata: <json>\n\n"
+ *
+ * @return char* Event (free with memprof_free), NULL if there is nothing to send
+ */
+static char *sse_build(sse_topic_t topic)
+{
+    cJSON *root = NULL;
+    switch (topic) {
+        case SSE_STATUS:    root = status_json(); break;
+        case SSE_ACTUATORS: root = actuators_json(); break;
+        case SSE_HEALTH:    root = health_json(); break;
+        case SSE_TASKS:
+            if (cpu_sampler_get(&s_sse_load) == ESP_OK) {
+                root = tasks_json(&s_sse_load);
+            }
+            break;
+        default: break;
+    }
+    if (root == NULL) {
+        return NULL;
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (json == NULL) {
+        return NULL;
+    }
+    size_t len = strlen(json) + 32;
+    char *event = memprof_malloc(MEMPROF_TAG_HTTP, len);
+    if (event != NULL) {
+        snprintf(event, len, "event: %s\ndata: %s\n\n", s_sse_topics[topic], json);
+    }
+    cJSON_free(json);
+    return event;
+}
+
+/**
+ * @brief Close a stream; the caller holds s_sse_mutex
+ *
+ * @param client Client
+ * @param graceful End the response (server stopping) instead of closing the socket (send failed)
+ */
+static void sse_close(sse_client_t *client, bool graceful)
+{
+    httpd_req_t *req = client->req;
+    int fd = httpd_req_to_sockfd(req);
+
+    if (graceful) {
+        httpd_resp_send_chunk(req, NULL, 0);
+    }
+    httpd_req_async_handler_complete(req);
+    if (!graceful) {
+        httpd_sess_trigger_close(s_server, fd);
+    }
+
+    portENTER_CRITICAL(&s_sse_lock);
+    client->req = NULL;
+    client->used = false;
+    portEXIT_CRITICAL(&s_sse_lock);
+    DLOGI(TAG, "Event stream %d closed", (int)(client - s_sse_clients));
+}
+
+static void sse_task(void *arg)
+{
+    while (true) {
+        // Woken early by a new stream so it gets its first events at once
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SSE_TICK_MS));
+        xSemaphoreTake(s_sse_mutex, portMAX_DELAY);
+
+        httpd_req_t *reqs[CONFIG_HTTPD_SSE_MAX_CLIENTS];
+        uint8_t wanted = 0;
+        portENTER_CRITICAL(&s_sse_lock);
+        for (int i = 0; i < CONFIG_HTTPD_SSE_MAX_CLIENTS; i++) {
+            reqs[i] = s_sse_clients[i].req;
+            if (reqs[i] != NULL) {
+                wanted |= s_sse_clients[i].topics;
+            }
+        }
+        portEXIT_CRITICAL(&s_sse_lock);
+
+        if (wanted & (1 << SSE_HEALTH)) {
+            sse_poll_health();
+        }
+
+        char *events[SSE_TOPIC_COUNT] = { NULL };
+        bool built[SSE_TOPIC_COUNT] = { false };
+        int64_t now_us = esp_timer_get_time();
+
+        for (int i = 0; i < CONFIG_HTTPD_SSE_MAX_CLIENTS; i++) {
+            sse_client_t *client = &s_sse_clients[i];
+            if (reqs[i] == NULL) {
+                continue;
+            }
+            for (int t = 0; t < SSE_TOPIC_COUNT; t++) {
+                if (!(client->topics & (1 << t)) || now_us < client->due_us[t]) {
+                    continue;
+                }
+                if (t == SSE_HEALTH && client->health_gen == s_sse_health_gen) {
+                    continue;
+                }
+                if (!built[t]) {
+                    events[t] = sse_build((sse_topic_t)t);
+                    built[t] = true;
+                }
+                if (events[t] == NULL) {
+                    continue;
+                }
+                if (httpd_resp_send_chunk(reqs[i], events[t], strlen(events[t])) != ESP_OK) {
+                    sse_close(client, false);
+                    break;
+                }
+                metrics_counter_inc(&s_m_sse_events);
+
+                uint32_t period_ms = client->interval_ms > s_sse_periods_ms[t] ?
+                                     client->interval_ms : s_sse_periods_ms[t];
+                client->due_us[t] = now_us + (int64_t)period_ms * 1000;
+                if (t == SSE_HEALTH) {
+                    client->health_gen = s_sse_health_gen;
+                }
+            }
+        }
+
+        for (int t = 0; t < SSE_TOPIC_COUNT; t++) {
+            memprof_free(MEMPROF_TAG_HTTP, events[t]);
+        }
+        xSemaphoreGive(s_sse_mutex);
+    }
+}
+
+/**
+ * @brief Close every stream and stop the event task
+ */
+static void sse_stop(void)
+{
+    if (s_sse_task == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_sse_mutex, portMAX_DELAY);
+    vTaskDelete(s_sse_task);
+    s_sse_task = NULL;
+    for (int i = 0; i < CONFIG_HTTPD_SSE_MAX_CLIENTS; i++) {
+        if (s_sse_clients[i].req != NULL) {
+            sse_close(&s_sse_clients[i], true);
+        }
+    }
+    xSemaphoreGive(s_sse_mutex);
+}
+
+/**
+ * @brief Parse "status,actuators,..." into topic bits
+ */
+static uint8_t sse_parse_topics(char *list)
+{
+    uint8_t topics = 0;
+    char *save = NULL;
+    for (char *name = strtok_r(list, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save)) {
+        for (int t = 0; t < SSE_TOPIC_COUNT; t++) {
+            if (strcmp(name, s_sse_topics[t]) == 0) {
+                topics |= 1 << t;
+            }
+        }
+    }
+    return topics;
+}
+
+// GET /api/events[?topics=status,actuators,health,tasks&interval=1000] - Server-Sent Events
+static esp_err_t api_events_handler(httpd_req_t *req)
+{
+    uint8_t topics = SSE_ALL_TOPICS;
+    uint32_t interval_ms = SSE_DEFAULT_INTERVAL_MS;
+
+    char query[96];
+    char value[64];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "topics", value, sizeof(value)) == ESP_OK) {
+            topics = sse_parse_topics(value);
+        }
+        if (httpd_query_key_value(query, "interval", value, sizeof(value)) == ESP_OK) {
+            interval_ms = strtoul(value, NULL, 10);
+        }
+    }
+    if (topics == 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No known topic");
+        return ESP_FAIL;
+    }
+    if (interval_ms < CONFIG_HTTPD_SSE_MIN_INTERVAL_MS) {
+        interval_ms = CONFIG_HTTPD_SSE_MIN_INTERVAL_MS;
+    } else if (interval_ms > SSE_MAX_INTERVAL_MS) {
+        interval_ms = SSE_MAX_INTERVAL_MS;
+    }
+
+    // The task is only started by the first stream
+    if (s_sse_task == NULL) {
+        if (s_sse_mutex == NULL) {
+            s_sse_mutex = xSemaphoreCreateMutex();
+        }
+        if (s_sse_mutex == NULL ||
+            xTaskCreate(sse_task, "web_sse", SSE_TASK_STACK, NULL, SSE_TASK_PRIORITY, &s_sse_task) != pdPASS) {
+            s_sse_task = NULL;
+            return httpd_resp_send_500(req);
+        }
+    }
+
+    sse_client_t *client = NULL;
+    portENTER_CRITICAL(&s_sse_lock);
+    for (int i = 0; i < CONFIG_HTTPD_SSE_MAX_CLIENTS; i++) {
+        if (!s_sse_clients[i].used) {
+            client = &s_sse_clients[i];
+            client->used = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_sse_lock);
+
+    if (client == NULL) {
+        // Browsers give up on a failed EventSource; the interface falls back to polling
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "30");
+        httpd_resp_sendstr(req, "Too many event streams");
+        return ESP_OK;
+    }
+
+    // Headers and the reconnect delay go out from the server task
+    httpd_resp_set_type(req, "text/event-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_req_t *async = NULL;
+    esp_err_t ret = httpd_resp_send_chunk(req, "retry: " STR(SSE_RETRY_MS) "\n\n", HTTPD_RESP_USE_STRLEN);
+    if (ret == ESP_OK) {
+        ret = httpd_req_async_handler_begin(req, &async);
+    }
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&s_sse_lock);
+        client->used = false;
+        portEXIT_CRITICAL(&s_sse_lock);
+        return ESP_FAIL;
+    }
+
+    client->topics = topics;
+    client->interval_ms = interval_ms;
+    client->health_gen = 0;
+    memset(client->due_us, 0, sizeof(client->due_us));
+    portENTER_CRITICAL(&s_sse_lock);
+    client->req = async;
+    portEXIT_CRITICAL(&s_sse_lock);
+
+    DLOGI(TAG, "Event stream %d opened (topics 0x%x, %lu ms)",
+          (int)(client - s_sse_clients), topics, (unsigned long)interval_ms);
+    xTaskNotifyGive(s_sse_task);
+    return ESP_OK;
+}
+
+// ============================================================================
+// Routing
+// ============================================================================
+
+/**
+ * @brief Every endpoint of the server
+ *
+ * body_max matches the buffer each handler reads its body into; larger
+ * bodies are refused before the handler runs. WEB_ROUTE_COMPRESS is for
+ * handlers that send through send_json() or resp_send_chunk().
+ */
+static const web_route_t s_routes[] = {
+    // Static files
+    { HTTP_GET,  "/",                       index_handler,                  WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/style.css",              css_handler,                    WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/core.js",                js_handler,                     WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/favicon.ico",            favicon_handler,                WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/actuators.html",    tabs_html_handler,              WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/system.html",       tabs_html_handler,              WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/config.html",       tabs_html_handler,              WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/files.html",        tabs_html_handler,              WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/tasks.html",        tabs_html_handler,              WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/actuators.js",      tabs_js_handler,                WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/system.js",         tabs_js_handler,                WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/config.js",         tabs_js_handler,                WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/files.js",          tabs_js_handler,                WEB_ROUTE_CACHEABLE, 0 },
+    { HTTP_GET,  "/tabs/tasks.js",          tabs_js_handler,                WEB_ROUTE_CACHEABLE, 0 },
+
+    // Session
+    { HTTP_POST, "/api/login",              api_login_handler,              0,              255 },
+    { HTTP_POST, "/api/logout",             api_logout_handler,             WEB_ROUTE_AUTH, 0 },
+
+    // File manager
+    { HTTP_GET,  "/api/files/list",         api_files_list_handler,         WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_GET,  "/api/files/info",         api_files_info_handler,         WEB_ROUTE_AUTH, 0 },
+    { HTTP_GET,  "/api/files/download",     api_files_download_handler,     WEB_ROUTE_AUTH, 0 },
+    { HTTP_GET,  "/api/files/view",         api_files_view_handler,         WEB_ROUTE_AUTH, 0 },
+    { HTTP_GET,  "/api/files/read",         api_files_read_handler,         WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_POST, "/api/files/write",        api_files_write_handler,        WEB_ROUTE_AUTH, 0 },
+    { HTTP_POST, "/api/files/delete",       api_files_delete_handler,       WEB_ROUTE_AUTH, 255 },
+    { HTTP_POST, "/api/files/mkdir",        api_files_mkdir_handler,        WEB_ROUTE_AUTH, 255 },
+    { HTTP_POST, "/api/files/upload",       api_files_upload_handler,       WEB_ROUTE_AUTH, 0 },
+
+    // System
+    { HTTP_GET,  "/api/status",             api_status_handler,             WEB_ROUTE_AUTH, 0 },
+    { HTTP_GET,  "/api/tasks",              api_tasks_handler,              WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_GET,  "/api/memory",             api_memory_handler,             WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_GET,  "/api/boot",               api_boot_handler,               WEB_ROUTE_AUTH, 0 },
+    { HTTP_POST, "/api/restart",            api_restart_handler,            WEB_ROUTE_AUTH, 0 },
+    { HTTP_GET,  "/api/events",             api_events_handler,             WEB_ROUTE_AUTH | WEB_ROUTE_ASYNC, 0 },
+
+    // WiFi
+    { HTTP_GET,  "/api/wifi/scan",          api_wifi_scan_handler,          WEB_ROUTE_AUTH, 0 },
+    { HTTP_POST, "/api/wifi/connect",       api_wifi_connect_handler,       WEB_ROUTE_AUTH, 255 },
+    { HTTP_GET,  "/api/wifi/status",        api_wifi_status_handler,        WEB_ROUTE_AUTH, 0 },
+
+    // RS485 configuration and diagnostics
+    { HTTP_GET,  "/api/rs485/config",       api_rs485_config_handler,       WEB_ROUTE_AUTH, 0 },
+    { HTTP_POST, "/api/rs485/config",       api_rs485_config_handler,       WEB_ROUTE_AUTH, 255 },
+    { HTTP_GET,  "/api/rs485/diag",         api_rs485_diag_handler,         WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_GET,  "/api/rs485/trace",        api_rs485_trace_handler,        WEB_ROUTE_AUTH, 0 },
+    { HTTP_POST, "/api/rs485/test",         api_rs485_test_handler,         WEB_ROUTE_AUTH, 255 },
+    { HTTP_POST, "/api/rs485/reset_stats",  api_rs485_reset_stats_handler,  WEB_ROUTE_AUTH, 0 },
+    { HTTP_GET,  "/api/trace",              api_trace_handler,              WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_GET,  "/metrics",                metrics_handler,                WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_GET,  "/api/profiler",           api_profiler_get_handler,       WEB_ROUTE_AUTH, 0 },
+    { HTTP_POST, "/api/profiler",           api_profiler_post_handler,      WEB_ROUTE_AUTH, 127 },
+
+    // Actuators
+    { HTTP_GET,  "/api/actuator/status",    api_actuator_status_handler,    WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, 0 },
+    { HTTP_POST, "/api/actuator/control",   api_actuator_control_handler,   WEB_ROUTE_AUTH, 255 },
+    { HTTP_GET,  "/api/actuator/scan",      api_actuator_scan_handler,      WEB_ROUTE_AUTH, 0 },
+    { HTTP_POST, "/api/actuator/add",       api_actuator_add_handler,       WEB_ROUTE_AUTH, 127 },
+    { HTTP_POST, "/api/actuator/remove",    api_actuator_remove_handler,    WEB_ROUTE_AUTH, 127 },
+    { HTTP_POST, "/api/actuator/set-name",  api_actuator_set_name_handler,  WEB_ROUTE_AUTH, 255 },
+    { HTTP_POST, "/api/batch",              api_batch_handler,              WEB_ROUTE_AUTH | WEB_ROUTE_COMPRESS, BATCH_BODY_MAX },
+};
+
+/**
+ * @brief Single entry point of every request
+ *
+ * Looks the route up and applies its flags. The handler runs with its
+ * cJSON allocations served from the request arena, which is reset when the
+ * handler returns, so cJSON trees must not outlive the request.
+ */
+static esp_err_t dispatch_handler(httpd_req_t *req)
+{
+    const web_route_t *route = web_router_find(s_router, req->method, req->uri);
+    if (route == NULL) {
+        return httpd_resp_send_404(req);
+    }
+
+    if ((route->flags & WEB_ROUTE_AUTH) && !check_auth(req)) {
+        return send_unauthorized(req);
+    }
+
+    if (route->body_max > 0 && req->content_len > route->body_max) {
+        DLOGW(TAG, "Body too large for %s: %d bytes", route->path, (int)req->content_len);
+        httpd_resp_set_status(req, "413 Content Too Large");
+        httpd_resp_sendstr(req, "Request body too large");
+        return ESP_FAIL;    // Close instead of reading the body
+    }
+
+    if (route->flags & WEB_ROUTE_CACHEABLE) {
+        httpd_resp_set_hdr(req, "Cache-Control", "max-age=" STR(CONFIG_HTTPD_STATIC_MAX_AGE_S));
+    }
+
+    if (route->flags & WEB_ROUTE_COMPRESS) {
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+        if (accepts_gzip(req)) {
+            s_resp_gzip.req = req;
+        }
+    }
+
+    esp_err_t ret;
+    if ((route->flags & WEB_ROUTE_ASYNC) || s_req_arena == NULL ||
+        arena_json_begin(s_req_arena) != ESP_OK) {
+        ret = route->handler(req);
+    } else {
+        ret = route->handler(req);
+        arena_json_end(s_req_arena);
+    }
+
+    // Handlers that fail mid-body leave the response unfinished
+    s_resp_gzip.req = NULL;
+    s_resp_gzip.compressing = false;
+    s_resp_gzip.held = 0;
+    return ret;
+}
+
+/**
+ * @brief Register the dispatcher once for every method used by a route
+ */
+static esp_err_t register_routes(void)
+{
+    uint64_t registered = 0;
+    for (size_t i = 0; i < sizeof(s_routes) / sizeof(s_routes[0]); i++) {
+        int method = s_routes[i].method;
+        if (registered & (1ULL << method)) {
+            continue;
+        }
+        httpd_uri_t uri = {
+            .uri = "/*",
+            .method = method,
+            .handler = dispatch_handler,
+        };
+        esp_err_t ret = httpd_register_uri_handler(s_server, &uri);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        registered |= 1ULL << method;
+    }
+    return ESP_OK;
+}
+
 // ============================================================================
 // Server Setup
 // ============================================================================
@@ -1830,9 +3660,19 @@ esp_err_t web_server_init(const web_server_config_t *config)
         web_server_get_default_config(&s_config);
     }
 
+    if (s_router == NULL) {
+        ret = web_router_create(s_routes, sizeof(s_routes) / sizeof(s_routes[0]), &s_router);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to build the route table: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    // One wildcard handler per method; the route table does the matching
     httpd_config_t http_config = HTTPD_DEFAULT_CONFIG();
     http_config.server_port = s_config.port;
-    http_config.max_uri_handlers = 50;
+    http_config.max_uri_handlers = 8;
+    http_config.uri_match_fn = httpd_uri_match_wildcard;
     http_config.stack_size = 8192;
 
     ESP_LOGI(TAG, "Starting server on port %d", http_config.server_port);
@@ -1843,258 +3683,37 @@ esp_err_t web_server_init(const web_server_config_t *config)
         return ret;
     }
 
-    // Static files
-    httpd_uri_t index_uri = {
-        .uri = "/",
-        .method = HTTP_GET,
-        .handler = index_handler,
-    };
-    httpd_register_uri_handler(s_server, &index_uri);
-
-    httpd_uri_t css_uri = {
-        .uri = "/style.css",
-        .method = HTTP_GET,
-        .handler = css_handler,
-    };
-    httpd_register_uri_handler(s_server, &css_uri);
-
-    httpd_uri_t js_uri = {
-        .uri = "/core.js",
-        .method = HTTP_GET,
-        .handler = js_handler,
-    };
-    httpd_register_uri_handler(s_server, &js_uri);
-
-    // Tabs HTML files
-    httpd_uri_t tabs_actuators_html = { .uri = "/tabs/actuators.html", .method = HTTP_GET, .handler = tabs_html_handler };
-    httpd_uri_t tabs_system_html = { .uri = "/tabs/system.html", .method = HTTP_GET, .handler = tabs_html_handler };
-    httpd_uri_t tabs_config_html = { .uri = "/tabs/config.html", .method = HTTP_GET, .handler = tabs_html_handler };
-    httpd_uri_t tabs_files_html = { .uri = "/tabs/files.html", .method = HTTP_GET, .handler = tabs_html_handler };
-    httpd_uri_t tabs_tasks_html = { .uri = "/tabs/tasks.html", .method = HTTP_GET, .handler = tabs_html_handler };
-    httpd_register_uri_handler(s_server, &tabs_actuators_html);
-    httpd_register_uri_handler(s_server, &tabs_system_html);
-    httpd_register_uri_handler(s_server, &tabs_config_html);
-    httpd_register_uri_handler(s_server, &tabs_files_html);
-    httpd_register_uri_handler(s_server, &tabs_tasks_html);
-
-    // Tabs JS files
-    httpd_uri_t tabs_actuators_js = { .uri = "/tabs/actuators.js", .method = HTTP_GET, .handler = tabs_js_handler };
-    httpd_uri_t tabs_system_js = { .uri = "/tabs/system.js", .method = HTTP_GET, .handler = tabs_js_handler };
-    httpd_uri_t tabs_config_js = { .uri = "/tabs/config.js", .method = HTTP_GET, .handler = tabs_js_handler };
-    httpd_uri_t tabs_files_js = { .uri = "/tabs/files.js", .method = HTTP_GET, .handler = tabs_js_handler };
-    httpd_uri_t tabs_tasks_js = { .uri = "/tabs/tasks.js", .method = HTTP_GET, .handler = tabs_js_handler };
-    httpd_register_uri_handler(s_server, &tabs_actuators_js);
-    httpd_register_uri_handler(s_server, &tabs_system_js);
-    httpd_register_uri_handler(s_server, &tabs_config_js);
-    httpd_register_uri_handler(s_server, &tabs_files_js);
-    httpd_register_uri_handler(s_server, &tabs_tasks_js);
-
-    httpd_uri_t favicon_uri = {
-        .uri = "/favicon.ico",
-        .method = HTTP_GET,
-        .handler = favicon_handler,
-    };
-    httpd_register_uri_handler(s_server, &favicon_uri);
-
-    // API - File Manager
-    httpd_uri_t files_list_uri = {
-        .uri = "/api/files/list",
-        .method = HTTP_GET,
-        .handler = api_files_list_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_list_uri);
-
-    httpd_uri_t files_info_uri = {
-        .uri = "/api/files/info",
-        .method = HTTP_GET,
-        .handler = api_files_info_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_info_uri);
-
-    httpd_uri_t files_download_uri = {
-        .uri = "/api/files/download",
-        .method = HTTP_GET,
-        .handler = api_files_download_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_download_uri);
+    metrics_register(&s_m_logins);
+    metrics_register(&s_m_auth_rejected);
+    metrics_register(&s_m_sse_streams);
+    metrics_register(&s_m_gzip_responses);
+    metrics_register(&s_m_gzip_in);
+    metrics_register(&s_m_gzip_out);
+    metrics_register(&s_m_sse_events);
 
-    httpd_uri_t files_view_uri = {
-        .uri = "/api/files/view",
-        .method = HTTP_GET,
-        .handler = api_files_view_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_view_uri);
-
-    httpd_uri_t files_read_uri = {
-        .uri = "/api/files/read",
-        .method = HTTP_GET,
-        .handler = api_files_read_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_read_uri);
-
-    httpd_uri_t files_write_uri = {
-        .uri = "/api/files/write",
-        .method = HTTP_POST,
-        .handler = api_files_write_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_write_uri);
-
-    httpd_uri_t files_delete_uri = {
-        .uri = "/api/files/delete",
-        .method = HTTP_POST,
-        .handler = api_files_delete_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_delete_uri);
-
-    httpd_uri_t files_mkdir_uri = {
-        .uri = "/api/files/mkdir",
-        .method = HTTP_POST,
-        .handler = api_files_mkdir_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_mkdir_uri);
-
-    httpd_uri_t files_upload_uri = {
-        .uri = "/api/files/upload",
-        .method = HTTP_POST,
-        .handler = api_files_upload_handler,
-    };
-    httpd_register_uri_handler(s_server, &files_upload_uri);
-
-    // API - System
-    httpd_uri_t status_uri = {
-        .uri = "/api/status",
-        .method = HTTP_GET,
-        .handler = api_status_handler,
-    };
-    httpd_register_uri_handler(s_server, &status_uri);
-
-    httpd_uri_t tasks_uri = {
-        .uri = "/api/tasks",
-        .method = HTTP_GET,
-        .handler = api_tasks_handler,
-    };
-    httpd_register_uri_handler(s_server, &tasks_uri);
-
-    httpd_uri_t restart_uri = {
-        .uri = "/api/restart",
-        .method = HTTP_POST,
-        .handler = api_restart_handler,
-    };
-    httpd_register_uri_handler(s_server, &restart_uri);
-
-    // API - WiFi
-    httpd_uri_t wifi_scan_uri = {
-        .uri = "/api/wifi/scan",
-        .method = HTTP_GET,
-        .handler = api_wifi_scan_handler,
-    };
-    httpd_register_uri_handler(s_server, &wifi_scan_uri);
-
-    httpd_uri_t wifi_connect_uri = {
-        .uri = "/api/wifi/connect",
-        .method = HTTP_POST,
-        .handler = api_wifi_connect_handler,
-    };
-    httpd_register_uri_handler(s_server, &wifi_connect_uri);
-
-    httpd_uri_t wifi_status_uri = {
-        .uri = "/api/wifi/status",
-        .method = HTTP_GET,
-        .handler = api_wifi_status_handler,
-    };
-    httpd_register_uri_handler(s_server, &wifi_status_uri);
-
-    // API - RS485 Config
-    httpd_uri_t rs485_config_get_uri = {
-        .uri = "/api/rs485/config",
-        .method = HTTP_GET,
-        .handler = api_rs485_config_handler,
-    };
-    httpd_register_uri_handler(s_server, &rs485_config_get_uri);
-
-    httpd_uri_t rs485_config_post_uri = {
-        .uri = "/api/rs485/config",
-        .method = HTTP_POST,
-        .handler = api_rs485_config_handler,
-    };
-    httpd_register_uri_handler(s_server, &rs485_config_post_uri);
-
-    // API - RS485 Diagnostics
-    httpd_uri_t rs485_diag_uri = {
-        .uri = "/api/rs485/diag",
-        .method = HTTP_GET,
-        .handler = api_rs485_diag_handler,
-    };
-    httpd_register_uri_handler(s_server, &rs485_diag_uri);
-
-    httpd_uri_t rs485_test_uri = {
-        .uri = "/api/rs485/test",
-        .method = HTTP_POST,
-        .handler = api_rs485_test_handler,
-    };
-    httpd_register_uri_handler(s_server, &rs485_test_uri);
-
-    httpd_uri_t rs485_reset_stats_uri = {
-        .uri = "/api/rs485/reset_stats",
-        .method = HTTP_POST,
-        .handler = api_rs485_reset_stats_handler,
-    };
-    httpd_register_uri_handler(s_server, &rs485_reset_stats_uri);
-
-    // API - Actuator Control (Multi-actuator)
-    httpd_uri_t actuator_status_uri = {
-        .uri = "/api/actuator/status",
-        .method = HTTP_GET,
-        .handler = api_actuator_status_handler,
-    };
-    httpd_register_uri_handler(s_server, &actuator_status_uri);
-
-    httpd_uri_t actuator_control_uri = {
-        .uri = "/api/actuator/control",
-        .method = HTTP_POST,
-        .handler = api_actuator_control_handler,
-    };
-    httpd_register_uri_handler(s_server, &actuator_control_uri);
-
-    httpd_uri_t actuator_scan_uri = {
-        .uri = "/api/actuator/scan",
-        .method = HTTP_GET,
-        .handler = api_actuator_scan_handler,
-    };
-    httpd_register_uri_handler(s_server, &actuator_scan_uri);
-
-    httpd_uri_t actuator_add_uri = {
-        .uri = "/api/actuator/add",
-        .method = HTTP_POST,
-        .handler = api_actuator_add_handler,
-    };
-    httpd_register_uri_handler(s_server, &actuator_add_uri);
-
-    httpd_uri_t actuator_remove_uri = {
-        .uri = "/api/actuator/remove",
-        .method = HTTP_POST,
-        .handler = api_actuator_remove_handler,
-    };
-    httpd_register_uri_handler(s_server, &actuator_remove_uri);
+#if CONFIG_HTTPD_REQUEST_ARENA_SIZE > 0
+    if (s_req_arena == NULL && arena_create(CONFIG_HTTPD_REQUEST_ARENA_SIZE, &s_req_arena) != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for the request arena, cJSON uses the heap");
+    }
+#endif
 
-    httpd_uri_t actuator_set_name_uri = {
-        .uri = "/api/actuator/set-name",
-        .method = HTTP_POST,
-        .handler = api_actuator_set_name_handler,
-    };
-    httpd_register_uri_handler(s_server, &actuator_set_name_uri);
+    ret = register_routes();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register routes: %s", esp_err_to_name(ret));
+        httpd_stop(s_server);
+        s_server = NULL;
+        return ret;
+    }
 
     s_running = true;
     ESP_LOGI(TAG, "Web server started");
 
-    // Load saved actuators from config
-    load_saved_actuators();
-
     return ESP_OK;
 }
 
 void web_server_deinit(void)
 {
+    sse_stop();
     if (s_server) {
         httpd_stop(s_server);
         s_server = NULL;
@@ -2112,5 +3731,6 @@ esp_err_t web_server_set_auth(const char *username, const char *password)
 {
     if (username) s_config.username = username;
     if (password) s_config.password = password;
+    session_revoke_all();
     return ESP_OK;
 }
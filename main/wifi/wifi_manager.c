@@ -8,16 +8,48 @@
 #include "esp_log.h"
 #include "esp_netif.h"
 #include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_timer.h"
+#include "mbedtls/md.h"
+#include "mbedtls/pkcs5.h"
+#include "sdkconfig.h"
+#include "metrics.h"
 
 static const char *TAG = "WIFI_MGR";
 
 // Event group bits
 #define WIFI_CONNECTED_BIT  BIT0
 #define WIFI_FAIL_BIT       BIT1
+#define WIFI_SCAN_DONE_BIT  BIT2
 
 // Maximum retry attempts
 #define MAX_RETRY_COUNT     5
 
+// Scan results kept for the web interface
+#define SCAN_CACHE_MAX      20
+#define SCAN_WAIT_MS        10000
+
+// Fast reconnect cache
+#define FAST_NVS_NAMESPACE  "wifi_fast"
+#define FAST_NVS_KEY        "ap"
+#define FAST_CACHE_VERSION  1
+#define FAST_TAG_LEN        8
+#define PMK_LEN             32
+
+/**
+ * @brief Access point of the last successful connection, kept in NVS
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint8_t authmode;           // wifi_auth_mode_t
+    uint8_t has_pmk;            // PMK valid (WPA/WPA2-PSK only)
+    uint8_t key_tag[FAST_TAG_LEN]; // HMAC of the SSID keyed by the password
+    char ssid[33];
+    uint8_t pmk[PMK_LEN];
+} fast_cache_t;
+
 // Static variables
 static EventGroupHandle_t s_wifi_event_group = NULL;
 static esp_netif_t *s_sta_netif = NULL;
@@ -27,6 +59,59 @@ static int s_retry_count = 0;
 static bool s_initialized = false;
 static wifi_manager_config_t s_config;
 
+static volatile bool s_fast_attempt = false;    // Fail on the first disconnect
+static volatile int64_t s_connect_start_us = 0; // Connect or link loss, 0 when idle
+static volatile bool s_link_lost = false;
+static wifi_connect_stats_t s_stats;
+
+static wifi_scan_result_t s_scan_cache[SCAN_CACHE_MAX];
+static wifi_scan_result_t s_scan_next[SCAN_CACHE_MAX];  // Filled by the event task
+static uint16_t s_scan_count = 0;
+static int64_t s_scan_time_us = 0;                      // 0 until the first scan completes
+static bool s_scanning = false;
+static int64_t s_scan_start_us = 0;
+static bool s_scan_restore_ap = false;                  // Switched AP -> APSTA to scan
+static portMUX_TYPE s_scan_mux = portMUX_INITIALIZER_UNLOCKED;
+
+METRIC_HISTOGRAM_DEFINE(s_m_connect_ms, "wifi_connect_milliseconds",
+                        "Time from connect request or link loss to IP address",
+                        100, 250, 500, 1000, 2000, 5000, 10000, 30000);
+METRIC_COUNTER_DEFINE(s_m_fast_connects, "wifi_fast_connects", "Connections made to the cached access point without scanning");
+METRIC_COUNTER_DEFINE(s_m_fast_fallbacks, "wifi_fast_connect_fallbacks", "Fast connects that failed and fell back to a full scan");
+METRIC_COUNTER_DEFINE(s_m_reconnects, "wifi_reconnects", "Links restored after a disconnection");
+
+/**
+ * @brief Collect the results of a scan (event task)
+ */
+static void scan_done(void)
+{
+    uint16_t count = 0;
+    wifi_ap_record_t ap;
+    while (count < SCAN_CACHE_MAX && esp_wifi_scan_get_ap_record(&ap) == ESP_OK) {
+        wifi_scan_result_t *r = &s_scan_next[count++];
+        strncpy(r->ssid, (char *)ap.ssid, sizeof(r->ssid) - 1);
+        r->ssid[sizeof(r->ssid) - 1] = '\0';
+        r->rssi = ap.rssi;
+        r->authmode = ap.authmode;
+    }
+    esp_wifi_clear_ap_list();
+
+    if (s_scan_restore_ap) {
+        s_scan_restore_ap = false;
+        esp_wifi_set_mode(WIFI_MODE_AP);
+    }
+
+    portENTER_CRITICAL(&s_scan_mux);
+    memcpy(s_scan_cache, s_scan_next, count * sizeof(s_scan_next[0]));
+    s_scan_count = count;
+    s_scan_time_us = esp_timer_get_time();
+    s_scanning = false;
+    portEXIT_CRITICAL(&s_scan_mux);
+
+    ESP_LOGI(TAG, "Found %d networks", count);
+    xEventGroupSetBits(s_wifi_event_group, WIFI_SCAN_DONE_BIT);
+}
+
 // Event handler
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                int32_t event_id, void *event_data)
@@ -40,7 +125,18 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                 break;
 
             case WIFI_EVENT_STA_DISCONNECTED:
-                if (s_retry_count < MAX_RETRY_COUNT) {
+                if (s_status == WIFI_STATUS_CONNECTED) {
+                    // Link lost: time the way back
+                    s_connect_start_us = esp_timer_get_time();
+                    s_link_lost = true;
+                    s_status = WIFI_STATUS_CONNECTING;
+                }
+                if (s_fast_attempt) {
+                    // The cached access point is gone; let the caller scan
+                    if (s_wifi_event_group) {
+                        xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+                    }
+                } else if (s_retry_count < MAX_RETRY_COUNT) {
                     esp_wifi_connect();
                     s_retry_count++;
                     ESP_LOGW(TAG, "Retry %d/%d", s_retry_count, MAX_RETRY_COUNT);
@@ -53,6 +149,12 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                 }
                 break;
 
+            case WIFI_EVENT_SCAN_DONE:
+                if (s_scanning) {
+                    scan_done();
+                }
+                break;
+
             case WIFI_EVENT_AP_START:
                 ESP_LOGI(TAG, "AP started");
                 s_status = WIFI_STATUS_AP_MODE;
@@ -82,6 +184,17 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         if (event_id == IP_EVENT_STA_GOT_IP) {
             ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
             ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
+            if (s_connect_start_us != 0) {
+                uint32_t ms = (esp_timer_get_time() - s_connect_start_us) / 1000;
+                s_connect_start_us = 0;
+                s_stats.last_connect_ms = ms;
+                metrics_histogram_observe(&s_m_connect_ms, ms);
+            }
+            if (s_link_lost) {
+                s_link_lost = false;
+                s_stats.reconnects++;
+                metrics_counter_add(&s_m_reconnects, 1);
+            }
             s_status = WIFI_STATUS_CONNECTED;
             s_retry_count = 0;
             if (s_wifi_event_group) {
@@ -153,6 +266,11 @@ esp_err_t wifi_manager_init(const wifi_manager_config_t *config)
     // Set WiFi storage to RAM (don't save to NVS automatically)
     ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
 
+    metrics_register(&s_m_connect_ms);
+    metrics_register(&s_m_fast_connects);
+    metrics_register(&s_m_fast_fallbacks);
+    metrics_register(&s_m_reconnects);
+
     s_initialized = true;
     ESP_LOGI(TAG, "WiFi manager initialized");
 
@@ -175,61 +293,230 @@ void wifi_manager_deinit(void)
     s_status = WIFI_STATUS_DISCONNECTED;
 }
 
-esp_err_t wifi_manager_connect(const char *ssid, const char *password)
+// ============================================================================
+// Fast reconnect cache
+// ============================================================================
+
+/**
+ * @brief Tag binding a cache entry to the credentials it was made with
+ */
+static void fast_key_tag(const char *ssid, const char *password, uint8_t tag[FAST_TAG_LEN])
 {
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "Not initialized");
-        return ESP_ERR_INVALID_STATE;
+    uint8_t mac[32];
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                    (const unsigned char *)password, strlen(password),
+                    (const unsigned char *)ssid, strlen(ssid), mac);
+    memcpy(tag, mac, FAST_TAG_LEN);
+}
+
+static bool fast_cache_load(const char *ssid, const char *password, fast_cache_t *cache)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(FAST_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
     }
+    size_t len = sizeof(*cache);
+    esp_err_t ret = nvs_get_blob(nvs, FAST_NVS_KEY, cache, &len);
+    nvs_close(nvs);
+
+    uint8_t tag[FAST_TAG_LEN];
+    fast_key_tag(ssid, password, tag);
+    return ret == ESP_OK && len == sizeof(*cache) &&
+           cache->version == FAST_CACHE_VERSION &&
+           strncmp(cache->ssid, ssid, sizeof(cache->ssid)) == 0 &&
+           memcmp(cache->key_tag, tag, FAST_TAG_LEN) == 0;
+}
 
-    if (ssid == NULL || strlen(ssid) == 0) {
-        ESP_LOGE(TAG, "Invalid SSID");
-        return ESP_ERR_INVALID_ARG;
+/**
+ * @brief Remember the access point just joined
+ *
+ * Writes NVS only when the access point, channel or credentials changed. The
+ * PMK costs 4096 PBKDF2 rounds, which is what the fast connect saves; it is
+ * derived here, once, while the link is already up.
+ */
+static void fast_cache_store(const char *ssid, const char *password, const fast_cache_t *previous)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
     }
 
-    ESP_LOGI(TAG, "Connecting to: %s", ssid);
+    fast_cache_t cache = {
+        .version = FAST_CACHE_VERSION,
+        .channel = ap.primary,
+        .authmode = ap.authmode,
+    };
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+    strncpy(cache.ssid, ssid, sizeof(cache.ssid) - 1);
+    fast_key_tag(ssid, password, cache.key_tag);
+
+    if (previous != NULL && previous->channel == cache.channel &&
+        previous->authmode == cache.authmode &&
+        memcmp(previous->bssid, cache.bssid, sizeof(cache.bssid)) == 0) {
+        return;
+    }
+
+    // WPA3 (SAE) derives its keys per association: only PSK networks have a PMK
+    size_t pw_len = strlen(password);
+    if ((ap.authmode == WIFI_AUTH_WPA_PSK || ap.authmode == WIFI_AUTH_WPA2_PSK ||
+         ap.authmode == WIFI_AUTH_WPA_WPA2_PSK) && pw_len >= 8 && pw_len < 64) {
+        if (previous != NULL && previous->has_pmk) {
+            memcpy(cache.pmk, previous->pmk, PMK_LEN);     // Same credentials
+        } else {
+            mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1,
+                                          (const unsigned char *)password, pw_len,
+                                          (const unsigned char *)ssid, strlen(ssid),
+                                          4096, PMK_LEN, cache.pmk);
+        }
+        cache.has_pmk = 1;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(FAST_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(nvs, FAST_NVS_KEY, &cache, sizeof(cache));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save fast connect cache: %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGI(TAG, "Fast connect cache: %02x:%02x:%02x:%02x:%02x:%02x, channel %d%s",
+             cache.bssid[0], cache.bssid[1], cache.bssid[2],
+             cache.bssid[3], cache.bssid[4], cache.bssid[5],
+             cache.channel, cache.has_pmk ? ", PMK" : "");
+}
 
+/**
+ * @brief Start the station and wait for an IP address
+ *
+ * @param cache Access point to join directly, NULL to scan for the SSID
+ */
+static esp_err_t sta_connect(const char *ssid, const char *password,
+                             const fast_cache_t *cache, uint32_t timeout_ms)
+{
     // Stop any existing connection
     esp_wifi_stop();
 
     // Configure station mode
     wifi_config_t wifi_config = {0};
     strncpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
-    if (password) {
+    if (cache != NULL && cache->has_pmk) {
+        // 64 hex digits are taken as the PSK itself, skipping PBKDF2
+        for (int i = 0; i < PMK_LEN; i++) {
+            static const char hex[] = "0123456789abcdef";
+            wifi_config.sta.password[2 * i] = hex[cache->pmk[i] >> 4];
+            wifi_config.sta.password[2 * i + 1] = hex[cache->pmk[i] & 0x0F];
+        }
+    } else if (password) {
         strncpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
     }
     wifi_config.sta.threshold.authmode = password && strlen(password) > 0 ?
                                          WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
-
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
+    if (cache != NULL) {
+        // Directed connect: probe one channel for one BSSID
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, cache->bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = cache->channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    }
 
     // Clear event bits
     xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
     s_retry_count = 0;
+    s_fast_attempt = cache != NULL;
     s_status = WIFI_STATUS_CONNECTING;
 
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_start());
+
     // Wait for connection
     EventBits_t bits = xEventGroupWaitBits(
         s_wifi_event_group,
         WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
         pdFALSE, pdFALSE,
-        pdMS_TO_TICKS(s_config.sta_timeout_ms)
+        pdMS_TO_TICKS(timeout_ms)
     );
+    s_fast_attempt = false;
+
+    return (bits & WIFI_CONNECTED_BIT) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t wifi_manager_connect(const char *ssid, const char *password)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "Not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (ssid == NULL || strlen(ssid) == 0) {
+        ESP_LOGE(TAG, "Invalid SSID");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (password == NULL) {
+        password = "";
+    }
+
+    ESP_LOGI(TAG, "Connecting to: %s", ssid);
 
-    if (bits & WIFI_CONNECTED_BIT) {
-        // Save successful connection
-        strncpy(s_config.sta_ssid, ssid, sizeof(s_config.sta_ssid) - 1);
-        if (password) {
-            strncpy(s_config.sta_password, password, sizeof(s_config.sta_password) - 1);
+    // Before stopping the station, so its disconnection is not a link loss
+    s_status = WIFI_STATUS_CONNECTING;
+    s_link_lost = false;
+    s_connect_start_us = esp_timer_get_time();
+
+    esp_err_t ret = ESP_FAIL;
+    fast_cache_t cache;
+    bool cached = false;
+#if CONFIG_WIFI_FAST_CONNECT
+    cached = fast_cache_load(ssid, password, &cache);
+    if (cached) {
+        ret = sta_connect(ssid, password, &cache, CONFIG_WIFI_FAST_CONNECT_TIMEOUT_MS);
+        if (ret == ESP_OK) {
+            s_stats.fast_connects++;
+            metrics_counter_add(&s_m_fast_connects, 1);
+        } else {
+            ESP_LOGW(TAG, "Fast connect failed, scanning");
+            s_stats.fast_fallbacks++;
+            metrics_counter_add(&s_m_fast_fallbacks, 1);
         }
-        return ESP_OK;
-    } else {
+    }
+#endif
+    if (ret != ESP_OK) {
+        ret = sta_connect(ssid, password, NULL, s_config.sta_timeout_ms);
+        if (ret == ESP_OK) {
+            s_stats.full_connects++;
+        }
+    }
+
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Connection failed");
+        s_connect_start_us = 0;
         s_status = WIFI_STATUS_DISCONNECTED;
         return ESP_FAIL;
     }
+
+    ESP_LOGI(TAG, "Connected in %lu ms", (unsigned long)s_stats.last_connect_ms);
+
+    // Save successful connection
+    strncpy(s_config.sta_ssid, ssid, sizeof(s_config.sta_ssid) - 1);
+    strncpy(s_config.sta_password, password, sizeof(s_config.sta_password) - 1);
+#if CONFIG_WIFI_FAST_CONNECT
+    fast_cache_store(ssid, password, cached ? &cache : NULL);
+#endif
+    return ESP_OK;
+}
+
+esp_err_t wifi_manager_get_connect_stats(wifi_connect_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = s_stats;
+    return ESP_OK;
 }
 
 esp_err_t wifi_manager_disconnect(void)
@@ -344,20 +631,35 @@ int8_t wifi_manager_get_rssi(void)
     return 0;
 }
 
-esp_err_t wifi_manager_scan(wifi_scan_result_t *results, uint16_t max_results, uint16_t *found)
+esp_err_t wifi_manager_scan_start(void)
 {
-    if (!s_initialized || results == NULL || found == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // A scan whose SCAN_DONE never came (WiFi stopped meanwhile) is restarted
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_scan_mux);
+    bool running = s_scanning && now - s_scan_start_us < SCAN_WAIT_MS * 1000LL;
+    if (!running) {
+        s_scanning = true;
+        s_scan_start_us = now;
+    }
+    portEXIT_CRITICAL(&s_scan_mux);
+    if (running) {
+        return ESP_OK;      // Served by the scan in progress
     }
 
     ESP_LOGI(TAG, "Starting WiFi scan...");
+    xEventGroupClearBits(s_wifi_event_group, WIFI_SCAN_DONE_BIT);
 
-    // If in AP mode, need to switch temporarily
+    // If in AP mode, need to switch until the scan is done
     wifi_mode_t current_mode;
     esp_wifi_get_mode(&current_mode);
 
     if (current_mode == WIFI_MODE_AP) {
         esp_wifi_set_mode(WIFI_MODE_APSTA);
+        s_scan_restore_ap = true;
     } else if (current_mode == WIFI_MODE_NULL) {
         esp_wifi_set_mode(WIFI_MODE_STA);
         esp_wifi_start();
@@ -374,45 +676,61 @@ esp_err_t wifi_manager_scan(wifi_scan_result_t *results, uint16_t max_results, u
         .scan_time.active.max = 300,
     };
 
-    esp_err_t ret = esp_wifi_scan_start(&scan_config, true);
+    // Results arrive with WIFI_EVENT_SCAN_DONE
+    esp_err_t ret = esp_wifi_scan_start(&scan_config, false);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Scan failed: %s", esp_err_to_name(ret));
-        return ret;
+        if (s_scan_restore_ap) {
+            s_scan_restore_ap = false;
+            esp_wifi_set_mode(WIFI_MODE_AP);
+        }
+        portENTER_CRITICAL(&s_scan_mux);
+        s_scanning = false;
+        portEXIT_CRITICAL(&s_scan_mux);
+        xEventGroupSetBits(s_wifi_event_group, WIFI_SCAN_DONE_BIT);
     }
+    return ret;
+}
 
-    // Get scan results
-    uint16_t ap_count = 0;
-    esp_wifi_scan_get_ap_num(&ap_count);
+bool wifi_manager_is_scanning(void)
+{
+    return s_scanning;
+}
 
-    if (ap_count == 0) {
-        *found = 0;
-        return ESP_OK;
+esp_err_t wifi_manager_get_scan_results(wifi_scan_result_t *results, uint16_t max_results,
+                                        uint16_t *found, uint32_t *age_ms)
+{
+    if (results == NULL || found == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    uint16_t to_get = (ap_count < max_results) ? ap_count : max_results;
-    wifi_ap_record_t *ap_records = malloc(to_get * sizeof(wifi_ap_record_t));
-    if (ap_records == NULL) {
-        return ESP_ERR_NO_MEM;
-    }
+    portENTER_CRITICAL(&s_scan_mux);
+    uint16_t count = s_scan_count < max_results ? s_scan_count : max_results;
+    memcpy(results, s_scan_cache, count * sizeof(s_scan_cache[0]));
+    int64_t time_us = s_scan_time_us;
+    portEXIT_CRITICAL(&s_scan_mux);
 
-    ret = esp_wifi_scan_get_ap_records(&to_get, ap_records);
-    if (ret == ESP_OK) {
-        for (uint16_t i = 0; i < to_get; i++) {
-            strncpy(results[i].ssid, (char *)ap_records[i].ssid, sizeof(results[i].ssid) - 1);
-            results[i].ssid[sizeof(results[i].ssid) - 1] = '\0';
-            results[i].rssi = ap_records[i].rssi;
-            results[i].authmode = ap_records[i].authmode;
-        }
-        *found = to_get;
-        ESP_LOGI(TAG, "Found %d networks", to_get);
+    *found = count;
+    if (age_ms != NULL) {
+        *age_ms = time_us ? (esp_timer_get_time() - time_us) / 1000 : 0;
     }
+    return time_us ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
 
-    free(ap_records);
-
-    // Restore mode if needed
-    if (current_mode == WIFI_MODE_AP) {
-        esp_wifi_set_mode(WIFI_MODE_AP);
+esp_err_t wifi_manager_scan(wifi_scan_result_t *results, uint16_t max_results, uint16_t *found)
+{
+    if (!s_initialized || results == NULL || found == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    return ret;
+    esp_err_t ret = wifi_manager_scan_start();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group, WIFI_SCAN_DONE_BIT,
+                                           pdFALSE, pdFALSE, pdMS_TO_TICKS(SCAN_WAIT_MS));
+    if (!(bits & WIFI_SCAN_DONE_BIT)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return wifi_manager_get_scan_results(results, max_results, found, NULL);
 }
@@ -41,6 +41,17 @@ typedef struct {
     wifi_auth_mode_t authmode;
 } wifi_scan_result_t;
 
+/**
+ * @brief Station connection statistics
+ */
+typedef struct {
+    uint32_t last_connect_ms;   // Connect request or link loss to IP address
+    uint32_t fast_connects;     // Joined the cached access point without scanning
+    uint32_t fast_fallbacks;    // Cached access point failed, scanned instead
+    uint32_t full_connects;     // Joined after a scan
+    uint32_t reconnects;        // Links restored after a disconnection
+} wifi_connect_stats_t;
+
 /**
  * @brief Initialize WiFi manager
  * @param config Configuration (can be NULL for defaults)
@@ -55,12 +66,23 @@ void wifi_manager_deinit(void);
 
 /**
  * @brief Start WiFi in station mode
+ *
+ * Joins the access point of the last successful connection directly (BSSID,
+ * channel and PMK cached in NVS) and falls back to a scan if that fails.
+ *
  * @param ssid Network SSID
  * @param password Network password
  * @return esp_err_t ESP_OK on success
  */
 esp_err_t wifi_manager_connect(const char *ssid, const char *password);
 
+/**
+ * @brief Get station connection statistics
+ * @param stats Pointer to store the statistics
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t wifi_manager_get_connect_stats(wifi_connect_stats_t *stats);
+
 /**
  * @brief Disconnect from WiFi
  */
@@ -112,7 +134,34 @@ esp_err_t wifi_manager_get_ssid(char *ssid_str);
 int8_t wifi_manager_get_rssi(void);
 
 /**
- * @brief Scan for WiFi networks
+ * @brief Start a scan in the background
+ *
+ * Returns at once; the results replace the cached ones when the scan is
+ * done. A request while a scan is running is served by that scan.
+ *
+ * @return esp_err_t ESP_OK if a scan is running, error if it could not start
+ */
+esp_err_t wifi_manager_scan_start(void);
+
+/**
+ * @brief Check if a background scan is running
+ * @return true while scanning
+ */
+bool wifi_manager_is_scanning(void);
+
+/**
+ * @brief Get the results of the last completed scan
+ * @param results Array to store results
+ * @param max_results Maximum number of results
+ * @param found Pointer to store number of networks found
+ * @param age_ms Pointer to store the age of the results (can be NULL)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no scan has completed yet
+ */
+esp_err_t wifi_manager_get_scan_results(wifi_scan_result_t *results, uint16_t max_results,
+                                        uint16_t *found, uint32_t *age_ms);
+
+/**
+ * @brief Scan for WiFi networks and wait for the results
  * @param results Array to store results
  * @param max_results Maximum number of results
  * @param found Pointer to store number of networks found
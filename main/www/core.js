@@ -52,10 +52,15 @@ async function api(endpoint, method = 'GET', data = null) {
         connectionState.connected = true;
         connectionState.lastSuccessfulPing = Date.now();
 
+        if (res.status === 401) {
+            showLogin();
+            throw new Error('Unauthorized');
+        }
+
         return await res.json();
     } catch (e) {
         // Network error - trigger reconnection if we were connected
-        if (connectionState.connected) {
+        if (e.message !== 'Unauthorized' && connectionState.connected) {
             toast('Communication error', 'error');
             startReconnection();
         }
@@ -64,6 +69,36 @@ async function api(endpoint, method = 'GET', data = null) {
     }
 }
 
+// ============================================================================
+// Login
+// ============================================================================
+
+// The session cookie is sent with every request; credentials only here
+function showLogin() {
+    document.getElementById('login-modal').classList.add('show');
+    document.getElementById('login-user').focus();
+}
+
+async function login() {
+    const username = document.getElementById('login-user').value;
+    const password = document.getElementById('login-pass').value;
+    const res = await fetch('/api/login', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ username, password })
+    });
+    if (res.ok) {
+        location.reload();
+    } else {
+        toast('Invalid credentials', 'error');
+    }
+}
+
+async function logout() {
+    await fetch('/api/logout', { method: 'POST' });
+    location.reload();
+}
+
 // ============================================================================
 // Connection State Management
 // ============================================================================
@@ -145,26 +180,89 @@ async function checkConnection() {
         });
 
         clearTimeout(timeoutId);
-        return res.ok;
+        return res.ok || res.status === 401;
     } catch (e) {
         return false;
     }
 }
 
+// ============================================================================
+// Event Stream
+// ============================================================================
+
+// One /api/events connection replaces the polling loops. Pollers keep
+// their timers but skip their fetch while the stream is live, so they take
+// over as soon as it drops (no EventSource, stream refused, server gone).
+const events = {
+    source: null,
+    live: false,
+    topics: new Set(['status', 'actuators', 'health']),
+    handlers: {},
+    retryTimer: null
+};
+
+const EVENTS_INTERVAL_MS = 1000;
+const EVENTS_RETRY_MS = 30000;
+
+function onEvent(type, fn) {
+    (events.handlers[type] = events.handlers[type] || []).push(fn);
+}
+
+// Add a topic; reopens the stream, whose topics are fixed when it opens
+function subscribeEvents(topic) {
+    if (events.topics.has(topic)) return;
+    events.topics.add(topic);
+    if (events.source) openEvents();
+}
+
+function openEvents() {
+    if (!window.EventSource) return;
+    if (events.source) events.source.close();
+    clearTimeout(events.retryTimer);
+
+    const topics = [...events.topics].join(',');
+    const src = new EventSource(`/api/events?topics=${topics}&interval=${EVENTS_INTERVAL_MS}`);
+    events.source = src;
+
+    src.onopen = () => { events.live = true; };
+    src.onerror = () => {
+        events.live = false;
+        // The browser retries dropped streams itself, but not refused ones
+        if (src.readyState === EventSource.CLOSED && events.source === src) {
+            events.source = null;
+            events.retryTimer = setTimeout(openEvents, EVENTS_RETRY_MS);
+        }
+    };
+    for (const type of ['status', 'actuators', 'health', 'tasks']) {
+        src.addEventListener(type, (e) => {
+            const d = JSON.parse(e.data);
+            (events.handlers[type] || []).forEach(fn => fn(d));
+        });
+    }
+}
+
 // ============================================================================
 // Status Badge Updates
 // ============================================================================
 
+function renderStatusBadges(d) {
+    const wifiBadge = document.getElementById('wifi-badge');
+    const modbusBadge = document.getElementById('modbus-badge');
+    wifiBadge.className = 'badge ' + (d.wifi_status >= 3 ? 'on' : 'off');
+    modbusBadge.className = 'badge ' + (d.modbus_ready ? 'on' : 'off');
+    const down = (d.buses || []).filter(b => !b.modbus_ready).map(b => b.bus);
+    modbusBadge.title = down.length ? `Bus ${down.join(', ')} down` : '';
+}
+
 async function updateStatusBadges() {
+    if (events.live) return;
     try {
-        const d = await api('status');
-        const wifiBadge = document.getElementById('wifi-badge');
-        const modbusBadge = document.getElementById('modbus-badge');
-        wifiBadge.className = 'badge ' + (d.wifi_status >= 3 ? 'on' : 'off');
-        modbusBadge.className = 'badge ' + (d.modbus_ready ? 'on' : 'off');
+        renderStatusBadges(await api('status'));
     } catch (e) {}
 }
 
+onEvent('status', renderStatusBadges);
+
 // ============================================================================
 // Lazy Loading System
 // ============================================================================
@@ -240,9 +338,10 @@ document.querySelectorAll('.nav-btn').forEach(btn => {
 // ============================================================================
 
 document.addEventListener('DOMContentLoaded', () => {
-    // Update status badges
+    // Status badges: from the event stream, polled while it is down
     updateStatusBadges();
     setInterval(updateStatusBadges, 10000);
+    openEvents();
 
     // Load initial tab (actuators)
     loadModule('actuators');
@@ -1,6 +1,7 @@
 // Actuators Module
 
 let selectedActuatorId = null;
+let selectedActuatorBus = 0;
 let actuatorsData = [];
 let actuatorsInterval = null;
 
@@ -16,6 +17,40 @@ async function refreshActuators() {
     } catch (e) {}
 }
 
+// Poll only while the event stream is down
+function pollActuators() {
+    if (!events.live) refreshActuators();
+}
+
+onEvent('actuators', (d) => {
+    actuatorsData = d.actuators || [];
+    renderActuators();
+});
+
+// Toast actuators changing health or going offline
+let actuatorsHealth = null;
+
+onEvent('health', (d) => {
+    const health = {};
+    d.actuators.forEach(act => {
+        health[actuatorLabel(act)] = act.connected ? act.health : 'offline';
+    });
+    if (actuatorsHealth) {
+        for (const [label, state] of Object.entries(health)) {
+            const prev = actuatorsHealth[label];
+            if (prev !== undefined && prev !== state) {
+                toast(`Actuator ${label}: ${state}`, state === 'healthy' ? 'success' : 'error');
+            }
+        }
+    }
+    actuatorsHealth = health;
+});
+
+// "id" on the first bus, "bus:id" on the others
+function actuatorLabel(act) {
+    return act.bus ? `${act.bus}:${act.id}` : `${act.id}`;
+}
+
 function renderActuators() {
     const container = document.getElementById('actuators-container');
 
@@ -29,18 +64,20 @@ function renderActuators() {
     }
 
     container.innerHTML = actuatorsData.map(act => `
-        <div class="actuator-card" onclick="openActuator(${act.id})">
-            <div class="id">${act.id}</div>
+        <div class="actuator-card" onclick="openActuator(${act.bus || 0}, ${act.id})">
+            <div class="id">${actuatorLabel(act)}</div>
             <div class="info">
                 <div class="name">${act.name || 'Actuator #' + act.id}</div>
                 <div class="stats">
                     ${act.connected ?
                         `Pos: ${act.position} | ${act.current}mA | ${act.voltage.toFixed(1)}V` :
+                        act.health === 'quarantined' ?
+                        `Offline - retry in ${Math.ceil(act.next_probe_ms / 1000)}s` :
                         'Disconnected'}
                 </div>
             </div>
-            <div class="status-dot ${act.connected ? 'on' : ''}"></div>
-            <button class="remove" onclick="event.stopPropagation(); removeActuator(${act.id})" title="Remove">
+            <div class="status-dot ${act.connected ? 'on' : (act.health || '')}"></div>
+            <button class="remove" onclick="event.stopPropagation(); removeActuator(${act.bus || 0}, ${act.id})" title="Remove">
                 <svg width="14" height="14" viewBox="0 0 24 24" fill="currentColor">
                     <path d="M19 6.41L17.59 5 12 10.59 6.41 5 5 6.41 10.59 12 5 17.59 6.41 19 12 13.41 17.59 19 19 17.59 13.41 12z"/>
                 </svg>
@@ -67,17 +104,22 @@ async function scanActuators() {
 }
 
 function addActuatorPrompt() {
-    const id = prompt('Enter actuator ID (1-247):');
-    if (id && !isNaN(id) && id >= 1 && id <= 247) {
-        addActuator(parseInt(id));
+    const input = prompt('Enter actuator ID (1-247), or bus:ID:');
+    if (!input) return;
+
+    const parts = input.split(':');
+    const bus = parts.length > 1 ? parseInt(parts[0]) : 0;
+    const id = parseInt(parts[parts.length - 1]);
+    if (!isNaN(bus) && bus >= 0 && !isNaN(id) && id >= 1 && id <= 247) {
+        addActuator(bus, id);
     }
 }
 
-async function addActuator(id) {
+async function addActuator(bus, id) {
     try {
-        const r = await api('actuator/add', 'POST', { id });
+        const r = await api('actuator/add', 'POST', { bus, id });
         if (r.success) {
-            toast(`Actuator ${id} added`, 'success');
+            toast(`Actuator ${actuatorLabel({ bus, id })} added`, 'success');
             refreshActuators();
         } else {
             toast(r.message || 'Failed to add', 'error');
@@ -85,12 +127,13 @@ async function addActuator(id) {
     } catch (e) {}
 }
 
-async function removeActuator(id) {
-    if (!confirm(`Remove actuator ${id}?`)) return;
+async function removeActuator(bus, id) {
+    const label = actuatorLabel({ bus, id });
+    if (!confirm(`Remove actuator ${label}?`)) return;
     try {
-        const r = await api('actuator/remove', 'POST', { id });
+        const r = await api('actuator/remove', 'POST', { bus, id });
         if (r.success) {
-            toast(`Actuator ${id} removed`, 'success');
+            toast(`Actuator ${label} removed`, 'success');
             refreshActuators();
         }
     } catch (e) {}
@@ -100,12 +143,13 @@ async function removeActuator(id) {
 // Modal
 // ============================================================================
 
-function openActuator(id) {
+function openActuator(bus, id) {
     selectedActuatorId = id;
-    const act = actuatorsData.find(a => a.id === id);
+    selectedActuatorBus = bus;
+    const act = actuatorsData.find(a => (a.bus || 0) === bus && a.id === id);
     if (!act) return;
 
-    document.getElementById('modal-act-id').textContent = '#' + id;
+    document.getElementById('modal-act-id').textContent = '#' + actuatorLabel(act);
     document.getElementById('modal-act-name').value = act.name || '';
 
     if (act.connected) {
@@ -129,6 +173,7 @@ async function saveActuatorName() {
 
     try {
         const r = await api('actuator/set-name', 'POST', {
+            bus: selectedActuatorBus,
             id: selectedActuatorId,
             name: name
         });
@@ -162,7 +207,7 @@ function syncSliders() {
 async function setForce(on) {
     if (!selectedActuatorId) return;
     try {
-        const r = await api('actuator/control', 'POST', { id: selectedActuatorId, force: on });
+        const r = await api('actuator/control', 'POST', { bus: selectedActuatorBus, id: selectedActuatorId, force: on });
         if (r.success) {
             toast(`Force ${on ? 'enabled' : 'disabled'}`, 'success');
             document.getElementById('btn-force-on').classList.toggle('active', on);
@@ -187,6 +232,7 @@ async function sendActuatorCommand() {
 
     try {
         const r = await api('actuator/control', 'POST', {
+            bus: selectedActuatorBus,
             id: selectedActuatorId,
             goal: { position: pos, speed: spd, current: cur }
         });
@@ -215,7 +261,7 @@ function initActuators() {
 
     // Start refresh interval (reduced frequency to avoid RS485 congestion)
     if (actuatorsInterval) clearInterval(actuatorsInterval);
-    actuatorsInterval = setInterval(refreshActuators, 3000);
+    actuatorsInterval = setInterval(pollActuators, 3000);
 
     // Initial load
     refreshActuators();
@@ -4,19 +4,31 @@
 // WiFi
 // ============================================================================
 
+function showNetworks(nets) {
+    const sel = document.getElementById('wifi-select');
+    const current = sel.value;
+    sel.innerHTML = '<option value="">Select network...</option>';
+    nets.forEach(n => {
+        const opt = document.createElement('option');
+        opt.value = n.ssid;
+        opt.textContent = `${n.ssid} (${n.rssi} dBm)`;
+        sel.appendChild(opt);
+    });
+    sel.value = current;
+}
+
 async function scanWiFi() {
     toast('Scanning...', 'info');
     try {
-        const nets = await api('wifi/scan');
-        const sel = document.getElementById('wifi-select');
-        sel.innerHTML = '<option value="">Select network...</option>';
-        nets.forEach(n => {
-            const opt = document.createElement('option');
-            opt.value = n.ssid;
-            opt.textContent = `${n.ssid} (${n.rssi} dBm)`;
-            sel.appendChild(opt);
-        });
-        toast(`Found ${nets.length} networks`, 'success');
+        // Cached results come back at once; poll until the fresh scan is done
+        let r = await api('wifi/scan?refresh=1');
+        showNetworks(r.networks);
+        for (let i = 0; r.scanning && i < 20; i++) {
+            await new Promise(res => setTimeout(res, 500));
+            r = await api('wifi/scan');
+        }
+        showNetworks(r.networks);
+        toast(`Found ${r.networks.length} networks`, 'success');
     } catch (e) {}
 }
 
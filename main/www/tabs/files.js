@@ -3,6 +3,8 @@
 let fmPartition = 'www';
 let fmPath = '/';
 let fmEditingFile = null;
+let fmFiles = [];
+let fmNext = null;         // Cursor of the next page, null when the listing is complete
 
 // ============================================================================
 // Partition & Navigation
@@ -40,23 +42,41 @@ function fmNavigateUp() {
 // File List
 // ============================================================================
 
+// One page of the listing; pages come sorted (folders first, then by name)
+async function fmFetchPage(cursor) {
+    let url = `/api/files/list?partition=${fmPartition}&dir=${encodeURIComponent(fmPath)}`;
+    if (cursor) url += `&cursor=${encodeURIComponent(cursor)}`;
+    const res = await fetch(url);
+    if (!res.ok) throw new Error(await res.text() || 'Failed');
+    return await res.json();
+}
+
 async function fmRefresh() {
     const list = document.getElementById('fm-file-list');
     list.innerHTML = '<div class="fm-empty">Loading...</div>';
 
     try {
-        const res = await fetch(`/api/files/list?partition=${fmPartition}&dir=${encodeURIComponent(fmPath)}`);
-        const data = await res.json();
-
-        if (!res.ok) throw new Error(data.error || 'Failed');
-
-        fmRenderFiles(data.files || []);
+        const data = await fmFetchPage(null);
+        fmFiles = data.files || [];
+        fmNext = data.next;
+        fmRenderFiles(fmFiles);
         fmUpdateStorageInfo();
     } catch (e) {
         list.innerHTML = `<div class="fm-empty">Error: ${e.message}</div>`;
     }
 }
 
+async function fmLoadMore() {
+    try {
+        const data = await fmFetchPage(fmNext);
+        fmFiles = fmFiles.concat(data.files || []);
+        fmNext = data.next;
+        fmRenderFiles(fmFiles);
+    } catch (e) {
+        toast('Failed to list files: ' + e.message, 'error');
+    }
+}
+
 function fmRenderFiles(files) {
     const list = document.getElementById('fm-file-list');
 
@@ -79,13 +99,6 @@ function fmRenderFiles(files) {
             </div>`;
     }
 
-    // Sort: dirs first
-    files.sort((a, b) => {
-        if (a.isDir && !b.isDir) return -1;
-        if (!a.isDir && b.isDir) return 1;
-        return a.name.localeCompare(b.name);
-    });
-
     files.forEach(f => {
         const icon = f.isDir ? '📁' : fmGetIcon(f.name);
         const size = f.isDir ? '' : formatBytes(f.size);
@@ -107,6 +120,10 @@ function fmRenderFiles(files) {
             </div>`;
     });
 
+    if (fmNext) {
+        html += `<div class="fm-empty"><button class="btn" onclick="fmLoadMore()">Load more</button></div>`;
+    }
+
     list.innerHTML = html || '<div class="fm-empty">No files</div>';
 }
 
@@ -4,66 +4,82 @@ let tasksRefreshInterval = null;
 async function refreshTasks() {
     try {
         const response = await fetch('/api/tasks');
-        const data = await response.json();
-        
-        // Update stats
-        document.getElementById('heap-free').textContent = formatBytes(data.heap_free);
-        document.getElementById('heap-min').textContent = formatBytes(data.heap_min);
-        document.getElementById('uptime').textContent = formatUptime(data.uptime_s);
-        document.getElementById('task-count').textContent = data.task_count;
-        
-        // Sort tasks by CPU usage
-        const tasks = data.tasks.sort((a, b) => b.cpu_percent - a.cpu_percent);
-        
-        // Update table
-        const tbody = document.getElementById('tasks-tbody');
-        tbody.innerHTML = tasks.map(task => `
-            <tr>
-                <td><strong>${task.name}</strong></td>
-                <td><span class="state-${task.state}">${task.state}</span></td>
-                <td>${task.priority}</td>
-                <td>${task.cpu_percent}%</td>
-                <td>${formatBytes(task.stack_hwm * 4)}</td>
-            </tr>
-        `).join('');
-        
-        // Update CPU bars
-        const cpuBars = document.getElementById('cpu-bars');
+        renderTasks(await response.json());
+    } catch (error) {
+        console.error('Failed to fetch tasks:', error);
+    }
+}
+
+// Poll only while the event stream is down
+function pollTasks() {
+    if (!events.live) refreshTasks();
+}
+
+function renderTasks(data) {
+    // Update stats
+    document.getElementById('heap-free').textContent = formatBytes(data.heap_free);
+    document.getElementById('heap-min').textContent = formatBytes(data.heap_min);
+    document.getElementById('uptime').textContent = formatUptime(data.uptime_s);
+    document.getElementById('task-count').textContent = data.task_count;
+    
+    // Sort tasks by CPU usage (last sampling interval)
+    const tasks = data.tasks.sort((a, b) => b.cpu_percent - a.cpu_percent);
+    
+    // Update table (stack_hwm is in bytes)
+    const tbody = document.getElementById('tasks-tbody');
+    tbody.innerHTML = tasks.map(task => `
+        <tr>
+            <td><strong>${task.name}</strong></td>
+            <td><span class="state-${task.state}">${task.state}</span></td>
+            <td>${task.priority}</td>
+            <td>${task.cpu_percent.toFixed(1)}%</td>
+            <td>${task.cpu_avg.toFixed(1)}%</td>
+            <td>${task.cpu_peak.toFixed(1)}%</td>
+            <td>${formatBytes(task.stack_hwm)}</td>
+        </tr>
+    `).join('');
+    
+    // Update CPU bars
+    const cpuBars = document.getElementById('cpu-bars');
 
-        // Separate IDLE tasks (core idle) from other tasks
-        const idleTasks = tasks.filter(t => t.name === 'IDLE0' || t.name === 'IDLE1');
-        const otherTasks = tasks.filter(t => t.name !== 'IDLE0' && t.name !== 'IDLE1');
+    // Idle tasks are listed in the table but not as bars
+    const otherTasks = tasks.filter(t => !t.name.startsWith('IDLE'));
 
-        // Format core usage display (100% - idle = usage)
-        const coreUsageHtml = idleTasks.map(task => {
-            const coreNum = task.name === 'IDLE0' ? '0' : '1';
-            const usagePercent = 100 - task.cpu_percent;
-            return `
-            <div class="cpu-bar">
-                <span class="cpu-bar-label">Core ${coreNum}</span>
-                <div class="cpu-bar-track">
-                    <div class="cpu-bar-fill" style="width: ${Math.min(usagePercent, 100)}%"></div>
-                </div>
-                <span class="cpu-bar-value">${usagePercent}%</span>
-            </div>`;
-        }).join('');
+    // Core load with its history
+    const coreUsageHtml = data.cores.map(core => `
+        <div class="cpu-bar">
+            <span class="cpu-bar-label">Core ${core.core}</span>
+            <div class="cpu-bar-track">
+                <div class="cpu-bar-fill" style="width: ${Math.min(core.load, 100)}%"></div>
+            </div>
+            <span class="cpu-bar-value">${core.load.toFixed(0)}%</span>
+        </div>
+        ${historyGraph(core.history)}
+    `).join('');
 
-        // Top 4 other tasks by CPU usage
-        const otherTasksHtml = otherTasks.slice(0, 4).map(task => `
-            <div class="cpu-bar">
-                <span class="cpu-bar-label">${task.name}</span>
-                <div class="cpu-bar-track">
-                    <div class="cpu-bar-fill" style="width: ${Math.min(task.cpu_percent, 100)}%"></div>
-                </div>
-                <span class="cpu-bar-value">${task.cpu_percent}%</span>
+    // Top 4 other tasks by CPU usage
+    const otherTasksHtml = otherTasks.slice(0, 4).map(task => `
+        <div class="cpu-bar">
+            <span class="cpu-bar-label">${task.name}</span>
+            <div class="cpu-bar-track">
+                <div class="cpu-bar-fill" style="width: ${Math.min(task.cpu_percent, 100)}%"></div>
             </div>
-        `).join('');
+            <span class="cpu-bar-value">${task.cpu_percent}%</span>
+        </div>
+    `).join('');
 
-        cpuBars.innerHTML = coreUsageHtml + otherTasksHtml;
-        
-    } catch (error) {
-        console.error('Failed to fetch tasks:', error);
-    }
+    cpuBars.innerHTML = coreUsageHtml + otherTasksHtml;
+}
+
+// Load history (percent, oldest first) as a line graph
+function historyGraph(history) {
+    if (!history || history.length < 2) return '';
+    const step = 100 / (history.length - 1);
+    const points = history.map((v, i) => `${(i * step).toFixed(1)},${100 - v}`).join(' ');
+    return `
+        <svg class="cpu-history" viewBox="0 0 100 100" preserveAspectRatio="none">
+            <polyline points="${points}" fill="none" stroke="currentColor" stroke-width="2" vector-effect="non-scaling-stroke" />
+        </svg>`;
 }
 
 function formatBytes(bytes) {
@@ -82,12 +98,19 @@ function formatUptime(seconds) {
 
 function initTasksTab() {
     refreshTasks();
+
+    // Task stats come with the event stream once subscribed
+    onEvent('tasks', (data) => {
+        const autoRefresh = document.getElementById('auto-refresh');
+        if (!autoRefresh || autoRefresh.checked) renderTasks(data);
+    });
+    subscribeEvents('tasks');
     
     const autoRefresh = document.getElementById('auto-refresh');
     if (autoRefresh) {
         autoRefresh.addEventListener('change', function() {
             if (this.checked) {
-                tasksRefreshInterval = setInterval(refreshTasks, 2000);
+                tasksRefreshInterval = setInterval(pollTasks, 2000);
             } else {
                 clearInterval(tasksRefreshInterval);
             }
@@ -95,7 +118,7 @@ function initTasksTab() {
         
         // Start auto-refresh
         if (autoRefresh.checked) {
-            tasksRefreshInterval = setInterval(refreshTasks, 2000);
+            tasksRefreshInterval = setInterval(pollTasks, 2000);
         }
     }
 }
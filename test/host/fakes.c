@@ -0,0 +1,78 @@
+/**
+ * @file fakes.c
+ * @brief Host versions of the firmware services the tested modules call
+ *
+ * Allocations go straight to the C library, metrics are plain counters and
+ * the ROM CRC32 is zlib's, which computes the same checksum.
+ */
+
+#include <stdlib.h>
+#include <zlib.h>
+
+#include "esp_err.h"
+#include "esp_rom_crc.h"
+#include "memprof.h"
+#include "metrics.h"
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len)
+{
+    return (uint32_t)crc32(crc, buf, len);
+}
+
+// ============================================================================
+// Memory
+// ============================================================================
+
+void *memprof_malloc(memprof_tag_t tag, size_t size)
+{
+    return malloc(size);
+}
+
+void *memprof_calloc(memprof_tag_t tag, size_t n, size_t size)
+{
+    return calloc(n, size);
+}
+
+void *memprof_realloc(memprof_tag_t tag, void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void memprof_free(memprof_tag_t tag, void *ptr)
+{
+    free(ptr);
+}
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+void metrics_register(metric_t *metric)
+{
+    atomic_store(&metric->registered, true);
+}
+
+void metrics_counter_add(metric_t *metric, uint32_t n)
+{
+    metric->cells[0] += n;
+}
+
+uint64_t metrics_counter_get(const metric_t *metric)
+{
+    return metric->cells[0];
+}
+
+void metrics_gauge_set(metric_t *metric, int32_t value)
+{
+    atomic_store(&metric->gauge, value);
+}
+
+void metrics_histogram_observe(metric_t *metric, uint32_t value)
+{
+    metric->cells[metric->num_bounds + 1] += value;
+}
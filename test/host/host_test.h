@@ -0,0 +1,34 @@
+/**
+ * @file host_test.h
+ * @brief Minimal checks for the host-side unit tests
+ *
+ * A failed CHECK prints its location and the test keeps going; main()
+ * returns HOST_TEST_RESULT() so ctest sees the failure.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int s_host_test_failures;
+
+#define CHECK(cond) do {                                                        \
+    if (!(cond)) {                                                              \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        s_host_test_failures++;                                                 \
+    }                                                                           \
+} while (0)
+
+#define CHECK_EQ(a, b) do {                                                     \
+    long long a_ = (long long)(a), b_ = (long long)(b);                         \
+    if (a_ != b_) {                                                             \
+        fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld != %lld)\n",    \
+                __FILE__, __LINE__, #a, #b, a_, b_);                            \
+        s_host_test_failures++;                                                 \
+    }                                                                           \
+} while (0)
+
+#define HOST_TEST_RESULT()  (s_host_test_failures == 0 ? 0 : 1)
+
+#endif // HOST_TEST_H
@@ -0,0 +1,15 @@
+/**
+ * @file gpio.h
+ * @brief Host stand-in for the GPIO driver types
+ */
+
+#ifndef GPIO_H
+#define GPIO_H
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_4      4
+#define GPIO_NUM_16     16
+#define GPIO_NUM_17     17
+
+#endif // GPIO_H
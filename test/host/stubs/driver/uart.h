@@ -0,0 +1,14 @@
+/**
+ * @file uart.h
+ * @brief Host stand-in for the UART driver types
+ */
+
+#ifndef UART_H
+#define UART_H
+
+typedef int uart_port_t;
+
+#define UART_NUM_1      1
+#define UART_NUM_2      2
+
+#endif // UART_H
@@ -0,0 +1,21 @@
+/**
+ * @file esp_http_server.h
+ * @brief Host stand-in for the esp_http_server types used by the router
+ */
+
+#ifndef ESP_HTTP_SERVER_H
+#define ESP_HTTP_SERVER_H
+
+#include <stdbool.h>
+
+typedef enum {
+    HTTP_DELETE = 0,
+    HTTP_GET = 1,
+    HTTP_HEAD = 2,
+    HTTP_POST = 3,
+    HTTP_PUT = 4,
+} httpd_method_t;
+
+typedef struct httpd_req httpd_req_t;
+
+#endif // ESP_HTTP_SERVER_H
@@ -0,0 +1,28 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for the ESP-IDF log macros: formats are checked, nothing is printed
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#define ESP_LOG_DISCARD(tag, fmt, ...)  do { if (0) printf("%s: " fmt, tag, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, fmt, ...)     ESP_LOG_DISCARD(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)     ESP_LOG_DISCARD(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)     ESP_LOG_DISCARD(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)     ESP_LOG_DISCARD(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...)     ESP_LOG_DISCARD(tag, fmt, ##__VA_ARGS__)
+
+#endif // ESP_LOG_H
@@ -0,0 +1,15 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS port constants
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+#define portNUM_PROCESSORS      2
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       (ms)
+
+#endif // FREERTOS_H
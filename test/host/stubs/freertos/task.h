@@ -0,0 +1,11 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for the FreeRTOS task header
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#endif // TASK_H
@@ -0,0 +1,12 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host build configuration: deferred logging and trace points compiled out
+ */
+
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#define CONFIG_DLOG_ENABLE          0
+#define CONFIG_TRACEPOINT_ENABLE    0
+
+#endif // SDKCONFIG_H
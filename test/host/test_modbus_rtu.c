@@ -0,0 +1,218 @@
+/**
+ * @file test_modbus_rtu.c
+ * @brief Adaptive response timeout of the Modbus RTU master
+ *
+ * The master runs against a fake RS485 bus whose slave answers after a
+ * programmed turnaround on a fake clock, or not at all. The timeout is
+ * read back with modbus_get_slave_timing() and from the deadline the
+ * master hands to rs485_receive().
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "modbus_rtu.h"
+#include "esp_timer.h"
+
+#define SLAVE           5
+#define BAUD            57600
+#define TIMEOUT_MS      100
+#define CHAR_US         ((10 * 1000000 + BAUD - 1) / BAUD)
+#define MIN_US          1000        // 4 characters are below MODBUS_MIN_TIMEOUT_US at this baud rate
+#define MAX_US          (TIMEOUT_MS * 1000)
+
+// ============================================================================
+// Fake bus
+// ============================================================================
+
+struct rs485_driver {
+    int dummy;
+};
+
+static struct rs485_driver s_bus;
+static int64_t s_now_us;
+static bool s_answer;               // Slave replies to the next request
+static uint32_t s_turnaround_us;    // From the end of the request to the response header
+static uint8_t s_reply[16];
+static size_t s_reply_len;
+static size_t s_reply_pos;
+static uint32_t s_header_wait_ms;   // Deadline of the last header read
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+int rs485_get_baud_rate(rs485_handle_t handle)
+{
+    return BAUD;
+}
+
+esp_err_t rs485_lock(rs485_handle_t handle, uint32_t timeout_ms)
+{
+    return ESP_OK;
+}
+
+void rs485_unlock(rs485_handle_t handle)
+{
+}
+
+esp_err_t rs485_flush_rx(rs485_handle_t handle)
+{
+    return ESP_OK;
+}
+
+void rs485_trace_rx(rs485_handle_t handle, const uint8_t *frame, size_t len)
+{
+}
+
+esp_err_t rs485_send(rs485_handle_t handle, const uint8_t *data, size_t len, uint32_t timeout_ms)
+{
+    // Reply to a single-register read with its address as the value
+    s_reply[0] = data[0];
+    s_reply[1] = data[1];
+    s_reply[2] = 2;
+    s_reply[3] = data[2];
+    s_reply[4] = data[3];
+    uint16_t crc = modbus_crc16(s_reply, 5);
+    s_reply[5] = crc & 0xFF;
+    s_reply[6] = crc >> 8;
+    s_reply_len = 7;
+    s_reply_pos = 0;
+    return ESP_OK;
+}
+
+esp_err_t rs485_receive(rs485_handle_t handle, uint8_t *data, size_t max_len, size_t *received,
+                        uint32_t timeout_ms)
+{
+    *received = 0;
+    if (s_reply_pos == 0) {
+        s_header_wait_ms = timeout_ms;
+        if (!s_answer) {
+            s_now_us += timeout_ms * 1000;
+            return ESP_ERR_TIMEOUT;
+        }
+        // The header arrives once the whole frame is in (RX idle timeout)
+        s_now_us += s_turnaround_us + (s_reply_len + RS485_RX_TIMEOUT_SYMBOLS) * CHAR_US;
+    }
+    size_t n = s_reply_len - s_reply_pos < max_len ? s_reply_len - s_reply_pos : max_len;
+    memcpy(data, &s_reply[s_reply_pos], n);
+    s_reply_pos += n;
+    *received = n;
+    return ESP_OK;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static modbus_handle_t s_mb;
+
+static esp_err_t exchange(bool answer, uint32_t turnaround_us)
+{
+    s_answer = answer;
+    s_turnaround_us = turnaround_us;
+    uint16_t value;
+    esp_err_t ret = modbus_read_holding_registers(s_mb, SLAVE, 0x1234, 1, &value);
+    if (ret == ESP_OK) {
+        CHECK_EQ(value, 0x1234);
+    }
+    return ret;
+}
+
+static modbus_slave_timing_t timing(void)
+{
+    modbus_slave_timing_t t;
+    CHECK_EQ(modbus_get_slave_timing(s_mb, SLAVE, &t), ESP_OK);
+    return t;
+}
+
+static void test_initial(void)
+{
+    modbus_slave_timing_t t = timing();
+    CHECK_EQ(t.srtt_us, 0);
+    CHECK_EQ(t.timeout_us, MAX_US);
+
+    modbus_slave_timing_t other;
+    CHECK_EQ(modbus_get_slave_timing(s_mb, 247, &other), ESP_OK);
+    CHECK_EQ(modbus_get_slave_timing(s_mb, 248, &other), ESP_ERR_INVALID_ARG);
+}
+
+static void test_converges(void)
+{
+    // First sample: srtt = sample, rttvar = sample / 2
+    CHECK_EQ(exchange(true, 8000), ESP_OK);
+    modbus_slave_timing_t t = timing();
+    CHECK_EQ(t.srtt_us, 8000);
+    CHECK_EQ(t.rttvar_us, 4000);
+    CHECK_EQ(t.timeout_us, 8000 + 4 * 4000);
+
+    // A steady slave: the deviation decays and the timeout closes in on the RTT
+    uint32_t last = t.timeout_us;
+    for (int i = 0; i < 40; i++) {
+        CHECK_EQ(exchange(true, 8000), ESP_OK);
+        t = timing();
+        CHECK(t.timeout_us <= last);
+        last = t.timeout_us;
+    }
+    CHECK_EQ(t.srtt_us, 8000);
+    CHECK(t.timeout_us >= 8000 && t.timeout_us < 8100);
+}
+
+static void test_clamps_low(void)
+{
+    // A fast slave cannot push the timeout under the minimum
+    for (int i = 0; i < 80; i++) {
+        CHECK_EQ(exchange(true, 100), ESP_OK);
+    }
+    modbus_slave_timing_t t = timing();
+    CHECK(t.srtt_us < MIN_US);
+    CHECK_EQ(t.timeout_us, MIN_US);
+}
+
+static void test_backoff(void)
+{
+    // Every missed response doubles the timeout, up to the configured maximum
+    uint32_t expect = timing().timeout_us;
+    uint32_t last_wait = 0;
+    while (expect < MAX_US) {
+        CHECK_EQ(exchange(false, 0), ESP_ERR_TIMEOUT);
+        CHECK(s_header_wait_ms > last_wait);
+        last_wait = s_header_wait_ms;
+        expect = expect * 2 < MAX_US ? expect * 2 : MAX_US;
+        CHECK_EQ(timing().timeout_us, expect);
+    }
+    CHECK_EQ(exchange(false, 0), ESP_ERR_TIMEOUT);
+    CHECK_EQ(timing().timeout_us, MAX_US);
+
+    // Header deadline: the timeout, rounded up to ms, plus a tick
+    CHECK_EQ(s_header_wait_ms, MAX_US / 1000 + 1);
+
+    // The next answer brings it back down
+    CHECK_EQ(exchange(true, 100), ESP_OK);
+    CHECK(timing().timeout_us < MAX_US);
+}
+
+static void test_clamps_high(void)
+{
+    // A slave slower than the configured timeout is capped at it
+    CHECK_EQ(exchange(true, 3 * MAX_US), ESP_OK);
+    CHECK_EQ(timing().timeout_us, MAX_US);
+}
+
+int main(void)
+{
+    modbus_config_t config = MODBUS_DEFAULT_CONFIG();
+    config.rs485 = &s_bus;
+    config.response_timeout = TIMEOUT_MS;
+    CHECK_EQ(modbus_init(&config, &s_mb), ESP_OK);
+
+    test_initial();
+    test_converges();
+    test_clamps_low();
+    test_backoff();
+    test_clamps_high();
+
+    modbus_deinit(s_mb);
+    return HOST_TEST_RESULT();
+}
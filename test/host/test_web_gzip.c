@@ -0,0 +1,179 @@
+/**
+ * @file test_web_gzip.c
+ * @brief Round trip of the streaming gzip encoder through zlib's inflate
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "host_test.h"
+#include "web_gzip.h"
+
+#define OUT_MAX     (1024 * 1024)
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t largest;
+} sink_t;
+
+static esp_err_t sink_write(void *ctx, const uint8_t *data, size_t len)
+{
+    sink_t *sink = ctx;
+    if (sink->len + len > OUT_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(&sink->data[sink->len], data, len);
+    sink->len += len;
+    if (len > sink->largest) {
+        sink->largest = len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t fail_write(void *ctx, const uint8_t *data, size_t len)
+{
+    return ESP_FAIL;
+}
+
+/**
+ * @brief Inflate a gzip stream, checking its header and trailer
+ *
+ * @return size_t Decompressed length, SIZE_MAX if zlib rejects the stream
+ */
+static size_t gunzip(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_size)
+{
+    z_stream zs = {0};
+    if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) {
+        return SIZE_MAX;
+    }
+    zs.next_in = (Bytef *)in;
+    zs.avail_in = in_len;
+    zs.next_out = out;
+    zs.avail_out = out_size;
+    int ret = inflate(&zs, Z_FINISH);
+    size_t len = zs.total_out;
+    bool consumed = zs.avail_in == 0;
+    inflateEnd(&zs);
+    return ret == Z_STREAM_END && consumed ? len : SIZE_MAX;
+}
+
+/**
+ * @brief Compress an input in chunks of a given size and inflate it back
+ */
+static void round_trip(uint8_t window_bits, const uint8_t *in, size_t in_len, size_t chunk)
+{
+    static uint8_t out[OUT_MAX];
+    static uint8_t back[OUT_MAX];
+    sink_t sink = { .data = out };
+
+    web_gzip_handle_t gz;
+    CHECK_EQ(web_gzip_create(window_bits, &gz), ESP_OK);
+    CHECK_EQ(web_gzip_begin(gz, sink_write, &sink), ESP_OK);
+    for (size_t pos = 0; pos < in_len; pos += chunk) {
+        size_t n = in_len - pos < chunk ? in_len - pos : chunk;
+        CHECK_EQ(web_gzip_write(gz, &in[pos], n), ESP_OK);
+    }
+    size_t reported_in = 0;
+    size_t reported_out = 0;
+    CHECK_EQ(web_gzip_finish(gz, &reported_in, &reported_out), ESP_OK);
+    web_gzip_delete(gz);
+
+    CHECK_EQ(reported_in, in_len);
+    CHECK_EQ(reported_out, sink.len);
+    CHECK(sink.largest <= 512);
+
+    size_t back_len = gunzip(out, sink.len, back, sizeof(back));
+    CHECK_EQ(back_len, in_len);
+    if (back_len == in_len) {
+        CHECK(memcmp(back, in, in_len) == 0);
+    }
+}
+
+static void test_round_trips(void)
+{
+    static uint8_t json[64 * 1024];
+    static uint8_t noise[48 * 1024];
+
+    // Repetitive, like the JSON documents the web server compresses
+    size_t json_len = 0;
+    json[json_len++] = '[';
+    for (int i = 0; json_len < sizeof(json) - 128; i++) {
+        json_len += snprintf((char *)&json[json_len], sizeof(json) - json_len,
+                             "{\"id\":%d,\"position\":%d,\"moving\":%s},", i % 247 + 1,
+                             (i * 37) % 4096, i % 3 ? "false" : "true");
+    }
+    json[json_len - 1] = ']';
+
+    // Incompressible: literals only
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < sizeof(noise); i++) {
+        seed = seed * 1103515245u + 12345u;
+        noise[i] = seed >> 24;
+    }
+
+    // Long runs reach the maximum match length
+    static uint8_t runs[10000];
+    memset(runs, 'a', sizeof(runs));
+    memset(&runs[5000], 'b', 1000);
+
+    for (uint8_t bits = WEB_GZIP_MIN_WINDOW_BITS; bits <= WEB_GZIP_MAX_WINDOW_BITS; bits++) {
+        round_trip(bits, json, 0, 1);
+        round_trip(bits, (const uint8_t *)"a", 1, 1);
+        round_trip(bits, (const uint8_t *)"abcabcabcabc", 12, 5);
+        round_trip(bits, json, json_len, json_len);
+        round_trip(bits, json, json_len, 1);
+        round_trip(bits, json, json_len, 1000);
+        round_trip(bits, noise, sizeof(noise), 4096);
+        round_trip(bits, runs, sizeof(runs), 333);
+    }
+}
+
+static void test_compresses(void)
+{
+    static uint8_t out[OUT_MAX];
+    static uint8_t text[32 * 1024];
+    for (size_t i = 0; i < sizeof(text); i++) {
+        text[i] = "{\"actuators\":[]}"[i % 16];
+    }
+
+    sink_t sink = { .data = out };
+    web_gzip_handle_t gz;
+    CHECK_EQ(web_gzip_create(12, &gz), ESP_OK);
+    CHECK_EQ(web_gzip_begin(gz, sink_write, &sink), ESP_OK);
+    CHECK_EQ(web_gzip_write(gz, text, sizeof(text)), ESP_OK);
+    CHECK_EQ(web_gzip_finish(gz, NULL, NULL), ESP_OK);
+    web_gzip_delete(gz);
+
+    CHECK(sink.len < sizeof(text) / 10);
+}
+
+static void test_errors(void)
+{
+    web_gzip_handle_t gz = NULL;
+    CHECK_EQ(web_gzip_create(WEB_GZIP_MIN_WINDOW_BITS - 1, &gz), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(web_gzip_create(WEB_GZIP_MAX_WINDOW_BITS + 1, &gz), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(web_gzip_create(12, NULL), ESP_ERR_INVALID_ARG);
+
+    // The header is buffered; the first error of the callback sticks until the end
+    uint8_t data[4096];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)rand();
+    }
+    CHECK_EQ(web_gzip_create(12, &gz), ESP_OK);
+    CHECK_EQ(web_gzip_begin(gz, fail_write, NULL), ESP_OK);
+    CHECK_EQ(web_gzip_write(gz, data, sizeof(data)), ESP_FAIL);
+    CHECK_EQ(web_gzip_finish(gz, NULL, NULL), ESP_FAIL);
+    web_gzip_delete(gz);
+}
+
+int main(void)
+{
+    test_round_trips();
+    test_compresses();
+    test_errors();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,138 @@
+/**
+ * @file test_web_router.c
+ * @brief Route table lookups, probing past collisions and duplicate detection
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "web_router.h"
+
+#define MANY_ROUTES     255
+
+static esp_err_t handler_a(httpd_req_t *req) { return ESP_OK; }
+static esp_err_t handler_b(httpd_req_t *req) { return ESP_OK; }
+
+/**
+ * @brief Slot of a route in a table of `slots` entries
+ *
+ * Mirrors the router's FNV-1a so the tests can pick paths that collide.
+ */
+static size_t slot_of(int method, const char *path, size_t slots)
+{
+    uint32_t hash = 2166136261u ^ (uint32_t)method;
+    hash *= 16777619u;
+    for (; *path != '\0'; path++) {
+        hash = (hash ^ (uint8_t)*path) * 16777619u;
+    }
+    return hash & (slots - 1);
+}
+
+static void test_lookup(void)
+{
+    static const web_route_t routes[] = {
+        { HTTP_GET,  "/api/status",          handler_a, WEB_ROUTE_AUTH, 0 },
+        { HTTP_POST, "/api/status",          handler_b, WEB_ROUTE_AUTH, 512 },
+        { HTTP_GET,  "/api/actuator/status", handler_a, 0, 0 },
+        { HTTP_GET,  "/",                    handler_b, WEB_ROUTE_CACHEABLE, 0 },
+    };
+    web_router_handle_t router;
+    CHECK_EQ(web_router_create(routes, 4, &router), ESP_OK);
+
+    CHECK(web_router_find(router, HTTP_GET, "/api/status") == &routes[0]);
+    CHECK(web_router_find(router, HTTP_POST, "/api/status") == &routes[1]);
+    CHECK(web_router_find(router, HTTP_GET, "/api/actuator/status") == &routes[2]);
+    CHECK(web_router_find(router, HTTP_GET, "/") == &routes[3]);
+
+    // The query string is not part of the path
+    CHECK(web_router_find(router, HTTP_GET, "/api/status?bus=1") == &routes[0]);
+    CHECK(web_router_find(router, HTTP_GET, "/?") == &routes[3]);
+
+    // Exact matches only
+    CHECK(web_router_find(router, HTTP_PUT, "/api/status") == NULL);
+    CHECK(web_router_find(router, HTTP_GET, "/api/statu") == NULL);
+    CHECK(web_router_find(router, HTTP_GET, "/api/status/") == NULL);
+    CHECK(web_router_find(router, HTTP_GET, "/api") == NULL);
+    CHECK(web_router_find(router, HTTP_GET, "") == NULL);
+    CHECK(web_router_find(router, HTTP_GET, NULL) == NULL);
+    CHECK(web_router_find(NULL, HTTP_GET, "/") == NULL);
+
+    web_router_delete(router);
+}
+
+static void test_collisions(void)
+{
+    // Two routes get a table of 4 slots: find paths that share a slot
+    char paths[3][16];
+    size_t want = slot_of(HTTP_GET, "/api/status", 4);
+    int found = 0;
+    for (int i = 0; found < 3 && i < 1000; i++) {
+        snprintf(paths[found], sizeof(paths[found]), "/c%d", i);
+        if (slot_of(HTTP_GET, paths[found], 4) == want) {
+            found++;
+        }
+    }
+    CHECK_EQ(found, 3);
+
+    const web_route_t routes[] = {
+        { HTTP_GET, "/api/status", handler_a, 0, 0 },
+        { HTTP_GET, paths[0],      handler_b, 0, 0 },
+    };
+    web_router_handle_t router;
+    CHECK_EQ(web_router_create(routes, 2, &router), ESP_OK);
+    CHECK(web_router_find(router, HTTP_GET, "/api/status") == &routes[0]);
+    CHECK(web_router_find(router, HTTP_GET, paths[0]) == &routes[1]);
+
+    // Unknown paths in the same slot probe past both routes to an empty one
+    CHECK(web_router_find(router, HTTP_GET, paths[1]) == NULL);
+    CHECK(web_router_find(router, HTTP_GET, paths[2]) == NULL);
+    web_router_delete(router);
+}
+
+static void test_full_table(void)
+{
+    static char paths[MANY_ROUTES][24];
+    static web_route_t routes[MANY_ROUTES];
+    for (int i = 0; i < MANY_ROUTES; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "/api/route/%d", i);
+        routes[i] = (web_route_t){ i % 2 ? HTTP_POST : HTTP_GET, paths[i], handler_a, 0, 0 };
+    }
+
+    web_router_handle_t router;
+    CHECK_EQ(web_router_create(routes, MANY_ROUTES, &router), ESP_OK);
+    for (int i = 0; i < MANY_ROUTES; i++) {
+        CHECK(web_router_find(router, routes[i].method, paths[i]) == &routes[i]);
+        CHECK(web_router_find(router, i % 2 ? HTTP_GET : HTTP_POST, paths[i]) == NULL);
+    }
+    CHECK(web_router_find(router, HTTP_GET, "/api/route/255") == NULL);
+    web_router_delete(router);
+
+    CHECK_EQ(web_router_create(routes, MANY_ROUTES + 1, &router), ESP_ERR_INVALID_ARG);
+}
+
+static void test_invalid(void)
+{
+    web_router_handle_t router;
+    const web_route_t dup[] = {
+        { HTTP_GET,  "/api/config", handler_a, 0, 0 },
+        { HTTP_POST, "/api/config", handler_a, 0, 0 },
+        { HTTP_GET,  "/api/config", handler_b, 0, 0 },
+    };
+    CHECK_EQ(web_router_create(dup, 3, &router), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(web_router_create(dup, 2, &router), ESP_OK);
+    web_router_delete(router);
+
+    CHECK_EQ(web_router_create(dup, 0, &router), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(web_router_create(NULL, 1, &router), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(web_router_create(dup, 1, NULL), ESP_ERR_INVALID_ARG);
+}
+
+int main(void)
+{
+    test_lookup();
+    test_collisions();
+    test_full_table();
+    test_invalid();
+    return HOST_TEST_RESULT();
+}
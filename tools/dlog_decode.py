@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Decode deferred log records printed with CONFIG_DLOG_HOST_DECODE=y.
+
+The firmware prints each DLOGx() message as a "~D<hex>" line holding the
+addresses of its format string and tag and the raw arguments. This tool
+reads those strings from the application ELF and formats the messages.
+Other lines are passed through unchanged.
+
+Examples:
+    idf.py monitor | ./tools/dlog_decode.py build/bocal-dinamico.elf
+    ./tools/dlog_decode.py build/bocal-dinamico.elf < capture.log
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LEVELS = "NEWIDV"
+ARG_U32, ARG_I64, ARG_F64, ARG_PTR, ARG_STR = 1, 2, 3, 4, 5
+
+RECORD = re.compile(r"~D([0-9a-f]{2})([0-9a-f]{2})([0-9a-f]{8})([0-9a-f]{8})([0-9a-f]{16})([0-9a-f]*)")
+SPEC = re.compile(r"%([-+ #0]*)(\d+)?(?:\.(\d+))?(?:hh|h|ll|l|L|q|j|z|t)?([diouxXcsfFeEgGaAp%])")
+
+
+class Elf:
+    """Allocated sections of a 32-bit little-endian ELF, addressed by vaddr."""
+
+    SHF_ALLOC = 0x2
+    SHT_NOBITS = 8
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(f"{path}: not a 32-bit little-endian ELF")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, stype, flags, addr, offset, size = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize)
+            if flags & self.SHF_ALLOC and stype != self.SHT_NOBITS and size:
+                self.sections.append((addr, addr + size, offset))
+        self.cache = {}
+
+    def string(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        text = None
+        for start, end, offset in self.sections:
+            if start <= addr < end:
+                pos = offset + addr - start
+                nul = self.data.index(b"\0", pos)
+                text = self.data[pos:nul].decode("utf-8", "replace")
+                break
+        self.cache[addr] = text
+        return text
+
+
+def decode_args(raw):
+    args = []
+    i = 0
+    while i < len(raw):
+        tag = raw[i]
+        i += 1
+        if tag in (ARG_U32, ARG_PTR):
+            args.append((tag, struct.unpack_from("<I", raw, i)[0]))
+            i += 4
+        elif tag == ARG_I64:
+            args.append((tag, struct.unpack_from("<q", raw, i)[0]))
+            i += 8
+        elif tag == ARG_F64:
+            args.append((tag, struct.unpack_from("<d", raw, i)[0]))
+            i += 8
+        elif tag == ARG_STR:
+            n = raw[i]
+            args.append((tag, raw[i + 1:i + 1 + n].decode("utf-8", "replace")))
+            i += 1 + n
+        else:
+            break
+    return args
+
+
+def format_message(fmt, args):
+    it = iter(args)
+
+    def conv(m):
+        flags, width, prec, c = m.groups()
+        if c == "%":
+            return "%"
+        try:
+            tag, value = next(it)
+        except StopIteration:
+            return "<?>"
+        spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "")
+        if c == "p":
+            return "0x%08x" % value
+        if c == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if c == "s":
+            return (spec + "s") % value
+        if c in "di":
+            if tag == ARG_U32 and value & 0x80000000:
+                value -= 1 << 32
+            return (spec + "d") % value
+        if c in "ouxX":
+            if value < 0:
+                value += 1 << 64
+            return (spec + ("d" if c == "u" else c)) % value
+        if c in "fFeEgG":
+            return (spec + c) % value
+        return f"<{c}?>"
+
+    return SPEC.sub(conv, fmt)
+
+
+def decode_line(elf, line):
+    m = RECORD.search(line)
+    if not m:
+        return line
+    level, _core, fmt_addr, tag_addr, time_us, raw = m.groups()
+    fmt = elf.string(int(fmt_addr, 16))
+    tag = elf.string(int(tag_addr, 16)) or "?"
+    if fmt is None:
+        return f"{line.rstrip()}  <format string 0x{fmt_addr} not in ELF>\n"
+    level = int(level, 16)
+    letter = LEVELS[level] if level < len(LEVELS) else "?"
+    msg = format_message(fmt, decode_args(bytes.fromhex(raw)))
+    return f"{letter} ({int(time_us, 16) // 1000}) {tag}: {msg}\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="application ELF the firmware was built from")
+    parser.add_argument("log", nargs="?", help="log file (default: stdin)")
+    args = parser.parse_args()
+
+    try:
+        elf = Elf(args.elf)
+    except (OSError, ValueError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    src = open(args.log, errors="replace") if args.log else sys.stdin
+    try:
+        for line in src:
+            sys.stdout.write(decode_line(elf, line))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
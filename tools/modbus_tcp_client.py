@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Minimal Modbus TCP client for exercising the gateway.
+
+Examples:
+    # Read present position..moving (0x0037-0x003B) of slave 1
+    ./tools/modbus_tcp_client.py 192.168.4.1 read 1 0x37 5
+
+    # Move slave 2 to position 3000 (force on, then goal position)
+    ./tools/modbus_tcp_client.py 192.168.4.1 write 2 0x32 1
+    ./tools/modbus_tcp_client.py 192.168.4.1 write 2 0x34 3000
+
+    # Same read from 4 connections at once, 50 times, to see coalescing
+    ./tools/modbus_tcp_client.py 192.168.4.1 stress 1 0x00 15 --clients 4 --count 50
+
+Use --port 503 for the second bus. Build with CONFIG_RS485_SIMULATOR=y to
+test without actuators.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import threading
+import time
+
+EXCEPTIONS = {
+    1: "illegal function",
+    2: "illegal data address",
+    3: "illegal data value",
+    4: "slave device failure",
+    6: "slave device busy",
+    10: "gateway path unavailable",
+    11: "gateway target failed to respond",
+}
+
+
+class Client:
+    def __init__(self, host, port, timeout=2.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.tid = 0
+
+    def close(self):
+        self.sock.close()
+
+    def _recv(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError("connection closed")
+            data += chunk
+        return data
+
+    def request(self, unit, pdu):
+        self.tid = (self.tid + 1) & 0xFFFF
+        self.sock.sendall(struct.pack(">HHHB", self.tid, 0, len(pdu) + 1, unit) + pdu)
+        tid, proto, length, _ = struct.unpack(">HHHB", self._recv(7))
+        rsp = self._recv(length - 1)
+        if tid != self.tid or proto != 0:
+            raise ValueError(f"bad MBAP header (tid {tid}, protocol {proto})")
+        if rsp[0] & 0x80:
+            code = rsp[1]
+            raise RuntimeError(f"exception 0x{code:02X} ({EXCEPTIONS.get(code, 'unknown')})")
+        return rsp
+
+    def read(self, unit, start, count):
+        rsp = self.request(unit, struct.pack(">BHH", 3, start, count))
+        return list(struct.unpack(f">{rsp[1] // 2}H", rsp[2:]))
+
+    def write(self, unit, reg, value):
+        self.request(unit, struct.pack(">BHH", 6, reg, value))
+
+
+def stress(args):
+    latencies = []
+    errors = []
+    lock = threading.Lock()
+
+    def worker():
+        client = Client(args.host, args.port)
+        try:
+            for _ in range(args.count):
+                t0 = time.perf_counter()
+                try:
+                    client.read(args.unit, args.start, args.num)
+                    with lock:
+                        latencies.append(time.perf_counter() - t0)
+                except RuntimeError as e:
+                    with lock:
+                        errors.append(str(e))
+        finally:
+            client.close()
+
+    threads = [threading.Thread(target=worker) for _ in range(args.clients)]
+    t0 = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.perf_counter() - t0
+
+    total = len(latencies) + len(errors)
+    print(f"{total} requests in {elapsed:.2f} s ({total / elapsed:.0f}/s), {len(errors)} errors")
+    if latencies:
+        latencies.sort()
+        print(f"latency ms: min {latencies[0] * 1000:.1f}"
+              f"  p50 {latencies[len(latencies) // 2] * 1000:.1f}"
+              f"  p99 {latencies[int(len(latencies) * 0.99)] * 1000:.1f}"
+              f"  max {latencies[-1] * 1000:.1f}")
+    print("Compare 'gateway' in /api/rs485/diag: coalesced, cache_hits, transactions")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=502)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("read", help="read holding registers")
+    p.add_argument("unit", type=int)
+    p.add_argument("start", type=lambda x: int(x, 0))
+    p.add_argument("num", type=int, nargs="?", default=1)
+
+    p = sub.add_parser("write", help="write a single register")
+    p.add_argument("unit", type=int)
+    p.add_argument("reg", type=lambda x: int(x, 0))
+    p.add_argument("value", type=lambda x: int(x, 0))
+
+    p = sub.add_parser("stress", help="concurrent identical reads")
+    p.add_argument("unit", type=int)
+    p.add_argument("start", type=lambda x: int(x, 0))
+    p.add_argument("num", type=int, nargs="?", default=1)
+    p.add_argument("--clients", type=int, default=4)
+    p.add_argument("--count", type=int, default=50)
+
+    args = parser.parse_args()
+
+    try:
+        if args.cmd == "stress":
+            stress(args)
+            return
+        client = Client(args.host, args.port)
+        if args.cmd == "read":
+            for i, value in enumerate(client.read(args.unit, args.start, args.num)):
+                print(f"0x{args.start + i:04X}: {value} (0x{value:04X})")
+        else:
+            client.write(args.unit, args.reg, args.value)
+            print("OK")
+        client.close()
+    except (OSError, RuntimeError, ValueError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Symbolize a sampling profile downloaded from GET /api/profiler.
+
+Each sample line of the profile holds the core, the task, the interrupted
+address, the return address of the interrupted function and a count. This
+tool resolves both addresses to function names from the symbol table of the
+application ELF and writes folded stacks ("task;caller;function count"),
+the input format of flamegraph.pl and speedscope. --flat lists the functions
+by samples instead.
+
+Examples:
+    ./tools/profile_fold.py build/bocal-dinamico.elf profile.txt > profile.folded
+    flamegraph.pl profile.folded > profile.svg
+    ./tools/profile_fold.py --flat build/bocal-dinamico.elf profile.txt | head -20
+"""
+
+import argparse
+import bisect
+import collections
+import struct
+import sys
+
+ISR_FRAME = "[interrupt]"
+
+
+class Symbols:
+    """Function symbols of a 32-bit little-endian ELF, looked up by address."""
+
+    SHT_SYMTAB = 2
+    STT_FUNC = 2
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError(f"{path}: not a 32-bit little-endian ELF")
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        sections = [struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize)
+                    for i in range(shnum)]
+
+        funcs = {}
+        for _, stype, _, _, offset, size, link, _, _, entsize in sections:
+            if stype != self.SHT_SYMTAB:
+                continue
+            str_offset = sections[link][4]
+            for pos in range(offset, offset + size, entsize or 16):
+                name, value, sym_size, info = struct.unpack_from("<IIIB", data, pos)
+                if info & 0xF != self.STT_FUNC or value == 0:
+                    continue
+                nul = data.index(b"\0", str_offset + name)
+                # Keep the sized symbol when an address has aliases
+                if value not in funcs or funcs[value][1] == 0:
+                    funcs[value] = (data[str_offset + name:nul].decode("utf-8", "replace"), sym_size)
+        if not funcs:
+            raise ValueError(f"{path}: no symbol table (stripped ELF?)")
+
+        self.addrs = sorted(funcs)
+        self.funcs = [funcs[a] for a in self.addrs]
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i < 0:
+            return None
+        name, size = self.funcs[i]
+        if size and addr >= self.addrs[i] + size:
+            return None
+        return name
+
+
+def return_to_call(addr):
+    """Address of the call instruction for an Xtensa windowed return address.
+
+    The top two bits of a0 hold the window increment of the call, not the
+    address: code lives in 0x40000000-0x7FFFFFFF.
+    """
+    return ((addr & 0x3FFFFFFF) | 0x40000000) - 3
+
+
+def read_profile(stream):
+    header = {}
+    samples = []
+    for line in stream:
+        line = line.strip()
+        if not line:
+            continue
+        if line.startswith("#"):
+            parts = line[1:].split()
+            if len(parts) == 2 and parts[1].isdigit():
+                header[parts[0]] = int(parts[1])
+            continue
+        core, task, pc, ret, count = line.split()
+        samples.append((int(core), task, int(pc, 16), int(ret, 16), int(count)))
+    return header, samples
+
+
+def fold(symbols, samples, args):
+    stacks = collections.Counter()
+    for core, task, pc, ret, count in samples:
+        if pc == 0:
+            frames = [ISR_FRAME]
+        else:
+            func = symbols.lookup(pc) or f"0x{pc:08x}"
+            caller = symbols.lookup(return_to_call(ret)) if ret and not args.no_caller else None
+            frames = [caller, func] if caller else [func]
+        if not args.no_task and task != "-":
+            frames.insert(0, task)
+        if args.core:
+            frames.insert(0, f"core{core}")
+        stacks[";".join(frames)] += count
+    return stacks
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="application ELF the firmware was built from")
+    parser.add_argument("profile", nargs="?", help="profile text (default: stdin)")
+    parser.add_argument("--flat", action="store_true", help="list functions by samples instead of folding")
+    parser.add_argument("--no-task", action="store_true", help="do not root the stacks at the task")
+    parser.add_argument("--no-caller", action="store_true", help="leave out the caller frame")
+    parser.add_argument("--core", action="store_true", help="root the stacks at the core")
+    args = parser.parse_args()
+
+    try:
+        symbols = Symbols(args.elf)
+        if args.profile:
+            with open(args.profile) as f:
+                header, samples = read_profile(f)
+        else:
+            header, samples = read_profile(sys.stdin)
+    except (OSError, ValueError) as e:
+        sys.exit(f"error: {e}")
+
+    if header.get("dropped"):
+        print(f"warning: {header['dropped']} samples dropped (table full, raise CONFIG_PROFILER_BUCKETS)",
+              file=sys.stderr)
+
+    if args.flat:
+        total = sum(s[4] for s in samples) or 1
+        funcs = collections.Counter()
+        for _, _, pc, _, count in samples:
+            funcs[ISR_FRAME if pc == 0 else symbols.lookup(pc) or f"0x{pc:08x}"] += count
+        for name, count in funcs.most_common():
+            print(f"{count:8d} {100.0 * count / total:6.2f}%  {name}")
+        return
+
+    for stack, count in sorted(fold(symbols, samples, args).items()):
+        print(f"{stack} {count}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Client for the UDP setpoint/telemetry channel.
+
+The key is the "key" of the "udp_control" section of config.json (or the
+BD_UDP_KEY environment variable).
+
+Examples:
+    # Print the telemetry stream
+    ./tools/udp_control.py 192.168.4.1 --key 0123456789abcdef watch
+
+    # Force on, then move bus 0 slave 1 and bus 0 slave 2 in one datagram
+    ./tools/udp_control.py 192.168.4.1 --key ... set 0:1=3000 0:2=1000 --force on
+
+    # Stream a sine to slave 1 at 50 Hz for 10 s; reports the setpoint ->
+    # telemetry acknowledgement time and the datagrams lost
+    ./tools/udp_control.py 192.168.4.1 --key ... sweep 0:1 --rate 50 --seconds 10
+
+Build with CONFIG_RS485_SIMULATOR=y to test without actuators.
+"""
+
+import argparse
+import hashlib
+import hmac
+import math
+import os
+import random
+import socket
+import struct
+import sys
+import time
+
+MAGIC = 0x4442
+VERSION = 2
+TYPE_SETPOINT, TYPE_TELEMETRY, TYPE_SUBSCRIBE, TYPE_HELLO, TYPE_WELCOME = 1, 2, 3, 4, 5
+HEADER = struct.Struct("<HBBIIIB3x")
+SETPOINT = struct.Struct("<BBBxHHH")
+TELEMETRY = struct.Struct("<BBBBHHHH")
+TAG_LEN = 16
+
+SET_POSITION, SET_SPEED, SET_CURRENT, SET_FORCE_ON, SET_FORCE_OFF = 1, 2, 4, 8, 16
+HEALTH = ("healthy", "suspect", "quarantined")
+
+
+class Channel:
+    def __init__(self, host, port, key):
+        self.addr = (host, port)
+        self.key = key.encode()
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.session = None
+        self.seq = 0
+
+    def _tag(self, data):
+        return hmac.new(self.key, data, hashlib.sha256).digest()[:TAG_LEN]
+
+    def _datagram(self, ptype, session, seq, entries=b"", count=0):
+        data = HEADER.pack(MAGIC, VERSION, ptype, session, seq, 0, count) + entries
+        self.sock.sendto(data + self._tag(data), self.addr)
+
+    def _recv(self, timeout):
+        """Return (type, session, seq, ack, body) of the next authenticated datagram, or None."""
+        deadline = time.monotonic() + timeout
+        while True:
+            self.sock.settimeout(max(0.0, deadline - time.monotonic()))
+            try:
+                data, _ = self.sock.recvfrom(2048)
+            except socket.timeout:
+                return None
+            if len(data) < HEADER.size + TAG_LEN:
+                continue
+            body, tag = data[:-TAG_LEN], data[-TAG_LEN:]
+            if not hmac.compare_digest(self._tag(body), tag):
+                print("datagram with a bad tag", file=sys.stderr)
+                continue
+            magic, version, ptype, session, seq, ack, _ = HEADER.unpack_from(body)
+            if magic == MAGIC and version == VERSION:
+                return ptype, session, seq, ack, body
+
+    def open_session(self, attempts=3):
+        """Ask the device for a session; packets of the previous one are dropped from now on."""
+        for _ in range(attempts):
+            nonce = random.getrandbits(32)
+            self._datagram(TYPE_HELLO, 0, nonce)
+            deadline = time.monotonic() + 1.0
+            while time.monotonic() < deadline:
+                pkt = self._recv(deadline - time.monotonic())
+                if pkt and pkt[0] == TYPE_WELCOME and pkt[3] == nonce:
+                    self.session, self.seq = pkt[1], 0
+                    return
+        raise SystemExit("no answer to HELLO (wrong key or address?)")
+
+    def _send(self, ptype, entries=b"", count=0):
+        if self.session is None or self.seq == 0xFFFFFFFF:
+            self.open_session()
+        self.seq += 1
+        self._datagram(ptype, self.session, self.seq, entries, count)
+        return self.seq
+
+    def subscribe(self):
+        return self._send(TYPE_SUBSCRIBE)
+
+    def setpoints(self, points):
+        """points: list of (bus, id, flags, position, speed, current)"""
+        entries = b"".join(SETPOINT.pack(*p) for p in points)
+        return self._send(TYPE_SETPOINT, entries, len(points))
+
+    def receive(self, timeout):
+        """Return (seq, ack, [entries]) of the next telemetry datagram of the session, or None."""
+        deadline = time.monotonic() + timeout
+        while True:
+            pkt = self._recv(max(0.0, deadline - time.monotonic()))
+            if pkt is None:
+                return None
+            ptype, session, seq, ack, body = pkt
+            if ptype != TYPE_TELEMETRY or session != self.session:
+                continue
+            count = body[16]
+            entries = [TELEMETRY.unpack_from(body, HEADER.size + i * TELEMETRY.size)
+                       for i in range(count)]
+            return seq, ack, entries
+
+
+def parse_target(text):
+    bus, _, id_ = text.partition(":")
+    return int(bus), int(id_)
+
+
+def cmd_watch(ch, args):
+    last_sub = 0
+    while True:
+        if time.monotonic() - last_sub > 1:
+            ch.subscribe()
+            last_sub = time.monotonic()
+        tlm = ch.receive(2.0)
+        if tlm is None:
+            print("no telemetry, opening a new session", file=sys.stderr)
+            ch.open_session(attempts=30)    # Rides out a reboot of the device
+            continue
+        seq, _, entries = tlm
+        line = " ".join(
+            f"{bus}:{id_} pos={pos} cur={cur}mA {volt / 10:.1f}V"
+            f"{' moving' if flags & 2 else ''}{'' if flags & 1 else ' OFFLINE'}"
+            f"{'' if health == 0 else ' ' + HEALTH[min(health, 2)]} age={age}ms"
+            for bus, id_, flags, health, pos, cur, volt, age in entries)
+        print(f"#{seq}: {line}")
+
+
+def cmd_set(ch, args):
+    flags_extra = {"on": SET_FORCE_ON, "off": SET_FORCE_OFF, None: 0}[args.force]
+    points = []
+    for item in args.targets:
+        target, _, pos = item.partition("=")
+        bus, id_ = parse_target(target)
+        flags = flags_extra | (SET_POSITION if pos else 0)
+        flags |= SET_SPEED if args.speed is not None else 0
+        flags |= SET_CURRENT if args.current is not None else 0
+        points.append((bus, id_, flags, int(pos or 0), args.speed or 0, args.current or 0))
+    seq = ch.setpoints(points)
+    start = time.monotonic()
+    while time.monotonic() - start < 2:
+        tlm = ch.receive(2.0)
+        if tlm and tlm[1] >= seq:
+            print(f"acknowledged in {(time.monotonic() - start) * 1000:.1f} ms")
+            return 0
+    print("no acknowledgement", file=sys.stderr)
+    return 1
+
+
+def cmd_sweep(ch, args):
+    bus, id_ = parse_target(args.target)
+    period = 1 / args.rate
+    sent = {}
+    delays = []
+    end = time.monotonic() + args.seconds
+    next_tx = time.monotonic()
+    while time.monotonic() < end:
+        now = time.monotonic()
+        if now >= next_tx:
+            pos = int(args.center + args.amplitude * math.sin(2 * math.pi * 0.5 * now))
+            sent[ch.setpoints([(bus, id_, SET_POSITION, pos, 0, 0)])] = now
+            next_tx += period
+        tlm = ch.receive(max(0.0, next_tx - time.monotonic()))
+        if tlm and tlm[1] in sent:
+            delays.append(time.monotonic() - sent.pop(tlm[1]))
+    if not delays:
+        print("no acknowledgement", file=sys.stderr)
+        return 1
+    delays.sort()
+    print(f"{len(delays) + len(sent)} setpoints, {len(delays)} acknowledged by telemetry "
+          f"(the rest superseded or lost)")
+    print(f"ack delay ms: min {delays[0] * 1000:.1f}  median {delays[len(delays) // 2] * 1000:.1f}  "
+          f"max {delays[-1] * 1000:.1f}")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=5005)
+    parser.add_argument("--key", default=os.environ.get("BD_UDP_KEY"))
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    sub.add_parser("watch", help="print telemetry")
+
+    p = sub.add_parser("set", help="send one setpoint datagram")
+    p.add_argument("targets", nargs="+", help="BUS:ID[=POSITION]")
+    p.add_argument("--speed", type=int)
+    p.add_argument("--current", type=int)
+    p.add_argument("--force", choices=("on", "off"))
+
+    p = sub.add_parser("sweep", help="stream sine setpoints and measure acknowledgements")
+    p.add_argument("target", help="BUS:ID")
+    p.add_argument("--rate", type=float, default=50)
+    p.add_argument("--seconds", type=float, default=10)
+    p.add_argument("--center", type=int, default=2000)
+    p.add_argument("--amplitude", type=int, default=1000)
+
+    args = parser.parse_args()
+    if not args.key:
+        parser.error("--key or BD_UDP_KEY is required")
+    ch = Channel(args.host, args.port, args.key)
+    try:
+        return {"watch": cmd_watch, "set": cmd_set, "sweep": cmd_sweep}[args.cmd](ch, args) or 0
+    except KeyboardInterrupt:
+        return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())